@@ -0,0 +1,94 @@
+/* Solves a query on a 3D map with a 50 ms budget, as a planner with a fixed control period
+   would: FMM* either reaches the goal within the budget or stops with a partial field and a
+   lower bound of the time of the goal. Then every solver is run with the same budget and with
+   an iteration budget, reporting whether they reached the goal and the bound they give.
+   Usage: test_budget [size of the map] [time budget in ms] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <memory>
+#include <limits>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/fmmstar.hpp>
+#include <fast_methods/fm/fim.hpp>
+#include <fast_methods/fm/gmm.hpp>
+#include <fast_methods/fm/ufmm.hpp>
+#include <fast_methods/fm/fsm.hpp>
+#include <fast_methods/fm/lsm.hpp>
+#include <fast_methods/fm/ddqm.hpp>
+
+using namespace std;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 3> FMGrid3D;
+typedef array<unsigned int, 3> Coord3D;
+
+void report(const Solver<FMGrid3D> & s, const FMGrid3D & grid, unsigned int goal) {
+    cout << s.getName() << ": " << s.getTime() << " ms, " << s.getIterations() << " iterations, "
+         << (s.wasBudgetExceeded() ? "stopped" : "finished");
+    if (s.isGoalReached())
+        cout << ", goal at time " << grid.getCell(goal).getArrivalTime();
+    else
+        cout << ", goal not reached";
+    if (s.wasBudgetExceeded())
+        cout << ", front at time " << s.getFrontTime();
+    cout << '\n';
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned int n = (argc > 1) ? atoi(argv[1]) : 150;
+    const double budget = (argc > 2) ? atof(argv[2]) : 50;
+    FMGrid3D grid(Coord3D{n, n, n});
+    const Coord3D start = {n/4, n/4, n/4};
+    const Coord3D goal = {3*n/4, 3*n/4, 3*n/4};
+    unsigned int goalIdx;
+    grid.coord2idx(goal, goalIdx);
+
+    // Exact time of the goal, for reference.
+    FMMStar<FMGrid3D> fmmstar;
+    fmmstar.setEnvironment(&grid);
+    fmmstar.setInitialAndGoalPoints(start, goal);
+    fmmstar.compute();
+    const double exact = grid.getCell(goalIdx).getArrivalTime();
+    cout << "Unbounded FMM*: " << fmmstar.getTime() << " ms, goal at time " << exact << '\n';
+
+    // Every bound given with the budget has to hold.
+    bool ok = true;
+    vector<unique_ptr<Solver<FMGrid3D> > > solvers;
+    solvers.emplace_back(new FMMStar<FMGrid3D>());
+    solvers.emplace_back(new FMM<FMGrid3D>());
+    solvers.emplace_back(new FIM<FMGrid3D>());
+    solvers.emplace_back(new GMM<FMGrid3D>());
+    solvers.emplace_back(new UFMM<FMGrid3D>());
+    solvers.emplace_back(new FSM<FMGrid3D>());
+    solvers.emplace_back(new LSM<FMGrid3D>());
+    solvers.emplace_back(new DDQM<FMGrid3D>());
+    for (const unsigned long iterations : {0ul, 100000ul}) {
+        cout << '\n' << (iterations ? "Budget of 100000 iterations:\n" : "Time budget:\n");
+        for (unique_ptr<Solver<FMGrid3D> > & s : solvers) {
+            s->setEnvironment(&grid);
+            s->setInitialAndGoalPoints(start, goal);
+            s->setTimeBudget(iterations ? numeric_limits<double>::infinity() : budget);
+            s->setIterationBudget(iterations);
+            s->compute();
+            report(*s, grid, goalIdx);
+
+            const double t = grid.getCell(goalIdx).getArrivalTime();
+            if (s->isGoalReached() && t < exact - 1e-6)
+                ok = false;
+            if (s->wasBudgetExceeded() && !s->isGoalReached() && s->getFrontTime() > exact + 1e-6)
+                ok = false;
+            s->reset();
+        }
+    }
+
+    return ok ? 0 : 1;
+}
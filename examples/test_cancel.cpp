@@ -0,0 +1,96 @@
+/* Solves a 3D map with FMM in a background thread, as a planner would, and cancels the solve
+   when a new query arrives: the stale solve stops within a check interval and the new one
+   starts right away. The progress callback reports the front of the stale solve. Then each
+   solver is cancelled shortly after starting, to check how fast they stop.
+   Usage: test_cancel [size of the map] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <future>
+#include <memory>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/fim.hpp>
+#include <fast_methods/fm/gmm.hpp>
+#include <fast_methods/fm/ufmm.hpp>
+#include <fast_methods/fm/fsm.hpp>
+#include <fast_methods/fm/lsm.hpp>
+#include <fast_methods/fm/ddqm.hpp>
+
+using namespace std;
+using namespace std::chrono;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 3> FMGrid3D;
+typedef array<unsigned int, 3> Coord3D;
+
+double elapsed(const time_point<steady_clock> & start) {
+    return duration_cast<microseconds>(steady_clock::now() - start).count()/1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned int n = (argc > 1) ? atoi(argv[1]) : 150;
+    FMGrid3D grid(Coord3D{n, n, n});
+
+    // Full solve, for reference.
+    FMM<FMGrid3D> fmm;
+    fmm.setEnvironment(&grid);
+    fmm.setInitialPoints(Coord3D{n/4, n/4, n/4});
+    fmm.compute();
+    cout << "Full FMM solve: " << fmm.getTime() << " ms\n";
+
+    // A solve is started and a new query arrives while it runs.
+    fmm.reset();
+    fmm.setInitialPoints(Coord3D{n/4, n/4, n/4});
+    double front = 0;
+    fmm.setProgressCallback([&front] (unsigned long, double t) { front = t; });
+    future<void> stale = fmm.computeAsync();
+    this_thread::sleep_for(milliseconds(20));
+
+    const time_point<steady_clock> arrival = steady_clock::now();
+    fmm.cancel();
+    stale.wait();
+    cout << "Stale solve cancelled in " << elapsed(arrival) << " ms, front at time " << front
+         << (fmm.wasCancelled() ? "" : " (not cancelled)") << '\n';
+
+    fmm.reset();
+    fmm.setProgressCallback(Solver<FMGrid3D>::ProgressCallback());
+    fmm.setInitialPoints(Coord3D{3*n/4, n/2, n/2});
+    future<void> fresh = fmm.computeAsync();
+    fresh.wait();
+    cout << "New query answered " << elapsed(arrival) << " ms after arriving\n";
+    bool ok = !fmm.wasCancelled() && !isinf(grid.getCell(0).getArrivalTime());
+
+    // Every solver is cancelled 10 ms after starting.
+    vector<unique_ptr<Solver<FMGrid3D> > > solvers;
+    solvers.emplace_back(new FMM<FMGrid3D>());
+    solvers.emplace_back(new FIM<FMGrid3D>());
+    solvers.emplace_back(new GMM<FMGrid3D>());
+    solvers.emplace_back(new UFMM<FMGrid3D>());
+    solvers.emplace_back(new FSM<FMGrid3D>("FSM", -1, 1));
+    solvers.emplace_back(new LSM<FMGrid3D>());
+    solvers.emplace_back(new DDQM<FMGrid3D>());
+    for (unique_ptr<Solver<FMGrid3D> > & s : solvers) {
+        s->setEnvironment(&grid);
+        s->setInitialPoints(Coord3D{n/4, n/4, n/4});
+        future<void> f = s->computeAsync();
+        this_thread::sleep_for(milliseconds(10));
+        const time_point<steady_clock> start = steady_clock::now();
+        s->cancel();
+        f.wait();
+        cout << s->getName() << ": stopped in " << elapsed(start) << " ms"
+             << (s->wasCancelled() ? "" : " (finished before the cancellation)") << '\n';
+        s->reset();
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,105 @@
+/* Solves a map given as an array of floats owned by the caller (as a costmap received from a
+   perception stack) with FMM, first copying it into an FMCell grid cell by cell and then
+   using it in place with an FMCellExternalF grid, which also writes the arrival times into
+   an array of the caller. The same map seen with its Y dimension flipped through negative
+   strides is solved too. Times are compared with those of the copied grid.
+   Usage: test_externalbuffer [size of the map] [number of cycles] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/fmcellexternal.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+
+using namespace std;
+using namespace std::chrono;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 2> FMGrid2D;
+typedef nDGridMap<FMCellExternalF, 2> ExternalGrid2D;
+
+int main(int argc, char **argv)
+{
+    const unsigned int n = (argc > 1) ? atoi(argv[1]) : 1000;
+    const unsigned int cycles = (argc > 2) ? atoi(argv[2]) : 5;
+
+    // The map of the caller: random speeds and some walls.
+    vector<float> map(n*n), times(n*n);
+    mt19937 rng(1);
+    uniform_real_distribution<float> speed(0.5f, 1.0f);
+    for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+            map[y*n + x] = (x % 100 == 50 && y % 200 > 20) ? 0 : speed(rng);
+    const array<unsigned int, 2> dimsize = {n, n};
+    const unsigned int x0 = (n/4 % 100 == 50) ? n/4 + 1 : n/4; // Not in a wall.
+    const array<unsigned int, 2> init_point = {x0, n/4};
+
+    // Copying the map into the grid every cycle (after restarting it).
+    FMGrid2D grid(dimsize);
+    FMM<FMGrid2D> fmm;
+    fmm.setEnvironment(&grid);
+    double copyTime = 0, copySolve = 0;
+    for (unsigned int c = 0; c < cycles; ++c) {
+        const time_point<steady_clock> start = steady_clock::now();
+        fmm.reset();
+        for (unsigned int i = 0; i < n*n; ++i)
+            grid[i].setVelocity(map[i]);
+        copyTime += duration_cast<microseconds>(steady_clock::now() - start).count()/1000.0;
+        fmm.setInitialPoints(init_point);
+        fmm.compute();
+        copySolve += fmm.getTime();
+    }
+
+    // Using the map in place every cycle.
+    ExternalGrid2D ext(dimsize);
+    FMM<ExternalGrid2D> extFmm;
+    extFmm.setEnvironment(&ext);
+    double extTime = 0, extSolve = 0;
+    for (unsigned int c = 0; c < cycles; ++c) {
+        const time_point<steady_clock> start = steady_clock::now();
+        // The grid is restarted, so reset() does not clean it again.
+        ext.setExternalBuffers(ExternalBuffer(map.data()), ExternalBuffer(times.data()));
+        extFmm.reset();
+        extTime += duration_cast<microseconds>(steady_clock::now() - start).count()/1000.0;
+        extFmm.setInitialPoints(init_point);
+        extFmm.compute();
+        extSolve += extFmm.getTime();
+    }
+
+    // The same map with Y flipped: row n-1 of the array is y = 0.
+    vector<float> flippedTimes(n*n);
+    const ptrdiff_t row = n*sizeof(float);
+    ExternalGrid2D flipped(dimsize);
+    flipped.setExternalBuffers(ExternalBuffer(&map[(n - 1)*n], vector<ptrdiff_t>{sizeof(float), -row}),
+                               ExternalBuffer(&flippedTimes[(n - 1)*n], vector<ptrdiff_t>{sizeof(float), -row}));
+    FMM<ExternalGrid2D> flippedFmm;
+    flippedFmm.setEnvironment(&flipped);
+    flippedFmm.setInitialPoints(array<unsigned int, 2>{x0, n - 1 - n/4});
+    flippedFmm.compute();
+
+    double maxDiff = 0, maxFlippedDiff = 0;
+    for (unsigned int i = 0; i < n*n; ++i) {
+        const double t = grid[i].getArrivalTime();
+        if (isinf(t) != isinf(times[i]) || isinf(t) != isinf(flippedTimes[i]))
+            maxDiff = numeric_limits<double>::infinity();
+        else if (!isinf(t)) {
+            maxDiff = max(maxDiff, abs(t - times[i])/max(t, 1.0));
+            maxFlippedDiff = max(maxFlippedDiff, abs(double(times[i]) - flippedTimes[i]));
+        }
+    }
+
+    cout << "Map: " << n << "x" << n << ", " << cycles << " cycles\n"
+         << "Copy: " << copyTime/cycles << " ms + FMM " << copySolve/cycles << " ms per cycle\n"
+         << "External: " << extTime/cycles << " ms + FMM " << extSolve/cycles << " ms per cycle\n"
+         << "Max relative difference to the copied grid (float times): " << maxDiff << '\n'
+         << "Max difference of the flipped view: " << maxFlippedDiff << endl;
+    return (maxDiff < 1e-5 && maxFlippedDiff == 0) ? 0 : 1;
+}
@@ -50,17 +50,26 @@ int main(int argc, const char ** argv)
     solvers.push_back(new FM2Star<FMGrid2D, FMPriorityQueue<FMCell> >("FM2*_SFMM_Time"));
     solvers.push_back(new FM2Star<FMGrid2D, FMPriorityQueue<FMCell> >("FM2*_SFMM_Dist", DISTANCE));
 
+    // First wave computed as an exact distance transform.
+    FM2<FMGrid2D> * fm2edt = new FM2<FMGrid2D>("FM2_EDT");
+    fm2edt->setFirstWave(WAVE_EDT);
+    solvers.push_back(fm2edt);
+    FM2Star<FMGrid2D> * fm2staredt = new FM2Star<FMGrid2D>("FM2*_EDT_Dist", DISTANCE);
+    fm2staredt->setFirstWave(WAVE_EDT);
+    solvers.push_back(fm2staredt);
+
     // Executing every solver individually over the same grid.
     for (Solver<FMGrid2D>* s :solvers)
     {
-        // For FM2 and its variations, it is better to completely reinitialize the grid.
+        // Every solver caches its own velocities map, so the grid is reloaded for each of them.
         //if(!MapLoader::loadMapFromText(filename.c_str(), grid_fm2)) // Loading from text file.
             //exit(1);
         MapLoader::loadMapFromImg(filename.c_str(), grid_fm2); // Loading from image.
         s->setEnvironment(&grid_fm2);
-        s->setInitialAndGoalPoints({30, 20}, {375, 280}); // Init and goal points directly set.
+        s->setInitialAndGoalPoints(array<unsigned int, ndims2>{30, 20}, array<unsigned int, ndims2>{375, 280}); // Init and goal points directly set.
         s->compute();
-        cout << "\tElapsed "<< s->getName() <<" time: " << s->getTime() << " ms" << '\n';
+        cout << "\tElapsed "<< s->getName() <<" time: " << s->getTime() << " ms (velocities map: "
+             << s->as<FM2<FMGrid2D>>()->getTimeVelocities() << " ms)" << '\n';
 
         Path2D path;
         vector<double> path_vels;
@@ -0,0 +1,91 @@
+/* Compares the row-major and the bricked layouts of nDGridMap running FMM-based
+   solvers on a 3D grid loaded from a given text file, as in test_fmm3d.cpp.
+   Usage: test_fmm3d_bricks <3D grid file> [number of runs] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/sfmm.hpp>
+#include <fast_methods/fm/ufmm.hpp>
+#include <fast_methods/io/maploader.hpp>
+
+using namespace std;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 3> FMGrid3D;
+typedef array<unsigned int, 3> Coord3D;
+
+/* Runs the solver nruns times and returns the best time, leaving the result in the grid. */
+double runSolver
+(Solver<FMGrid3D> * s, FMGrid3D & grid, const Coord3D & init_point, unsigned int nruns) {
+    double best = numeric_limits<double>::infinity();
+    s->setEnvironment(&grid);
+    s->setInitialPoints(init_point);
+    for (unsigned int i = 0; i < nruns; ++i) {
+        s->compute();
+        best = min(best, s->getTime());
+        if (i + 1 < nruns)
+            s->reset();
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        console::error("Usage: test_fmm3d_bricks <3D grid file> [number of runs]");
+        return 1;
+    }
+    const unsigned int nruns = (argc > 2) ? atoi(argv[2]) : 3;
+    const vector<unsigned int> brickSizes = {1, 4, 8, 16};
+    Coord3D init_point = {5, 5, 5};
+    const array<string, 3> names = {{"FMM", "SFMM", "UFMM"}};
+
+    for (const string & name : names) {
+        cout << name << '\n';
+        vector<double> reference;
+        for (unsigned int b : brickSizes) {
+            FMGrid3D grid;
+            grid.setBrickSize(b);
+            MapLoader::loadMapFromText(argv[1], grid);
+
+            Solver<FMGrid3D> * s;
+            if (name == "FMM")
+                s = new FMM<FMGrid3D>;
+            else if (name == "SFMM")
+                s = new SFMM<FMGrid3D>;
+            else
+                s = new UFMM<FMGrid3D>;
+            const double time = runSolver(s, grid, init_point, nruns);
+            delete s;
+
+            // Results are compared in row-major order.
+            bool same = true;
+            for (unsigned int i = 0; i < grid.getNumberOfCells(); ++i) {
+                const double v = grid.getCell(grid.rowMajor2idx(i)).getValue();
+                if (b == 1)
+                    reference.push_back(v);
+                else if (!(v == reference[i]))
+                    same = false;
+            }
+
+            cout << "\tBrick size " << b << ": " << time << " ms";
+            if (b == 1)
+                cout << " (row-major)";
+            else if (!same)
+                cout << " DIFFERENT RESULTS";
+            cout << '\n';
+        }
+    }
+
+    return 0;
+}
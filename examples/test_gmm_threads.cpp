@@ -0,0 +1,87 @@
+/* Compares parallel GMM with serial GMM on synthetic 2D and 3D maps, taking FMM as the
+   reference: for every map it reports the largest error of both with respect to FMM (and how
+   many cells differ), the difference between them and their times. Parallel GMM has to give
+   the same times with 2 and 4 threads and not a larger error than serial GMM.
+   Usage: test_gmm_threads */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/gmm.hpp>
+#include <fast_methods/io/mapgenerator.hpp>
+
+using namespace std;
+
+// Largest difference between the finite times of a and b, counting the cells which differ.
+double maxError(const vector<double> & a, const vector<double> & b, unsigned int & ndiff) {
+    double e = 0;
+    ndiff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (isfinite(a[i])) {
+            const double d = abs(a[i] - b[i]);
+            if (d > 1e-9)
+                ++ndiff;
+            e = max(e, d);
+        }
+    return e;
+}
+
+template <class grid_t>
+void solve(Solver<grid_t> & s, grid_t & grid, const vector<unsigned int> & init, vector<double> & times) {
+    s.setEnvironment(&grid);
+    s.setInitialPoints(init);
+    s.compute();
+    times.resize(grid.size());
+    for (unsigned int i = 0; i < grid.size(); ++i)
+        times[i] = grid.getCell(i).getArrivalTime();
+    cout << "  " << s.getName() << " " << s.getTime() << " ms";
+}
+
+template <size_t ndims>
+bool run(const array<unsigned int, ndims> & dims, ObstacleMap obstacles, VelocityField velocities) {
+    typedef nDGridMap<FMCell, ndims> grid_t;
+    grid_t grid;
+    MapGenerator::generate(grid, dims, obstacles, 0.15, velocities, 7);
+    const vector<unsigned int> init = MapGenerator::randomFreeCells(grid, 1, 3);
+
+    vector<double> fmm, serial, parallel2, parallel4;
+    FMM<grid_t> f;
+    GMM<grid_t> g;
+    GMM<grid_t> g2("GMM2", -1, 2);
+    GMM<grid_t> g4("GMM4", -1, 4);
+    cout << ndims << "D, obstacles " << obstacles << ", velocities " << velocities << ":";
+    solve(f, grid, init, fmm);
+    solve(g, grid, init, serial);
+    solve(g2, grid, init, parallel2);
+    solve(g4, grid, init, parallel4);
+    cout << '\n';
+
+    unsigned int ns, np, nsp, n24;
+    const double es = maxError(fmm, serial, ns);
+    const double ep = maxError(fmm, parallel2, np);
+    const double esp = maxError(serial, parallel2, nsp);
+    const double e24 = maxError(parallel2, parallel4, n24);
+    cout << "  error wrt FMM: serial " << es << " (" << ns << " cells), parallel " << ep << " (" << np
+         << " cells); parallel wrt serial " << esp << " (" << nsp << " cells)\n";
+    return n24 == 0 && e24 == 0 && ep <= es + 1e-9;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= run<2>({{120, 90}}, RANDOM_OBSTACLES, UNIFORM_VELOCITY);
+    ok &= run<2>({{120, 90}}, RANDOM_OBSTACLES, SMOOTH_VELOCITY);
+    ok &= run<2>({{500, 500}}, BARRIER_OBSTACLES, SMOOTH_VELOCITY);
+    ok &= run<3>({{30, 25, 20}}, RANDOM_OBSTACLES, UNIFORM_VELOCITY);
+    ok &= run<3>({{30, 25, 20}}, NO_OBSTACLES, SMOOTH_VELOCITY);
+    cout << (ok ? "OK" : "FAILED") << '\n';
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/* Solves FMM once from the center of a map and extracts the paths from many random goals,
+   one after the other with GradientDescent and in batches with a single precision
+   GradientField, for an increasing number of threads. Prints the times of both.
+   Usage: test_gradientfield [number of paths] [max number of threads] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/gradientdescent/gradientdescent.hpp>
+#include <fast_methods/gradientdescent/gradientfield.hpp>
+
+using namespace std;
+using namespace std::chrono;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 2> FMGrid2D;
+typedef GradientField<FMGrid2D, float> Field;
+
+int main(int argc, char **argv)
+{
+    const unsigned int npaths = (argc > 1) ? atoi(argv[1]) : 256;
+    const unsigned int maxThreads = (argc > 2) ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+
+    // A 500x500 map with a 1 cell border and some walls.
+    FMGrid2D grid(array<unsigned int, 2>{500, 500});
+    array<unsigned int, 2> c;
+    for (c[1] = 0; c[1] < 500; ++c[1])
+        for (c[0] = 0; c[0] < 500; ++c[0]) {
+            unsigned int idx;
+            grid.coord2idx(c, idx);
+            const bool border = c[0] == 0 || c[1] == 0 || c[0] == 499 || c[1] == 499;
+            const bool wall = (c[0] % 100 == 50 && c[1] % 250 > 20) || (c[1] == 250 && c[0] % 100 > 50);
+            grid[idx].setOccupancy((border || wall) ? 0 : 1);
+        }
+
+    unsigned int start;
+    grid.coord2idx(array<unsigned int, 2>{200, 240}, start);
+    FMM<FMGrid2D> fmm;
+    fmm.setEnvironment(&grid);
+    fmm.setInitialPoints(vector<unsigned int>{start});
+    fmm.compute();
+
+    vector<unsigned int> goals;
+    mt19937 rng(1);
+    uniform_int_distribution<unsigned int> coord(1, 498);
+    while (goals.size() < npaths) {
+        unsigned int goal;
+        grid.coord2idx(array<unsigned int, 2>{coord(rng), coord(rng)}, goal);
+        if (!isinf(grid[goal].getArrivalTime()))
+            goals.push_back(goal);
+    }
+
+    time_point<steady_clock> t = steady_clock::now();
+    for (unsigned int goal : goals) {
+        Field::Path path;
+        vector<double> velocities;
+        GradientDescent<FMGrid2D>::apply(grid, goal, path, velocities);
+    }
+    cout << "GradientDescent: " << duration<double, milli>(steady_clock::now() - t).count() << " ms\n";
+
+    const FMGrid2D & cgrid = grid;
+    for (unsigned int nthreads = 1; nthreads <= maxThreads; nthreads *= 2) {
+        Field field(nthreads);
+        vector<Field::Path> paths;
+        vector<vector<double> > velocities;
+        t = steady_clock::now();
+        field.build(cgrid);
+        const double build = duration<double, milli>(steady_clock::now() - t).count();
+        t = steady_clock::now();
+        field.apply(goals, paths, velocities);
+        cout << "GradientField, " << nthreads << " threads: build " << build << " ms, paths "
+             << duration<double, milli>(steady_clock::now() - t).count() << " ms, "
+             << count_if(paths.begin(), paths.end(), [] (const Field::Path & p) { return p.empty(); })
+             << " not finished\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+/* Converts a 3D .grid text file into the binary .fmgrid format and compares the time to load
+   both, checking that the grids loaded are the same.
+   Usage: test_gridbinary [.grid file] [.fmgrid file]
+   By default it converts ../data/3dbarriers_9.grid into 3dbarriers_9.fmgrid. */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <chrono>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/io/maploader.hpp>
+#include <fast_methods/io/gridwriter.hpp>
+
+using namespace std;
+using namespace std::chrono;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 3> FMGrid3D;
+
+int main(int argc, char **argv)
+{
+    const char * text = (argc > 1) ? argv[1] : "../data/3dbarriers_9.grid";
+    const char * binary = (argc > 2) ? argv[2] : "3dbarriers_9.fmgrid";
+
+    FMGrid3D grid;
+    time_point<steady_clock> start = steady_clock::now();
+    if (!MapLoader::loadMapFromText(text, grid))
+        return 1;
+    const double textTime = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+    GridWriter::saveVelocitiesBinary(binary, grid);
+
+    FMGrid3D grid2;
+    start = steady_clock::now();
+    if (!MapLoader::loadMapFromBinary(binary, grid2))
+        return 1;
+    const double binaryTime = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+    unsigned int diff = grid.size() != grid2.size() || grid.getLeafSize() != grid2.getLeafSize();
+    for (unsigned int i = 0; !diff && i < grid.size(); ++i)
+        diff += grid[i].getVelocity() != grid2[i].getVelocity();
+
+    vector<unsigned int> obs, obs2;
+    grid.getOccupiedCells(obs);
+    grid2.getOccupiedCells(obs2);
+    diff += obs != obs2;
+
+    cout << "Cells: " << grid.size() << ", obstacles: " << obs2.size() << '\n'
+         << "Text load: " << textTime << " ms\n"
+         << "Binary load: " << binaryTime << " ms\n"
+         << "Grids " << (diff ? "differ" : "are the same") << endl;
+    return diff ? 1 : 0;
+}
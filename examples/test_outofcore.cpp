@@ -0,0 +1,95 @@
+/* Solves a 3D grid stored on disk as tiles (TiledGrid) with TiledFIM, with a cache of a few
+   tiles, and compares the arrival times with those of FMM on the grid in memory.
+   Usage: test_outofcore [cells per side] [tile size] [cached tiles]
+   By default a 96^3 grid with spherical obstacles, tiles of 16^3 cells and 16 cached tiles. */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+#include <fast_methods/ndgridmap/tiledgrid.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/tiledfim.hpp>
+
+using namespace std;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCell, 3> FMGrid3D;
+typedef array<unsigned int, 3> Coord3D;
+
+int main(int argc, char **argv)
+{
+    const unsigned int n = (argc > 1) ? atoi(argv[1]) : 96;
+    const unsigned int tileSize = (argc > 2) ? atoi(argv[2]) : 16;
+    const unsigned int cached = (argc > 3) ? atoi(argv[3]) : 16;
+
+    // Obstacles: spheres on a regular lattice, and slower cells in the upper half.
+    auto velocity = [n] (const Coord3D & c) {
+        const double s = n / 4.0;
+        double d2 = 0;
+        for (unsigned int i = 0; i < 3; ++i) {
+            const double x = std::fmod(c[i] + s/2, s) - s/2;
+            d2 += x*x;
+        }
+        if (d2 < s*s/9)
+            return 0.0;
+        return (c[2] < n/2) ? 1.0 : 0.5;
+    };
+    const Coord3D dims = {n, n, n};
+    const Coord3D init_point = {n/8, n/8, n/8};
+
+    TiledGrid<3> tiled;
+    if (!tiled.create("outofcore.fmtiles", dims, 1, tileSize, velocity))
+        return 1;
+    tiled.setCacheSize(cached);
+
+    TiledFIM<3> tfim;
+    tfim.setEnvironment(&tiled);
+    tfim.setInitialPoints(vector<Coord3D>(1, init_point));
+    tfim.compute();
+    tfim.printRunInfo();
+
+    // Same grid in memory.
+    FMGrid3D grid(dims);
+    std::vector<unsigned int> obs;
+    Coord3D c;
+    for (c[2] = 0; c[2] < n; ++c[2])
+        for (c[1] = 0; c[1] < n; ++c[1])
+            for (c[0] = 0; c[0] < n; ++c[0]) {
+                unsigned int idx;
+                grid.coord2idx(c, idx);
+                grid[idx].setOccupancy(velocity(c));
+                if (grid[idx].isOccupied())
+                    obs.push_back(idx);
+            }
+    grid.setOccupiedCells(obs);
+    FMM<FMGrid3D> fmm;
+    fmm.setEnvironment(&grid);
+    fmm.setInitialPoints(init_point);
+    fmm.compute();
+    cout << "\tElapsed "<< fmm.getName() <<" time: " << fmm.getTime() << " ms" << '\n';
+
+    double maxDiff = 0;
+    unsigned int mismatches = 0;
+    for (c[2] = 0; c[2] < n; ++c[2])
+        for (c[1] = 0; c[1] < n; ++c[1])
+            for (c[0] = 0; c[0] < n; ++c[0]) {
+                unsigned int idx;
+                grid.coord2idx(c, idx);
+                const double t = tiled.getArrivalTime(c);
+                const double r = grid[idx].isOccupied() ? std::numeric_limits<double>::infinity() : grid[idx].getValue();
+                if (std::isinf(t) || std::isinf(r))
+                    mismatches += std::isinf(t) != std::isinf(r);
+                else
+                    maxDiff = std::max(maxDiff, std::fabs(t - r));
+            }
+    cout << "Maximum difference with FMM: " << maxDiff << ", cells reached by only one of them: " << mismatches << endl;
+
+    tiled.saveGridValuesBinary("outofcore.fmgrid");
+    return (mismatches == 0 && maxDiff < 1e-6) ? 0 : 1;
+}
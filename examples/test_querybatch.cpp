@@ -0,0 +1,84 @@
+/* Solves a batch of random start/goal queries on the same map with QueryBatch, for an
+   increasing number of threads, and prints the throughput in queries per second. Paths
+   are compared with those of a single FMM solving the queries one after the other, and the
+   program fails if any of them differs.
+   Usage: test_querybatch [number of queries] [max number of threads] */
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcellsoa.h>
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/fm/querybatch.hpp>
+
+using namespace std;
+
+// A bit of shorthand.
+typedef nDGridMap<FMCellSoA, 2> FMGrid2D;
+typedef QueryBatch<FMGrid2D> Batch;
+
+int main(int argc, char **argv)
+{
+    const unsigned int nqueries = (argc > 1) ? atoi(argv[1]) : 64;
+    const unsigned int maxThreads = (argc > 2) ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+
+    // A 500x500 map with a 1 cell border and some walls.
+    FMGrid2D env(array<unsigned int, 2>{500, 500});
+    array<unsigned int, 2> c;
+    for (c[1] = 0; c[1] < 500; ++c[1])
+        for (c[0] = 0; c[0] < 500; ++c[0]) {
+            unsigned int idx;
+            env.coord2idx(c, idx);
+            const bool border = c[0] == 0 || c[1] == 0 || c[0] == 499 || c[1] == 499;
+            const bool wall = (c[0] % 100 == 50 && c[1] % 250 > 20) || (c[1] == 250 && c[0] % 100 > 50);
+            env[idx].setOccupancy((border || wall) ? 0 : 1);
+        }
+
+    vector<Batch::Query> queries;
+    mt19937 rng(1);
+    uniform_int_distribution<unsigned int> coord(1, 498);
+    while (queries.size() < nqueries) {
+        unsigned int start, goal;
+        env.coord2idx(array<unsigned int, 2>{coord(rng), coord(rng)}, start);
+        env.coord2idx(array<unsigned int, 2>{coord(rng), coord(rng)}, goal);
+        if (start != goal && !env[start].isOccupied() && !env[goal].isOccupied())
+            queries.push_back(Batch::Query(vector<unsigned int>{start}, goal));
+    }
+
+    // Reference: one solver on a copy of the map.
+    vector<Batch::Path> reference(nqueries);
+    {
+        FMGrid2D grid = env;
+        FMM<FMGrid2D> fmm;
+        fmm.setEnvironment(&grid);
+        for (unsigned int q = 0; q < nqueries; ++q) {
+            fmm.setInitialAndGoalPoints(queries[q].init_points, queries[q].goal_idx);
+            fmm.compute();
+            unsigned int idx = queries[q].goal_idx;
+            vector<double> velocities;
+            if (!isinf(grid[idx].getArrivalTime()))
+                GradientDescent<FMGrid2D>::apply(grid, idx, reference[q], velocities);
+            fmm.reset();
+        }
+    }
+
+    bool ok = true;
+    for (unsigned int nthreads = 1; nthreads <= maxThreads; nthreads *= 2) {
+        Batch batch(env, nthreads);
+        const vector<Batch::Path> paths = batch.computePaths(queries);
+        batch.printRunInfo();
+        if (paths != reference) {
+            console::warning("Paths different from the reference.");
+            ok = false;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
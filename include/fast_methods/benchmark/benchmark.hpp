@@ -3,7 +3,23 @@
     It works for FMM (any heap and SFMM), FIM and UFMM. It has not been tested
     with FM2 solvers.
     
-    By default, it will save a log file in a generated folder called results.
+    By default, it will save a log file in a generated folder called results. Every run logs
+    the times (ms, with the resolution of steady_clock) of its phases: compute, reset, setup and,
+    for FM2 solvers, the velocities map. Warmup runs (setWarmupRuns()) are run before the logged
+    ones of each solver and not logged. The log ends with the statistics of the phases of each
+    solver (see RunStatistics), in lines starting with '#', which are also shown in the terminal.
+    If the operation counters are compiled in (see OpCounters), those of the last run of each
+    solver follow them. Every run also logs the memory of the solver and of the grid after it
+    (Solver::memory(), nDGridMap::memory()) and the peak resident memory of the process during
+    it (MemoryUsage::peakRSS()), and the log ends with those of each solver. Hardware events set
+    with setPerfEvents() (see PerfCounters) are counted around the compute() of every run and
+    logged in a column per event after the memory; their
+    statistics, and the instructions per cycle and LLC miss bandwidth if their events are
+    counted, follow the summary.
+
+    Besides the text log, the same values can be saved as JSON (every run and the statistics of
+    each solver, which BenchmarkComparison reads to compare with a baseline) and as CSV (a row per
+    run), see setLogFormats().
     
     This program is free software: you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
@@ -21,28 +37,70 @@
 #define BENCHMARK_HPP_
 
 #include <chrono>
+#include <cmath>
 #include <limits>
+#include <iomanip>
+#include <array>
+#include <algorithm>
 
 #include <boost/filesystem.hpp>
 #include <boost/progress.hpp>
 
 #include <fast_methods/fm/solver.hpp>
 #include <fast_methods/io/gridwriter.hpp>
+#include <fast_methods/io/asyncgridwriter.hpp>
+#include <fast_methods/utils/allocationcounter.hpp>
+#include <fast_methods/utils/perfcounters.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
+#include <fast_methods/benchmark/runstatistics.hpp>
+
+/** \brief Formats of the log of a Benchmark, which can be combined (LOG_TEXT | LOG_JSON). */
+enum LogFormat {LOG_TEXT = 1, LOG_JSON = 2, LOG_CSV = 4};
 
 template <class grid_t>
 class Benchmark {
 
     public:
+        /** \brief Values of a run, as logged. Allocations are NaN if they are not counted. */
+        struct RunRecord {
+            unsigned int        id;
+            double              time;
+            double              resetTime;
+            double              allocations;
+            double              setupTime;
+            double              velocitiesTime;
+            size_t              solverMemory;
+            size_t              gridMemory;
+            size_t              peakRSS;
+            std::vector<double> events;
+        };
+
+        /** \brief Runs of a solver and their statistics, as logged. */
+        struct SolverRecord {
+            std::string                                             name;
+            std::vector<RunRecord>                                  runs;
+            std::vector<std::pair<std::string, RunStatistics> >     phases;
+            std::vector<std::pair<std::string, RunStatistics> >     events;
+            std::vector<std::pair<std::string, unsigned long long> > counters;
+        };
 
         Benchmark
         (unsigned int saveGrid = 0, bool saveLog = true) :
         saveGrid_(saveGrid),
+        gridFormat_(GRID_TEXT),
         saveLog_(saveLog),
+        logFormats_(LOG_TEXT),
+        verbose_(true),
         runID_(0),
         nruns_(10),
+        nwarmup_(0),
+        peakRSS_(0),
+        allocations_(0),
         path_("results"),
         name_("benchmark"),
-        fromCFG_(false){}
+        fromCFG_(false),
+        maxTime_(std::numeric_limits<double>::infinity()),
+        maxDistance_(std::numeric_limits<double>::infinity()) {}
 
         virtual ~Benchmark()
         {
@@ -67,6 +125,13 @@ class Benchmark {
             saveGrid_ = s;
         }
 
+        /** \brief Sets the format of the grids saved (text by default). Grids are written by a background
+            thread (see AsyncGridWriter), so saving them does not delay the runs. */
+        void setGridFormat
+        (GridFormat f) {
+            gridFormat_ = f;
+        }
+
         /** \brief  Sets the environment (grid map) the benchmark will be run on. */
         void setEnvironment
         (grid_t* grid) {
@@ -79,6 +144,20 @@ class Benchmark {
             nruns_ = n;
         }
 
+        /** \brief Sets the number of runs of each solver before the logged ones, to warm up caches and
+            buffers. 0 by default. */
+        void setWarmupRuns
+        (unsigned int n) {
+            nwarmup_ = n;
+        }
+
+        /** \brief Sets the events counted around the compute() of every run, as named by perf (for instance
+            cycles, instructions and LLC-misses, see PerfCounters). None by default. */
+        void setPerfEvents
+        (const std::vector<std::string> & events) {
+            perfEvents_ = events;
+        }
+
         /** \brief  Set the path where results will be saved. */
         void setPath
         (const boost::filesystem::path & path) {
@@ -91,6 +170,27 @@ class Benchmark {
             saveLog_ = s;
         }
 
+        /** \brief Sets the formats of the log saved (see setSaveLog()), a combination of LogFormat: text
+            (LOG_TEXT, by default) in benchmark_name.log, JSON (LOG_JSON) in benchmark_name.json and CSV
+            (LOG_CSV) in benchmark_name.csv. */
+        void setLogFormats
+        (unsigned int formats) {
+            logFormats_ = formats;
+        }
+
+        /** \brief Returns the runs and statistics of the solvers run, in the order they were added. */
+        const std::vector<SolverRecord> & getRecords
+        () const {
+            return records_;
+        }
+
+        /** \brief Sets whether the progress and the summaries are shown in the terminal (true by default).
+            BenchmarkSuite runs its benchmarks without them. */
+        void setVerbose
+        (bool v) {
+            verbose_ = v;
+        }
+
         /** \brief Sets the initial and goal points (indices) for the solvers. */
         void setInitialAndGoalPoints
         (const std::vector<unsigned int> & init_points, unsigned int goal_idx) {
@@ -104,6 +204,14 @@ class Benchmark {
             setInitialAndGoalPoints(init_points, -1);
         }
 
+        /** \brief Sets the maximum arrival time and distance of the solvers (see Solver::setMaxArrivalTime()
+            and Solver::setMaxDistance()). */
+        void setLimits
+        (double maxTime, double maxDistance) {
+            maxTime_ = maxTime;
+            maxDistance_ = maxDistance;
+        }
+
         /** \brief Automatically runs all the solvers. */
         void run
         () {
@@ -115,7 +223,11 @@ class Benchmark {
             else if (saveLog_)
                 boost::filesystem::create_directory(path_);
 
-            boost::progress_display showProgress (solvers_.size()*nruns_);
+            // Before the progress bar, as the events which cannot be counted are warned about.
+            perf_.open(perfEvents_);
+
+            std::ostream quiet(nullptr);
+            boost::progress_display showProgress (solvers_.size()*nruns_, verbose_ ? std::cout : quiet);
 
             configSolvers();
 
@@ -123,11 +235,27 @@ class Benchmark {
 
             for (Solver<grid_t>* s :solvers_)
             {
+                for (unsigned int i = 0; i < nwarmup_; ++i)
+                {
+                    s->reset();
+                    s->compute();
+                }
+                for (std::vector<double> & p : phases_)
+                    p.clear();
+                records_.push_back(SolverRecord());
+                records_.back().name = s->getName();
+                perfRuns_.assign(perfEvents_.size(), std::vector<double>());
                 for (unsigned int i = 0; i < nruns_; ++i)
                 {
                     ++runID_;
+                    MemoryUsage::resetPeakRSS();
+                    const unsigned long long allocations = AllocationCounter::count();
                     s->reset();
+                    perf_.start();
                     s->compute();
+                    perf_.stop();
+                    allocations_ = AllocationCounter::count() - allocations;
+                    peakRSS_ = MemoryUsage::peakRSS();
                     logRun(s);
 
                     if (saveGrid_ == 2)
@@ -137,20 +265,52 @@ class Benchmark {
                 }
                 if (saveGrid_ == 1)
                     saveGrid(s);
-                s->reset();                
+                s->reset();
+                logSummary(s);
             }
-
-            if (saveLog_)
-                saveLog();
-            else {
+            writer_.wait();
+            perf_.close();
+
+            if (saveLog_) {
+                if (logFormats_ & LOG_TEXT)
+                    saveLog();
+                if (logFormats_ & LOG_JSON)
+                    saveJSON();
+                if (logFormats_ & LOG_CSV)
+                    saveCSV();
+            }
+            if (!verbose_)
+                return;
+            if (!saveLog_) {
                 console::info("Benchmark log format:");
                 std::cout << "Name\t#Runs\t#Dims\tDim1...DimN\t#Starts\tStartIdx\tGoalIdx"<<'\n';
-                std::cout << "RunID\tName\tTime (ms)" << '\n';
+                std::cout << "RunID\tName\tTime (ms)\tReset time (ms)\tAllocations\tSetup time (ms)\tVelocities time (ms)"
+                          << "\tSolver memory (B)\tGrid memory (B)\tPeak RSS (B)";
+                for (const std::string & e : perfEvents_)
+                    std::cout << '\t' << e;
+                std::cout << '\n';
                 std::cout << log_.str() << '\n';
             }
+            console::info("Benchmark summary (ms):");
+            std::cout << "Name\tPhase\t#Runs\tMin\tMedian\tMean\tP95\tStddev\t#Outliers" << '\n';
+            std::cout << summary_.str();
+            console::info("Memory of the last run and largest peak RSS of the runs:");
+            std::cout << "Name\tSolver\tGrid\tPeak RSS" << '\n';
+            std::cout << memory_.str();
+            if (OpCounters::enabled()) {
+                console::info("Operation counters of the last run:");
+                std::cout << "Name\tCounter\tValue" << '\n';
+                std::cout << counters_.str();
+            }
+            if (!perfEvents_.empty()) {
+                console::info("Hardware events:");
+                std::cout << "Name\tEvent\t#Runs\tMin\tMedian\tMean\tP95\tStddev\t#Outliers" << '\n';
+                std::cout << perfSummary_.str();
+            }
         }
 
-        /** \brief  Logs the last run of solver s. */
+        /** \brief  Logs the last run of solver s. Allocations are those of its reset() and compute(), nan if
+            they are not counted (see AllocationCounter). */
         void logRun
         (const Solver<grid_t>* s)
         {
@@ -160,20 +320,79 @@ class Benchmark {
             log_ << '\n' << fmtID_;
 
             std::cout.copyfmt(init);
-            log_ << '\t' << s->getName() << "\t" << s->getTime();
+            log_ << std::fixed << std::setprecision(6);
+            log_ << '\t' << s->getName() << "\t" << s->getTime() << "\t" << s->getResetTime() << '\t';
+            if (AllocationCounter::enabled())
+                log_ << allocations_;
+            else
+                log_ << "nan";
+            log_ << '\t' << s->getSetupTime() << '\t' << s->getTimeVelocities();
+            log_ << '\t' << s->memory() << '\t' << s->getGrid()->memory() << '\t' << peakRSS_;
+            peakRSSRuns_.push_back(peakRSS_);
+            const RunRecord r = {runID_, s->getTime(), s->getResetTime(),
+                AllocationCounter::enabled() ? double(allocations_) : std::numeric_limits<double>::quiet_NaN(),
+                s->getSetupTime(), s->getTimeVelocities(), s->memory(), s->getGrid()->memory(), peakRSS_, perf_.getCounts()};
+            records_.back().runs.push_back(r);
+            for (unsigned int i = 0; i < perf_.getCounts().size(); ++i) {
+                const double c = perf_.getCounts()[i];
+                if (std::isnan(c))
+                    log_ << "\tnan";
+                else
+                    log_ << '\t' << (unsigned long long)std::llround(c);
+                perfRuns_[i].push_back(c);
+            }
+
+            phases_[0].push_back(s->getTime());
+            phases_[1].push_back(s->getResetTime());
+            phases_[2].push_back(s->getSetupTime());
+            phases_[3].push_back(s->getTimeVelocities());
         }
 
-        /** \brief Saves the grid values result of the last run of solver s. */
+        /** \brief Logs the statistics of the phases of the runs of solver s, its counters and its events. The
+            velocities map is only logged for the solvers which compute one. */
+        void logSummary
+        (const Solver<grid_t>* s) {
+            static const char * names[] = {"compute", "reset", "setup", "velocities"};
+            summary_ << std::fixed << std::setprecision(6);
+            for (unsigned int p = 0; p < phases_.size(); ++p) {
+                if (p == 3 && std::all_of(phases_[p].begin(), phases_[p].end(), [] (double t) { return t == 0; }))
+                    continue;
+                const RunStatistics st(phases_[p]);
+                records_.back().phases.push_back(std::make_pair(std::string(names[p]), st));
+                summary_ << s->getName() << '\t' << names[p] << '\t' << st.runs << '\t' << st.min << '\t'
+                         << st.median << '\t' << st.mean << '\t' << st.p95 << '\t' << st.stddev << '\t'
+                         << st.outliers << '\n';
+            }
+
+            memory_ << s->getName() << '\t' << MemoryUsage::toString(s->memory()) << '\t'
+                    << MemoryUsage::toString(s->getGrid()->memory()) << '\t'
+                    << MemoryUsage::toString(peakRSSRuns_.empty() ? 0 : *std::max_element(peakRSSRuns_.begin(), peakRSSRuns_.end()))
+                    << '\n';
+            peakRSSRuns_.clear();
+
+            const OpCounters & c = s->getCounters();
+            for (unsigned int i = 0; i < OpCounters::NCOUNTERS; ++i)
+                if (c.get(OpCounters::Counter(i))) {
+                    counters_ << s->getName() << '\t' << OpCounters::name(OpCounters::Counter(i)) << '\t'
+                              << c.get(OpCounters::Counter(i)) << '\n';
+                    records_.back().counters.push_back(std::make_pair(std::string(OpCounters::name(OpCounters::Counter(i))),
+                                                                      c.get(OpCounters::Counter(i))));
+                }
+
+            logPerfSummary(s);
+        }
+
+        /** \brief Queues the grid values result of the last run of solver s to be saved. */
         void saveGrid
-        (Solver<grid_t>* s) const {
+        (Solver<grid_t>* s) {
             thread_local boost::filesystem::path filename;
             if (saveGrid_ == 1)
                 filename = path_ / name_ / s->getName();
             if (saveGrid_ == 2)
                 filename = path_ / name_ / fmtID_;
             
-            filename.replace_extension(".grid");
-            GridWriter::saveGridValues(filename.string().c_str(), *(s->getGrid()));
+            filename.replace_extension(GridWriter::extension(gridFormat_));
+            writer_.saveGridValues(filename.string(), *(s->getGrid()), gridFormat_);
         }
 
         /** \brief Saves the log to a file: benchmark_name.log */
@@ -181,6 +400,99 @@ class Benchmark {
         () const {
             std::ofstream ofs (path_.string() + "/" + name_ + ".log");
             ofs << log_.rdbuf();
+            std::istringstream summary(summary_.str());
+            std::string line;
+            ofs << "\n# Summary (ms): name, phase, #runs, min, median, mean, p95, stddev, #outliers";
+            while (std::getline(summary, line))
+                ofs << "\n# " << line;
+            std::istringstream memory(memory_.str());
+            ofs << "\n# Memory of the last run and largest peak RSS of the runs: name, solver, grid, peak RSS";
+            while (std::getline(memory, line))
+                ofs << "\n# " << line;
+            if (OpCounters::enabled()) {
+                std::istringstream counters(counters_.str());
+                ofs << "\n# Operation counters of the last run: name, counter, value";
+                while (std::getline(counters, line))
+                    ofs << "\n# " << line;
+            }
+            if (!perfEvents_.empty()) {
+                ofs << "\n# Hardware events:";
+                for (unsigned int i = 0; i < perfEvents_.size(); ++i)
+                    ofs << (i ? "," : "\t") << perfEvents_[i];
+                std::istringstream perf(perfSummary_.str());
+                ofs << "\n# Hardware events summary: name, event, #runs, min, median, mean, p95, stddev, #outliers";
+                while (std::getline(perf, line))
+                    ofs << "\n# " << line;
+            }
+            ofs.close();
+        }
+
+        /** \brief Saves the runs and statistics of the solvers as JSON: benchmark_name.json. NaN values (not
+            counted) are null. */
+        void saveJSON
+        () const {
+            std::ofstream ofs (path_.string() + "/" + name_ + ".json");
+            ofs << std::setprecision(std::numeric_limits<double>::digits10);
+            ofs << "{\n  \"name\": " << jsonString(name_) << ",\n  \"runs\": " << nruns_ << ",\n  \"warmup\": " << nwarmup_
+                << ",\n  \"ndims\": " << grid_->getNDims() << ",\n  \"dimsize\": [";
+            for (unsigned int i = 0; i < grid_->getNDims(); ++i)
+                ofs << (i ? ", " : "") << grid_->getDimSizes()[i];
+            ofs << "],\n  \"start\": [";
+            for (unsigned int i = 0; i < init_points_.size(); ++i)
+                ofs << (i ? ", " : "") << init_points_[i];
+            ofs << "],\n  \"goal\": ";
+            if (int(goal_idx_) == -1)
+                ofs << "null";
+            else
+                ofs << goal_idx_;
+            ofs << ",\n  \"events\": [";
+            for (unsigned int i = 0; i < perfEvents_.size(); ++i)
+                ofs << (i ? ", " : "") << jsonString(perfEvents_[i]);
+            ofs << "],\n  \"solvers\": [";
+            for (unsigned int i = 0; i < records_.size(); ++i) {
+                const SolverRecord & s = records_[i];
+                ofs << (i ? "," : "") << "\n    {\n      \"name\": " << jsonString(s.name) << ",\n      \"runs\": [";
+                for (unsigned int j = 0; j < s.runs.size(); ++j) {
+                    const RunRecord & r = s.runs[j];
+                    ofs << (j ? "," : "") << "\n        {\"id\": " << r.id << ", \"time\": " << jsonNumber(r.time)
+                        << ", \"reset_time\": " << jsonNumber(r.resetTime) << ", \"allocations\": " << jsonNumber(r.allocations)
+                        << ", \"setup_time\": " << jsonNumber(r.setupTime) << ", \"velocities_time\": " << jsonNumber(r.velocitiesTime)
+                        << ", \"solver_memory\": " << r.solverMemory << ", \"grid_memory\": " << r.gridMemory
+                        << ", \"peak_rss\": " << r.peakRSS << ", \"events\": [";
+                    for (unsigned int k = 0; k < r.events.size(); ++k)
+                        ofs << (k ? ", " : "") << jsonNumber(r.events[k]);
+                    ofs << "]}";
+                }
+                ofs << "\n      ],\n      \"statistics\": {";
+                jsonStatistics(ofs, s.phases);
+                ofs << "},\n      \"events\": {";
+                jsonStatistics(ofs, s.events);
+                ofs << "},\n      \"counters\": {";
+                for (unsigned int j = 0; j < s.counters.size(); ++j)
+                    ofs << (j ? ", " : "") << jsonString(s.counters[j].first) << ": " << s.counters[j].second;
+                ofs << "}\n    }";
+            }
+            ofs << "\n  ]\n}\n";
+            ofs.close();
+        }
+
+        /** \brief Saves the runs as CSV, a row per run with a header: benchmark_name.csv. */
+        void saveCSV
+        () const {
+            std::ofstream ofs (path_.string() + "/" + name_ + ".csv");
+            ofs << std::setprecision(std::numeric_limits<double>::digits10);
+            ofs << "run_id,solver,time_ms,reset_time_ms,allocations,setup_time_ms,velocities_time_ms,solver_memory,grid_memory,peak_rss";
+            for (const std::string & e : perfEvents_)
+                ofs << ',' << csvString(e);
+            ofs << '\n';
+            for (const SolverRecord & s : records_)
+                for (const RunRecord & r : s.runs) {
+                    ofs << r.id << ',' << csvString(s.name) << ',' << r.time << ',' << r.resetTime << ',' << r.allocations << ','
+                        << r.setupTime << ',' << r.velocitiesTime << ',' << r.solverMemory << ',' << r.gridMemory << ',' << r.peakRSS;
+                    for (double e : r.events)
+                        ofs << ',' << e;
+                    ofs << '\n';
+                }
             ofs.close();
         }
 
@@ -227,7 +539,105 @@ class Benchmark {
             {
                 s->setEnvironment(grid_);
                 s->setInitialAndGoalPoints(init_points_, goal_idx_);
+                s->setMaxArrivalTime(maxTime_);
+                s->setMaxDistance(maxDistance_);
+            }
+        }
+
+        /** \brief Logs the statistics of the events of the runs of solver s. Runs in which an event was not
+            counted are left out of its statistics, and events never counted are not logged. The instructions per cycle (ipc) and the bandwidth of the
+            LLC misses (llc-miss-GB/s, 64 bytes per miss over the time of compute()) are added if their events
+            are counted. */
+        void logPerfSummary
+        (const Solver<grid_t>* s) {
+            std::vector<std::string> names(perfEvents_);
+            std::vector<std::vector<double> > runs(perfRuns_);
+            const auto find = [this] (const std::string & e) {
+                return std::find(perfEvents_.begin(), perfEvents_.end(), e) - perfEvents_.begin();
+            };
+            const size_t cycles = find("cycles"), instructions = find("instructions");
+            if (cycles < perfEvents_.size() && instructions < perfEvents_.size()) {
+                names.push_back("ipc");
+                runs.push_back(std::vector<double>());
+                for (unsigned int r = 0; r < perfRuns_[cycles].size(); ++r)
+                    runs.back().push_back(perfRuns_[instructions][r]/perfRuns_[cycles][r]);
+            }
+            size_t llc = find("LLC-misses");
+            if (llc == perfEvents_.size())
+                llc = find("LLC-load-misses");
+            if (llc < perfEvents_.size()) {
+                names.push_back("llc-miss-GB/s");
+                runs.push_back(std::vector<double>());
+                for (unsigned int r = 0; r < perfRuns_[llc].size(); ++r)
+                    runs.back().push_back(perfRuns_[llc][r]*64/(phases_[0][r]*1e6));
+            }
+
+            perfSummary_ << std::fixed << std::setprecision(6);
+            for (unsigned int i = 0; i < names.size(); ++i) {
+                std::vector<double> counted;
+                for (double c : runs[i])
+                    if (!std::isnan(c))
+                        counted.push_back(c);
+                if (counted.empty())
+                    continue;
+                const RunStatistics st(counted);
+                records_.back().events.push_back(std::make_pair(names[i], st));
+                perfSummary_ << s->getName() << '\t' << names[i] << '\t' << st.runs << '\t' << st.min << '\t'
+                             << st.median << '\t' << st.mean << '\t' << st.p95 << '\t' << st.stddev << '\t'
+                             << st.outliers << '\n';
+            }
+        }
+
+        /** \brief Returns s as a JSON string, quoted and escaped. */
+        static std::string jsonString
+        (const std::string & s) {
+            std::ostringstream oss;
+            oss << '"';
+            for (char c : s) {
+                if (c == '"' || c == '\\')
+                    oss << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20)
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+                else
+                    oss << c;
+            }
+            oss << '"';
+            return oss.str();
+        }
+
+        /** \brief Returns x as a JSON number, null if it is not finite. */
+        static std::string jsonNumber
+        (double x) {
+            if (!std::isfinite(x))
+                return "null";
+            std::ostringstream oss;
+            oss << std::setprecision(std::numeric_limits<double>::digits10) << x;
+            return oss.str();
+        }
+
+        /** \brief Writes the statistics as the members of a JSON object. */
+        static void jsonStatistics
+        (std::ostream & os, const std::vector<std::pair<std::string, RunStatistics> > & stats) {
+            for (unsigned int i = 0; i < stats.size(); ++i) {
+                const RunStatistics & st = stats[i].second;
+                os << (i ? ", " : "") << "\n        " << jsonString(stats[i].first) << ": {\"runs\": " << st.runs
+                   << ", \"min\": " << jsonNumber(st.min) << ", \"median\": " << jsonNumber(st.median) << ", \"mean\": "
+                   << jsonNumber(st.mean) << ", \"p95\": " << jsonNumber(st.p95) << ", \"stddev\": " << jsonNumber(st.stddev)
+                   << ", \"outliers\": " << st.outliers << "}";
             }
+            if (!stats.empty())
+                os << "\n      ";
+        }
+
+        /** \brief Returns s as a CSV field, quoted if it has commas or quotes. */
+        static std::string csvString
+        (const std::string & s) {
+            if (s.find_first_of(",\"\n") == std::string::npos)
+                return s;
+            std::string q("\"");
+            for (char c : s)
+                q += (c == '"') ? std::string("\"\"") : std::string(1, c);
+            return q + "\"";
         }
 
         /** \brief Formats as a string the run ID. */
@@ -261,10 +671,22 @@ class Benchmark {
         /** \brief If 1, the resulting grids (times) of the first run of each solver are saved to files.
              If 2, the grids for all runs of each solver are saved. */
         unsigned int                                        saveGrid_;
+
+        /** \brief Format of the grids saved. */
+        GridFormat                                          gridFormat_;
+
+        /** \brief Writes the grids saved in the background. */
+        AsyncGridWriter                                     writer_;
         
         /** \brief  If true, the log is saved to file. Output on terminal otherwise. */
         bool                                                saveLog_;
 
+        /** \brief Formats of the log saved, a combination of LogFormat. */
+        unsigned int                                        logFormats_;
+
+        /** \brief If false, nothing is shown in the terminal. */
+        bool                                                verbose_;
+
         /** \brief ID of the current run. */
         unsigned int                                        runID_;
         
@@ -274,6 +696,46 @@ class Benchmark {
         /** \brief Number of runs for each solver. */
         unsigned int                                        nruns_;
 
+        /** \brief Number of warmup runs for each solver. */
+        unsigned int                                        nwarmup_;
+
+        /** \brief Times of the phases of the runs of the current solver: compute, reset, setup and
+            velocities map. */
+        std::array<std::vector<double>, 4>                  phases_;
+
+        /** \brief Statistics of the solvers run, a line per solver and phase. */
+        std::stringstream                                   summary_;
+
+        /** \brief Runs and statistics of the solvers run. */
+        std::vector<SolverRecord>                           records_;
+
+        /** \brief Operation counters of the last run of the solvers, a line per solver and counter. */
+        std::stringstream                                   counters_;
+
+        /** \brief Events counted around the compute() of every run. */
+        std::vector<std::string>                            perfEvents_;
+
+        /** \brief Counters of the events. */
+        PerfCounters                                        perf_;
+
+        /** \brief Counts of the events of the runs of the current solver, a vector per event. */
+        std::vector<std::vector<double> >                   perfRuns_;
+
+        /** \brief Statistics of the events of the solvers run, a line per solver and event. */
+        std::stringstream                                   perfSummary_;
+
+        /** \brief Memory of the solvers run, a line per solver. */
+        std::stringstream                                   memory_;
+
+        /** \brief Peak resident memory of the last run. */
+        size_t                                              peakRSS_;
+
+        /** \brief Peak resident memory of the runs of the current solver. */
+        std::vector<size_t>                                 peakRSSRuns_;
+
+        /** \brief Heap allocations of the last run. */
+        unsigned long long                                  allocations_;
+
         /** \brief Path were the results will be saved. */
         boost::filesystem::path                             path_;
         
@@ -282,6 +744,12 @@ class Benchmark {
 
         /** \brief If true, benchmark configured from CFG file, used to selectively free memory. */
         bool                                                fromCFG_;
+
+        /** \brief Maximum arrival time of the solvers. */
+        double                                              maxTime_;
+
+        /** \brief Maximum distance to the start of the solvers. */
+        double                                              maxDistance_;
 };
 
 #endif /* BENCHMARK_HPP_*/
@@ -23,6 +23,7 @@
 
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/trim.hpp>
 
 #include <fast_methods/benchmark/benchmark.hpp>
 #include <fast_methods/io/maploader.hpp>
@@ -30,13 +31,22 @@
 #include <fast_methods/fm/fmm.hpp>
 #include <fast_methods/fm/sfmm.hpp>
 #include <fast_methods/fm/fmmstar.hpp>
+#include <fast_methods/fm/pfmm.hpp>
+#include <fast_methods/fm/bfmm.hpp>
 #include <fast_methods/fm/sfmmstar.hpp>
 #include <fast_methods/fm/fim.hpp>
+#include <fast_methods/fm/bfim.hpp>
+#include <fast_methods/fm/gpufim.hpp>
 #include <fast_methods/fm/gmm.hpp>
 #include <fast_methods/fm/ufmm.hpp>
 #include <fast_methods/fm/fsm.hpp>
+#include <fast_methods/fm/gpufsm.hpp>
+#include <fast_methods/fm/vfsm.hpp>
 #include <fast_methods/fm/lsm.hpp>
 #include <fast_methods/fm/ddqm.hpp>
+#include <fast_methods/fm/hierarchical.hpp>
+#include <fast_methods/fm2/fm2.hpp>
+#include <fast_methods/fm2/fm2star.hpp>
 
 /// \todo the getter functions do not check if the types are admissible.
 /// \todo does not have support for multiple starts or goals.
@@ -56,14 +66,19 @@ class BenchmarkCFG {
             readOptions(filename);
         }
 
+        /** \brief Returns the names of the solvers which can be given in the solvers section of CFG files. */
+        static const std::vector<std::string> & knownSolvers
+        () {
+            static const std::vector<std::string> solvers = {
+                "fmm", "fmmstar", "fmmdary", "fmmdarystar", "fmmfib", "fmmfibstar", "fmmradix", "fmmhash", "fmmhashstar", "pfmm", "bfmm", "sfmm", "sfmmstar",
+                "gmm", "fim", "bfim", "gpufim", "ufmm", "fsm", "gpufsm", "vfsm", "lsm", "ddqm", "hfmm", "hfm2", "hfm2star" // Add solver here.
+            };
+            return solvers;
+        }
+
         /** \brief Parses the CFG file given. */
         bool readOptions(const char * filename)
         {
-            static const std::vector<std::string> knownSolvers = {
-                "fmm", "fmmstar", "fmmfib", "fmmfibstar", "sfmm", "sfmmstar",
-                "gmm", "fim", "ufmm", "fsm", "lsm", "ddqm" // Add solver here.
-            };
-
             std::fstream cfg(filename);
             if (!cfg.good())
             {
@@ -81,15 +96,25 @@ class BenchmarkCFG {
             desc.add_options()
                 ("grid.file",          boost::program_options::value<std::string>(),                             "Path to load a velocities map from image.")
                 ("grid.text",          boost::program_options::value<std::string>(),                             "Path to load a velocities map from a .grid file.")
+                ("grid.binary",        boost::program_options::value<std::string>(),                             "Path to load a velocities map from a binary .fmgrid file.")
+                ("grid.slices",        boost::program_options::value<std::string>(),                             "Comma-separated paths of the images of the slices of a 3D velocities map, by increasing z.")
                 ("grid.ndims",         boost::program_options::value<std::string>()->default_value("2"),         "Number of dimensions.")
-                ("grid.cell",          boost::program_options::value<std::string>()->default_value("FMCell"),    "Type of cell. FMCell by default.")
+                ("grid.cell",          boost::program_options::value<std::string>()->default_value("FMCell"),    "Type of cell: FMCell (default), FMCellSoA or FMCellSparse (3D).")
+                ("grid.precision",     boost::program_options::value<std::string>()->default_value("double"),    "Precision of the cell values: double (default) or float.")
+                ("grid.bricksize",     boost::program_options::value<std::string>()->default_value("0"),         "Size of the bricks of 3D+ grids: 1 (row-major order) or a power of 2. Default layout if 0.")
                 ("grid.dimsize",       boost::program_options::value<std::string>()->default_value("200,200"),   "Size of dimensions: N,M,O...")
                 ("grid.leafsize",      boost::program_options::value<std::string>()->default_value("1"),         "Leafsize (assuming cubic cells).")
                 ("problem.start",      boost::program_options::value<std::string>()->required(),                 "Start point: s1,s2,s3...")
                 ("problem.goal",       boost::program_options::value<std::string>()->default_value("nan"),       "Goal point: g1,g2,g3... By default no goal point.")
+                ("problem.maxtime",    boost::program_options::value<std::string>()->default_value("inf"),       "Maximum arrival time computed. By default no limit.")
+                ("problem.maxdistance", boost::program_options::value<std::string>()->default_value("inf"),      "Maximum distance to the start computed (in leafsize units). By default no limit.")
                 ("benchmark.name",     boost::program_options::value<std::string>()->default_value(name.string()), "Name of the benchmark.")
                 ("benchmark.runs",     boost::program_options::value<std::string>()->default_value("10"),        "Number of runs per solver.")
-                ("benchmark.savegrid", boost::program_options::value<std::string>()->default_value("0"),         "Save grid values of each run.");
+                ("benchmark.warmup",   boost::program_options::value<std::string>()->default_value("0"),         "Number of warmup runs per solver, not logged.")
+                ("benchmark.savegrid", boost::program_options::value<std::string>()->default_value("0"),         "Save grid values of each run.")
+                ("benchmark.gridformat", boost::program_options::value<std::string>()->default_value("text"),    "Format of the grids saved: text (default), binary or compressed.")
+                ("benchmark.format",   boost::program_options::value<std::string>()->default_value("text"),      "Comma-separated formats of the log: text (default), json and csv.")
+                ("benchmark.perf",     boost::program_options::value<std::string>()->default_value(""),          "Comma-separated events counted around each run (Linux), as named by perf: cycles,instructions,LLC-misses... None by default.");
 
             boost::program_options::variables_map vm;
             boost::program_options::parsed_options po = boost::program_options::parse_config_file(cfg, desc, true);
@@ -113,9 +138,9 @@ class BenchmarkCFG {
                     std::string solver = key.substr(8);
                     // If it is a known solver, save it together with its constructor
                     // parameters (if given).
-                    for (std::size_t i = 0; i < knownSolvers.size(); ++i)
-                        if (solver == knownSolvers[i]) {
-                            solverNames_.push_back(knownSolvers[i]);
+                    for (std::size_t i = 0; i < knownSolvers().size(); ++i)
+                        if (solver == knownSolvers()[i]) {
+                            solverNames_.push_back(knownSolvers()[i]);
                             ctorParams_.push_back(val);
                         }
                 }
@@ -128,152 +153,66 @@ class BenchmarkCFG {
         void configure
         (Benchmark<grid_t> & b) {
             b.setSaveLog(true);
+            unsigned int formats = 0;
+            for (std::string f : split(getValue<std::string>("benchmark.format"))) {
+                boost::trim(f);
+                if (f == "text")
+                    formats |= LOG_TEXT;
+                else if (f == "json")
+                    formats |= LOG_JSON;
+                else if (f == "csv")
+                    formats |= LOG_CSV;
+                else if (!f.empty())
+                    console::warning("Unknown log format " + f + ", use text, json or csv.");
+            }
+            b.setLogFormats(formats ? formats : unsigned(LOG_TEXT));
             b.setName(getValue<std::string>("benchmark.name"));
             b.setSaveGrid(getValue<unsigned int>("benchmark.savegrid"));
+            const std::string format = getValue<std::string>("benchmark.gridformat");
+            if (format == "binary")
+                b.setGridFormat(GRID_BINARY);
+            else if (format == "compressed")
+                b.setGridFormat(GRID_COMPRESSED);
+            else if (format != "text")
+                console::warning("Unknown grid format " + format + ", saving text grids.");
             b.setNRuns(getValue<unsigned int>("benchmark.runs"));
+            b.setWarmupRuns(getValue<unsigned int>("benchmark.warmup"));
+            std::vector<std::string> events(split(getValue<std::string>("benchmark.perf")));
+            for (std::string & e : events)
+                boost::trim(e);
+            events.erase(std::remove(events.begin(), events.end(), std::string()), events.end());
+            b.setPerfEvents(events);
+            b.setLimits(getValue<double>("problem.maxtime"), getValue<double>("problem.maxdistance"));
             b.setPath(boost::filesystem::path("results"));
             b.fromCFG(true);
 
             for (size_t i = 0; i < solverNames_.size(); ++i)
             {
-                const std::string & name = solverNames_[i];
-
-                bool defaultCtor = true;
-                if (!ctorParams_[i].empty())
-                    defaultCtor = false;
-
-                Solver<grid_t> * solver;
-
-                if (defaultCtor) {
-                    if (name == "fmm")
-                        solver = new FMM<grid_t>();
-                    else if (name == "fmmstar")
-                        solver = new FMMStar<grid_t>();
-                    else if (name == "fmmfib")
-                        solver = new FMM<grid_t, FMFibHeap<cell_t> >("FMMFib");
-                    else if (name == "fmmfibstar")
-                        solver = new FMMStar<grid_t,  FMFibHeap<cell_t> >("FMMFib*");
-                    else if (name == "sfmm")
-                        solver = new SFMM<grid_t>("SFMM");
-                    else if (name == "sfmmstar")
-                        solver = new SFMMStar<grid_t>("SFMM*");
-                    else if (name == "gmm")
-                        solver = new GMM<grid_t>();
-                    else if (name == "fim")
-                        solver = new FIM<grid_t>();
-                    else if (name == "ufmm")
-                        solver = new UFMM<grid_t>();
-                    else if (name == "fsm")
-                        solver = new FSM<grid_t>();
-                    else if (name == "lsm")
-                        solver = new LSM<grid_t>();
-                    else if (name == "ddqm")
-                        solver = new DDQM<grid_t>();
-                    // Add solver here.
-
-                    else
-                        continue;
-                }
-                else { // Create solvers with specified constructor parameters.
-                    std::vector<std::string> p(split(ctorParams_[i]));
-
-                    // FMM and FMM*
-                    if (name == "fmm")
-                        solver = new FMM<grid_t>(ctorParams_[i].c_str());
-                    else if (name == "fmmstar") {
-                        if (p.size() == 1)
-                            solver = new FMMStar<grid_t>(p[0].c_str());
-                        else if (p.size() == 2) {
-                            if (p[1] == "TIME")
-                                solver = new FMMStar<grid_t>(p[0].c_str(), TIME);
-                            else if (p[1] == "DISTANCE")
-                                solver = new FMMStar<grid_t>(p[0].c_str(), DISTANCE);
-                        }
-                    }
-                    // FMMFib and FMMFib*
-                    else if (name == "fmmfib")
-                        solver = new FMM<grid_t, FMFibHeap<cell_t> >(ctorParams_[i].c_str());
-                    else if (name == "fmmfibstar") {
-                        if (p.size() == 1)
-                            solver = new FMMStar<grid_t, FMFibHeap<cell_t>>(p[0].c_str());
-                        else if (p.size() == 2) {
-                            if (p[1] == "TIME")
-                                solver = new FMMStar<grid_t, FMFibHeap<cell_t>>(p[0].c_str(), TIME);
-                            else if (p[1] == "DISTANCE")
-                                solver = new FMMStar<grid_t, FMFibHeap<cell_t>>(p[0].c_str(), DISTANCE);
-                        }
-                    }
-                    // SFMM and SFMM*
-                    else if (name == "sfmm")
-                        solver = new SFMM<grid_t, cell_t>(ctorParams_[i].c_str());
-                    else if (name == "sfmmstar") {
-                        if (p.size() == 1)
-                            solver = new SFMMStar<grid_t, cell_t>(p[0].c_str());
-                        else if (p.size() == 2) {
-                            if (p[1] == "TIME")
-                                solver = new SFMMStar<grid_t, cell_t>(p[0].c_str(), TIME);
-                            else if (p[1] == "DISTANCE")
-                                solver = new SFMMStar<grid_t, cell_t>(p[0].c_str(), DISTANCE);
-                        }
-                    }
-                    // GMM
-                    else if (name == "gmm") {
-                        if (p.size() == 1)
-                            solver = new GMM<grid_t>(p[0].c_str());
-                        else if (p.size() == 2)
-                            solver = new GMM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
-                    }
-                    // FIM
-                    else if (name == "fim") {
-                        if (p.size() == 1)
-                            solver = new FIM<grid_t>(p[0].c_str());
-                        else if (p.size() == 2)
-                            solver = new FIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
-                    }
-                    // UFMM
-                    else if (name == "ufmm") {
-                        if (p.size() == 1)
-                            solver = new UFMM<grid_t>(p[0].c_str());
-                        else if (p.size() == 2)
-                            solver = new UFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
-                        else if (p.size() == 3)
-                            solver = new UFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<double>(p[2]));
-                    }
-                    // FSM
-                    else if (name == "fsm") {
-                        if (p.size() == 1)
-                            solver = new FSM<grid_t>(p[0].c_str());
-                        else if (p.size() == 2)
-                            solver = new FSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
-                    }
-                    // LSM
-                    else if (name == "lsm") {
-                        if (p.size() == 1)
-                            solver = new LSM<grid_t>(p[0].c_str());
-                        else if (p.size() == 2)
-                            solver = new LSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
-                    }
-                    // DDQM
-                    else if (name == "ddqm") {
-                        solver = new LSM<grid_t>(p[0].c_str());
-                    }
-                    // Add solver here.
-
-                    else
-                        continue;
+                Solver<grid_t> * solver = createSolver<grid_t, cell_t>(solverNames_[i], ctorParams_[i]);
+                if (!solver) {
+                    console::warning("Wrong number of parameters for solver " + ctorParams_[i] + ". Skipping it.");
+                    continue;
                 }
-
                 b.addSolver(solver);
             }
 
             constexpr size_t N = grid_t::getNDims();
             grid_t * grid = new grid_t();
+            grid->setBrickSize(getValue<unsigned int>("grid.bricksize"));
             if (options_.find("grid.file") != options_.end())
                 MapLoader::loadMapFromImg(options_.find("grid.file")->second.c_str(), *grid);
             else if (options_.find("grid.text") != options_.end()) {
                 if(!MapLoader::loadMapFromText(options_.find("grid.text")->second.c_str(), *grid))
                     exit(1);
             }
+            else if (options_.find("grid.binary") != options_.end()) {
+                if(!MapLoader::loadMapFromBinary(options_.find("grid.binary")->second.c_str(), *grid))
+                    exit(1);
+            }
+            else if (options_.find("grid.slices") != options_.end()) {
+                if(!MapLoader::loadMapFromImageStack(split(options_.find("grid.slices")->second), *grid))
+                    exit(1);
+            }
             else {
                 const std::string & strToSplit = options_.find("grid.dimsize")->second;
                 std::array<unsigned int, N> dimSize = splitAndCast<unsigned int, N>(strToSplit);
@@ -303,6 +242,275 @@ class BenchmarkCFG {
             b.setEnvironment(grid);
         }
 
+        /** \brief Creates the solver named as in the solvers section of CFG files (for instance fmmdary), with
+            the constructor parameters given (comma-separated, the name of the solver first) or with the
+            default constructor if they are empty. Returns nullptr if the name is unknown or the number of
+            parameters is wrong. */
+        template <class grid_t, class cell_t>
+        static Solver<grid_t> * createSolver
+        (const std::string & name, const std::string & params) {
+            bool defaultCtor = true;
+            if (!params.empty())
+                defaultCtor = false;
+
+            Solver<grid_t> * solver = nullptr;
+
+            if (defaultCtor) {
+                if (name == "fmm")
+                    solver = new FMM<grid_t>();
+                else if (name == "fmmstar")
+                    solver = new FMMStar<grid_t>();
+                else if (name == "fmmdary")
+                    solver = new FMM<grid_t, FMDaryHeap<cell_t> >("FMMDary");
+                else if (name == "fmmdarystar")
+                    solver = new FMMStar<grid_t, FMDaryHeap<cell_t> >("FMMDary*");
+                else if (name == "fmmfib")
+                    solver = new FMM<grid_t, FMFibHeap<cell_t> >("FMMFib");
+                else if (name == "fmmfibstar")
+                    solver = new FMMStar<grid_t,  FMFibHeap<cell_t> >("FMMFib*");
+                else if (name == "fmmradix")
+                    solver = new FMM<grid_t, FMRadixHeap<cell_t> >("FMMRadix");
+                else if (name == "fmmhash")
+                    solver = new FMM<grid_t, FMHashHeap<cell_t> >("FMMHash");
+                else if (name == "fmmhashstar")
+                    solver = new FMMStar<grid_t, FMHashHeap<cell_t> >("FMMHash*");
+                else if (name == "pfmm")
+                    solver = new PFMM<grid_t>();
+                else if (name == "bfmm")
+                    solver = new BFMM<grid_t>();
+                else if (name == "sfmm")
+                    solver = new SFMM<grid_t>("SFMM");
+                else if (name == "sfmmstar")
+                    solver = new SFMMStar<grid_t>("SFMM*");
+                else if (name == "gmm")
+                    solver = new GMM<grid_t>();
+                else if (name == "fim")
+                    solver = new FIM<grid_t>();
+                else if (name == "bfim")
+                    solver = new BFIM<grid_t>();
+                else if (name == "gpufim")
+                    solver = new GPUFIM<grid_t>();
+                else if (name == "ufmm")
+                    solver = new UFMM<grid_t>();
+                else if (name == "fsm")
+                    solver = new FSM<grid_t>();
+                else if (name == "gpufsm")
+                    solver = new GPUFSM<grid_t>();
+                else if (name == "vfsm")
+                    solver = new VFSM<grid_t>();
+                else if (name == "lsm")
+                    solver = new LSM<grid_t>();
+                else if (name == "ddqm")
+                    solver = new DDQM<grid_t>();
+                else if (name == "hfmm")
+                    solver = new Hierarchical<grid_t>();
+                else if (name == "hfm2")
+                    solver = new Hierarchical<grid_t, FM2<grid_t> >();
+                else if (name == "hfm2star")
+                    solver = new Hierarchical<grid_t, FM2Star<grid_t> >();
+                // Add solver here.
+
+                else
+                    return nullptr;
+            }
+            else { // Create solvers with specified constructor parameters.
+                std::vector<std::string> p(split(params));
+                HeurStrategy h = NOHEUR;
+
+                // FMM and FMM*
+                if (name == "fmm")
+                    solver = new FMM<grid_t>(params.c_str());
+                else if (name == "fmmstar") {
+                    if (p.size() == 1)
+                        solver = new FMMStar<grid_t>(p[0].c_str());
+                    else if (p.size() == 2 && parseHeuristic(p[1], h))
+                        solver = new FMMStar<grid_t>(p[0].c_str(), h);
+                }
+                // FMMDary and FMMDary*
+                else if (name == "fmmdary")
+                    solver = new FMM<grid_t, FMDaryHeap<cell_t> >(params.c_str());
+                else if (name == "fmmdarystar") {
+                    if (p.size() == 1)
+                        solver = new FMMStar<grid_t, FMDaryHeap<cell_t>>(p[0].c_str());
+                    else if (p.size() == 2 && parseHeuristic(p[1], h))
+                        solver = new FMMStar<grid_t, FMDaryHeap<cell_t>>(p[0].c_str(), h);
+                }
+                // FMMFib and FMMFib*
+                else if (name == "fmmfib")
+                    solver = new FMM<grid_t, FMFibHeap<cell_t> >(params.c_str());
+                else if (name == "fmmfibstar") {
+                    if (p.size() == 1)
+                        solver = new FMMStar<grid_t, FMFibHeap<cell_t>>(p[0].c_str());
+                    else if (p.size() == 2 && parseHeuristic(p[1], h))
+                        solver = new FMMStar<grid_t, FMFibHeap<cell_t>>(p[0].c_str(), h);
+                }
+                // FMMRadix
+                else if (name == "fmmradix")
+                    solver = new FMM<grid_t, FMRadixHeap<cell_t> >(params.c_str());
+                // FMMHash and FMMHash*
+                else if (name == "fmmhash")
+                    solver = new FMM<grid_t, FMHashHeap<cell_t> >(params.c_str());
+                else if (name == "fmmhashstar") {
+                    if (p.size() == 1)
+                        solver = new FMMStar<grid_t, FMHashHeap<cell_t>>(p[0].c_str());
+                    else if (p.size() == 2 && parseHeuristic(p[1], h))
+                        solver = new FMMStar<grid_t, FMHashHeap<cell_t>>(p[0].c_str(), h);
+                }
+                // PFMM
+                else if (name == "pfmm") {
+                    if (p.size() == 1)
+                        solver = new PFMM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new PFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new PFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                    else if (p.size() == 4)
+                        solver = new PFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]), boost::lexical_cast<double>(p[3]));
+                }
+                // BFMM
+                else if (name == "bfmm")
+                    solver = new BFMM<grid_t>(p[0].c_str());
+                // SFMM and SFMM*
+                else if (name == "sfmm")
+                    solver = new SFMM<grid_t, cell_t>(params.c_str());
+                else if (name == "sfmmstar") {
+                    if (p.size() == 1)
+                        solver = new SFMMStar<grid_t, cell_t>(p[0].c_str());
+                    else if (p.size() == 2 && parseHeuristic(p[1], h))
+                        solver = new SFMMStar<grid_t, cell_t>(p[0].c_str(), h);
+                }
+                // GMM
+                else if (name == "gmm") {
+                    if (p.size() == 1)
+                        solver = new GMM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new GMM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new GMM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                }
+                // FIM
+                else if (name == "fim") {
+                    if (p.size() == 1)
+                        solver = new FIM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new FIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
+                }
+                // BFIM
+                else if (name == "bfim") {
+                    if (p.size() == 1)
+                        solver = new BFIM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new BFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new BFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                    else if (p.size() == 4)
+                        solver = new BFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]), boost::lexical_cast<unsigned>(p[2]), boost::lexical_cast<unsigned>(p[3]));
+                }
+                // GPUFIM
+                else if (name == "gpufim") {
+                    if (p.size() == 1)
+                        solver = new GPUFIM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new GPUFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new GPUFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                    else if (p.size() == 4)
+                        solver = new GPUFIM<grid_t>(p[0].c_str(), boost::lexical_cast<double>(p[1]), boost::lexical_cast<unsigned>(p[2]), boost::lexical_cast<unsigned>(p[3]));
+                }
+                // UFMM
+                else if (name == "ufmm") {
+                    if (p.size() == 1)
+                        solver = new UFMM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new UFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new UFMM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<double>(p[2]));
+                }
+                // FSM
+                else if (name == "fsm") {
+                    if (p.size() == 1)
+                        solver = new FSM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new FSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new FSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                }
+                // GPUFSM
+                else if (name == "gpufsm") {
+                    if (p.size() == 1)
+                        solver = new GPUFSM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new GPUFSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new GPUFSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                }
+                // VFSM
+                else if (name == "vfsm") {
+                    if (p.size() == 1)
+                        solver = new VFSM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new VFSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                }
+                // LSM
+                else if (name == "lsm") {
+                    if (p.size() == 1)
+                        solver = new LSM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new LSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new LSM<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                }
+                // DDQM
+                else if (name == "ddqm") {
+                    if (p.size() == 1)
+                        solver = new DDQM<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new DDQM<grid_t>(p[0].c_str(), boost::lexical_cast<bool>(p[1]));
+                }
+                // Hierarchical FMM, FM2 and FM2*
+                else if (name == "hfmm") {
+                    if (p.size() == 1)
+                        solver = new Hierarchical<grid_t>(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new Hierarchical<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new Hierarchical<grid_t>(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                }
+                else if (name == "hfm2") {
+                    if (p.size() == 1)
+                        solver = new Hierarchical<grid_t, FM2<grid_t> >(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new Hierarchical<grid_t, FM2<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new Hierarchical<grid_t, FM2<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                    else if (p.size() == 4)
+                        solver = new Hierarchical<grid_t, FM2<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]), boost::lexical_cast<double>(p[3]));
+                }
+                else if (name == "hfm2star") {
+                    if (p.size() == 1)
+                        solver = new Hierarchical<grid_t, FM2Star<grid_t> >(p[0].c_str());
+                    else if (p.size() == 2)
+                        solver = new Hierarchical<grid_t, FM2Star<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]));
+                    else if (p.size() == 3)
+                        solver = new Hierarchical<grid_t, FM2Star<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]));
+                    else if (p.size() == 4 && parseHeuristic(p[3], h))
+                        solver = new Hierarchical<grid_t, FM2Star<grid_t> >(p[0].c_str(), boost::lexical_cast<unsigned>(p[1]), boost::lexical_cast<unsigned>(p[2]), h);
+                }
+                // Add solver here.
+
+                else
+                    return nullptr;
+            }
+
+            return solver;
+        }
+
+        /** \brief Sets the value of a key (option), as if it was given in the CFG file. */
+        void setValue
+        (const std::string & key, const std::string & value) {
+            options_[key] = value;
+        }
+
         /** \brief Get the value for a given key (option). */
         template<typename T>
         T getValue
@@ -314,6 +522,17 @@ class BenchmarkCFG {
                 return boost::lexical_cast<T>(0);
         }
 
+        /** \brief From a string of format XXX,YY,ZZZ,... splis the elements (comma-separated) as a vector of strings. */
+        static std::vector<std::string> split
+        (const std::string & s) {
+            std::vector<std::string> elems;
+            std::stringstream ss(s);
+            std::string item;
+            while (std::getline(ss, item, ','))
+                elems.push_back(item);
+            return elems;
+        }
+
     private:
         // Based on http://stackoverflow.com/a/236803/2283531
         /** \brief From a string of format XXX,YY,ZZZ,... splis the N elements and cast as type T (comma-separated) as an array. */
@@ -332,19 +551,16 @@ class BenchmarkCFG {
             return elems;
         }
 
-        /** \brief From a string of format XXX,YY,ZZZ,... splis the elements (comma-separated) as a vector of strings. */
-        std::vector<std::string> split
-        (const std::string & s) {
-            std::vector<std::string> elems;
-            std::stringstream ss(s);
-            std::string item;
-            size_t pos = 1, str_size = s.length()-1;
-            while (pos < str_size) {
-                std::getline(ss, item, ',');
-                elems.push_back(item);
-                pos += item.length();
-            }
-            return elems;
+        /** \brief Sets h to the heuristic strategy named s (TIME, DISTANCE, OCTILE or MAXSPEED). Returns false if unknown. */
+        static bool parseHeuristic
+        (const std::string & s, HeurStrategy & h) {
+            static const std::unordered_map<std::string, HeurStrategy> heuristics = {
+                {"TIME", TIME}, {"DISTANCE", DISTANCE}, {"OCTILE", OCTILE}, {"MAXSPEED", MAXSPEED}};
+            const auto it = heuristics.find(s);
+            if (it == heuristics.end())
+                return false;
+            h = it->second;
+            return true;
         }
 
         /** \brief Stores the names of the parsed solvers. */
@@ -0,0 +1,216 @@
+/*! \class BenchmarkComparison
+    \brief Compares the compute() times of the solvers of two JSON benchmark logs (see
+    Benchmark::setLogFormats()), a baseline and the current one, to detect performance regressions,
+    for instance when upgrading the library (fm_benchmark --compare).
+
+    Solvers are matched by name. The speedup of a solver is the median time of the baseline over
+    the median time of the current log (larger than 1 if it is faster now), and its confidence
+    interval is obtained by bootstrapping: both sets of runs are resampled with replacement and
+    the percentiles of the speedups of the resamples are taken. A solver regressed if the whole
+    interval is below 1/(1 + threshold), that is, if it is slower than the threshold allows with
+    the confidence given, so that the noise of a few runs does not fail a build. The more runs
+    the logs have, the narrower the intervals.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKCOMPARISON_HPP_
+#define BENCHMARKCOMPARISON_HPP_
+
+#include <string>
+#include <vector>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <fast_methods/console/console.h>
+#include <fast_methods/benchmark/runstatistics.hpp>
+
+class BenchmarkComparison {
+
+    public:
+        /** \brief Comparison of a solver. */
+        struct Result {
+            std::string     name;
+            /** \brief Runs of the solver in the baseline and in the current log (0 if it is not in it). */
+            unsigned int    baselineRuns;
+            unsigned int    currentRuns;
+            /** \brief Median times (ms). */
+            double          baselineMedian;
+            double          currentMedian;
+            /** \brief Speedup of the current log and its confidence interval. */
+            double          speedup;
+            double          low;
+            double          high;
+            bool            regression;
+        };
+
+        /** \brief threshold is the slowdown allowed (0.05 for 5%), confidence that of the intervals. */
+        BenchmarkComparison
+        (double threshold = 0.05, double confidence = 0.95, unsigned int resamples = 10000) :
+            threshold_(threshold), confidence_(confidence), resamples_(resamples) {}
+
+        /** \brief Sets the slowdown allowed (0.05 for 5%). */
+        void setThreshold
+        (double threshold) {
+            threshold_ = threshold;
+        }
+
+        /** \brief Sets the confidence of the intervals (0.95 by default). */
+        void setConfidence
+        (double confidence) {
+            confidence_ = confidence;
+        }
+
+        /** \brief Compares the JSON logs given. Returns false if they cannot be read. */
+        bool compare
+        (const std::string & baseline, const std::string & current) {
+            std::vector<std::pair<std::string, std::vector<double> > > base, cur;
+            if (!load(baseline, base) || !load(current, cur))
+                return false;
+
+            results_.clear();
+            std::mt19937_64 rng(1);
+            for (const auto & b : base) {
+                Result r = {b.first, unsigned(b.second.size()), 0, RunStatistics(b.second).median,
+                            std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(),
+                            std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), false};
+                const auto c = std::find_if(cur.begin(), cur.end(), [&b] (const std::pair<std::string, std::vector<double> > & c) {
+                    return c.first == b.first;
+                });
+                if (c != cur.end() && !c->second.empty() && !b.second.empty()) {
+                    r.currentRuns = c->second.size();
+                    r.currentMedian = RunStatistics(c->second).median;
+                    r.speedup = r.baselineMedian / r.currentMedian;
+                    bootstrap(b.second, c->second, rng, r.low, r.high);
+                    r.regression = r.high < 1/(1 + threshold_);
+                }
+                results_.push_back(r);
+            }
+            for (const auto & c : cur)
+                if (std::find_if(base.begin(), base.end(), [&c] (const std::pair<std::string, std::vector<double> > & b) {
+                        return b.first == c.first; }) == base.end()) {
+                    Result r = {c.first, 0, unsigned(c.second.size()), std::numeric_limits<double>::quiet_NaN(),
+                                RunStatistics(c.second).median, std::numeric_limits<double>::quiet_NaN(),
+                                std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), false};
+                    results_.push_back(r);
+                }
+            return true;
+        }
+
+        /** \brief Returns the comparisons of the solvers: those of the baseline in its order, followed by those
+            only in the current log. */
+        const std::vector<Result> & getResults
+        () const {
+            return results_;
+        }
+
+        /** \brief Returns true if any solver regressed. */
+        bool hasRegressions
+        () const {
+            return std::any_of(results_.begin(), results_.end(), [] (const Result & r) { return r.regression; });
+        }
+
+        /** \brief Prints a line per solver: median times, speedup, confidence interval and verdict (faster,
+            slower or same if the interval contains 1, REGRESSION, new or missing). */
+        void print
+        () const {
+            std::ostringstream title;
+            title << "Comparison with the baseline (ms), " << confidence_*100 << "% confidence intervals, "
+                  << threshold_*100 << "% slowdown allowed:";
+            console::info(title.str());
+            std::cout << "Name\tBaseline\tCurrent\tSpeedup\tLow\tHigh\tResult" << '\n';
+            std::cout << std::fixed;
+            for (const Result & r : results_) {
+                std::cout << r.name << '\t' << std::setprecision(6) << r.baselineMedian << '\t' << r.currentMedian << '\t'
+                          << std::setprecision(3) << r.speedup << '\t' << r.low << '\t' << r.high << '\t';
+                if (r.baselineRuns == 0)
+                    std::cout << "new";
+                else if (r.currentRuns == 0)
+                    std::cout << "missing";
+                else if (r.regression)
+                    std::cout << "REGRESSION";
+                else if (r.low > 1)
+                    std::cout << "faster";
+                else if (r.high < 1)
+                    std::cout << "slower";
+                else
+                    std::cout << "same";
+                std::cout << '\n';
+            }
+            std::cout.unsetf(std::ios_base::floatfield);
+        }
+
+        /** \brief Reads the compute() times of the runs of every solver of a JSON log. Returns false if it
+            cannot be read. */
+        static bool load
+        (const std::string & filename, std::vector<std::pair<std::string, std::vector<double> > > & times) {
+            boost::property_tree::ptree log;
+            try {
+                boost::property_tree::read_json(filename, log);
+                times.clear();
+                for (const auto & s : log.get_child("solvers")) {
+                    times.push_back(std::make_pair(s.second.get<std::string>("name"), std::vector<double>()));
+                    for (const auto & r : s.second.get_child("runs"))
+                        times.back().second.push_back(r.second.get<double>("time"));
+                }
+            }
+            catch (const boost::property_tree::ptree_error & e) {
+                console::error("Unable to read the benchmark log " + filename + ": " + e.what());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        /** \brief Sets low and high to the bounds of the confidence interval of the speedup of the median of
+            current over that of base, by bootstrapping. */
+        void bootstrap
+        (const std::vector<double> & base, const std::vector<double> & current, std::mt19937_64 & rng,
+         double & low, double & high) const {
+            std::vector<double> speedups(resamples_), b(base.size()), c(current.size());
+            std::uniform_int_distribution<size_t> pickBase(0, base.size() - 1), pickCurrent(0, current.size() - 1);
+            for (unsigned int i = 0; i < resamples_; ++i) {
+                for (double & x : b)
+                    x = base[pickBase(rng)];
+                for (double & x : c)
+                    x = current[pickCurrent(rng)];
+                std::sort(b.begin(), b.end());
+                std::sort(c.begin(), c.end());
+                speedups[i] = RunStatistics::percentile(b, 50) / RunStatistics::percentile(c, 50);
+            }
+            std::sort(speedups.begin(), speedups.end());
+            low = RunStatistics::percentile(speedups, 50*(1 - confidence_));
+            high = RunStatistics::percentile(speedups, 100 - 50*(1 - confidence_));
+        }
+
+        /** \brief Slowdown allowed. */
+        double                  threshold_;
+
+        /** \brief Confidence of the intervals. */
+        double                  confidence_;
+
+        /** \brief Number of bootstrap resamples. */
+        unsigned int            resamples_;
+
+        /** \brief Comparisons of the last compare(). */
+        std::vector<Result>     results_;
+};
+
+#endif /* BENCHMARKCOMPARISON_HPP_ */
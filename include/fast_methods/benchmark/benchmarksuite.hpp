@@ -0,0 +1,474 @@
+/*! \class BenchmarkSuite
+    \brief Runs the solvers of a CFG file on synthetic problems generated by MapGenerator, for every
+    combination of the parameters given, and reports weak and strong scaling tables.
+
+    The suite section of the CFG file gives comma-separated lists of: dimensions (2, 3 or 4), cells
+    (of a hypercube grid, rounded to the closest power of an integer), obstacles (none, random,
+    maze or barriers), densities of the obstacles, velocities (uniform, smooth or piecewise), numbers
+    of sources (at random free cells) and numbers of threads. The solvers section is that of
+    BenchmarkCFG. Every problem is a Benchmark of its own, whose log is saved as
+    results/<suite name>/<problem>_t<threads>.log.
+
+    The parallel solvers (PFMM, GMM, BFIM, GPUFIM, FSM, GPUFSM and LSM) are given every number of threads
+    in their constructor parameters, replacing the one given in the solvers section if any:
+    - Strong scaling: each problem is solved with every number of threads. The speedup of a number of
+      threads is the median time with the fewest threads over its median time, and the efficiency the
+      speedup per added thread (1 if ideal). The rest of the solvers are run once per problem, with the
+      fewest threads.
+    - Weak scaling: the cells of each problem are multiplied by the times the threads are larger than
+      the fewest threads, so that the cells per thread are kept, and only the parallel solvers are run.
+      The efficiency is the median time with the fewest threads over the median time, 1 if ideal.
+
+    Problems have no goal, so that the whole grid is solved: FM2-based solvers, which need one, are
+    skipped.
+
+    Tables are shown in the terminal and saved as results/<suite name>.scaling. Problems whose grid
+    does not fit in suite.maxmemory (estimated as 4 times the size of its cells) or has 2^32 cells or
+    more are skipped with a warning.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKSUITE_HPP_
+#define BENCHMARKSUITE_HPP_
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+#include <fast_methods/benchmark/benchmark.hpp>
+#include <fast_methods/benchmark/benchmarkcfg.hpp>
+#include <fast_methods/io/mapgenerator.hpp>
+
+class BenchmarkSuite {
+
+    public:
+        /** \brief Requires readOptions to be manually called after this constructor. */
+        BenchmarkSuite
+        () {}
+
+        /** \brief Parses the CFG file given. */
+        bool readOptions
+        (const char * filename) {
+            std::fstream cfg(filename);
+            if (!cfg.good()) {
+                console::error(std::string("Unable to open file: ") + filename);
+                return 0;
+            }
+            boost::filesystem::path name = boost::filesystem::path(filename).filename();
+            name.replace_extension("");
+
+            boost::program_options::options_description desc;
+            desc.add_options()
+                ("suite.name",         boost::program_options::value<std::string>()->default_value(name.string()), "Name of the suite.")
+                ("suite.ndims",        boost::program_options::value<std::string>()->default_value("2"),         "Numbers of dimensions: 2, 3 or 4.")
+                ("suite.cells",        boost::program_options::value<std::string>()->default_value("10000"),     "Numbers of cells of the grids.")
+                ("suite.obstacles",    boost::program_options::value<std::string>()->default_value("none"),      "Obstacles: none, random, maze or barriers.")
+                ("suite.densities",    boost::program_options::value<std::string>()->default_value("0.2"),       "Densities of the obstacles, in (0,1).")
+                ("suite.velocities",   boost::program_options::value<std::string>()->default_value("uniform"),   "Velocities: uniform, smooth or piecewise.")
+                ("suite.sources",      boost::program_options::value<std::string>()->default_value("1"),         "Numbers of sources.")
+                ("suite.threads",      boost::program_options::value<std::string>()->default_value("1"),         "Numbers of threads of the parallel solvers.")
+                ("suite.scaling",      boost::program_options::value<std::string>()->default_value("strong,weak"), "Scaling tables: strong, weak or both.")
+                ("suite.runs",         boost::program_options::value<std::string>()->default_value("3"),         "Number of runs per solver and problem.")
+                ("suite.warmup",       boost::program_options::value<std::string>()->default_value("1"),         "Number of warmup runs per solver and problem, not logged.")
+                ("suite.seed",         boost::program_options::value<std::string>()->default_value("1"),         "Seed of the maps and sources.")
+                ("suite.maxmemory",    boost::program_options::value<std::string>()->default_value("0"),         "Largest memory of a grid in MB, 0 for half the physical memory.")
+                ("suite.cell",         boost::program_options::value<std::string>()->default_value("FMCell"),    "Type of cell: FMCell (default) or FMCellSoA.")
+                ("suite.precision",    boost::program_options::value<std::string>()->default_value("double"),    "Precision of the cell values: double (default) or float.");
+
+            boost::program_options::variables_map vm;
+            boost::program_options::parsed_options po = boost::program_options::parse_config_file(cfg, desc, true);
+            boost::program_options::store(po, vm);
+            boost::program_options::notify(vm);
+            cfg.close();
+
+            for (const auto& var : vm)
+                options_[var.first] = boost::any_cast<std::string>(var.second.value());
+
+            // Solvers as in BenchmarkCFG.
+            std::vector<std::string> unr = boost::program_options::collect_unrecognized(po.options, boost::program_options::exclude_positional);
+            for (std::size_t i = 0 ; i < unr.size()/2 ; ++i) {
+                const std::string key = boost::to_lower_copy(unr[i*2]);
+                if (key.substr(0,8) != "solvers.")
+                    continue;
+                const std::vector<std::string> & known = BenchmarkCFG::knownSolvers();
+                if (std::find(known.begin(), known.end(), key.substr(8)) == known.end())
+                    continue;
+                if (key.find("fm2") != std::string::npos) {
+                    console::warning("Solver " + key.substr(8) + " needs a goal, which the problems of suites do not have. Skipping it.");
+                    continue;
+                }
+                solverNames_.push_back(key.substr(8));
+                ctorParams_.push_back(unr[i*2 + 1]);
+            }
+
+            try {
+                for (const std::string & s : list("suite.obstacles")) {
+                    ObstacleMap o;
+                    if (!MapGenerator::parseObstacles(s, o)) {
+                        console::error("Unknown obstacles: " + s + ". Use none, random, maze or barriers.");
+                        return 0;
+                    }
+                    obstacles_.push_back(o);
+                }
+                for (const std::string & s : list("suite.velocities")) {
+                    VelocityField v;
+                    if (!MapGenerator::parseVelocities(s, v)) {
+                        console::error("Unknown velocities: " + s + ". Use uniform, smooth or piecewise.");
+                        return 0;
+                    }
+                    velocities_.push_back(v);
+                }
+                for (const std::string & s : list("suite.ndims"))
+                    ndims_.push_back(boost::lexical_cast<unsigned int>(s));
+                for (const std::string & s : list("suite.cells"))
+                    cells_.push_back(boost::lexical_cast<double>(s));
+                for (const std::string & s : list("suite.densities"))
+                    densities_.push_back(boost::lexical_cast<double>(s));
+                for (const std::string & s : list("suite.sources"))
+                    sources_.push_back(boost::lexical_cast<unsigned int>(s));
+                for (const std::string & s : list("suite.threads"))
+                    threads_.push_back(std::max(1u, boost::lexical_cast<unsigned int>(s)));
+            }
+            catch (const boost::bad_lexical_cast &) {
+                console::error("Wrong number in the suite section.");
+                return 0;
+            }
+            std::sort(threads_.begin(), threads_.end());
+            threads_.erase(std::unique(threads_.begin(), threads_.end()), threads_.end());
+            const std::vector<std::string> scaling = list("suite.scaling");
+            strong_ = std::find(scaling.begin(), scaling.end(), "strong") != scaling.end();
+            weak_ = std::find(scaling.begin(), scaling.end(), "weak") != scaling.end();
+
+            if (threads_.empty() || ndims_.empty() || cells_.empty() || solverNames_.empty()) {
+                console::error("The suite needs dimensions, cells, threads and solvers.");
+                return 0;
+            }
+            return 1;
+        }
+
+        /** \brief Runs the suite on grids of cells of type cell_t and reports the scaling tables. */
+        template <class cell_t>
+        void run
+        () {
+            boost::filesystem::path path("results");
+            boost::filesystem::create_directory(path);
+            boost::filesystem::create_directory(path / getValue<std::string>("suite.name"));
+            strongTable_.str("");
+            weakTable_.str("");
+            results_.clear();
+
+            for (unsigned int n : ndims_)
+                switch (n) {
+                    case 2: runDims<nDGridMap<cell_t, 2>, cell_t>(); break;
+                    case 3: runDims<nDGridMap<cell_t, 3>, cell_t>(); break;
+                    case 4: runDims<nDGridMap<cell_t, 4>, cell_t>(); break;
+                    // Include here new dimensions.
+                    default: console::warning("Suites run 2, 3 or 4 dimensions, skipping " + std::to_string(n) + ".");
+                }
+
+            std::ofstream ofs((path / (getValue<std::string>("suite.name") + ".scaling")).string());
+            if (strong_) {
+                console::info("Strong scaling (ms):");
+                std::cout << "Problem\tSolver\tThreads\tMedian\tSpeedup\tEfficiency" << '\n' << strongTable_.str();
+                ofs << "# Strong scaling: problem, solver, threads, median (ms), speedup, efficiency\n" << strongTable_.str();
+            }
+            if (weak_) {
+                console::info("Weak scaling (ms):");
+                std::cout << "Problem\tSolver\tThreads\tCells\tMedian\tEfficiency" << '\n' << weakTable_.str();
+                ofs << "# Weak scaling: problem (with the fewest threads), solver, threads, cells, median (ms), efficiency\n"
+                    << weakTable_.str();
+            }
+            ofs.close();
+        }
+
+        /** \brief Get the value for a given key (option). */
+        template<typename T>
+        T getValue
+        (const std::string & key) const {
+            std::unordered_map<std::string, std::string>::const_iterator iter = options_.find(key);
+            if (iter != options_.end())
+                return boost::lexical_cast<T>(iter->second);
+            else
+                return boost::lexical_cast<T>(0);
+        }
+
+        /** \brief Returns the position of the number of threads in the constructor parameters of the solver
+            (the name being the 0th), and in defaults the default values of the parameters before it.
+            Returns false for the solvers which do not run threads. */
+        static bool threadsParameter
+        (const std::string & solver, unsigned int & pos, std::vector<std::string> & defaults) {
+            const std::string maxSweeps = std::to_string(std::numeric_limits<unsigned>::max());
+            const std::unordered_map<std::string, std::vector<std::string> > parallel = {
+                {"pfmm", {}}, {"gmm", {"-1"}}, {"bfim", {"0", "0"}}, {"gpufim", {"0", "0"}},
+                {"fsm", {maxSweeps}}, {"gpufsm", {maxSweeps}}, {"lsm", {maxSweeps}}}; // Add parallel solver here.
+            const auto it = parallel.find(solver);
+            if (it == parallel.end())
+                return false;
+            defaults = it->second;
+            pos = 1 + defaults.size();
+            return true;
+        }
+
+    private:
+        /** \brief Result of a solver in a problem. */
+        struct Result {
+            std::string     problem;
+            unsigned int    solver;
+            unsigned int    threads;
+            RunStatistics   stats;
+        };
+
+        /** \brief Runs the problems of grids of type grid_t. */
+        template <class grid_t, class cell_t>
+        void runDims
+        () {
+            constexpr size_t N = grid_t::getNDims();
+            for (double c : cells_)
+                for (ObstacleMap o : obstacles_)
+                    for (unsigned int d = 0; d < ((o == NO_OBSTACLES) ? 1 : densities_.size()); ++d)
+                        for (VelocityField v : velocities_)
+                            for (unsigned int s : sources_) {
+                                const double density = (o == NO_OBSTACLES) ? 0 : densities_[d];
+                                const std::string base = problemName(N, side(c, N), o, density, v, s);
+                                if (strong_)
+                                    for (unsigned int t : threads_)
+                                        runProblem<grid_t, cell_t>(side(c, N), o, density, v, s, t, t == threads_[0]);
+                                if (weak_)
+                                    for (unsigned int t : threads_) {
+                                        const unsigned int n = side(c*t/threads_[0], N);
+                                        runProblem<grid_t, cell_t>(n, o, density, v, s, t, false);
+                                        weakRow(base, problemName(N, n, o, density, v, s), t, std::pow(double(n), double(N)));
+                                    }
+                                if (strong_)
+                                    for (unsigned int t : threads_)
+                                        strongRow(base, t);
+                            }
+        }
+
+        /** \brief Solves the problem of size n^N given with t threads: the parallel solvers and, if serial is
+            true, the rest. Solvers already run on it are not run again. */
+        template <class grid_t, class cell_t>
+        void runProblem
+        (unsigned int n, ObstacleMap o, double density, VelocityField v, unsigned int sources, unsigned int t, bool serial) {
+            constexpr size_t N = grid_t::getNDims();
+            const std::string problem = problemName(N, n, o, density, v, sources);
+            const double cells = std::pow(double(n), double(N));
+            size_t maxMemory = getValue<size_t>("suite.maxmemory") << 20;
+            if (maxMemory == 0)
+                maxMemory = size_t(sysconf(_SC_PHYS_PAGES)) * size_t(sysconf(_SC_PAGE_SIZE)) / 2;
+            if (cells >= double(std::numeric_limits<unsigned int>::max()) || 4*cells*sizeof(cell_t) > maxMemory) {
+                console::warning("Skipping " + problem + ": too many cells.");
+                return;
+            }
+
+            std::vector<std::pair<unsigned int, std::string> > solvers;
+            for (unsigned int i = 0; i < solverNames_.size(); ++i) {
+                unsigned int pos;
+                std::vector<std::string> defaults;
+                const bool parallel = threadsParameter(solverNames_[i], pos, defaults);
+                if ((parallel || serial) && !find(problem, i, parallel ? t : threads_[0]))
+                    solvers.push_back(std::make_pair(i, parallel ? threadsParams<grid_t, cell_t>(i, t) : ctorParams_[i]));
+            }
+            if (solvers.empty())
+                return;
+
+            std::cout << problem << ", " << t << " threads" << std::endl;
+            std::unique_ptr<grid_t> grid(new grid_t());
+            std::array<unsigned int, N> dimsize;
+            dimsize.fill(n);
+            MapGenerator::generate(*grid, dimsize, o, density, v, getValue<uint64_t>("suite.seed"));
+
+            Benchmark<grid_t> b;
+            b.setVerbose(false);
+            b.setSaveLog(true);
+            b.setPath(boost::filesystem::path("results") / getValue<std::string>("suite.name"));
+            b.setName(problem + "_t" + std::to_string(t));
+            b.setNRuns(getValue<unsigned int>("suite.runs"));
+            b.setWarmupRuns(getValue<unsigned int>("suite.warmup"));
+            b.setInitialPoints(MapGenerator::randomFreeCells(*grid, sources, getValue<uint64_t>("suite.seed")));
+            b.setEnvironment(grid.get());
+            std::vector<unsigned int> added;
+            for (const auto & s : solvers) {
+                Solver<grid_t> * solver = BenchmarkCFG::createSolver<grid_t, cell_t>(solverNames_[s.first], s.second);
+                if (!solver) {
+                    console::warning("Wrong number of parameters for solver " + s.second + ". Skipping it.");
+                    continue;
+                }
+                if (solverDisplayNames_.size() <= s.first)
+                    solverDisplayNames_.resize(s.first + 1);
+                solverDisplayNames_[s.first] = solver->getName();
+                b.addSolver(solver);
+                added.push_back(s.first);
+            }
+            b.run();
+
+            for (unsigned int i = 0; i < added.size(); ++i) {
+                unsigned int pos;
+                std::vector<std::string> defaults;
+                Result r = {problem, added[i], threadsParameter(solverNames_[added[i]], pos, defaults) ? t : threads_[0],
+                            b.getRecords()[i].phases[0].second};
+                results_.push_back(r);
+            }
+        }
+
+        /** \brief Returns the constructor parameters of solver i with t threads. */
+        template <class grid_t, class cell_t>
+        std::string threadsParams
+        (unsigned int i, unsigned int t) {
+            unsigned int pos;
+            std::vector<std::string> defaults;
+            threadsParameter(solverNames_[i], pos, defaults);
+            std::vector<std::string> p = BenchmarkCFG::split(ctorParams_[i]);
+            if (p.empty())
+                p.push_back(displayName<grid_t, cell_t>(i));
+            for (unsigned int j = p.size(); j < pos; ++j)
+                p.push_back(defaults[j - 1]);
+            if (p.size() == pos)
+                p.push_back(std::to_string(t));
+            else
+                p[pos] = std::to_string(t);
+            std::string params = p[0];
+            for (unsigned int j = 1; j < p.size(); ++j)
+                params += "," + p[j];
+            return params;
+        }
+
+        /** \brief Returns the name of solver i, as given by its getName(). */
+        template <class grid_t, class cell_t>
+        std::string displayName
+        (unsigned int i) {
+            const std::vector<std::string> p = BenchmarkCFG::split(ctorParams_[i]);
+            if (!p.empty())
+                return p[0];
+            std::unique_ptr<Solver<grid_t> > s(BenchmarkCFG::createSolver<grid_t, cell_t>(solverNames_[i], ""));
+            return s ? s->getName() : solverNames_[i];
+        }
+
+        /** \brief Returns the result of solver i in the problem with t threads, nullptr if it was not run. */
+        const Result * find
+        (const std::string & problem, unsigned int i, unsigned int t) const {
+            for (const Result & r : results_)
+                if (r.problem == problem && r.solver == i && r.threads == t)
+                    return &r;
+            return nullptr;
+        }
+
+        /** \brief Adds to the strong scaling table the rows of the problem with t threads. */
+        void strongRow
+        (const std::string & problem, unsigned int t) {
+            strongTable_ << std::fixed;
+            for (unsigned int i = 0; i < solverNames_.size(); ++i) {
+                const Result * r = find(problem, i, t), * r0 = find(problem, i, threads_[0]);
+                if (!r || !r0)
+                    continue;
+                const double speedup = r0->stats.median / r->stats.median;
+                strongTable_ << problem << '\t' << solverDisplayNames_[i] << '\t' << t << '\t' << std::setprecision(6)
+                             << r->stats.median << '\t' << std::setprecision(2) << speedup << '\t'
+                             << speedup * threads_[0] / t << '\n';
+            }
+        }
+
+        /** \brief Adds to the weak scaling table the rows of the problem with t threads, scaled from base. */
+        void weakRow
+        (const std::string & base, const std::string & problem, unsigned int t, double cells) {
+            weakTable_ << std::fixed;
+            for (unsigned int i = 0; i < solverNames_.size(); ++i) {
+                const Result * r = find(problem, i, t), * r0 = find(base, i, threads_[0]);
+                if (!r || !r0)
+                    continue;
+                unsigned int pos;
+                std::vector<std::string> defaults;
+                if (!threadsParameter(solverNames_[i], pos, defaults))
+                    continue;
+                weakTable_ << base << '\t' << solverDisplayNames_[i] << '\t' << t << '\t' << std::setprecision(0) << cells
+                           << '\t' << std::setprecision(6) << r->stats.median << '\t' << std::setprecision(2)
+                           << r0->stats.median / r->stats.median << '\n';
+            }
+        }
+
+        /** \brief Returns the size of the side of a hypercube of about cells cells in N dimensions. */
+        static unsigned int side
+        (double cells, size_t N) {
+            return std::max(2u, unsigned(std::lround(std::pow(cells, 1.0/N))));
+        }
+
+        /** \brief Returns the name of a problem, as 2d_100x100_maze0.3_smooth_1src. */
+        static std::string problemName
+        (size_t N, unsigned int n, ObstacleMap o, double density, VelocityField v, unsigned int sources) {
+            std::ostringstream oss;
+            oss << N << "d_" << n;
+            for (size_t d = 1; d < N; ++d)
+                oss << 'x' << n;
+            oss << '_' << MapGenerator::name(o);
+            if (o != NO_OBSTACLES)
+                oss << density;
+            oss << '_' << MapGenerator::name(v) << '_' << sources << "src";
+            return oss.str();
+        }
+
+        /** \brief Returns the comma-separated values of an option, trimmed. */
+        std::vector<std::string> list
+        (const std::string & key) const {
+            std::vector<std::string> l = BenchmarkCFG::split(options_.find(key)->second);
+            for (std::string & s : l)
+                boost::trim(s);
+            l.erase(std::remove(l.begin(), l.end(), std::string()), l.end());
+            return l;
+        }
+
+        /** \brief Stores the names of the parsed solvers. */
+        std::vector<std::string> solverNames_;
+
+        /** \brief Stores the constructor parameters for the parsed solvers. */
+        std::vector<std::string> ctorParams_;
+
+        /** \brief Names of the solvers run, as shown in the tables. */
+        std::vector<std::string> solverDisplayNames_;
+
+        /** \brief Option-value map.*/
+        std::unordered_map<std::string, std::string> options_;
+
+        /** \brief Parameters of the problems. */
+        std::vector<unsigned int>   ndims_;
+        std::vector<double>         cells_;
+        std::vector<ObstacleMap>    obstacles_;
+        std::vector<double>         densities_;
+        std::vector<VelocityField>  velocities_;
+        std::vector<unsigned int>   sources_;
+        std::vector<unsigned int>   threads_;
+
+        /** \brief Scaling tables reported. */
+        bool                        strong_;
+        bool                        weak_;
+
+        /** \brief Results of the solvers in the problems run. */
+        std::vector<Result>         results_;
+
+        /** \brief Rows of the scaling tables. */
+        std::stringstream           strongTable_;
+        std::stringstream           weakTable_;
+};
+
+#endif /* BENCHMARKSUITE_HPP_*/
@@ -0,0 +1,88 @@
+/*! \class RunStatistics
+    \brief Summary statistics of the times of the runs of a solver in a Benchmark: minimum,
+    median, mean, 95th percentile and standard deviation.
+
+    Outliers are detected with Tukey's fences: samples farther than 1.5 times the interquartile
+    range below the first quartile or above the third one (for instance, runs interrupted by
+    the operating system). They are counted and kept in the statistics, so that a large number
+    of them warns about noisy measurements instead of hiding them. Percentiles are interpolated
+    linearly between the closest samples.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RUNSTATISTICS_HPP_
+#define RUNSTATISTICS_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+struct RunStatistics {
+    /** \brief Statistics of no samples: all of them NaN. */
+    RunStatistics() : runs(0), min(std::numeric_limits<double>::quiet_NaN()), median(min), mean(min),
+        p95(min), stddev(min), outliers(0) {}
+
+    /** \brief Computes the statistics of the samples given. */
+    explicit RunStatistics
+    (std::vector<double> samples) : RunStatistics() {
+        runs = samples.size();
+        if (samples.empty())
+            return;
+        std::sort(samples.begin(), samples.end());
+        min = samples.front();
+        median = percentile(samples, 50);
+        p95 = percentile(samples, 95);
+
+        double sum = 0;
+        for (double x : samples)
+            sum += x;
+        mean = sum/runs;
+        double sq = 0;
+        for (double x : samples)
+            sq += (x - mean)*(x - mean);
+        stddev = (runs > 1) ? std::sqrt(sq/(runs - 1)) : 0;
+
+        const double q1 = percentile(samples, 25), q3 = percentile(samples, 75);
+        const double lo = q1 - 1.5*(q3 - q1), hi = q3 + 1.5*(q3 - q1);
+        for (double x : samples)
+            if (x < lo || x > hi)
+                ++outliers;
+    }
+
+    /** \brief p-th percentile (p in [0,100]) of the sorted samples, not empty. */
+    static double percentile
+    (const std::vector<double> & sorted, double p) {
+        const double pos = p/100*(sorted.size() - 1);
+        const size_t i = size_t(pos);
+        if (i + 1 >= sorted.size())
+            return sorted.back();
+        return sorted[i] + (pos - i)*(sorted[i+1] - sorted[i]);
+    }
+
+    /** \brief Number of samples. */
+    unsigned int    runs;
+
+    double          min;
+    double          median;
+    double          mean;
+    double          p95;
+
+    /** \brief Sample standard deviation (0 for a single sample). */
+    double          stddev;
+
+    /** \brief Number of samples out of Tukey's fences. */
+    unsigned int    outliers;
+};
+
+#endif /* RUNSTATISTICS_HPP_ */
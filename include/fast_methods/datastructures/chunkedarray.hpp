@@ -0,0 +1,165 @@
+/*! \class ChunkedArray
+    \brief Array divided in chunks of 2^chunkBits elements which are allocated the first
+    time one of their elements is written. Elements of chunks not allocated are equal to
+    the default value given.
+
+    Used to store grids (FMCellSparse) and per-cell data of the heaps which only touch a
+    small part of very large grids.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHUNKEDARRAY_HPP_
+#define CHUNKEDARRAY_HPP_
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstddef>
+
+template <class T> class ChunkedArray {
+
+    public:
+        /** @param chunkBits each chunk has 2^chunkBits elements.
+            @param def value of the elements not written yet. */
+        ChunkedArray(unsigned int chunkBits = 12, const T & def = T()) :
+            chunkBits_(chunkBits), default_(def), size_(0), allocated_(0) {}
+
+        /** \brief Resizes the array to n elements, all of them equal to the default value.
+            Chunks are deallocated. */
+        void resize
+        (size_t n) {
+            chunks_.clear();
+            chunks_.resize((n + chunkSize() - 1) >> chunkBits_);
+            size_ = n;
+            allocated_ = 0;
+        }
+
+        /** \brief Resizes the array to n elements of chunks of 2^chunkBits elements. */
+        void resize
+        (size_t n, unsigned int chunkBits) {
+            chunkBits_ = chunkBits;
+            resize(n);
+        }
+
+        /** \brief Returns element i. Its chunk is not allocated. */
+        inline const T & get
+        (size_t i) const {
+            const T * c = chunks_[i >> chunkBits_].get();
+            return c ? c[i & chunkMask()] : default_;
+        }
+
+        /** \brief Sets element i to v. The chunk is allocated only if v is not the default value. */
+        inline void set
+        (size_t i, const T & v) {
+            T * c = chunks_[i >> chunkBits_].get();
+            if (c)
+                c[i & chunkMask()] = v;
+            else if (!(v == default_))
+                allocate(i >> chunkBits_)[i & chunkMask()] = v;
+        }
+
+        /** \brief Returns a modifiable reference to element i, allocating its chunk if necessary. */
+        inline T & operator[]
+        (size_t i) {
+            T * c = chunks_[i >> chunkBits_].get();
+            return (c ? c : allocate(i >> chunkBits_))[i & chunkMask()];
+        }
+
+        /** \brief Returns element i. Its chunk is not allocated. */
+        inline const T & operator[]
+        (size_t i) const {
+            return get(i);
+        }
+
+        /** \brief Sets all the elements of the allocated chunks to v. No chunk is allocated
+            nor deallocated. */
+        void fillAllocated
+        (const T & v) {
+            for (std::unique_ptr<T[]> & c : chunks_)
+                if (c)
+                    std::fill(c.get(), c.get() + chunkSize(), v);
+        }
+
+        /** \brief Returns true if the chunk of element i is allocated. */
+        inline bool isAllocated
+        (size_t i) const {
+            return static_cast<bool>(chunks_[i >> chunkBits_]);
+        }
+
+        /** \brief Returns the number of elements of the array. */
+        inline size_t size
+        () const {
+            return size_;
+        }
+
+        /** \brief Returns the number of elements per chunk. */
+        inline size_t chunkSize
+        () const {
+            return size_t(1) << chunkBits_;
+        }
+
+        /** \brief Returns the number of chunks allocated. */
+        inline size_t allocatedChunks
+        () const {
+            return allocated_;
+        }
+
+        /** \brief Returns the number of bytes allocated: chunks and chunks table. */
+        inline size_t memory
+        () const {
+            return allocated_*chunkSize()*sizeof(T) + chunks_.capacity()*sizeof(std::unique_ptr<T[]>);
+        }
+
+        /** \brief Deallocates all the chunks and sets the size to 0. */
+        void clear
+        () {
+            chunks_.clear();
+            size_ = 0;
+            allocated_ = 0;
+        }
+
+    private:
+        inline size_t chunkMask
+        () const {
+            return chunkSize() - 1;
+        }
+
+        /** \brief Allocates chunk c initialized with the default value. */
+        T * allocate
+        (size_t c) {
+            chunks_[c].reset(new T[chunkSize()]);
+            std::fill(chunks_[c].get(), chunks_[c].get() + chunkSize(), default_);
+            ++allocated_;
+            return chunks_[c].get();
+        }
+
+        /** \brief The chunks, nullptr if not allocated. */
+        std::vector<std::unique_ptr<T[]> >  chunks_;
+
+        /** \brief Each chunk has 2^chunkBits_ elements. */
+        unsigned int                        chunkBits_;
+
+        /** \brief Value of the elements of the chunks not allocated. */
+        T                                   default_;
+
+        /** \brief Number of elements. */
+        size_t                              size_;
+
+        /** \brief Number of chunks allocated. */
+        size_t                              allocated_;
+};
+
+#endif /* CHUNKEDARRAY_HPP_ */
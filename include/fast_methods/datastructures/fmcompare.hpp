@@ -21,13 +21,17 @@
 #define FMCOMPARE_H_
 
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
 
 /** \brief This struct is used a comparator for the heap. Since a minimum-heap
     is desired the operation checked is param1 > param2 as seen in this
-    [Stack Overflow post](http://stackoverflow.com/a/16706002/2283531). */
+    [Stack Overflow post](http://stackoverflow.com/a/16706002/2283531).
+
+    Cells are referred to by CellStorage<cell_t>::const_pointer, a plain pointer
+    unless the cell type is stored otherwise (FMCellSoA). */
 template <class cell_t> struct FMCompare {
     inline bool operator()
-    (const cell_t * c1 , const cell_t * c2) const {
+    (typename CellStorage<cell_t>::const_pointer c1, typename CellStorage<cell_t>::const_pointer c2) const {
         return c1->getTotalValue() > c2->getTotalValue();
     }
 };
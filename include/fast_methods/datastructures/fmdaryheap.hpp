@@ -20,19 +20,36 @@
 #ifndef FMDARYHEAP_H_
 #define FMDARYHEAP_H_
 
+#include <vector>
+#include <type_traits>
+
 #include <boost/heap/d_ary_heap.hpp>
 
 #include <fast_methods/datastructures/fmcompare.hpp>
+#include <fast_methods/datastructures/chunkedarray.hpp>
+#include <fast_methods/datastructures/poolallocator.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
 
-/// \note for memory efficiency, use map instead of vector for handles_.
+/// \note handles_ has the size of the grid. FMHashHeap keeps positions only for the cells in the heap.
 template <class cell_t = FMCell> class FMDaryHeap {
 
-    /** \brief Shorthand for heap type. */
-    typedef boost::heap::d_ary_heap<const cell_t *, boost::heap::mutable_<true>, boost::heap::arity<2>, boost::heap::compare<FMCompare<cell_t>> > d_ary_heap_t;
+    /** \brief Shorthand for the type used to refer to cells. */
+    typedef typename CellStorage<cell_t>::const_pointer cell_ptr_t;
+
+    /** \brief Allocator of the nodes, tagged with the heap type to account their memory. */
+    typedef PoolAllocator<cell_ptr_t, FMDaryHeap> allocator_t;
+
+    /** \brief Shorthand for heap type. Its nodes are kept in a pool when the heap is cleared, so
+        later queries do not allocate them again. */
+    typedef boost::heap::d_ary_heap<cell_ptr_t, boost::heap::mutable_<true>, boost::heap::arity<2>, boost::heap::compare<FMCompare<cell_t>>,
+                                    boost::heap::allocator<allocator_t> > d_ary_heap_t;
     
     /** \brief Shorthand for heap element handle type. */
     typedef typename d_ary_heap_t::handle_type handle_t;
 
+    /** \brief Handles of the cells of sparse grids are allocated in chunks, when used. */
+    typedef typename std::conditional<CellStorage<cell_t>::sparse, ChunkedArray<handle_t>, std::vector<handle_t> >::type handles_t;
+
     public:
         FMDaryHeap () {}
         
@@ -44,12 +61,13 @@ template <class cell_t = FMCell> class FMDaryHeap {
         /** \brief Sets the maximum number of cells the heap will contain. */
         void setMaxSize
         (const size_t & n) {
-            handles_.resize(n);
+            if (handles_.size() != n)
+                handles_.resize(n);
         }
         
         /** \brief Pushes a new element into the heap. */
         void push
-        (const cell_t * c) {
+        (cell_ptr_t c) {
             handles_[c->getIndex()] = heap_.push(c);
         }
         
@@ -69,7 +87,7 @@ template <class cell_t = FMCell> class FMDaryHeap {
         
         /** \brief Updates the position of the cell in the heap. Its priority can increase or decrease. */
         void update
-        (const cell_t * c) {
+        (cell_ptr_t c) {
             heap_.update(handles_[c->getIndex()], c);
         }
         
@@ -77,15 +95,14 @@ template <class cell_t = FMCell> class FMDaryHeap {
             It is more efficient than the update() function if it is ensured that the priority
             will increase. */
         void increase
-        (const cell_t * c) {
+        (cell_ptr_t c) {
             heap_.increase(handles_[c->getIndex()], c);
         }
 
-        /** \brief Deallocates heap memory. */
+        /** \brief Empties the heap. Handles are kept, so setting the same maximum size again is immediate. */
         void clear
         () {
             heap_.clear();
-            handles_.clear();
         }
 
         /** \brief Returns true if the heap is empty. */
@@ -94,13 +111,26 @@ template <class cell_t = FMCell> class FMDaryHeap {
             return heap_.empty();
         }
 
+        /** \brief Returns the number of bytes allocated by the handles. Nodes are in sharedMemory(). */
+        size_t memory
+        () const {
+            return MemoryUsage::of(handles_);
+        }
+
+        /** \brief Returns the number of bytes allocated for the nodes of all the FMDaryHeaps of this cell
+            type, in use or kept in their pools (see PoolAllocator). */
+        static size_t sharedMemory
+        () {
+            return allocator_t::memory();
+        }
+
     protected:
         /** \brief The actual heap for cell_t. */
         d_ary_heap_t heap_;  /*!< The actual heap for cell_t. */
         
         /** \brief Stores the handles of each cell by keeping the indices: handles_(0) is the handle for
              the cell with index 0 in the grid. Makes possible to update the heap.*/
-        std::vector<handle_t> handles_;
+        handles_t handles_;
 };
 
 
@@ -0,0 +1,74 @@
+/*! \class FMHashHeap
+    \brief FMKeyHeap which keeps the positions of the cells in an IndexHashMap instead of an
+    array of the size of the grid, to be used as narrow band in the FM algorithms on large
+    grids where the narrow band is small compared to the grid (for instance, goal-bounded
+    queries on big 3D maps). Ready to be used with FMCell and derived types.
+
+    The position of a cell is inserted when it is pushed and erased when it is popped, so the
+    memory of the heap is proportional to the largest narrow band, not to the grid: setMaxSize()
+    allocates nothing. Positions are found by hashing, which is slower than indexing an array,
+    so FMKeyHeap is still the default heap. Cells are popped in the same order as FMKeyHeap.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FMHASHHEAP_H_
+#define FMHASHHEAP_H_
+
+#include <fast_methods/datastructures/fmkeyheap.hpp>
+#include <fast_methods/datastructures/indexhashmap.hpp>
+
+template <class cell_t = FMCell, unsigned int arity = 4> class FMHashHeap : public FMKeyHeap<cell_t, arity, IndexHashMap> {
+
+    /** \brief Shorthand for the base heap. */
+    typedef FMKeyHeap<cell_t, arity, IndexHashMap> FMKeyHeap_;
+
+    public:
+        FMHashHeap () {}
+
+        /** \brief The heap does not depend on the number of cells. */
+        FMHashHeap (const size_t &) {}
+
+        /** \brief Positions are only stored for the cells in the heap. Does nothing. */
+        void setMaxSize
+        (const size_t &) {}
+
+        /** \brief Pops index of the element with lowest value and removes it from the heap. */
+        unsigned int popMinIdx
+        () {
+            const unsigned int idx = FMKeyHeap_::popMinIdx();
+            pos_.erase(idx);
+            return idx;
+        }
+
+        /** \brief Empties the heap. The memory of the positions is kept for the next query. */
+        void clear
+        () {
+            FMKeyHeap_::clear();
+            pos_.clear();
+        }
+
+        /** \brief Returns the number of bytes allocated by the heap and the positions. */
+        size_t memory
+        () const {
+            return heap_.capacity()*sizeof(heap_[0]) + pos_.memory();
+        }
+
+    protected:
+        using FMKeyHeap_::heap_;
+        using FMKeyHeap_::pos_;
+};
+
+#endif /* FMHASHHEAP_H_ */
@@ -0,0 +1,190 @@
+/*! \class FMKeyHeap
+    \brief D-ary heap (4-ary by default) which stores the value of the cells next to their
+    index, to be used as narrow band in the FM algorithms. Ready to be used with FMCell and
+    derived types.
+
+    Comparisons only read the heap array: the total value (getTotalValue()) of a cell is
+    read once when it is pushed or increased, instead of twice per comparison as heaps
+    of cell pointers do (FMDaryHeap). The position of each cell in the heap is kept in an
+    array of indices (chunked for sparse grids), so increase() needs no Boost handles. The
+    container of the positions is the third template parameter: FMHashHeap keeps them in an
+    IndexHashMap, only for the cells in the heap.
+
+    Ties are not broken as in FMDaryHeap, so cells with the same value can be popped in
+    a different order.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FMKEYHEAP_H_
+#define FMKEYHEAP_H_
+
+#include <vector>
+#include <type_traits>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/datastructures/chunkedarray.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
+
+/// Positions of the cells of sparse grids are allocated in chunks, when used.
+template <class cell_t = FMCell, unsigned int arity = 4,
+          class positions_t = typename std::conditional<CellStorage<cell_t>::sparse, ChunkedArray<unsigned int>, std::vector<unsigned int> >::type>
+class FMKeyHeap {
+
+    static_assert(arity >= 2, "FMKeyHeap: arity has to be at least 2.");
+
+    /** \brief Shorthand for the type used to refer to cells. */
+    typedef typename CellStorage<cell_t>::const_pointer cell_ptr_t;
+
+    /** \brief Value and index of a cell. */
+    struct Entry {
+        double          key;
+        unsigned int    idx;
+    };
+
+    public:
+        FMKeyHeap () {}
+
+        /** \brief Creates a heap with n maximum elements. */
+        FMKeyHeap (const size_t & n) { pos_.resize(n); }
+
+        virtual ~ FMKeyHeap() { clear(); }
+
+        /** \brief Sets the maximum number of cells the heap will contain. */
+        void setMaxSize
+        (const size_t & n) {
+            if (pos_.size() != n)
+                pos_.resize(n);
+        }
+
+        /** \brief Pushes a new element into the heap. */
+        void push
+        (cell_ptr_t c) {
+            heap_.push_back(Entry());
+            siftUp(heap_.size() - 1, Entry{c->getTotalValue(), c->getIndex()});
+        }
+
+        /** \brief Pops index of the element with lowest value and removes it from the heap. */
+        unsigned int popMinIdx
+        () {
+            const unsigned int idx = heap_[0].idx;
+            const Entry last = heap_.back();
+            heap_.pop_back();
+            if (!heap_.empty())
+                siftDown(0, last);
+            return idx;
+        }
+
+        /** \brief Returns current size of the heap. */
+        size_t size
+        () const {
+            return heap_.size();
+        }
+
+        /** \brief Updates the position of the cell in the heap. Its priority can increase or decrease. */
+        void update
+        (cell_ptr_t c) {
+            const unsigned int i = pos_[c->getIndex()];
+            const Entry e{c->getTotalValue(), c->getIndex()};
+            if (e.key < heap_[i].key)
+                siftUp(i, e);
+            else
+                siftDown(i, e);
+        }
+
+        /** \brief Updates the position of the cell in the heap. Its priority can only increase.
+            It is more efficient than the update() function if it is ensured that the priority
+            will increase. */
+        void increase
+        (cell_ptr_t c) {
+            siftUp(pos_[c->getIndex()], Entry{c->getTotalValue(), c->getIndex()});
+        }
+
+        /** \brief Empties the heap. Positions are kept, so setting the same maximum size again is immediate. */
+        void clear
+        () {
+            heap_.clear();
+        }
+
+        /** \brief Returns true if the heap is empty. */
+        bool empty
+        () const {
+            return heap_.empty();
+        }
+
+        /** \brief Returns the number of bytes allocated by the heap and the positions. */
+        size_t memory
+        () const {
+            return MemoryUsage::of(heap_) + MemoryUsage::of(pos_);
+        }
+
+        /** \brief Nothing is shared with other heaps. */
+        static size_t sharedMemory
+        () {
+            return 0;
+        }
+
+    protected:
+        /** \brief Places e in position i, or in an upper one if its key is lower than those of its parents. */
+        inline void siftUp
+        (unsigned int i, const Entry & e) {
+            while (i > 0) {
+                const unsigned int parent = (i - 1) / arity;
+                if (!(e.key < heap_[parent].key))
+                    break;
+                place(i, heap_[parent]);
+                i = parent;
+            }
+            place(i, e);
+        }
+
+        /** \brief Places e in position i, or in a lower one if its key is greater than those of its children. */
+        inline void siftDown
+        (unsigned int i, const Entry & e) {
+            const unsigned int n = heap_.size();
+            while (true) {
+                const unsigned int first = arity*i + 1;
+                if (first >= n)
+                    break;
+                const unsigned int last = (first + arity < n) ? first + arity : n;
+                unsigned int min = first;
+                for (unsigned int c = first + 1; c < last; ++c)
+                    if (heap_[c].key < heap_[min].key)
+                        min = c;
+                if (!(heap_[min].key < e.key))
+                    break;
+                place(i, heap_[min]);
+                i = min;
+            }
+            place(i, e);
+        }
+
+        /** \brief Sets entry i of the heap and the position of its cell. */
+        inline void place
+        (unsigned int i, const Entry & e) {
+            heap_[i] = e;
+            pos_[e.idx] = i;
+        }
+
+        /** \brief The heap, as an array: children of entry i are entries arity*i+1 to arity*i+arity. */
+        std::vector<Entry> heap_;
+
+        /** \brief Position in heap_ of each cell, by index: pos_[0] is the position of the cell with
+            index 0 in the grid. Makes possible to update the heap. */
+        positions_t pos_;
+};
+
+#endif /* FMKEYHEAP_H_ */
@@ -23,9 +23,16 @@
 #include <boost/heap/priority_queue.hpp>
 
 #include <fast_methods/datastructures/fmcompare.hpp>
+#include <fast_methods/datastructures/poolallocator.hpp>
 
 template <class cell_t = FMCell> class FMPriorityQueue{
 
+    /** \brief Shorthand for the type used to refer to cells. */
+    typedef typename CellStorage<cell_t>::const_pointer cell_ptr_t;
+
+    /** \brief Allocator of the queue, tagged with its type to account its memory. */
+    typedef PoolAllocator<cell_ptr_t, FMPriorityQueue> allocator_t;
+
     public:
         FMPriorityQueue () {}
 
@@ -42,14 +49,14 @@ template <class cell_t = FMCell> class FMPriorityQueue{
 
         /** \brief Pushes a new element into the heap. */
         void push 
-        (const cell_t * c) {
+        (cell_ptr_t c) {
             heap_.push(c);
         }
 
         /** \brief Priority queues do not allow key increasing. Therefore, it pushes the element again.
              This is done so that SFMM is implemented as FMM with this heap. */
         void increase
-        (const cell_t * c) {
+        (cell_ptr_t c) {
             heap_.push(c);
         }
 
@@ -79,9 +86,21 @@ template <class cell_t = FMCell> class FMPriorityQueue{
             return heap_.empty();
         }
 
+        /** \brief The memory of the queue is accounted with that of the rest in sharedMemory(). */
+        size_t memory
+        () const {
+            return 0;
+        }
+
+        /** \brief Returns the number of bytes allocated by all the FMPriorityQueues of this cell type. */
+        static size_t sharedMemory
+        () {
+            return allocator_t::memory();
+        }
+
     protected:
         /** \brief The actual queue for FMCells. */
-        boost::heap::priority_queue<const cell_t *, boost::heap::compare<FMCompare<cell_t> > > heap_;
+        boost::heap::priority_queue<cell_ptr_t, boost::heap::compare<FMCompare<cell_t> >, boost::heap::allocator<allocator_t> > heap_;
 };
 
 
@@ -0,0 +1,197 @@
+/*! \class FMRadixHeap
+    \brief Monotone radix heap to be used as narrow band in the FM algorithms. Ready to be
+    used with FMCell and derived types.
+
+    Cells are sorted by their total value (getTotalValue()) exactly, as the binary heap does,
+    but without comparisons: the value, a non-negative floating point number, is taken as
+    an unsigned integer (the order is the same) and cells are kept in 65 buckets according to
+    the highest bit in which their value differs from the last value popped. Popping the
+    minimum only scans the first non-empty bucket, which is then split into the lower ones,
+    so each cell moves at most 64 times and, in practice, very few.
+
+    It requires values not lower than the last one popped, as in FMM (new arrival times are
+    larger than those of the neighbors they are computed from). Lower values are handled
+    as equal to the last one popped, which can happen with the heuristics of FMM*: then
+    the order is not exactly that of the binary heap.
+
+    increase() pushes the cell again with its new value instead of moving it. The old entry
+    is discarded when reached: entries are only valid if their value is still the value
+    of the cell and the cell is not frozen.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FMRADIXHEAP_H_
+#define FMRADIXHEAP_H_
+
+#include <vector>
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
+
+template <class cell_t = FMCell> class FMRadixHeap {
+
+    /** \brief Shorthand for the type used to refer to cells. */
+    typedef typename CellStorage<cell_t>::const_pointer cell_ptr_t;
+
+    /** \brief A cell and its value when pushed. */
+    struct Entry {
+        uint64_t    key;
+        cell_ptr_t  cell;
+    };
+
+    public:
+        FMRadixHeap () : last_(0), size_(0) {}
+
+        /** \brief Creates a heap with n maximum elements. */
+        FMRadixHeap (const size_t & n) : FMRadixHeap() { setMaxSize(n); }
+
+        virtual ~ FMRadixHeap() { clear(); }
+
+        /** \brief Buckets grow as needed and keep their memory, so only the first one is reserved
+            (for up to 1024 cells). */
+        void setMaxSize
+        (const size_t & n) {
+            buckets_[0].reserve(std::min<size_t>(n, 1024));
+        }
+
+        /** \brief Pushes a new element into the heap. */
+        void push
+        (cell_ptr_t c) {
+            insert(Entry{keyOf(c), c});
+            ++size_;
+        }
+
+        /** \brief Pops index of the element with lowest value and removes it from the heap. */
+        unsigned int popMinIdx
+        () {
+            while (true) {
+                while (!buckets_[0].empty()) {
+                    const Entry e = buckets_[0].back();
+                    buckets_[0].pop_back();
+                    if (isValid(e)) {
+                        --size_;
+                        return e.cell->getIndex();
+                    }
+                }
+                refill();
+            }
+        }
+
+        /** \brief Returns current size of the heap. */
+        size_t size
+        () const {
+            return size_;
+        }
+
+        /** \brief Updates the position of the cell in the heap. Its value can only decrease. */
+        void increase
+        (cell_ptr_t c) {
+            insert(Entry{keyOf(c), c});
+        }
+
+        /** \brief Empties the heap. The memory of the buckets is kept. */
+        void clear
+        () {
+            for (std::vector<Entry> & b : buckets_)
+                b.clear();
+            last_ = 0;
+            size_ = 0;
+        }
+
+        /** \brief Returns true if the heap is empty. */
+        bool empty
+        () const {
+            return size_ == 0;
+        }
+
+        /** \brief Returns the number of bytes allocated by the buckets. */
+        size_t memory
+        () const {
+            return MemoryUsage::of(buckets_);
+        }
+
+        /** \brief Nothing is shared with other heaps. */
+        static size_t sharedMemory
+        () {
+            return 0;
+        }
+
+    protected:
+        /** \brief Returns the value of the cell as an unsigned integer with the same order. */
+        static inline uint64_t keyOf
+        (cell_ptr_t c) {
+            const double v = c->getTotalValue();
+            uint64_t k;
+            std::memcpy(&k, &v, sizeof(k));
+            return k;
+        }
+
+        /** \brief Returns true if the entry was not replaced by a later increase() and the cell was not popped. */
+        inline bool isValid
+        (const Entry & e) const {
+            return e.cell->getState() != FMState::FROZEN && keyOf(e.cell) == e.key;
+        }
+
+        /** \brief Bucket of the entries with key k (not lower than last_). */
+        inline unsigned int bucketOf
+        (uint64_t k) const {
+            return (k == last_) ? 0 : 64 - __builtin_clzll(k ^ last_);
+        }
+
+        inline void insert
+        (const Entry & e) {
+            buckets_[bucketOf(std::max(e.key, last_))].push_back(e);
+        }
+
+        /** \brief Moves the entries of the first non-empty bucket to lower buckets, taking the minimum
+            of them as last_ (so at least one goes to bucket 0). Invalid entries are removed. */
+        void refill
+        () {
+            unsigned int b = 1;
+            while (buckets_[b].empty())
+                ++b;
+
+            std::vector<Entry> & bucket = buckets_[b];
+            uint64_t minKey = UINT64_MAX;
+            for (const Entry & e : bucket)
+                if (isValid(e))
+                    minKey = std::min(minKey, std::max(e.key, last_));
+
+            if (minKey != UINT64_MAX) {
+                last_ = minKey;
+                for (const Entry & e : bucket)
+                    if (isValid(e))
+                        insert(e);
+            }
+            bucket.clear();
+        }
+
+        /** \brief Entries by the highest bit in which their key differs from last_ (0 if equal). */
+        std::array<std::vector<Entry>, 65> buckets_;
+
+        /** \brief Key of the last bucket refill, lower than or equal to all the keys in the heap. */
+        uint64_t last_;
+
+        /** \brief Number of cells in the heap, invalid entries excluded. */
+        size_t size_;
+};
+
+#endif /* FMRADIXHEAP_H_ */
@@ -1,7 +1,22 @@
 /*! \class FMUntidyQueue
-    \brief Wraps the UntidyQueue implementation by 
+    \brief Untidy priority queue (Yatziv et al.) to be used as narrow band in UFMM. Ready to be
+    used with FMCell and derived types.
+
+    Cells are sorted by their arrival time into a ring of buckets of width inc/s, s being
+    the number of buckets and inc the maximum difference between the arrival times in the queue
+    at the same time (the maximum increment). Cells in the same bucket are popped in the same
+    order they were pushed (first in, first out). Arrival times larger than inc from the
+    first bucket go to the last bucket, and lower than the first bucket to the first one.
+
+    The ring is allocated once and every bucket is an array of cells which keeps its memory,
+    so pushing does not allocate (after the first runs). The bucket of each cell is saved in
+    the cell (FMCell::setBucket()). increase() pushes the cell again into its new bucket and
+    leaves the old entry, which is discarded when reached because the bucket saved in the
+    cell is not that one anymore. Therefore, all the operations are O(1).
+
+    Based on the UntidyQueue implementation by
     [Jerome Piovano](ftp://ftp-sop.inria.fr/athena/Team/Jerome.Piovano/Doxygen/classlevelset_1_1PriorityQueue.html)
-    
+
     Copyright (C) 2014 Javier V. Gomez
     www.javiervgomez.com
 
@@ -20,67 +35,173 @@
 #ifndef FMUNTIDYQUEUE_HPP_
 #define FMUNTIDYQUEUE_HPP_
 
-#include <fast_methods/thirdparty/untidy_queue.hpp>
+#include <vector>
+#include <cmath>
+
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
 
-/// \todo save buckets here as a hash table instead of saving them in FMCell.
 template<class cell_t = FMCell> class FMUntidyQueue {
 
+    /** \brief Shorthand for the type used to refer to cells. */
+    typedef typename CellStorage<cell_t>::pointer cell_ptr_t;
+
+    /** \brief Shorthand for the type stored in the queue. */
+    typedef typename CellStorage<cell_t>::const_pointer cell_const_ptr_t;
+
+    /** \brief Cells of a bucket, popped from head. */
+    struct Bucket {
+        Bucket() : head(0) {}
+
+        std::vector<cell_const_ptr_t>   cells;
+        size_t                          head;
+    };
+
     public:
-        /** \brief Creates an object with s buckets of size s. */
+        /** \brief Creates a queue with s buckets and maximum increment inc. */
         FMUntidyQueue
-        (unsigned s = 1000, double inc = 2) {
-            queue_ = new levelset::PriorityQueue<const cell_t * >(s, inc);
+        (unsigned s = 1000, double inc = 2) : buckets_(s), t0_(0), i0_(0), size_(0) {
+            setMaxIncrement(inc);
         }
 
-        virtual ~FMUntidyQueue() { delete queue_; }
+        virtual ~FMUntidyQueue() { clear(); }
+
+        /** \brief Sets the maximum difference between the arrival times of the cells in the queue.
+            The queue has to be empty. */
+        void setMaxIncrement
+        (double inc) {
+            inc_ = inc;
+            delta_ = inc_ / buckets_.size();
+        }
 
-        /** \brief Pushes a new element into the heap. */
+        /** \brief Pushes a new element into the queue. */
         void push
-        (cell_t * c) {
-            c->setBucket( queue_->push(c, c->getArrivalTime()) );
+        (cell_ptr_t c) {
+            if (empty()) {
+                clear();
+                t0_ = c->getArrivalTime();
+            }
+            insert(c);
+            ++size_;
         }
 
-        /** \brief Returns current size of the heap. */
+        /** \brief Returns current size of the queue. */
         size_t size
         () const {
-            return queue_->size();
+            return size_;
         }
 
         /** \brief Updates the position of the cell in the priority queue. Its priority can only increase.
              Also updates the bucket of the cell. */
         void increase
-        (cell_t * c) {
-            c->setBucket( queue_->increase_priority(c, c->getBucket(), c->getArrivalTime()) );
+        (cell_ptr_t c) {
+            if (bucketOf(c->getArrivalTime()) != unsigned(c->getBucket()))
+                insert(c);
         }
 
         /** \brief Returns index of the element with \e lowest value (to be popped next). */
         unsigned int topIdx
-        (){
-            return queue_->top()->getIndex();
+        () {
+            return top()->getIndex();
         }
 
-        /** \brief Removes the top value of the heap. */
+        /** \brief Removes the top value of the queue. */
         void pop
         () {
-            queue_->pop();
+            if (empty())
+                return;
+            top();
+            ++buckets_[i0_].head;
+            --size_;
         }
 
-        /** \brief Deallocates heap memory. */
+        /** \brief Empties the queue. The memory of the buckets is kept. */
         void clear
         () {
-            queue_->clear();
+            for (Bucket & b : buckets_) {
+                b.cells.clear();
+                b.head = 0;
+            }
+            t0_ = 0;
+            i0_ = 0;
+            size_ = 0;
         }
 
-        /** \brief Returns true if the heap is empty. */
+        /** \brief Returns true if the queue is empty. */
         bool empty
         () const {
-            return queue_->empty();
+            return size_ == 0;
+        }
+
+        /** \brief Returns the number of bytes allocated by the ring of buckets and their cells. */
+        size_t memory
+        () const {
+            size_t bytes = MemoryUsage::of(buckets_);
+            for (const Bucket & b : buckets_)
+                bytes += MemoryUsage::of(b.cells);
+            return bytes;
+        }
+
+        /** \brief Nothing is shared with other queues. */
+        static size_t sharedMemory
+        () {
+            return 0;
         }
 
     protected:
-        /** \brief The actual Unitidy queue for cell_t. */
-        levelset::PriorityQueue<const cell_t * > * queue_;
+        /** \brief Returns the bucket of the arrival time t. */
+        inline unsigned int bucketOf
+        (double t) const {
+            const unsigned int n = buckets_.size();
+            const double i = std::floor((t - t0_) * n / inc_);
+            const unsigned int offset = (i > 0) ? ((i < n) ? static_cast<unsigned int>(i) : n-1) : 0;
+            return (offset + i0_) % n;
+        }
+
+        /** \brief Adds the cell to the bucket of its arrival time and saves the bucket in the cell. */
+        inline void insert
+        (cell_ptr_t c) {
+            const unsigned int b = bucketOf(c->getArrivalTime());
+            c->setBucket(b);
+            buckets_[b].cells.push_back(c);
+        }
+
+        /** \brief Moves the first bucket to the first valid entry and returns it. The queue must
+            not be empty. Entries of cells saved in another bucket are discarded. */
+        cell_const_ptr_t top
+        () {
+            while (true) {
+                Bucket & b = buckets_[i0_];
+                while (b.head < b.cells.size()) {
+                    if (unsigned(b.cells[b.head]->getBucket()) == i0_)
+                        return b.cells[b.head];
+                    ++b.head;
+                }
+                b.cells.clear();
+                b.head = 0;
+                i0_ = (i0_ + 1) % buckets_.size();
+                t0_ += delta_;
+            }
+        }
+
+        /** \brief Ring of buckets. */
+        std::vector<Bucket> buckets_;
+
+        /** \brief Maximum increment. */
+        double inc_;
+
+        /** \brief Width of the buckets. */
+        double delta_;
+
+        /** \brief Lowest arrival time of the first bucket. */
+        double t0_;
+
+        /** \brief First bucket. */
+        unsigned int i0_;
+
+        /** \brief Number of cells in the queue, old entries excluded. */
+        size_t size_;
 };
 
-#endif /* FMUNTIDYQUEUE_H_ */
+#endif /* FMUNTIDYQUEUE_HPP_ */
@@ -0,0 +1,167 @@
+/*! \class IndexHashMap
+    \brief Open addressing hash map from cell indices to unsigned integers, with linear probing.
+
+    Used to keep per-cell data of the cells in the narrow band only (the positions of FMHashHeap),
+    so that its memory is proportional to the number of cells stored instead of the size of the
+    grid. Slots are key-value pairs in a single array of a power of two size, kept at most half
+    full. Keys are erased shifting back the following slots of their run, so there are no
+    tombstones and probes stay short however many keys are inserted and erased. clear() keeps
+    the slots allocated, so the map of a heap does not allocate memory again in later queries.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef INDEXHASHMAP_HPP_
+#define INDEXHASHMAP_HPP_
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+class IndexHashMap {
+
+    public:
+        IndexHashMap() : size_(0), bits_(0) {}
+
+        /** \brief Returns a reference to the value of key, inserted with value 0 if not in the map.
+            References are valid until the next insertion. */
+        inline unsigned int & operator[]
+        (unsigned int key) {
+            if (2*(size_ + 1) > slots_.size())
+                grow();
+            size_t i = home(key);
+            while (slots_[i].key != EMPTY) {
+                if (slots_[i].key == key)
+                    return slots_[i].value;
+                i = next(i);
+            }
+            slots_[i].key = key;
+            slots_[i].value = 0;
+            ++size_;
+            return slots_[i].value;
+        }
+
+        /** \brief Returns a pointer to the value of key, nullptr if it is not in the map. */
+        inline const unsigned int * find
+        (unsigned int key) const {
+            if (size_ == 0)
+                return nullptr;
+            for (size_t i = home(key); slots_[i].key != EMPTY; i = next(i))
+                if (slots_[i].key == key)
+                    return &slots_[i].value;
+            return nullptr;
+        }
+
+        /** \brief Removes key from the map, if it is in it. */
+        void erase
+        (unsigned int key) {
+            if (size_ == 0)
+                return;
+            size_t i = home(key);
+            while (slots_[i].key != key) {
+                if (slots_[i].key == EMPTY)
+                    return;
+                i = next(i);
+            }
+
+            // Slots after i in its run are moved back to it unless their home is between i and them.
+            for (size_t j = next(i); slots_[j].key != EMPTY; j = next(j)) {
+                const size_t k = home(slots_[j].key);
+                if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+                    continue;
+                slots_[i] = slots_[j];
+                i = j;
+            }
+            slots_[i].key = EMPTY;
+            --size_;
+        }
+
+        /** \brief Removes all the keys. Slots are kept allocated. */
+        void clear
+        () {
+            if (size_ == 0)
+                return;
+            for (Slot & s : slots_)
+                s.key = EMPTY;
+            size_ = 0;
+        }
+
+        /** \brief Returns the number of keys in the map. */
+        inline size_t size
+        () const {
+            return size_;
+        }
+
+        /** \brief Returns true if there are no keys in the map. */
+        inline bool empty
+        () const {
+            return size_ == 0;
+        }
+
+        /** \brief Returns the number of bytes allocated. */
+        inline size_t memory
+        () const {
+            return slots_.capacity()*sizeof(Slot);
+        }
+
+    private:
+        /** \brief Key of the empty slots, not a valid cell index. */
+        static constexpr unsigned int EMPTY = ~0u;
+
+        /** \brief Key-value pair. */
+        struct Slot {
+            unsigned int key;
+            unsigned int value;
+        };
+
+        /** \brief Slot of key without collisions: Fibonacci hashing of the key, so that consecutive
+            indices (as cells of the narrow band are) are spread over the array. */
+        inline size_t home
+        (unsigned int key) const {
+            return (key * 2654435769u) >> (32 - bits_);
+        }
+
+        inline size_t next
+        (size_t i) const {
+            return (i + 1) & (slots_.size() - 1);
+        }
+
+        /** \brief Doubles the number of slots (16 the first time) and inserts the keys again. */
+        void grow
+        () {
+            std::vector<Slot> old;
+            old.swap(slots_);
+            bits_ = old.empty() ? 4 : bits_ + 1;
+            slots_.assign(size_t(1) << bits_, Slot{EMPTY, 0});
+            for (const Slot & s : old)
+                if (s.key != EMPTY) {
+                    size_t i = home(s.key);
+                    while (slots_[i].key != EMPTY)
+                        i = next(i);
+                    slots_[i] = s;
+                }
+        }
+
+        /** \brief The slots, 2^bits_ of them. */
+        std::vector<Slot>   slots_;
+
+        /** \brief Number of keys in the map. */
+        size_t              size_;
+
+        /** \brief Number of bits of the slot indices. */
+        unsigned int        bits_;
+};
+
+#endif /* INDEXHASHMAP_HPP_ */
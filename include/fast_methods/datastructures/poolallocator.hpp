@@ -0,0 +1,163 @@
+/*! \class PoolAllocator
+    \brief Allocator which keeps the memory of the single objects deallocated in a free list
+    instead of returning it, to be used by node based containers (for instance, the Boost
+    heaps of FMDaryHeap and FMFibHeap, which allocate a node per push).
+
+    Freed nodes are reused by the next allocations of the same type in the same thread, so
+    once a query has been solved, the following ones of a similar size do not allocate
+    memory: clearing the heap between queries returns its nodes to the pool. Arrays
+    (n > 1) are allocated with operator new as usual. Pools are per thread and per node
+    type, so the allocator has no state and it can be used by any number of containers.
+    The memory of a pool is released when its thread finishes.
+
+    The second template parameter tags the containers which share the pools, so that their
+    memory can be accounted (memory()): the bytes allocated by all the allocators with the
+    same tag, in every thread, in use or free. Allocations are only counted when memory is
+    taken from or returned to the system, not when nodes are reused.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POOLALLOCATOR_HPP_
+#define POOLALLOCATOR_HPP_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <atomic>
+
+/** \brief Bytes allocated by the PoolAllocators of each tag. */
+template <class Tag> class PoolAllocatorMemory {
+
+    public:
+        static std::atomic<std::size_t> & bytes
+        () {
+            static std::atomic<std::size_t> n(0);
+            return n;
+        }
+};
+
+template <class T, class Tag = void> class PoolAllocator {
+
+    public:
+        typedef T               value_type;
+        typedef T *             pointer;
+        typedef const T *       const_pointer;
+        typedef T &             reference;
+        typedef const T &       const_reference;
+        typedef std::size_t     size_type;
+        typedef std::ptrdiff_t  difference_type;
+
+        template <class U> struct rebind {
+            typedef PoolAllocator<U, Tag> other;
+        };
+
+        PoolAllocator() {}
+
+        template <class U> PoolAllocator(const PoolAllocator<U, Tag> &) {}
+
+        /** \brief Returns the bytes allocated by the allocators of Tag (all types and threads). */
+        static size_type memory
+        () {
+            return PoolAllocatorMemory<Tag>::bytes().load(std::memory_order_relaxed);
+        }
+
+        pointer allocate
+        (size_type n, const void * = nullptr) {
+            if (n == 1) {
+                FreeList & list = freeList();
+                if (list.head) {
+                    Node * node = list.head;
+                    list.head = node->next;
+                    return reinterpret_cast<pointer>(node);
+                }
+            }
+            PoolAllocatorMemory<Tag>::bytes().fetch_add(n*blockSize(), std::memory_order_relaxed);
+            return static_cast<pointer>(::operator new(n*blockSize()));
+        }
+
+        void deallocate
+        (pointer p, size_type n) {
+            if (n == 1) {
+                FreeList & list = freeList();
+                Node * node = reinterpret_cast<Node *>(p);
+                node->next = list.head;
+                list.head = node;
+            }
+            else {
+                PoolAllocatorMemory<Tag>::bytes().fetch_sub(n*blockSize(), std::memory_order_relaxed);
+                ::operator delete(p);
+            }
+        }
+
+        size_type max_size
+        () const {
+            return size_type(-1) / blockSize();
+        }
+
+        template <class U, class... Args>
+        void construct
+        (U * p, Args&&... args) {
+            ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template <class U>
+        void destroy
+        (U * p) {
+            p->~U();
+        }
+
+        pointer address(reference x) const {return &x;}
+        const_pointer address(const_reference x) const {return &x;}
+
+        bool operator==(const PoolAllocator &) const {return true;}
+        bool operator!=(const PoolAllocator &) const {return false;}
+
+    private:
+        /** \brief Free block, reusing the memory of the object. */
+        struct Node {
+            Node * next;
+        };
+
+        /** \brief Free blocks of the thread, released when the thread finishes. */
+        struct FreeList {
+            FreeList() : head(nullptr) {}
+
+            ~FreeList() {
+                while (head) {
+                    Node * next = head->next;
+                    ::operator delete(head);
+                    PoolAllocatorMemory<Tag>::bytes().fetch_sub(blockSize(), std::memory_order_relaxed);
+                    head = next;
+                }
+            }
+
+            Node * head;
+        };
+
+        /** \brief Blocks hold an object or a free list node. */
+        static constexpr size_type blockSize
+        () {
+            return (sizeof(T) > sizeof(Node)) ? sizeof(T) : sizeof(Node);
+        }
+
+        static FreeList & freeList
+        () {
+            static thread_local FreeList list;
+            return list;
+        }
+};
+
+#endif /* POOLALLOCATOR_HPP_ */
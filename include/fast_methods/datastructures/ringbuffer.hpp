@@ -0,0 +1,109 @@
+/*! \class RingBuffer
+    \brief First in, first out queue stored in a contiguous circular buffer whose capacity is a
+    power of two, so that the positions wrap around with a mask.
+
+    The buffer doubles when it is full, and it is never shrunk: clear() keeps the memory for
+    the next uses. Unlike a vector in which the elements are only erased when it is emptied,
+    the memory is proportional to the largest number of elements in the queue at the same time,
+    not to the insertions (used by DDQM, whose queues are pushed while they are popped).
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RINGBUFFER_HPP_
+#define RINGBUFFER_HPP_
+
+#include <vector>
+#include <cstddef>
+
+template <class T> class RingBuffer {
+
+    public:
+        RingBuffer() : head_(0), size_(0) {}
+
+        /** \brief Inserts v at the back of the queue, doubling the buffer if it is full. */
+        inline void push_back
+        (const T & v) {
+            if (size_ == buffer_.size())
+                grow();
+            buffer_[(head_ + size_) & (buffer_.size() - 1)] = v;
+            ++size_;
+        }
+
+        /** \brief Removes and returns the element at the front of the queue, which must not be empty. */
+        inline T pop_front
+        () {
+            const T v = buffer_[head_];
+            head_ = (head_ + 1) & (buffer_.size() - 1);
+            --size_;
+            return v;
+        }
+
+        /** \brief Returns the element at the front of the queue, which must not be empty. */
+        inline const T & front
+        () const {
+            return buffer_[head_];
+        }
+
+        /** \brief Returns true if the queue has no elements. */
+        inline bool empty
+        () const {
+            return size_ == 0;
+        }
+
+        /** \brief Returns the number of elements in the queue. */
+        inline size_t size
+        () const {
+            return size_;
+        }
+
+        /** \brief Returns the number of elements the buffer holds before it grows. */
+        inline size_t capacity
+        () const {
+            return buffer_.size();
+        }
+
+        /** \brief Empties the queue. The buffer is kept. */
+        void clear
+        () {
+            head_ = 0;
+            size_ = 0;
+        }
+
+        /** \brief Returns the number of bytes allocated by the buffer. */
+        size_t memory
+        () const {
+            return buffer_.capacity()*sizeof(T);
+        }
+
+    private:
+        /** \brief Doubles the buffer (16 elements at least), moving the elements to its beginning. */
+        void grow
+        () {
+            std::vector<T> buffer(buffer_.empty() ? 16 : 2*buffer_.size());
+            for (size_t i = 0; i < size_; ++i)
+                buffer[i] = buffer_[(head_ + i) & (buffer_.size() - 1)];
+            buffer_.swap(buffer);
+            head_ = 0;
+        }
+
+        /** \brief Circular buffer, of a power of two elements. */
+        std::vector<T>  buffer_;
+
+        /** \brief Position of the front element. */
+        size_t          head_;
+
+        /** \brief Number of elements in the queue. */
+        size_t          size_;
+};
+
+#endif /* RINGBUFFER_HPP_ */
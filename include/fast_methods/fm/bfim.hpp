@@ -0,0 +1,431 @@
+/*! \class BFIM
+    \brief Implements the block (tiled) Fast Iterative Method, running in parallel.
+
+    The grid is split into tiles of tileSize cells per side and the active list of FIM is
+    split by tiles: each tile has its own active list, and a list of active tiles (those with
+    active cells) is kept. Each round, every active tile runs a pass of FIM over its active
+    list, as FIM does over the whole list. Neighbors of converged cells which belong to other
+    tiles are not updated by the thread: they are checked afterwards and added to the list of
+    their tile, which is activated. The algorithm finishes when no tile is active, with the
+    same result as FIM. A single pass per round keeps the front advancing as in FIM: running
+    tiles until they converge makes cells ahead of the front be updated many times.
+
+    Tiles are processed concurrently by a WorkerPool. Tiles are colored as a checkerboard and
+    the two colors are processed one after the other, so that tiles updated at the same time
+    are never neighbors and the arrival times a thread reads are not written by other threads.
+    Arrival times and states are stored in arrays of the solver during the computation and
+    copied to the grid at the end.
+
+    As in FIM, if a goal is set the propagation stops when the goal converges. The round in
+    which it converges is finished.
+
+    The grid is assumed to be squared, that is Delta(x) = Delta(y) = leafsize_
+
+    @par External documentation:
+        W. Jeong and R. Whitaker, A Fast Iterative Method for Eiknal Equations, SIAM J. Sci. Comput., 30(5), 2512–2534. 2008.
+        <a href="http://epubs.siam.org/doi/abs/10.1137/060670298">[PDF]</a>
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BFIM_HPP_
+#define BFIM_HPP_
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <limits>
+
+#include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+#include <fast_methods/utils/utils.h>
+
+template < class grid_t > class BFIM : public EikonalSolver<grid_t> {
+
+    public:
+        typedef typename EikonalSolver<grid_t>::value_t value_t;
+
+        /** @param error error threshold value that reveals if a cell has converged, as in FIM.
+            @param tileSize cells per side of the tiles, 0 for 16 in 2D, 8 in 3D and 4 otherwise.
+            @param nthreads number of threads, 0 to use as many as hardware threads. */
+        BFIM(double error = 0, unsigned tileSize = 0, unsigned nthreads = 0) : EikonalSolver<grid_t>("BFIM"),
+            E_(error), tileSize_(tileSize), nthreads_(nthreads), rounds_(0) {}
+
+        BFIM(const char * name, double error = 0, unsigned tileSize = 0, unsigned nthreads = 0) : EikonalSolver<grid_t>(name),
+            E_(error), tileSize_(tileSize), nthreads_(nthreads), rounds_(0) {}
+
+        virtual ~BFIM() { clear(); }
+
+        /** \brief Builds the tiles if the grid changed and starts the threads. */
+        virtual void setup
+        () {
+            EikonalSolver<grid_t>::setup();
+            if (tiledGrid_ != grid_ || tiledDims_ != grid_->getDimSizes() || cellTile_.size() != grid_->size())
+                buildTiles();
+            pool_.resize(nthreads_);
+            work_.resize(pool_.size());
+        }
+
+        /** \brief Actual method that implements block FIM. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            const grid_t & grid = *grid_;
+            times_.resize(grid.size());
+            for (unsigned int i = 0; i < grid.size(); ++i)
+                times_[i] = grid.getCell(i).getArrivalTime();
+            states_.assign(grid.size(), FMState::OPEN);
+            for (TileWork & w : work_)
+                w.visited.clear();
+            goalReached_ = false;
+
+            // Algorithm initialization.
+            activeTiles_.clear();
+            phaseTiles_[1].clear();
+            for (const unsigned int & i: init_points_) {
+                times_[i] = 0;
+                states_[i] = FMState::FROZEN;
+
+                const unsigned int n_neighs = grid.getNeighbors(i, neighbors_);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+                for (unsigned int s = 0; s < n_neighs; ++s) {
+                    const unsigned int x_nb = neighbors_[s];
+                    if (states_[x_nb] == FMState::OPEN && !grid.getCell(x_nb).isOccupied()) {
+                        states_[x_nb] = FMState::NARROW;
+                        work_[0].visited.push_back(x_nb);
+                        tileLists_[cellTile_[x_nb]].push_back(x_nb);
+                        scheduleTile(cellTile_[x_nb], 1);
+                    }
+                }
+            }
+
+            // Main loop, a round per iteration.
+            while (!goalReached_ && !activeTiles_.empty()) {
+                ++rounds_;
+                phaseTiles_[0].clear();
+                phaseTiles_[1].clear();
+                for (unsigned int t : activeTiles_)
+                    phaseTiles_[tileColor_[t]].push_back(t);
+                activeTiles_.clear();
+
+                for (unsigned int c = 0; c < 2; ++c) {
+                    const std::vector<unsigned int> & tiles = phaseTiles_[c];
+                    for (unsigned int t : tiles)
+                        active_[t] = 0;
+
+                    std::atomic<unsigned int> next(0);
+                    pool_.run([this, &tiles, &next] (unsigned int th) {
+                        for (unsigned int k = next++; k < tiles.size(); k = next++)
+                            processTile(tiles[k], work_[th]);
+                    });
+
+                    for (unsigned int t : tiles)
+                        if (!tileLists_[t].empty())
+                            scheduleTile(t, 1);
+                    for (TileWork & w : work_)
+                        mergeOutbox(w, c);
+                }
+            }
+
+            // Results are copied to the grid, only for the cells reached.
+            for (const TileWork & w : work_)
+                for (unsigned int idx : w.visited) {
+                    if (std::isinf(times_[idx])) // Beyond the limits.
+                        continue;
+                    grid_->getCell(idx).setArrivalTime(times_[idx]);
+                    grid_->getCell(idx).setState(FMState::FROZEN);
+                }
+            for (const unsigned int & i: init_points_) {
+                grid_->getCell(i).setArrivalTime(0);
+                grid_->getCell(i).setState(FMState::FROZEN);
+            }
+
+            // Lists of the tiles not finished if the goal was reached.
+            for (std::vector<unsigned int> & l : tileLists_)
+                l.clear();
+            for (unsigned int t : activeTiles_)
+                active_[t] = 0;
+            for (unsigned int t : phaseTiles_[1])
+                active_[t] = 0;
+            activeTiles_.clear();
+        }
+
+        /** \brief Returns the number of threads used. */
+        unsigned int getNumberOfThreads
+        () const {
+            if (nthreads_ > 0)
+                return nthreads_;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /** \brief Returns the number of cells per side of the tiles. */
+        unsigned int getTileSize
+        () const {
+            if (tileSize_ > 0)
+                return tileSize_;
+            return (grid_t::getNDims() == 2) ? 16 : ((grid_t::getNDims() == 3) ? 8 : 4);
+        }
+
+        virtual void clear
+        () {
+            times_.clear();
+            states_.clear();
+            rounds_ = 0;
+        }
+
+        virtual void reset
+        () {
+            EikonalSolver<grid_t>::reset();
+            rounds_ = 0;
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Block Fast Iterative Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Tile size: " << getTileSize() << '\n'
+                      << '\t' << "Threads: " << getNumberOfThreads() << '\n'
+                      << '\t' << "Rounds: " << rounds_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the times and states of the tiles, the lists of tiles and
+            the lists of the threads. */
+        virtual size_t memory
+        () const {
+            size_t bytes = EikonalSolver<grid_t>::memory() + MemoryUsage::of(work_) + MemoryUsage::of(times_)
+                    + MemoryUsage::of(states_) + MemoryUsage::of(cellTile_) + MemoryUsage::of(tileColor_)
+                    + MemoryUsage::of(tileLists_) + MemoryUsage::of(active_) + MemoryUsage::of(activeTiles_)
+                    + MemoryUsage::of(phaseTiles_);
+            for (const TileWork & w : work_)
+                bytes += MemoryUsage::of(w.next) + MemoryUsage::of(w.outbox) + MemoryUsage::of(w.visited);
+            return bytes;
+        }
+
+    protected:
+        /** \brief Arrays used by a thread to process the tiles. */
+        struct TileWork {
+            /** \brief Active list of the next pass over the tile being processed. */
+            std::vector<unsigned int>   next;
+
+            /** \brief Neighbors of converged cells which belong to other tiles. */
+            std::vector<unsigned int>   outbox;
+
+            /** \brief Cells reached by the thread, to be copied to the grid. */
+            std::vector<unsigned int>   visited;
+        };
+
+        /** \brief Computes the tile of each cell and colors the tiles. */
+        void buildTiles
+        () {
+            constexpr size_t N = grid_t::getNDims();
+            const std::array<unsigned int, N> dims = grid_->getDimSizes();
+            const unsigned int ts = getTileSize();
+
+            unsigned int ntiles = 1;
+            for (size_t i = 0; i < N; ++i) {
+                ntilesDim_[i] = (dims[i] + ts - 1)/ts;
+                tileStride_[i] = ntiles;
+                ntiles *= ntilesDim_[i];
+            }
+
+            // Padding cells of bricked grids do not belong to any tile.
+            cellTile_.assign(grid_->size(), ntiles);
+            std::array<unsigned int, N> coords;
+            coords.fill(0);
+            for (unsigned int i = 0; i < grid_->getNumberOfCells(); ++i) {
+                unsigned int idx, t = 0;
+                grid_->coord2idx(coords, idx);
+                for (size_t j = 0; j < N; ++j)
+                    t += (coords[j] / ts)*tileStride_[j];
+                cellTile_[idx] = t;
+
+                // Next coordinates in row-major order.
+                for (size_t j = 0; j < N; ++j) {
+                    if (++coords[j] < dims[j])
+                        break;
+                    coords[j] = 0;
+                }
+            }
+
+            tileColor_.resize(ntiles);
+            for (unsigned int t = 0; t < ntiles; ++t) {
+                unsigned int sum = 0;
+                for (size_t i = 0; i < N; ++i)
+                    sum += (t / tileStride_[i]) % ntilesDim_[i];
+                tileColor_[t] = sum & 1;
+            }
+            tileLists_.assign(ntiles, std::vector<unsigned int>());
+            active_.assign(ntiles, 0);
+
+            tiledGrid_ = grid_;
+            tiledDims_ = dims;
+        }
+
+        /** \brief Runs a pass of FIM over the active list of tile t. */
+        void processTile
+        (unsigned int t, TileWork & w) {
+            const grid_t & grid = *grid_;
+            std::vector<unsigned int> & list = tileLists_[t];
+            std::array<unsigned int, 2*grid_t::getNDims()> neighs;
+            w.next.clear();
+            FAST_METHODS_COUNT(PASSES);
+            for (unsigned int x : list) {
+                const value_t p = times_[x];
+                const value_t q = solveEikonal(times_, x);
+                if (!isWithinLimits(x, q)) { // Dropped, it can be activated again by a neighbor.
+                    states_[x] = FMState::OPEN;
+                    continue;
+                }
+                if (q < p)
+                    times_[x] = q;
+                if (p - q > E_) { // Not converged.
+                    w.next.push_back(x);
+                    continue;
+                }
+
+                const unsigned int n_neighs = grid.getNeighbors(x, neighs);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+                for (unsigned int s = 0; s < n_neighs; ++s) {
+                    const unsigned int x_nb = neighs[s];
+                    if (states_[x_nb] != FMState::NARROW && !grid.getCell(x_nb).isOccupied()) {
+                        if (cellTile_[x_nb] != t)
+                            w.outbox.push_back(x_nb);
+                        else if (updateNeighbor(x_nb, w.visited))
+                            w.next.push_back(x_nb);
+                    }
+                }
+                if (x == goal_idx_)
+                    goalReached_ = true;
+                states_[x] = FMState::FROZEN;
+            }
+            // Copied instead of swapped: each list keeps the capacity it needs across passes and queries.
+            list.assign(w.next.begin(), w.next.end());
+        }
+
+        /** \brief Updates the time of x_nb, neighbor of a converged cell. Returns true if it improved,
+            in which case it is set as NARROW. */
+        inline bool updateNeighbor
+        (unsigned int x_nb, std::vector<unsigned int> & visited) {
+            const value_t q = solveEikonal(times_, x_nb);
+            if (!utils::isTimeBetterThan(q, times_[x_nb]) || !isWithinLimits(x_nb, q))
+                return false;
+            times_[x_nb] = q;
+            if (states_[x_nb] == FMState::OPEN)
+                visited.push_back(x_nb);
+            states_[x_nb] = FMState::NARROW;
+            return true;
+        }
+
+        /** \brief Adds the neighbors in the outbox of w to the active lists of their tiles, as FIM does
+            with the neighbors of converged cells. Called after phase (color) c. */
+        void mergeOutbox
+        (TileWork & w, unsigned int c) {
+            for (unsigned int x_nb : w.outbox)
+                if (states_[x_nb] != FMState::NARROW && updateNeighbor(x_nb, w.visited)) {
+                    tileLists_[cellTile_[x_nb]].push_back(x_nb);
+                    scheduleTile(cellTile_[x_nb], c);
+                }
+            w.outbox.clear();
+        }
+
+        /** \brief Adds tile t to the tiles to process after phase c: in the current round (phase 1)
+            if c is 0 and t is of color 1, in the next round otherwise. */
+        inline void scheduleTile
+        (unsigned int t, unsigned int c) {
+            if (active_[t])
+                return;
+            active_[t] = 1;
+            if (c == 0 && tileColor_[t] == 1)
+                phaseTiles_[1].push_back(t);
+            else
+                activeTiles_.push_back(t);
+        }
+
+        using EikonalSolver<grid_t>::grid_;
+        using EikonalSolver<grid_t>::solveEikonal;
+        using EikonalSolver<grid_t>::init_points_;
+        using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::setup_;
+        using EikonalSolver<grid_t>::name_;
+        using EikonalSolver<grid_t>::counters_;
+        using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
+        using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+
+    private:
+        /** \brief Error threshold value that reveals if a cell has converged. */
+        double E_;
+
+        /** \brief Cells per side of the tiles, 0 for the default of getTileSize(). */
+        unsigned int tileSize_;
+
+        /** \brief Number of threads, 0 for as many as hardware threads. */
+        unsigned int nthreads_;
+
+        /** \brief Rounds of the main loop performed. */
+        unsigned int rounds_;
+
+        /** \brief Threads processing the tiles. */
+        WorkerPool pool_;
+
+        /** \brief Arrays of each thread. */
+        std::vector<TileWork> work_;
+
+        /** \brief Arrival times during the computation. */
+        std::vector<value_t> times_;
+
+        /** \brief States of the cells during the computation. */
+        std::vector<FMState> states_;
+
+        /** \brief Set when the goal converges. */
+        std::atomic<bool> goalReached_;
+
+        /** \brief Tile of each cell. */
+        std::vector<unsigned int> cellTile_;
+
+        /** \brief Colors (0 or 1) of the tiles, neighbor tiles have different colors. */
+        std::vector<unsigned char> tileColor_;
+
+        /** \brief Active list of each tile. */
+        std::vector<std::vector<unsigned int> > tileLists_;
+
+        /** \brief For each tile, 1 if it is in activeTiles_ or phaseTiles_. */
+        std::vector<unsigned char> active_;
+
+        /** \brief Tiles to process in the next round. */
+        std::vector<unsigned int> activeTiles_;
+
+        /** \brief Active tiles of each color in the current round. */
+        std::array<std::vector<unsigned int>, 2> phaseTiles_;
+
+        /** \brief Number of tiles in each dimension. */
+        std::array<unsigned int, grid_t::getNDims()> ntilesDim_;
+
+        /** \brief Tile index increment for each dimension. */
+        std::array<unsigned int, grid_t::getNDims()> tileStride_;
+
+        /** \brief Grid and dimensions the tiles were built for. */
+        const grid_t * tiledGrid_ = nullptr;
+        std::array<unsigned int, grid_t::getNDims()> tiledDims_ = {};
+};
+
+#endif /* BFIM_HPP_*/
@@ -0,0 +1,362 @@
+/*! \class BFMM
+    \brief Implements a bidirectional Fast Marching Method for point to point queries.
+
+    Two fronts are marched at the same time: the forward one from the initial points, on the
+    grid as FMM does, and the backward one from the goal, on arrays of the solver. The front
+    with the lowest arrival time frozen last is marched next, so both grow at the same pace.
+    Every time a cell gets a time from one front and already has one from the other, the sum
+    of both is a candidate travel time from the initial points to the goal through that cell
+    (the meeting cell). The propagation finishes when the last frozen times of both fronts add
+    up to at least the best candidate, as no cell out of both fronts can lead to a lower one.
+
+    In open environments each front only covers the half of the distance between the initial
+    points and the goal, which is about the half of the cells of FMM in 2D and the quarter in 3D.
+    The discretization of the Eikonal equation is not symmetric, so with obstacles or varying
+    velocities the travel time can differ slightly from the one of FMM (relative errors about
+    1e-4 in 2D and 1e-3 in 3D).
+
+    The grid holds the arrival times of the forward front only, so the goal cell usually
+    keeps an infinite arrival time: the travel time is given by getPathTime() and the path by
+    computePath(), which descends both fields from the meeting cell. The times of the backward
+    front are given by getBackwardTimes(). Without goal it works as FMM. The limits of the
+    propagation (see Solver) only apply to the forward front.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BFMM_HPP_
+#define BFMM_HPP_
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+#include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/datastructures/fmkeyheap.hpp>
+#include <fast_methods/gradientdescent/gradientdescent.hpp>
+#include <fast_methods/utils/utils.h>
+
+template < class grid_t, class heap_t = FMKeyHeap<typename grid_t::cell_t> > class BFMM : public EikonalSolver<grid_t> {
+
+    public:
+        typedef typename EikonalSolver<grid_t>::value_t value_t;
+
+        /** \brief Path type encapsulation. */
+        typedef std::vector< std::array<double, grid_t::getNDims()> > path_t;
+
+        BFMM() : EikonalSolver<grid_t>("BFMM") { clearRunInfo(); }
+
+        BFMM(const char * name) : EikonalSolver<grid_t>(name) { clearRunInfo(); }
+
+        virtual ~BFMM() { clear(); }
+
+        /** \brief Executes EikonalSolver setup and allocates the narrow band and the arrays of the backward front. */
+        virtual void setup
+        () {
+            EikonalSolver<grid_t>::setup();
+            narrow_band_.setMaxSize(grid_->size());
+            if (backTimes_.size() != grid_->size()) {
+                backTimes_.assign(grid_->size(), std::numeric_limits<value_t>::infinity());
+                backFrozen_.assign(grid_->size(), false);
+                backTouched_.clear();
+            }
+        }
+
+        /** \brief Actual method that implements bidirectional FMM. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            restoreBackward();
+            clearRunInfo();
+            value_t lastForward = 0;
+            value_t lastBackward = 0;
+
+            for (const unsigned int & i: init_points_) {
+                grid_->getCell(i).setArrivalTime(0);
+                grid_->getCell(i).setState(FMState::NARROW);
+                narrow_band_.push(grid_->getCellPtr(i));
+                FAST_METHODS_COUNT(HEAP_PUSHES);
+            }
+
+            const bool hasGoal = int(goal_idx_) != -1;
+            if (hasGoal)
+                setBackwardTime(goal_idx_, 0);
+
+            while (true) {
+                const bool forward = !narrow_band_.empty();
+                const bool backward = !band_.empty();
+                if (!forward && !backward)
+                    break;
+                // An exhausted front does not bound the times of the candidates anymore.
+                if (hasGoal && (forward ? lastForward : 0) + (backward ? lastBackward : 0) >= pathTime_)
+                    break;
+                if (forward && (!backward || lastForward <= lastBackward))
+                    lastForward = forwardStep();
+                else
+                    lastBackward = backwardStep();
+            }
+        }
+
+        /** \brief Computes the path from the goal to the closest initial point: the backward times are descended
+            from the meeting cell to the goal and the forward times from the meeting cell to the initial point.
+            The path is empty if the goal was not reached. */
+        void computePath
+        (path_t * p, std::vector <double> * path_velocity, double step = 1) {
+            p->clear();
+            path_velocity->clear();
+            if (int(meeting_) == -1)
+                return;
+
+            path_t toGoal, toInit;
+            std::vector<double> velsToGoal, velsToInit;
+            unsigned int idx = meeting_;
+            GradientDescent<grid_t>::apply(*grid_, backTimes_, idx, toGoal, velsToGoal, step);
+            idx = meeting_;
+            GradientDescent<grid_t>::apply(*grid_, idx, toInit, velsToInit, step);
+
+            // The meeting cell is the first point of both.
+            p->assign(toGoal.rbegin(), toGoal.rend());
+            p->insert(p->end(), toInit.begin() + 1, toInit.end());
+            path_velocity->assign(velsToGoal.rbegin(), velsToGoal.rend());
+            path_velocity->insert(path_velocity->end(), velsToInit.begin() + 1, velsToInit.end());
+        }
+
+        /** \brief Returns the travel time from the initial points to the goal, infinity if not reached. */
+        double getPathTime
+        () const {
+            return pathTime_;
+        }
+
+        /** \brief Returns the cell in which both fronts met with the lowest travel time, -1 if they did not. */
+        unsigned int getMeetingIdx
+        () const {
+            return meeting_;
+        }
+
+        /** \brief Returns the arrival times of the backward front (from the goal), indexed as the grid. */
+        const std::vector<value_t> & getBackwardTimes
+        () const {
+            return backTimes_;
+        }
+
+        /** \brief Returns the number of cells frozen by the forward and backward fronts in the last run. */
+        unsigned int getFrozenCells
+        () const {
+            return frozenForward_ + frozenBackward_;
+        }
+
+        virtual void clear
+        () {
+            narrow_band_.clear();
+            band_.clear();
+            backTimes_.clear();
+            backFrozen_.clear();
+            backTouched_.clear();
+        }
+
+        virtual void reset
+        () {
+            EikonalSolver<grid_t>::reset();
+            narrow_band_.clear();
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Bidirectional Fast Marching Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Frozen cells (forward/backward): " << frozenForward_ << '/' << frozenBackward_ << '\n'
+                      << '\t' << "Path time: " << pathTime_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the narrow band and the backward front. */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + MemoryUsage::of(narrow_band_) + heap_t::sharedMemory()
+                    + MemoryUsage::of(band_) + MemoryUsage::of(backTimes_) + MemoryUsage::of(backFrozen_)
+                    + MemoryUsage::of(backTouched_);
+        }
+
+        virtual size_t sharedMemory
+        () const {
+            return heap_t::sharedMemory();
+        }
+
+    protected:
+        using EikonalSolver<grid_t>::grid_;
+        using EikonalSolver<grid_t>::init_points_;
+        using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::setup_;
+        using EikonalSolver<grid_t>::name_;
+        using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
+        using EikonalSolver<grid_t>::solveEikonal;
+        using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::counters_;
+
+    private:
+        /** \brief Freezes the cell of the forward narrow band with the lowest arrival time and updates its
+            neighbors, as FMM. Returns the time of the frozen cell. */
+        value_t forwardStep
+        () {
+            const grid_t & cgrid = *grid_;
+            FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, narrow_band_.size() + band_.size());
+            const unsigned int idxMin = narrow_band_.popMinIdx();
+            FAST_METHODS_COUNT(HEAP_POPS);
+            grid_->getCell(idxMin).setState(FMState::FROZEN);
+            ++frozenForward_;
+            const value_t t = cgrid.getCell(idxMin).getArrivalTime();
+
+            const unsigned int n_neighs = grid_->getNeighbors(idxMin, neighbors_);
+            FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+            for (unsigned int s = 0; s < n_neighs; ++s) {
+                const unsigned int j = neighbors_[s];
+                if ((cgrid.getCell(j).getState() == FMState::FROZEN) || cgrid.getCell(j).isOccupied())
+                    continue;
+                const double new_arrival_time = solveEikonal(j);
+                if (!isWithinLimits(j, new_arrival_time))
+                    continue;
+
+                if (cgrid.getCell(j).getState() == FMState::NARROW) {
+                    if (utils::isTimeBetterThan(new_arrival_time, cgrid.getCell(j).getArrivalTime())) {
+                        grid_->getCell(j).setArrivalTime(new_arrival_time);
+                        narrow_band_.increase(grid_->getCellPtr(j));
+                        FAST_METHODS_COUNT(HEAP_INCREASES);
+                    }
+                }
+                else {
+                    grid_->getCell(j).setState(FMState::NARROW);
+                    grid_->getCell(j).setArrivalTime(new_arrival_time);
+                    narrow_band_.push(grid_->getCellPtr(j));
+                    FAST_METHODS_COUNT(HEAP_PUSHES);
+                }
+                meet(j);
+            }
+            return t;
+        }
+
+        /** \brief Freezes the cell of the backward band with the lowest time and updates its neighbors.
+            Returns the time of the frozen cell. */
+        value_t backwardStep
+        () {
+            std::pair<value_t, unsigned int> b;
+            FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, narrow_band_.size() + band_.size());
+            do {
+                std::pop_heap(band_.begin(), band_.end(), std::greater<std::pair<value_t, unsigned int> >());
+                b = band_.back();
+                band_.pop_back();
+                FAST_METHODS_COUNT(HEAP_POPS);
+            } while ((b.first != backTimes_[b.second] || backFrozen_[b.second]) && !band_.empty());
+            // Stale entries only remain if all of them are, then nothing is frozen.
+            if (b.first != backTimes_[b.second] || backFrozen_[b.second])
+                return b.first;
+
+            backFrozen_[b.second] = true;
+            ++frozenBackward_;
+
+            const grid_t & cgrid = *grid_;
+            const unsigned int n_neighs = cgrid.getNeighbors(b.second, backNeighbors_);
+            FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+            for (unsigned int s = 0; s < n_neighs; ++s) {
+                const unsigned int j = backNeighbors_[s];
+                if (backFrozen_[j] || cgrid.getCell(j).isOccupied())
+                    continue;
+                const value_t t = solveEikonal(backTimes_, j);
+                if (utils::isTimeBetterThan(t, backTimes_[j]))
+                    setBackwardTime(j, t);
+            }
+            return b.first;
+        }
+
+        /** \brief Sets the backward time of cell idx and pushes it into the backward band. */
+        void setBackwardTime
+        (unsigned int idx, value_t t) {
+            if (std::isinf(backTimes_[idx]))
+                backTouched_.push_back(idx);
+            backTimes_[idx] = t;
+            band_.push_back(std::make_pair(t, idx));
+            std::push_heap(band_.begin(), band_.end(), std::greater<std::pair<value_t, unsigned int> >());
+            FAST_METHODS_COUNT(HEAP_PUSHES);
+            meet(idx);
+        }
+
+        /** \brief Updates the best travel time if cell idx has times from both fronts. */
+        void meet
+        (unsigned int idx) {
+            const grid_t & cgrid = *grid_;
+            const double t = double(cgrid.getCell(idx).getArrivalTime()) + backTimes_[idx];
+            if (t < pathTime_) {
+                pathTime_ = t;
+                meeting_ = idx;
+            }
+        }
+
+        /** \brief Restores the cells of the backward front of the previous run. */
+        void restoreBackward
+        () {
+            for (const unsigned int i : backTouched_) {
+                backTimes_[i] = std::numeric_limits<value_t>::infinity();
+                backFrozen_[i] = false;
+            }
+            backTouched_.clear();
+            band_.clear();
+        }
+
+        void clearRunInfo
+        () {
+            pathTime_ = std::numeric_limits<double>::infinity();
+            meeting_ = -1;
+            frozenForward_ = 0;
+            frozenBackward_ = 0;
+        }
+
+        /** \brief Instance of the heap used by the forward front. */
+        heap_t                                          narrow_band_;
+
+        /** \brief Narrow band of the backward front, a binary heap of times and cells. Entries of cells
+            improved later are discarded when popped. */
+        std::vector<std::pair<value_t, unsigned int> >  band_;
+
+        /** \brief Arrival times of the backward front (from the goal). */
+        std::vector<value_t>                            backTimes_;
+
+        /** \brief Cells frozen by the backward front. */
+        std::vector<bool>                               backFrozen_;
+
+        /** \brief Cells with backward time, restored in the next run. */
+        std::vector<unsigned int>                       backTouched_;
+
+        /** \brief Neighbors of the cell frozen by the backward front. */
+        std::array <unsigned int, 2*grid_t::getNDims()> backNeighbors_;
+
+        /** \brief Best travel time from the initial points to the goal and cell where it was found. */
+        double                                          pathTime_;
+        unsigned int                                    meeting_;
+
+        /** \brief Number of cells frozen in the last run by each front. */
+        unsigned int                                    frozenForward_;
+        unsigned int                                    frozenBackward_;
+};
+
+#endif /* BFMM_HPP_*/
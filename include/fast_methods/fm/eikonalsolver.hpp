@@ -29,83 +29,113 @@
 #include <numeric>
 #include <fstream>
 #include <array>
+#include <vector>
 #include <chrono>
+#include <limits>
 
 #include <boost/concept_check.hpp>
 
 #include <fast_methods/fm/solver.hpp>
+#include <fast_methods/fm/eikonalkernel.hpp>
 #include <fast_methods/console/console.h>
 
 template <class grid_t>
 class EikonalSolver : public Solver<grid_t>{
 
     public:
+        /** \brief Scalar type in which times are stored and the Eikonal equation is solved. */
+        typedef typename grid_t::value_t value_t;
+
         EikonalSolver() : Solver<grid_t>("EikonalSolver") {}
         EikonalSolver(const std::string& name) : Solver<grid_t>(name) {}
 
+        /** \brief Executes Solver setup and caches the squared leaf size used by solveEikonal(). */
+        virtual void setup
+        () {
+            Solver<grid_t>::setup();
+            leafsize_ = grid_->getLeafSize();
+            leafsize2_ = leafsize_ * leafsize_;
+        }
+
         /** \brief Solves nD Eikonal equation for cell idx. If heuristics are activated, it will add
-            the estimated travel time to goal with current velocity. */
-        virtual double solveEikonal
+            the estimated travel time to goal with current velocity.
+
+            It is allocation-free: see EikonalKernel. Requires setup() to be called before. It is not
+            virtual, so that it is inlined in the loops of the solvers: FMM and FSM take the most
+            derived solver as a template parameter to call the update of the derived class. */
+        double solveEikonal
         (const int & idx) {
-            unsigned int a = grid_t::getNDims(); // a parameter of the Eikonal equation.
-            Tvalues_.clear();
+            // Cells are only read, through the const grid so that they are not marked as dirty.
+            return solveEikonal(*grid_, idx);
+        }
+
+        /** \brief solveEikonal() on the given grid instead of the grid of the solver, for solvers
+            splitting the grid into several ones. The leaf size has to be the same. */
+        value_t solveEikonal
+        (const grid_t & grid, unsigned int idx) const {
+            FAST_METHODS_COUNT(EIKONAL_SOLVES);
+            unsigned int a = 0; // a parameter of the Eikonal equation.
+            const value_t Tidx = grid.getCell(idx).getArrivalTime();
 
+            // Dimensions which do not contribute are set to infinity, so they are sorted last.
+            std::array<value_t, grid_t::getNDims()> T;
             for (unsigned int dim = 0; dim < grid_t::getNDims(); ++dim) {
-                double minTInDim = grid_->getMinValueInDim(idx, dim);
-                if (!isinf(minTInDim) && minTInDim < grid_->getCell(idx).getArrivalTime())
-                    Tvalues_.push_back(minTInDim);
+                const value_t minTInDim = grid.getMinValueInDim(idx, dim);
+                if (!std::isinf(minTInDim) && minTInDim < Tidx) {
+                    T[dim] = minTInDim;
+                    ++a;
+                }
                 else
-                    a -=1;
+                    T[dim] = std::numeric_limits<value_t>::infinity();
             }
 
             if (a == 0)
-                return std::numeric_limits<double>::infinity();
-
-            // Sort the neighbor values to make easy the following code.
-            /// \todo given that this sorts a small vector, a n^2 methods could be better. Test it.
-            std::sort(Tvalues_.begin(), Tvalues_.end());
-            double updatedT;
-            for (unsigned i = 1; i <= a; ++i) {
-                updatedT = solveEikonalNDims(idx, i);
-                // If no more dimensions or increasing one dimension will not improve time.
-                if (i == a || (updatedT - Tvalues_[i]) < utils::COMP_MARGIN)
-                    break;
-            }
-            return updatedT;
+                return std::numeric_limits<value_t>::infinity();
+
+            EikonalSort<value_t, grid_t::getNDims()>::sort(T);
+            const value_t vel = grid.getCell(idx).getVelocity();
+            return EikonalKernel<value_t, grid_t::getNDims()>::solve(T, a, leafsize_ / vel, leafsize2_ / (vel*vel));
         }
 
-    protected:
-        /** \brief Solves the Eikonal equation assuming that Tvalues_
-            is sorted. */
-        double solveEikonalNDims
-        (unsigned int idx, unsigned int dim) {
-            // Solve for 1 dimension.
-            if (dim == 1)
-                return Tvalues_[0] + grid_->getLeafSize() / grid_->getCell(idx).getVelocity();
-
-            // Solve for any number > 1 of dimensions.
-            double sumT = 0;
-            double sumTT = 0;
-            for (unsigned i = 0; i < dim; ++i) {
-                sumT += Tvalues_[i];
-                sumTT += Tvalues_[i]*Tvalues_[i];
+        /** \brief solveEikonal() reading the times from the given array instead of the grid, for solvers
+            working on their own arrays. It does not modify the solver nor the grid. */
+        value_t solveEikonal
+        (const std::vector<value_t> & times, unsigned int idx) const {
+            FAST_METHODS_COUNT(EIKONAL_SOLVES);
+            constexpr size_t N = grid_t::getNDims();
+            const grid_t & grid = *grid_;
+            unsigned int a = 0;
+            const value_t Tidx = times[idx];
+            std::array<value_t, N> T;
+            std::array<unsigned int, 2> neighs;
+            for (unsigned int dim = 0; dim < N; ++dim) {
+                unsigned int n = 0;
+                grid.getNeighborsInDim(idx, neighs, n, dim);
+                value_t minTInDim = std::numeric_limits<value_t>::infinity();
+                for (unsigned int j = 0; j < n; ++j)
+                    minTInDim = std::min(minTInDim, times[neighs[j]]);
+                if (!std::isinf(minTInDim) && minTInDim < Tidx) {
+                    T[dim] = minTInDim;
+                    ++a;
+                }
+                else
+                    T[dim] = std::numeric_limits<value_t>::infinity();
             }
 
-            // These a,b,c values are simplified since leafsize^2, which should be present in the three
-            // terms but they are cancelled out when solving the quadratic function.
-            double a = dim;
-            double b = -2*sumT;
-            double c = sumTT - grid_->getLeafSize() * grid_->getLeafSize() / (grid_->getCell(idx).getVelocity()*grid_->getCell(idx).getVelocity());
-            double quad_term = b*b - 4*a*c;
-
-            if (quad_term < 0)
-                return std::numeric_limits<double>::infinity();
-            else
-                return (-b + sqrt(quad_term))/(2*a);
+            if (a == 0)
+                return std::numeric_limits<value_t>::infinity();
+
+            EikonalSort<value_t, N>::sort(T);
+            const value_t vel = grid.getCell(idx).getVelocity();
+            return EikonalKernel<value_t, N>::solve(T, a, leafsize_ / vel, leafsize2_ / (vel*vel));
         }
 
-        /** \brief Auxiliar vector with values T0,T1...Tn-1 variables in the Discretized Eikonal Equation. */
-        std::vector<double>          Tvalues_;
+    protected:
+        /** \brief Leaf size of the grid, cached in setup(). */
+        double                       leafsize_;
+
+        /** \brief Squared leaf size of the grid, cached in setup(). */
+        double                       leafsize2_;
 
         /** \brief Auxiliar array which stores the neighbor of each iteration of the computeFM() function. */
         std::array <unsigned int, 2*grid_t::getNDims()> neighbors_;
@@ -28,7 +28,7 @@
 #ifndef FIM_HPP_
 #define FIM_HPP_
 
-#include <list>
+#include <vector>
 
 #include <fast_methods/fm/eikonalsolver.hpp>
 #include <fast_methods/utils/utils.h>
@@ -41,6 +41,14 @@ template < class grid_t > class FIM : public EikonalSolver<grid_t> {
 
         virtual ~FIM() { clear(); }
 
+        /** \brief Reserves the active lists for the whole grid, so that queries do not allocate. */
+        virtual void setup
+        () {
+            EikonalSolver<grid_t>::setup();
+            active_list_.reserve(grid_->size());
+            next_list_.reserve(grid_->size());
+        }
+
         /** \brief Actual method that implements FIM. */
         virtual void computeInternal
         () {
@@ -59,6 +67,7 @@ template < class grid_t > class FIM : public EikonalSolver<grid_t> {
                 grid_->getCell(i).setState(FMState::FROZEN);
 
                 n_neighs = grid_->getNeighbors(i, neighbors_);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                 for (unsigned int s = 0; s < n_neighs; ++s) {// For each neighbor
                     x_nb = neighbors_[s];
                     if ( (grid_->getCell(x_nb).getState() == FMState::OPEN) && !grid_->getCell(x_nb).isOccupied()) {
@@ -68,45 +77,77 @@ template < class grid_t > class FIM : public EikonalSolver<grid_t> {
                 }
             }
 
-            // Main loop.
+            // Main loop. Each iteration the cells of active_list_ are updated in order and the list of the
+            // next iteration is built in next_list_: cells not converged are kept in their position, and
+            // converged ones are replaced by the neighbors they activate.
             while(!stopWavePropagation && !active_list_.empty()) {
-                for (std::list<unsigned int>::iterator x = active_list_.begin(); x!=active_list_.end(); ++x) { // for each cell of active_list
-                    p = grid_->getCell(*x).getArrivalTime();
-                    q = solveEikonal(*x);
-                    grid_->getCell(*x).setArrivalTime(q);
+                next_list_.clear();
+                FAST_METHODS_COUNT(PASSES);
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, active_list_.size());
+                for (const unsigned int x : active_list_) { // for each cell of active_list
+                    p = grid_->getCell(x).getArrivalTime();
+                    q = solveEikonal(x);
+                    if (!isWithinLimits(x, q)) { // Dropped, it can be activated again by a neighbor.
+                        grid_->getCell(x).setState(FMState::OPEN);
+                        continue;
+                    }
+                    grid_->getCell(x).setArrivalTime(q);
                     if (fabs(p - q) <= E_) { // if the cell has converged
-                        n_neighs = grid_->getNeighbors(*x, neighbors_);
+                        n_neighs = grid_->getNeighbors(x, neighbors_);
+                        FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                         for (unsigned int s = 0; s < n_neighs; ++s){ // For each neighbor of converged cells of active_list
                             x_nb = neighbors_[s];
                             if (grid_->getCell(x_nb).getState() != FMState::NARROW && !grid_->getCell(x_nb).isOccupied()) {
                                 p = grid_->getCell(x_nb).getArrivalTime();
                                 q = solveEikonal(x_nb);
-                                if (utils::isTimeBetterThan(q, p)) {
+                                if (utils::isTimeBetterThan(q, p) && isWithinLimits(x_nb, q)) {
                                     grid_->getCell(x_nb).setArrivalTime(q);
-                                    active_list_.insert(x, x_nb);
+                                    next_list_.push_back(x_nb);
                                     grid_->getCell(x_nb).setState(FMState::NARROW);
                                     }
                             }
                         }// For each neighbor of converged cells of active_list
-                    if (*x == goal_idx_)
+                    if (goalFrozen(x))
                         stopWavePropagation = true;
-                    grid_->getCell(*x).setState(FMState::FROZEN);
-                    x = active_list_.erase(x);
-                    --x;
+                    grid_->getCell(x).setState(FMState::FROZEN);
                     }// if the cell has converged
+                    else
+                        next_list_.push_back(x);
                 }// for each cell of active_list
+                if (stopRequested(std::numeric_limits<double>::quiet_NaN(), active_list_.size()))
+                    stopWavePropagation = true;
+                active_list_.swap(next_list_);
             }//while active_list is not empty
         }
 
         virtual void clear
         () {
             active_list_.clear();
+            next_list_.clear();
         }
 
         virtual void reset
         () {
             EikonalSolver<grid_t>::reset();
             active_list_.clear();
+            next_list_.clear();
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Fast Iterative Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Error threshold: " << E_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the active lists. */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + MemoryUsage::of(active_list_) + MemoryUsage::of(next_list_);
         }
 
     protected:
@@ -114,13 +155,22 @@ template < class grid_t > class FIM : public EikonalSolver<grid_t> {
         using EikonalSolver<grid_t>::solveEikonal;
         using EikonalSolver<grid_t>::init_points_;
         using EikonalSolver<grid_t>::goal_idx_;
-        using EikonalSolver<grid_t>::setup;
+        using EikonalSolver<grid_t>::goalFrozen;
+        using EikonalSolver<grid_t>::stopRequested;
         using EikonalSolver<grid_t>::setup_;
         using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::name_;
+        using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
+        using EikonalSolver<grid_t>::counters_;
 
     private:
-        /** \brief List wich stores the narrow band of each iteration. */
-        std::list<unsigned int> active_list_;
+        /** \brief Active list (narrow band) of the current iteration. */
+        std::vector<unsigned int> active_list_;
+
+        /** \brief Active list of the next iteration, swapped with active_list_ after each iteration. */
+        std::vector<unsigned int> next_list_;
         
         /** \brief Error threshold value that reveals if a cell has converged. */
         double E_;
@@ -9,12 +9,32 @@
     The type of the heap introduced is very important for the behaviour of the
     algorithm. The following heaps are provided:
 
-    - FMDaryHeap wrap for the Boost D_ary heap (generalization of binary heaps).
-    * Set by default if no other heap is specified. The arity has been set to 2
-    * (binary heap) since it has been tested to be the more efficient in this algorithm.
+    - FMKeyHeap 4-ary heap storing the values of the cells next to their indices, so
+    * comparisons do not access the cells. Set by default if no other heap is specified.
+    - FMDaryHeap wrap for the Boost D_ary heap (generalization of binary heaps). The arity
+    * has been set to 2 (binary heap) since it has been tested to be the more efficient
+    * of Boost heaps in this algorithm.
     - FMFibHeap wrap for the Boost Fibonacci heap.
     - FMPriorityQueue wrap to the std::PriorityQueue class. This heap implies the implementation
     * of the Simplified FMM (SFMM) method, done automatically because of the FMPriorityQueue::increase implementation.
+    - FMRadixHeap monotone radix heap. Same order as the binary heap, without comparisons.
+    - FMHashHeap FMKeyHeap with the positions of the cells in a hash map, so its memory depends
+    * on the size of the narrow band instead of the size of the grid.
+
+    After a complete run (no goal nor heuristics), update() repairs the arrival times when the
+    velocities of some cells change, and moveInitialPoints() when the initial points move,
+    instead of running again. As in LPA* and E*, cells whose time is not the one computed from
+    their neighbors are popped by the lowest of both: cells with a higher time take the new one
+    and are frozen, as in FMM, and cells with a lower time are set as not reached and pushed
+    again. Then their neighbors are checked. Only the cells whose time changes, and their
+    neighbors, are visited, and the result is the same as running FMM again. Keys of cells can
+    increase, so these cells are kept in a binary heap with lazy deletion of their own instead
+    of the narrow band.
+
+    derived_t is the most derived solver (CRTP), void for FMM itself: the main loop calls its
+    solveEikonal() without virtual dispatch, so derived solvers can replace the update of the
+    cells at compile time (see FMMStar). The main loop is also instantiated with and without
+    heuristics, so that FMM does not check them for every cell.
 
     @par External documentation:
         FMM:
@@ -49,31 +69,49 @@
 #include <numeric>
 #include <fstream>
 #include <array>
+#include <vector>
+#include <limits>
+#include <chrono>
+#include <functional>
+#include <type_traits>
 
 #include <fast_methods/fm/eikonalsolver.hpp>
 
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/datastructures/fmkeyheap.hpp>
 #include <fast_methods/datastructures/fmdaryheap.hpp>
 
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
 #include <fast_methods/console/console.h>
 
-/** \brief Heuristic strategy to be used. TIME = DISTANCE/local velocity. */
-enum HeurStrategy {NOHEUR = 0, TIME, DISTANCE};
+/** \brief Heuristic strategy to be used, from the Euclidean distance to the goal in cells. TIME = DISTANCE/local
+    velocity. OCTILE = octile distance (in 2D the diagonal steps plus the straight ones), not lower than
+    DISTANCE. MAXSPEED = DISTANCE*leaf size/maximum speed, a lower bound of the arrival time. */
+enum HeurStrategy {NOHEUR = 0, TIME, DISTANCE, OCTILE, MAXSPEED};
 
-template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMM : public EikonalSolver<grid_t> {
+template < class grid_t, class heap_t = FMKeyHeap<typename grid_t::cell_t>, class derived_t = void >  class FMM : public EikonalSolver<grid_t> {
 
     public:
-        FMM(HeurStrategy h = NOHEUR) : EikonalSolver<grid_t>("FMM"), heurStrategy_(h), precomputed_(false) {
+        FMM(HeurStrategy h = NOHEUR) : EikonalSolver<grid_t>("FMM"), heurStrategy_(h), heurSpeed_(0), gridSpeed_(0),
+            complete_(false), repaired_(0) {
             /// \todo automate the naming depending on the heap.
             //if (static_cast<FMFibHeap>(heap_t))
              //   name_ = "FMMFib";
         }
 
-        FMM(const char * name, HeurStrategy h = NOHEUR) : EikonalSolver<grid_t>(name), heurStrategy_(h), precomputed_(false) {}
+        FMM(const char * name, HeurStrategy h = NOHEUR) : EikonalSolver<grid_t>(name), heurStrategy_(h), heurSpeed_(0), gridSpeed_(0),
+            complete_(false), repaired_(0) {}
 
         virtual ~FMM() { clear(); }
 
+        /** \brief Sets the environment. The maximum speed used by the MAXSPEED heuristic is computed again. */
+        virtual void setEnvironment
+        (grid_t * g) {
+            EikonalSolver<grid_t>::setEnvironment(g);
+            gridSpeed_ = 0;
+            complete_ = false;
+        }
+
         /** \brief Executes EikonalSolver setup and sets maximum size for the narrow band. */
         virtual void setup
         () {
@@ -93,72 +131,98 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMM : public
             if (!setup_)
                 setup();
 
-            unsigned int j = 0;
-            unsigned int n_neighs = 0;
-            bool stopWavePropagation = false;
-
             // Algorithm initialization
             for (unsigned int &i: init_points_) { // For each initial point
                 grid_->getCell(i).setArrivalTime(0);
                 // Include heuristics if necessary.
-                if (heurStrategy_ == TIME)
-                    grid_->getCell(i).setHeuristicTime( getPrecomputedDistance(i)/grid_->getCell(i).getVelocity() );
-                else if (heurStrategy_ == DISTANCE)
-                    grid_->getCell(i).setHeuristicTime( getPrecomputedDistance(i) );
-                narrow_band_.push( &(grid_->getCell(i)) );
+                if (heurStrategy_ != NOHEUR)
+                    grid_->getCell(i).setHeuristicTime(getHeuristic(i));
+                narrow_band_.push( grid_->getCellPtr(i) );
+                FAST_METHODS_COUNT(HEAP_PUSHES);
             }
 
-            // Main loop.
-            unsigned int idxMin = 0;
-            while (!stopWavePropagation && !narrow_band_.empty()) {
-                idxMin = narrow_band_.popMinIdx();
-                n_neighs = grid_->getNeighbors(idxMin, neighbors_);
-                grid_->getCell(idxMin).setState(FMState::FROZEN);
-                for (unsigned int s = 0; s < n_neighs; ++s) {
-                    j = neighbors_[s];
-                    if ((grid_->getCell(j).getState() == FMState::FROZEN) || grid_->getCell(j).isOccupied())
-                        continue;
-                    else {
-                        double new_arrival_time = solveEikonal(j);
+            if (heurStrategy_ == NOHEUR)
+                propagate<false>();
+            else
+                propagate<true>();
 
-                        // Include heuristics if necessary.
-                        if (heurStrategy_ == TIME)
-                            grid_->getCell(j).setHeuristicTime( getPrecomputedDistance(j)/grid_->getCell(j).getVelocity() );
-                        else if (heurStrategy_ == DISTANCE)
-                            grid_->getCell(j).setHeuristicTime( getPrecomputedDistance(j) );
+            complete_ = narrow_band_.empty() && heurStrategy_ == NOHEUR;
+            if (complete_) {
+                sources_ = init_points_;
+                std::sort(sources_.begin(), sources_.end());
+            }
+        }
 
-                        // Updating narrow band if necessary.
-                        if (grid_->getCell(j).getState() == FMState::NARROW) {
-                            if (utils::isTimeBetterThan(new_arrival_time, grid_->getCell(j).getArrivalTime())) {
-                                grid_->getCell(j).setArrivalTime(new_arrival_time);
-                                narrow_band_.increase( &(grid_->getCell(j)) );
-                            }
-                        }
-                        else {
-                            grid_->getCell(j).setState(FMState::NARROW);
-                            grid_->getCell(j).setArrivalTime(new_arrival_time);
-                            narrow_band_.push( &(grid_->getCell(j)) );
-                        } // neighbors_ open.
-                    } // neighbors_ not frozen.
-                } // For each neighbor.
+        /** \brief Repairs the arrival times after the velocities (or occupancies) of cells have changed,
+            giving the same result as running again. If the last run was not complete (it had a goal or
+            heuristics, or the solver was reset), or the changes reach a large part of the grid, it runs
+            again instead. */
+        void update
+        (const std::vector<unsigned int> & cells) {
+            start_ = std::chrono::steady_clock::now();
+            if (!complete_)
+                computeAgain();
+            else {
+                repaired_ = 0;
+                for (unsigned int i : cells)
+                    checkCell(i);
+                if (!repair())
+                    computeAgain();
+            }
+            end_ = std::chrono::steady_clock::now();
+            time_ = std::chrono::duration<double, std::milli>(end_-start_).count();
+        }
 
-                if (idxMin == goal_idx_)
-                    stopWavePropagation = true;
-            } // while narrow band not empty
+        /** \brief Sets new initial points and repairs the arrival times, as update(). The arrival time of
+            most cells changes if the initial points move, unless new initial points are added. With a
+            maximum distance (which depends on the initial points) it runs again. */
+        void moveInitialPoints
+        (const std::vector<unsigned int> & init_points) {
+            start_ = std::chrono::steady_clock::now();
+            const std::vector<unsigned int> old = init_points_;
+            init_points_ = init_points;
+            if (!complete_ || !std::isinf(this->getMaxDistance()))
+                computeAgain();
+            else {
+                repaired_ = 0;
+                sources_ = init_points_;
+                std::sort(sources_.begin(), sources_.end());
+                for (unsigned int i : init_points_)
+                    checkCell(i);
+                for (unsigned int i : old)
+                    checkCell(i);
+                if (!repair())
+                    computeAgain();
+            }
+            end_ = std::chrono::steady_clock::now();
+            time_ = std::chrono::duration<double, std::milli>(end_-start_).count();
+        }
+
+        /** \brief Returns the number of cells repaired by the last update() or moveInitialPoints(). */
+        unsigned int getRepairedCells
+        () const {
+            return repaired_;
         }
 
-        /** \brief Set heuristics flag. True is activated. It will precompute distances
-            if not done already. */
+        /** \brief Sets the heuristic strategy. Heuristics are only activated if there is a goal point. */
         void setHeuristics
         (HeurStrategy h) {
             if (h && int(goal_idx_)!=-1) {
                 heurStrategy_ = h;
                 grid_->idx2coord(goal_idx_, heur_coord_);
-                if (!precomputed_)
-                    precomputeDistances();
+                if (h == MAXSPEED && heurSpeed_ <= 0 && gridSpeed_ <= 0)
+                    gridSpeed_ = grid_->getMaxSpeed();
             }
         }
 
+        /** \brief Sets the speed dividing the distances of the MAXSPEED heuristic, which must not be lower
+            than any speed of the grid so that it is a lower bound. 0 (default) for the maximum speed of the
+            grid, computed once per environment. */
+        void setHeuristicSpeed
+        (double v) {
+            heurSpeed_ = v;
+        }
+
         /** \brief Returns heuristics flag. */
         HeurStrategy getHeuristics
         () const {
@@ -168,50 +232,28 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMM : public
         virtual void clear
         () {
             narrow_band_.clear();
-            distances_.clear();
-            precomputed_ = false;
+            gridSpeed_ = 0;
         }
 
         virtual void reset
         () {
             EikonalSolver<grid_t>::reset();
             narrow_band_.clear();
+            complete_ = false;
         }
 
-        /** \brief Computes euclidean distance between goal and rest of cells. */
-        virtual void precomputeDistances
-        () {
-            distances_.reserve(grid_->size());
+        /** \brief Returns the heuristic value of cell idx, computed from its coordinates. */
+        double getHeuristic
+        (unsigned int idx) const {
             std::array <unsigned int, grid_t::getNDims()> coords;
-            double dist = 0;
-
-            for (size_t i = 0; i < grid_->size(); ++i)
-            {
-                dist = 0;
-                grid_->idx2coord(i, coords);
-
-                for (size_t j = 0; j < coords.size(); ++j)
-                    dist += coords[j]*coords[j];
-
-                distances_[i] = std::sqrt(dist);
+            grid_->idx2coord(idx, coords);
+            std::array <int, grid_t::getNDims()> d;
+            int d2 = 0;
+            for (unsigned int i = 0; i < grid_t::getNDims(); ++i) {
+                d[i] = int(coords[i]) - int(heur_coord_[i]);
+                d2 += d[i]*d[i];
             }
-            precomputed_ = true;
-        }
-
-        /** \brief Extracts the euclidean distance calculated from precomputeDistances
-            function distance between two positions. */
-        virtual double getPrecomputedDistance
-        (const unsigned int idx) {
-            std::array <unsigned int, grid_t::getNDims()> position, distance;
-            grid_->idx2coord(idx, position);
-
-            for (unsigned int i = 0; i < grid_t::getNDims(); ++i)
-                distance[i] = utils::absUI(position[i] - heur_coord_[i]);
-
-            unsigned int idx_dist;
-            grid_->coord2idx(distance, idx_dist);
-
-            return distances_[idx_dist];
+            return heuristicOf(idx, d, d2);
         }
 
         virtual void printRunInfo
@@ -219,7 +261,22 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMM : public
             console::info("Fast Marching Method");
             std::cout << '\t' << name_ << '\n'
                       << '\t' << "Heuristic type: " << heurStrategy_ << '\n'
-                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the narrow band and the buffers of update() and moveInitialPoints(). */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + MemoryUsage::of(narrow_band_) + heap_t::sharedMemory()
+                    + MemoryUsage::of(sources_) + MemoryUsage::of(band_);
+        }
+
+        virtual size_t sharedMemory
+        () const {
+            return heap_t::sharedMemory();
         }
 
 
@@ -228,27 +285,252 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMM : public
         using EikonalSolver<grid_t>::grid_;
         using EikonalSolver<grid_t>::init_points_;
         using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::goalFrozen;
+        using EikonalSolver<grid_t>::stopRequested;
+        using EikonalSolver<grid_t>::counters_;
         using EikonalSolver<grid_t>::setup_;
         using EikonalSolver<grid_t>::name_;
         using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
         using EikonalSolver<grid_t>::solveEikonal;
         using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::start_;
+        using EikonalSolver<grid_t>::end_;
+
+        /** \brief Most derived solver, whose solveEikonal() is called by the main loop. */
+        typedef typename std::conditional<std::is_void<derived_t>::value, FMM, derived_t>::type self_t;
+
+        /** \brief Returns this solver as the most derived one. */
+        self_t & self
+        () {
+            return static_cast<self_t &>(*this);
+        }
 
     private:
+        /** \brief Main loop of FMM, from the initial points in the narrow band. Frozen and occupied
+            neighbors are only read, through the const grid so that they are not marked as dirty. */
+        template <bool heuristics>
+        void propagate
+        () {
+            const grid_t & cgrid = *grid_;
+            unsigned int j = 0;
+            unsigned int n_neighs = 0;
+            bool stopWavePropagation = false;
+            unsigned int idxMin = 0;
+            while (!stopWavePropagation && !narrow_band_.empty()) {
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, narrow_band_.size());
+                idxMin = narrow_band_.popMinIdx();
+                FAST_METHODS_COUNT(HEAP_POPS);
+                if (!heuristics)
+                    n_neighs = grid_->getNeighbors(idxMin, neighbors_);
+                else
+                    n_neighs = getNeighborsToGoal(idxMin);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+                grid_->getCell(idxMin).setState(FMState::FROZEN);
+                for (unsigned int s = 0; s < n_neighs; ++s) {
+                    j = neighbors_[s];
+                    if ((cgrid.getCell(j).getState() == FMState::FROZEN) || cgrid.getCell(j).isOccupied())
+                        continue;
+                    else {
+                        double new_arrival_time = self().solveEikonal(j);
+                        if (!isWithinLimits(j, new_arrival_time))
+                            continue;
+
+                        // Updating narrow band if necessary.
+                        if (grid_->getCell(j).getState() == FMState::NARROW) {
+                            if (utils::isTimeBetterThan(new_arrival_time, grid_->getCell(j).getArrivalTime())) {
+                                grid_->getCell(j).setArrivalTime(new_arrival_time);
+                                narrow_band_.increase( grid_->getCellPtr(j) );
+                                FAST_METHODS_COUNT(HEAP_INCREASES);
+                            }
+                        }
+                        else {
+                            // Include heuristics if necessary, they do not change once the cell is in the narrow band.
+                            if (heuristics)
+                                grid_->getCell(j).setHeuristicTime(getNeighborHeuristic(j, s));
+                            grid_->getCell(j).setState(FMState::NARROW);
+                            grid_->getCell(j).setArrivalTime(new_arrival_time);
+                            narrow_band_.push( grid_->getCellPtr(j) );
+                            FAST_METHODS_COUNT(HEAP_PUSHES);
+                        } // neighbors_ open.
+                    } // neighbors_ not frozen.
+                } // For each neighbor.
+
+                if (goalFrozen(idxMin) || stopRequested(cgrid.getCell(idxMin).getTotalValue()))
+                    stopWavePropagation = true;
+            } // while narrow band not empty
+        }
+
+        /** \brief Resets the solver and runs it again, when the arrival times cannot be repaired. */
+        void computeAgain
+        () {
+            reset();
+            computeInternal();
+        }
+
+        /** \brief Arrival time of cell idx from its neighbors, regardless of its current time: 0 for the
+            initial points and infinity for obstacles and cells out of the limits. */
+        double repairTime
+        (unsigned int idx) {
+            const grid_t & cgrid = *grid_;
+            if (std::binary_search(sources_.begin(), sources_.end(), idx))
+                return 0;
+            if (cgrid.getCell(idx).isOccupied())
+                return std::numeric_limits<double>::infinity();
+
+            // solveEikonal() only takes the neighbors lower than the time of the cell.
+            const double t = cgrid.getCell(idx).getArrivalTime();
+            grid_->getCell(idx).setArrivalTime(std::numeric_limits<double>::infinity());
+            const double r = self().solveEikonal(idx);
+            grid_->getCell(idx).setArrivalTime(t);
+            return isWithinLimits(idx, r) ? r : std::numeric_limits<double>::infinity();
+        }
+
+        /** \brief Pushes cell idx into band_ if its time is not the one computed from its neighbors, with
+            the lowest of both as key. */
+        void checkCell
+        (unsigned int idx) {
+            const double t = grid_->getCell(idx).getArrivalTime();
+            const double r = repairTime(idx);
+            if (r != t) {
+                band_.push_back(std::make_pair(std::min(t, r), idx));
+                std::push_heap(band_.begin(), band_.end(), std::greater<std::pair<double, unsigned int> >());
+            }
+        }
+
+        /** \brief Pops band_ until empty. Cells whose time is higher than the one computed from their
+            neighbors take it and are frozen, cells whose time is lower are set as not reached and
+            pushed again, and the neighbors of both are checked. Entries whose key is no longer the
+            lowest of both times are skipped. Returns false, leaving the arrival times to be computed
+            again, once a quarter of the grid has been repaired, as running again is faster. */
+        bool repair
+        () {
+            const grid_t & cgrid = *grid_;
+            while (!band_.empty()) {
+                if (repaired_ > grid_->size()/4) {
+                    band_.clear();
+                    return false;
+                }
+                std::pop_heap(band_.begin(), band_.end(), std::greater<std::pair<double, unsigned int> >());
+                const std::pair<double, unsigned int> b = band_.back();
+                band_.pop_back();
+                const unsigned int idx = b.second;
+                const double t = cgrid.getCell(idx).getArrivalTime();
+                const double r = repairTime(idx);
+                if (r == t || std::min(t, r) != b.first)
+                    continue;
+
+                ++repaired_;
+                const unsigned int n_neighs = grid_->getNeighbors(idx, neighbors_);
+                if (r < t) {
+                    grid_->getCell(idx).setArrivalTime(r);
+                    grid_->getCell(idx).setState(FMState::FROZEN);
+                }
+                else {
+                    grid_->getCell(idx).setArrivalTime(std::numeric_limits<double>::infinity());
+                    grid_->getCell(idx).setState(FMState::OPEN);
+                    checkCell(idx);
+                }
+                for (unsigned int s = 0; s < n_neighs; ++s)
+                    checkCell(neighbors_[s]);
+            }
+            return true;
+        }
+
+        /** \brief Gets the neighbors of cell idx as getNeighbors(), their dimensions and the coordinates of
+            idx relative to the goal, from which getNeighborHeuristic() computes their heuristics. */
+        unsigned int getNeighborsToGoal
+        (unsigned int idx) {
+            unsigned int n = 0;
+            for (unsigned int dim = 0; dim < grid_t::getNDims(); ++dim) {
+                const unsigned int n0 = n;
+                grid_->getNeighborsInDim(idx, neighbors_, n, dim);
+                for (unsigned int k = n0; k < n; ++k)
+                    neighborDims_[k] = dim;
+            }
+
+            std::array <unsigned int, grid_t::getNDims()> coords;
+            grid_->idx2coord(idx, coords);
+            heurD2_ = 0;
+            for (unsigned int i = 0; i < grid_t::getNDims(); ++i) {
+                heurD_[i] = int(coords[i]) - int(heur_coord_[i]);
+                heurD2_ += heurD_[i]*heurD_[i];
+            }
+            heurIdx_ = idx;
+            return n;
+        }
+
+        /** \brief Heuristic of neighbor s (index j) of the last cell given to getNeighborsToGoal(): its coordinates
+            differ in 1 in its dimension, so the squared distance is updated instead of computed. */
+        double getNeighborHeuristic
+        (unsigned int j, unsigned int s) const {
+            const unsigned int dim = neighborDims_[s];
+            std::array <int, grid_t::getNDims()> d = heurD_;
+            d[dim] += (j > heurIdx_) ? 1 : -1;
+            return heuristicOf(j, d, heurD2_ + d[dim]*d[dim] - heurD_[dim]*heurD_[dim]);
+        }
+
+        /** \brief Heuristic of cell idx, being d its coordinates relative to the goal and d2 the squared distance. */
+        double heuristicOf
+        (unsigned int idx, const std::array <int, grid_t::getNDims()> & d, int d2) const {
+            switch (heurStrategy_) {
+                case TIME:
+                    return std::sqrt(double(d2)) / grid_->getCell(idx).getVelocity();
+                case DISTANCE:
+                    return std::sqrt(double(d2));
+                case OCTILE: {
+                    // Sorted from the largest: each step moves along all the dimensions not reached yet.
+                    std::array <unsigned int, grid_t::getNDims()> a;
+                    for (unsigned int i = 0; i < grid_t::getNDims(); ++i)
+                        a[i] = utils::absUI(d[i]);
+                    std::sort(a.begin(), a.end(), std::greater<unsigned int>());
+                    double h = 0;
+                    for (unsigned int i = 0; i < grid_t::getNDims(); ++i)
+                        h += (std::sqrt(double(i+1)) - std::sqrt(double(i))) * a[i];
+                    return h;
+                }
+                case MAXSPEED:
+                    return std::sqrt(double(d2)) * grid_->getLeafSize() / ((heurSpeed_ > 0) ? heurSpeed_ : gridSpeed_);
+                default:
+                    return 0;
+            }
+        }
+
         /** \brief Instance of the heap used. */
         heap_t                                          narrow_band_;
 
         /** \brief Flag to activate heuristics and corresponding strategy. */
         HeurStrategy                                    heurStrategy_;
 
-        /** \brief Stores the precomputed heuristic distances. */
-        std::vector<double>                             distances_;
-        
-        /** \brief Flag to indicate if distances_ is already computed. */
-        bool                                            precomputed_;
+        /** \brief Speed set for the MAXSPEED heuristic, 0 for gridSpeed_. */
+        double                                          heurSpeed_;
+
+        /** \brief Maximum speed of the grid, computed by setHeuristics() for the MAXSPEED heuristic (0 if not yet). */
+        double                                          gridSpeed_;
 
         /** \brief Goal coord, goal of the second wave propagation (actually the initial point of the path). */
         std::array <unsigned int, grid_t::getNDims()>   heur_coord_;
+
+        /** \brief Dimension of each neighbor found by getNeighborsToGoal(). */
+        std::array <unsigned int, 2*grid_t::getNDims()> neighborDims_;
+
+        /** \brief Cell given to getNeighborsToGoal(), its coordinates relative to the goal and its squared distance. */
+        unsigned int                                    heurIdx_;
+        std::array <int, grid_t::getNDims()>            heurD_;
+        int                                             heurD2_;
+
+        /** \brief True if the last run was complete, so that update() can repair it. */
+        bool                                            complete_;
+
+        /** \brief Initial points of the last run, sorted. */
+        std::vector<unsigned int>                       sources_;
+
+        /** \brief Number of cells repaired by the last update() or moveInitialPoints(). */
+        unsigned int                                    repaired_;
+
+        /** \brief Cells to be repaired, binary heap of (key, index) pairs. */
+        std::vector<std::pair<double, unsigned int> >   band_;
 };
 
 #endif /* FMM_HPP_*/
@@ -9,9 +9,11 @@
     The type of the heap introduced is very important for the behaviour of the
     algorithm. The following heaps are provided:
 
-    - FMDaryHeap wrap for the Boost D_ary heap (generalization of binary heaps).
-    * Set by default if no other heap is specified. The arity has been set to 2
-    * (binary heap) since it has been tested to be the more efficient in this algorithm.
+    - FMKeyHeap 4-ary heap storing the values of the cells next to their indices, so
+    * comparisons do not access the cells. Set by default if no other heap is specified.
+    - FMDaryHeap wrap for the Boost D_ary heap (generalization of binary heaps). The arity
+    * has been set to 2 (binary heap) since it has been tested to be the more efficient
+    * of Boost heaps in this algorithm.
     - FMFibHeap wrap for the Boost Fibonacci heap.
     - FMPriorityQueue wrap to the std::PriorityQueue class. This heap implies the implementation
     * of the Simplified FMMStar (SFMMStar) method, done automatically because of the FMPriorityQueue::increase implementation.
@@ -53,15 +55,18 @@
 #include <fast_methods/fm/fmm.hpp>
 
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/datastructures/fmkeyheap.hpp>
 #include <fast_methods/datastructures/fmdaryheap.hpp>
 
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
 #include <fast_methods/console/console.h>
 
-template < class grid_t, class heap_t = FMDaryHeap<FMCell> >  class FMMStar : public FMM<grid_t, heap_t> {
+/** \brief FMM with heuristics. It is the derived solver of its FMM base (CRTP), so the main loop with
+    heuristics is instantiated for it and calls its solveEikonal() statically. */
+template < class grid_t, class heap_t = FMKeyHeap<typename grid_t::cell_t> >  class FMMStar : public FMM<grid_t, heap_t, FMMStar<grid_t, heap_t> > {
 
     /** \brief Shorthand for base solver. */
-    typedef FMM<grid_t, heap_t> FMMBase;
+    typedef FMM<grid_t, heap_t, FMMStar<grid_t, heap_t> > FMMBase;
 
     public:
         FMMStar(HeurStrategy h = TIME) : FMMBase("FMM*", h) {
@@ -13,6 +13,20 @@
     NOTE: The sweeping directions are inverted with respect to the paper to make implementation easier. And sweeping
     is implemented recursively (undetermined number of nested for loops) to achieve n-dimensional behaviour.
 
+    With more than 1 thread (see constructor), the 2^n sweep directions are run at the same time, as in
+    the parallel sweeping of the reference below: each thread sweeps its directions on a private copy
+    of the arrival times and then the copies are reduced to their minimum. This is repeated until
+    an iteration does not change any time, the goal converges or maxSweeps sweeps are done (each
+    direction counts as a sweep). It converges to the same solution but not in the same number of
+    sweeps, and a copy of the arrival times per thread (up to 2^n) is required.
+
+    derived_t is the most derived solver (CRTP), void for FSM itself: sweeps call its solveForIdx(),
+    sweepCopy() and solveForIdxInCopy() without virtual dispatch, so that the update of every cell
+    is inlined in the loops (see LSM, which sweeps the copies itself).
+
+    @par External documentation:
+        H. Zhao, Parallel implementations of the fast sweeping method, J. Comput. Math. 25 (2007), 421-429.
+
     Copyright (C) 2015 Javier V. Gomez
     www.javiervgomez.com
 
@@ -32,22 +46,33 @@
 #define FSM_HPP_
 
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <type_traits>
 
 #include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/ndgridmap/occupancybitmap.hpp>
 #include <fast_methods/utils/utils.h>
 
 
 /// \todo implement a more robust goal point stopping criterion.
-template < class grid_t > class FSM : public EikonalSolver<grid_t> {
+template < class grid_t, class derived_t = void > class FSM : public EikonalSolver<grid_t> {
 
     public:
-        FSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : EikonalSolver<grid_t>("FSM"),
+        typedef typename EikonalSolver<grid_t>::value_t value_t;
+
+        /** @param maxSweeps maximum number of sweeps.
+            @param nthreads number of threads, 0 to use as many as hardware threads. 1 (default) sweeps
+                   sequentially on the grid, more threads run the sweep directions in parallel. */
+        FSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : EikonalSolver<grid_t>("FSM"),
             sweeps_(0),
-            maxSweeps_(maxSweeps) {}
+            maxSweeps_(maxSweeps),
+            nthreads_(nthreads) {}
 
-        FSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : EikonalSolver<grid_t>(name),
+        FSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : EikonalSolver<grid_t>(name),
             sweeps_(0),
-            maxSweeps_(maxSweeps) {}
+            maxSweeps_(maxSweeps),
+            nthreads_(nthreads) {}
 
         /** \brief Sets and cleans the grid in which operations will be performed.
              Since a maximum number of dimensions is assumed, fills the rest with size 1. */
@@ -56,23 +81,22 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
             EikonalSolver<grid_t>::setEnvironment(g);
             // Filling the size of the dimensions...
             std::array<unsigned, grid_t::getNDims()> dimsize = g->getDimSizes();
-            size_t ncells = 1;
-            for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+            for (size_t i = 0; i < grid_t::getNDims(); ++i)
                 dimsize_[i] = dimsize[i];
-                ncells *= dimsize[i];
-                d_[i] = ncells;
-            }
-
-            Tvalues_.reserve(grid_t::getNDims());
         }
 
         /** \brief Executes EikonalSolver setup and other checks. */
         virtual void setup
         () {
             EikonalSolver<grid_t>::setup();
+            // Sweeps are restricted to the cells which can be within the limits.
+            this->getLimitsBox(lo_, hi_);
             initializeSweepArrays();
-            if (int(goal_idx_) != -1)
-                console::warning("Setting a goal point in FSM (and LSM) is experimental. It may lead to wrong results.");
+            if (int(goal_idx_) != -1) {
+                // Built once, so that queries do not allocate it.
+                static const std::string experimental("Setting a goal point in FSM (and LSM) is experimental. It may lead to wrong results.");
+                console::warning(experimental);
+            }
         }
 
         /** \brief Actual method that implements FSM. */
@@ -88,14 +112,28 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
             keepSweeping_ = true;
             stopPropagation_ = false;
 
-            while (keepSweeping_ && !stopPropagation_ && sweeps_ < maxSweeps_) {
+            if (getNumberOfThreads() > 1) {
+                parallelSweeps();
+                return;
+            }
+
+            while (keepSweeping_ && !stopPropagation_ && !stopped_ && sweeps_ < maxSweeps_) {
                 keepSweeping_ = false;
                 setSweep();
                 ++sweeps_;
+                FAST_METHODS_COUNT(SWEEPS);
                 recursiveIteration(grid_t::getNDims()-1);
             }
         }
 
+        /** \brief Returns the number of threads used to sweep. */
+        unsigned int getNumberOfThreads
+        () const {
+            if (nthreads_ > 0)
+                return nthreads_;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
         virtual void reset
         () {
             EikonalSolver<grid_t>::reset();
@@ -109,30 +147,59 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
             std::cout << '\t' << name_ << '\n'
                       << '\t' << "Maximum sweeps: " << maxSweeps_ << '\n'
                       << '\t' << "Sweeps performed: " << sweeps_ << '\n'
-                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+                      << '\t' << "Threads: " << getNumberOfThreads() << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the copies of the times of the threads. */
+        virtual size_t memory
+        () const {
+            size_t bytes = EikonalSolver<grid_t>::memory() + MemoryUsage::of(times_) + MemoryUsage::of(copies_);
+            for (const SweepCopy & c : copies_)
+                bytes += MemoryUsage::of(c.times) + c.unlockedCells.memory() + MemoryUsage::of(c.rowUnlocked);
+            return bytes;
         }
 
     protected:
+        /** \brief Most derived solver, whose solveForIdx(), sweepCopy() and solveForIdxInCopy() are called by the sweeps. */
+        typedef typename std::conditional<std::is_void<derived_t>::value, FSM, derived_t>::type self_t;
+
+        /** \brief Returns this solver as the most derived one. */
+        self_t & self
+        () {
+            return static_cast<self_t &>(*this);
+        }
+
         /** \brief Equivalent to nesting as many for loops as dimensions. For every most inner
-         * loop iteration, solveForIdx() is called for the corresponding idx. */
+         * loop iteration, solveForIdx() of the derived solver is called for the corresponding idx. Indices are
+         * the sum of the offsets of the coordinates, so any grid layout is supported. The
+         * sweep stops after the row in which a stop is requested (see Solver::cancel()). */
         void recursiveIteration
         (size_t depth, int it = 0) {
             if (depth > 0) {
-                for(int i = inits_[depth]; i != ends_[depth]; i += incs_[depth])
-                    recursiveIteration(depth-1, it + i*d_[depth-1]);
+                for(int i = inits_[depth]; i != ends_[depth] && !stopped_; i += incs_[depth])
+                    recursiveIteration(depth-1, it + grid_->getCoordOffset(depth, i));
             }
             else {
-                for(int i = inits_[0]; i != ends_[0]; i += incs_[0])
-                    if (!grid_->getCell(it+i).isOccupied())
-                        solveForIdx(it+i);
+                for(int i = inits_[0]; i != ends_[0]; i += incs_[0]) {
+                    const unsigned int idx = it + grid_->getCoordOffset(0, i);
+                    if (!grid_->getCell(idx).isOccupied())
+                        self().solveForIdx(idx);
+                }
+                stopRequested(std::numeric_limits<double>::quiet_NaN(), std::abs(ends_[0] - inits_[0]));
             }
         }
 
         /** \brief Actually executes one solving iteration of the FSM. */
-        virtual void solveForIdx
+        void solveForIdx
         (unsigned idx) {
             const double prevTime = grid_->getCell(idx).getArrivalTime();
             const double newTime = solveEikonal(idx);
+            if (!isWithinLimits(idx, newTime))
+                return;
             if(utils::isTimeBetterThan(newTime, prevTime)) {
                 grid_->getCell(idx).setArrivalTime(newTime);
                 keepSweeping_ = true;
@@ -165,17 +232,173 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
             {
                 if (incs_[i] == 1)
                 {
-                    inits_[i] = 0;
-                    ends_[i] = dimsize_[i];
+                    inits_[i] = lo_[i];
+                    ends_[i] = hi_[i];
                 }
                 else
                 {
-                    inits_[i] = dimsize_[i]-1;
-                    ends_[i] = -1;
+                    inits_[i] = hi_[i]-1;
+                    ends_[i] = lo_[i]-1;
                 }
             }
         }
 
+        /** \brief Private arrays of a thread of the parallel sweeps. */
+        struct SweepCopy {
+            /** \brief Arrival times. */
+            std::vector<value_t>        times;
+
+            /** \brief Locks of LSM: bits of the unlocked cells and unlocked cells per row. */
+            OccupancyBitmap             unlockedCells;
+            std::vector<unsigned int>   rowUnlocked;
+
+            /** \brief True if a time was improved in the last iteration. */
+            bool                        changed;
+
+            /** \brief True if the goal converged in the last iteration. */
+            bool                        converged;
+        };
+
+        /** \brief Runs the sweep directions in parallel on private copies of the arrival times, which
+            are reduced to their minimum after each iteration (all the directions). The grid is only
+            read by the threads and it is updated at the end. */
+        void parallelSweeps
+        () {
+            const unsigned int ndirs = 1u << grid_t::getNDims();
+            const unsigned int nthreads = std::min(getNumberOfThreads(), ndirs);
+            const grid_t & grid = *grid_;
+            times_.resize(grid.size());
+            for (unsigned int i = 0; i < grid.size(); ++i)
+                times_[i] = grid.getCell(i).getArrivalTime();
+            initializeParallelSweeps();
+            copies_.resize(nthreads);
+
+            std::vector<std::thread> threads;
+            while (keepSweeping_ && !stopPropagation_ && !stopped_ && sweeps_ < maxSweeps_) {
+                // The last iteration may not run all the directions.
+                const unsigned int n = std::min<unsigned int>(ndirs, maxSweeps_ - sweeps_);
+                const unsigned int ncopies = std::min(nthreads, n);
+                for (unsigned int t = 0; t < ncopies; ++t)
+                    threads.emplace_back([this, t, n, ncopies] () {
+                        SweepCopy & c = copies_[t];
+                        initializeCopy(c);
+                        c.changed = false;
+                        c.converged = false;
+                        for (unsigned int dir = t; dir < n; dir += ncopies)
+                            self().sweepCopy(c, dir);
+                    });
+                for (std::thread & th : threads)
+                    th.join();
+                threads.clear();
+                sweeps_ += n;
+                FAST_METHODS_COUNT_N(SWEEPS, n);
+
+                keepSweeping_ = false;
+                for (unsigned int t = 0; t < ncopies; ++t) {
+                    keepSweeping_ |= copies_[t].changed;
+                    stopPropagation_ |= copies_[t].converged;
+                }
+
+                // Reduction, each thread a range of cells.
+                const unsigned int range = (grid.size() + ncopies - 1) / ncopies;
+                for (unsigned int t = 0; t < ncopies; ++t)
+                    threads.emplace_back([this, t, range, ncopies] () {
+                        reduceCopies(t*range, std::min<unsigned int>((t+1)*range, times_.size()), ncopies);
+                    });
+                for (std::thread & th : threads)
+                    th.join();
+                threads.clear();
+                finishReduction(ncopies);
+
+                // Stops are checked after each iteration, once the copies are reduced.
+                unsigned int cells = n;
+                for (size_t i = 0; i < grid_t::getNDims(); ++i)
+                    cells *= hi_[i] - lo_[i];
+                stopRequested(std::numeric_limits<double>::quiet_NaN(), cells);
+            }
+
+            for (unsigned int i = 0; i < times_.size(); ++i)
+                if (times_[i] < grid.getCell(i).getArrivalTime())
+                    grid_->getCell(i).setArrivalTime(times_[i]);
+        }
+
+        /** \brief Initializes the shared arrays of the parallel sweeps besides the times. Nothing in FSM. */
+        virtual void initializeParallelSweeps
+        () {}
+
+        /** \brief Copies the shared arrays to the private arrays of a thread. */
+        virtual void initializeCopy
+        (SweepCopy & c) {
+            c.times = times_;
+        }
+
+        /** \brief Sets in the shared arrays the minimum times of cells [begin, end) of the first
+            ncopies copies. */
+        virtual void reduceCopies
+        (unsigned int begin, unsigned int end, unsigned int ncopies) {
+            for (unsigned int t = 0; t < ncopies; ++t) {
+                const std::vector<value_t> & times = copies_[t].times;
+                for (unsigned int i = begin; i < end; ++i)
+                    times_[i] = std::min(times_[i], times[i]);
+            }
+        }
+
+        /** \brief Called once the times of the first ncopies copies are reduced, in the calling thread.
+            Nothing in FSM. */
+        virtual void finishReduction
+        (unsigned int) {}
+
+        /** \brief Sweeps the cells of a private copy in direction dir: bit i of dir set
+            means increasing coordinates in dimension i. The derived solver may define its own. */
+        void sweepCopy
+        (SweepCopy & c, unsigned int dir) {
+            constexpr size_t N = grid_t::getNDims();
+            const grid_t & grid = *grid_;
+            std::array<int, N> coords, inc, first, last;
+            for (size_t i = 0; i < N; ++i) {
+                inc[i] = ((dir >> i) & 1) ? 1 : -1;
+                first[i] = (inc[i] == 1) ? lo_[i] : hi_[i] - 1;
+                last[i] = (inc[i] == 1) ? hi_[i] : lo_[i] - 1;
+                coords[i] = first[i];
+            }
+
+            while (true) {
+                unsigned int base = 0;
+                for (size_t i = 1; i < N; ++i)
+                    base += grid.getCoordOffset(i, coords[i]);
+                for (int i = first[0]; i != last[0]; i += inc[0]) {
+                    const unsigned int idx = base + grid.getCoordOffset(0, i);
+                    if (!grid.getCell(idx).isOccupied())
+                        self().solveForIdxInCopy(c, idx);
+                }
+
+                // Next row.
+                size_t i = 1;
+                for (; i < N; ++i) {
+                    coords[i] += inc[i];
+                    if (coords[i] != last[i])
+                        break;
+                    coords[i] = first[i];
+                }
+                if (i >= N)
+                    break;
+            }
+        }
+
+        /** \brief solveForIdx() on a private copy. */
+        void solveForIdxInCopy
+        (SweepCopy & c, unsigned int idx) {
+            const value_t newTime = solveEikonal(c.times, idx);
+            if (!isWithinLimits(idx, newTime))
+                return;
+            if (utils::isTimeBetterThan(newTime, c.times[idx])) {
+                c.times[idx] = newTime;
+                c.changed = true;
+            }
+            else if (!isnan(newTime) && !isinf(newTime) && (idx == goal_idx_))
+                c.converged = true;
+        }
+
         /** \brief Initializes the internal arrays employed. */
         virtual void initializeSweepArrays
         () {
@@ -192,8 +415,14 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
         using EikonalSolver<grid_t>::setup_;
         using EikonalSolver<grid_t>::name_;
         using EikonalSolver<grid_t>::time_;
-        using EikonalSolver<grid_t>::Tvalues_;
+        using EikonalSolver<grid_t>::resetTime_;
         using EikonalSolver<grid_t>::solveEikonal;
+        using EikonalSolver<grid_t>::leafsize_;
+        using EikonalSolver<grid_t>::leafsize2_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::stopRequested;
+        using EikonalSolver<grid_t>::stopped_;
+        using EikonalSolver<grid_t>::counters_;
 
         /** \brief Number of sweeps performed. */
         unsigned int sweeps_;
@@ -219,9 +448,18 @@ template < class grid_t > class FSM : public EikonalSolver<grid_t> {
         /** \brief Size of each dimension, extended to the maximum size. Extended dimensions always 1. */
         std::array<int, grid_t::getNDims()> dimsize_;
 
-        /** \brief Auxiliar array to speed up indexing generalization: stores parcial multiplications of dimensions sizes. d_[0] = dimsize_[0];
-            d_[1] = dimsize_[0]*dimsize_[1]; etc. */
-        std::array<int, grid_t::getNDims()> d_;
+        /** \brief Sweeps cover cells [lo_, hi_) of each dimension: the whole grid unless the propagation
+            is limited (see Solver::getLimitsBox()). */
+        std::array<int, grid_t::getNDims()> lo_, hi_;
+
+        /** \brief Number of threads, 0 for as many as hardware threads. */
+        unsigned int nthreads_;
+
+        /** \brief Arrival times shared by the threads of the parallel sweeps. */
+        std::vector<value_t> times_;
+
+        /** \brief Private arrays of each thread of the parallel sweeps. */
+        std::vector<SweepCopy> copies_;
 };
 
 #endif /* FSM_HPP_*/
@@ -6,6 +6,17 @@
 
     The grid is assumed to be squared, that is Delta(x) = Delta(y) = leafsize_
 
+    With more than one thread, the cells of each group (those in gamma_ with T <= tm_) are
+    copied to a contiguous array and each pass updates their neighbors (without duplicates, in
+    increasing index order) in rounds of two steps: the new arrival times are computed in
+    parallel without modifying the grid, and then they are applied, keeping the minimum time of
+    each cell (and inserting the new narrow cells in the second pass). As the cells of a round
+    are updated from the times before it, instead of in place as the serial passes do, rounds
+    are repeated until no time improves (by more than utils::COMP_MARGIN), so that the updates
+    within the group are propagated. The results are the same for any number of threads; they
+    are not those of serial GMM, as the converged passes do not depend on the order of the
+    group, but their error with respect to FMM is not larger in the maps of test_gmm_threads.
+
     @par External documentation:
         S. Kim, An O(N) Level Set Method for Eikonal Equations, SIAM J. Sci. Comput., 22(6), 2178–2193. 2006.
         <a href="http://epubs.siam.org/doi/abs/10.1137/S1064827500367130">[PDF]</a>
@@ -28,14 +39,23 @@
 #ifndef GMM_HPP_
 #define GMM_HPP_
 
+#include <vector>
+#include <thread>
+#include <algorithm>
+
 #include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+#include <fast_methods/utils/utils.h>
 
 template < class grid_t > class GMM : public EikonalSolver <grid_t> {
 
     public:
-        GMM(double dt = -1) : EikonalSolver<grid_t>("GMM"), deltau_(dt) {}
-        
-        GMM(const char * name, double dt = -1) : EikonalSolver<grid_t>(name), deltau_(dt) {}
+        /** @param dt increment of tm_ per step, -1 for 1/(max speed).
+            @param nthreads number of threads, 0 to use as many as hardware threads. 1 (default) runs
+                   the serial passes. */
+        GMM(double dt = -1, unsigned nthreads = 1) : EikonalSolver<grid_t>("GMM"), deltau_(dt), nthreads_(nthreads) {}
+
+        GMM(const char * name, double dt = -1, unsigned nthreads = 1) : EikonalSolver<grid_t>(name), deltau_(dt), nthreads_(nthreads) {}
 
         virtual ~GMM() { clear(); }
 
@@ -48,7 +68,14 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
 
                 // FIM paper dt:
                 deltau_ = 1/grid_->getMaxSpeed();
+
+            // A cell is inserted in gamma_ once per query, so queries do not allocate.
+            gamma_.reserve(grid_->size());
+            if (getNumberOfThreads() > 1) {
+                pool_.resize(getNumberOfThreads());
+                group_.reserve(grid_->size());
             }
+        }
 
         /** \brief Actual method that implements GMM. */
         virtual void computeInternal
@@ -66,12 +93,15 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
                 grid_->getCell(i).setArrivalTime(0);
                 grid_->getCell(i).setState(FMState::FROZEN);
                 n_neighs = grid_->getNeighbors(i, neighbors_);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                 for (unsigned int s = 0; s < n_neighs; ++s){  // For each neighbor
                     j = neighbors_[s];
                     if ((grid_->getCell(j).getState() == FMState::FROZEN) || grid_->getCell(j).isOccupied())
                         continue;
                     else {
                         double new_arrival_time = solveEikonal(j);
+                        if (!isWithinLimits(j, new_arrival_time))
+                            continue;
                         if (new_arrival_time < tm_){
                             tm_ = new_arrival_time;
                         }
@@ -82,48 +112,54 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
                 } // For each neighbor.
             } // For each initial point.
 
+            if (getNumberOfThreads() > 1) {
+                computeParallel();
+                return;
+            }
+
             // Main loop
             while(!stopWavePropagation && !gamma_.empty()) {
 
                 tm_ += deltau_;
-
-                std::list<unsigned int>::reverse_iterator k = gamma_.rbegin();
-                std::list<unsigned int>::iterator i = k.base();//iterator points to the next element the reverse_iterator is currently pointing to
-                i--;
-                k = gamma_.rend();
-                std::list<unsigned int>::iterator q = k.base();
-                q--;//the end of a reverse list is the first element of that list
-                //This is needed because some functions, like std::list::erase, do not work with reverse iterators
+                FAST_METHODS_COUNT(GROUPS);
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, gamma_.size());
 
                 // First pass
-                for( ; i!=q; --i) {//for each gamma in the reverse order
-                    if( grid_->getCell(*i).getArrivalTime() <= tm_) {
-                        n_neighs = grid_->getNeighbors(*i, neighbors_);
+                for (size_t z = gamma_.size(); z-- > 0; ) {//for each gamma in the reverse order
+                    const unsigned int i = gamma_[z];
+                    if( grid_->getCell(i).getArrivalTime() <= tm_) {
+                        n_neighs = grid_->getNeighbors(i, neighbors_);
+                        FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                         for (unsigned int s = 0; s < n_neighs; ++s){  // For each neighbor of gamma
                             j = neighbors_[s];
                             if ( (grid_->getCell(j).getState() == FMState::FROZEN) || grid_->getCell(j).isOccupied() || (grid_->getCell(j).getVelocity() == 0)) // If Frozen,obstacle or velocity = 0
                                 continue;
                             else {
                                 double new_arrival_time = solveEikonal(j);
-                                if (new_arrival_time < grid_->getCell(j).getArrivalTime()) // Updating narrow band if necessary.
+                                if (new_arrival_time < grid_->getCell(j).getArrivalTime() && isWithinLimits(j, new_arrival_time)) // Updating narrow band if necessary.
                                     grid_->getCell(j).setArrivalTime(new_arrival_time);
                             }
                         }//for each neighbor of gamma
                     }
                 }//for each gamma in the reverse order
 
-                // Second pass
+                // Second pass. Cells kept are compacted at the beginning of gamma_ and new cells are
+                // appended, then moved after the kept ones.
                 const size_t narrow_size = gamma_.size();
-                i = gamma_.begin();
+                size_t kept = 0;
                 for(size_t z = 0; z < narrow_size; ++z) {//for each gamma in the forward order
-                    if( grid_->getCell(*i).getArrivalTime()<= tm_) {
-                        n_neighs = grid_->getNeighbors(*i, neighbors_);
+                    const unsigned int i = gamma_[z];
+                    if( grid_->getCell(i).getArrivalTime()<= tm_) {
+                        n_neighs = grid_->getNeighbors(i, neighbors_);
+                        FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                         for (unsigned int s = 0; s < n_neighs; ++s) {// for each neighbor of gamma
                             j = neighbors_[s];
                             if ((grid_->getCell(j).getState() == FMState::FROZEN) || grid_->getCell(j).isOccupied() || (grid_->getCell(j).getVelocity() == 0)) // If Frozen,obstacle or velocity = 0
                                 continue;
                             else {
                                 double new_arrival_time = solveEikonal(j);
+                                if (!isWithinLimits(j, new_arrival_time))
+                                    continue;
                                 if (new_arrival_time < grid_->getCell(j).getArrivalTime()) {
                                         grid_->getCell(j).setArrivalTime(new_arrival_time);
                                 }
@@ -133,20 +169,25 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
                                 }
                             }
                         }//for each neighbor of gamma
-                    grid_->getCell(*i).setState(FMState::FROZEN);
-                    if (*i == goal_idx_)
+                    grid_->getCell(i).setState(FMState::FROZEN);
+                    if (goalFrozen(i))
                         stopWavePropagation = true;
-                    i = gamma_.erase(i);
                     }
                     else
-                        ++i;
+                        gamma_[kept++] = i;
                 }//for each gamma in the forward order
+                gamma_.erase(gamma_.begin() + kept, gamma_.begin() + narrow_size);
+                if (stopRequested(tm_, narrow_size - kept))
+                    stopWavePropagation = true;
             }//while gamma is not zero
         }//compute
 
         virtual void clear
         () {
             gamma_.clear();
+            group_.clear();
+            updates_.clear();
+            newTimes_.clear();
         }
 
         virtual void reset
@@ -156,14 +197,145 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
             tm_ = 0;
         }
 
+        /** \brief Returns the number of threads used. */
+        unsigned int getNumberOfThreads
+        () const {
+            if (nthreads_ > 0)
+                return nthreads_;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Group Marching Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Delta tm: " << deltau_ << '\n'
+                      << '\t' << "Threads: " << getNumberOfThreads() << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the group and the updates of the threads. */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + MemoryUsage::of(gamma_) + MemoryUsage::of(group_)
+                    + MemoryUsage::of(updates_) + MemoryUsage::of(newTimes_);
+        }
+
     protected:
+        /** \brief Main loop of the parallel mode. Group cells are frozen when gathered for the second
+            pass, so that they are not updated by the rest of the group. */
+        void computeParallel
+        () {
+            while (!gamma_.empty()) {
+                tm_ += deltau_;
+                FAST_METHODS_COUNT(GROUPS);
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, gamma_.size());
+
+                // First pass, times are updated.
+                group_.clear();
+                for (unsigned int i : gamma_)
+                    if (grid_->getCell(i).getArrivalTime() <= tm_)
+                        group_.push_back(i);
+                updateGroup(false);
+
+                // Second pass, times are updated and new cells inserted in gamma_.
+                group_.clear();
+                size_t kept = 0;
+                for (const unsigned int i : gamma_) {
+                    if (grid_->getCell(i).getArrivalTime() <= tm_) {
+                        group_.push_back(i);
+                        grid_->getCell(i).setState(FMState::FROZEN);
+                    }
+                    else
+                        gamma_[kept++] = i;
+                }
+                gamma_.resize(kept);
+                updateGroup(true);
+
+                bool stop = stopRequested(tm_, group_.size());
+                for (const unsigned int i : group_)
+                    if (goalFrozen(i))
+                        stop = true;
+                if (stop)
+                    break;
+            }
+        }
+
+        /** \brief Updates the neighbors of the cells of group_ which are not frozen, occupied or with velocity
+            0, in rounds until no time improves: new times are computed in parallel and then applied,
+            keeping the minima. If insert is true, the open cells updated are inserted in gamma_. */
+        void updateGroup
+        (bool insert) {
+            const grid_t & grid = *grid_;
+            std::array<unsigned int, 2*grid_t::getNDims()> neighs;
+            updates_.clear();
+            FAST_METHODS_COUNT_N(NEIGHBOR_QUERIES, group_.size());
+            for (const unsigned int i : group_) {
+                const unsigned int n_neighs = grid.getNeighbors(i, neighs);
+                for (unsigned int s = 0; s < n_neighs; ++s) {
+                    const auto & cell = grid.getCell(neighs[s]);
+                    if (cell.getState() != FMState::FROZEN && !cell.isOccupied() && cell.getVelocity() != 0)
+                        updates_.push_back(neighs[s]);
+                }
+            }
+            std::sort(updates_.begin(), updates_.end());
+            updates_.erase(std::unique(updates_.begin(), updates_.end()), updates_.end());
+            newTimes_.resize(updates_.size());
+
+            // Small rounds are not worth the synchronization.
+            const unsigned int nt = (updates_.size() < minParallelGroup) ? 1 : pool_.size();
+            bool improved = true;
+            for (bool first = true; improved; first = false) {
+                if (nt == 1)
+                    computeUpdates(0, 1);
+                else
+                    pool_.run([this, nt] (unsigned int t) { computeUpdates(t, nt); });
+
+                improved = false;
+                for (size_t k = 0; k < updates_.size(); ++k) {
+                    const unsigned int j = updates_[k];
+                    const double t = newTimes_[k];
+                    if (!isWithinLimits(j, t))
+                        continue;
+                    if (t < grid_->getCell(j).getArrivalTime()) {
+                        improved |= utils::isTimeBetterThan(t, grid_->getCell(j).getArrivalTime());
+                        grid_->getCell(j).setArrivalTime(t);
+                    }
+                    if (first && insert && grid_->getCell(j).getState() == FMState::OPEN) {
+                        gamma_.push_back(j);
+                        grid_->getCell(j).setState(FMState::NARROW);
+                    }
+                }
+            }
+        }
+
+        /** \brief Computes in newTimes_ the new times of part t of nt of the cells of updates_. The grid is
+            not modified. */
+        void computeUpdates
+        (unsigned int t, unsigned int nt) {
+            const grid_t & grid = *grid_;
+            const size_t end = updates_.size()*(t+1)/nt;
+            for (size_t k = updates_.size()*t/nt; k < end; ++k)
+                newTimes_[k] = solveEikonal(grid, updates_[k]);
+        }
+
         using EikonalSolver<grid_t>::grid_;
         using EikonalSolver<grid_t>::solveEikonal;
         using EikonalSolver<grid_t>::init_points_;
         using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::goalFrozen;
+        using EikonalSolver<grid_t>::stopRequested;
         using EikonalSolver<grid_t>::setup;
         using EikonalSolver<grid_t>::setup_;
         using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
+        using EikonalSolver<grid_t>::name_;
+        using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
+        using EikonalSolver<grid_t>::counters_;
 
     private:
         /** \brief Global bound that determines the group of cells of gamma that will be updated in each step. */
@@ -172,8 +344,24 @@ template < class grid_t > class GMM : public EikonalSolver <grid_t> {
         /** \brief For each updating step, tm_ is increased by this value. */
         double                  deltau_;
         
-        /** \brief List wich stores the narrow band of each iteration. */
-        std::list<unsigned int> gamma_;
+        /** \brief Narrow band, in order of insertion. */
+        std::vector<unsigned int> gamma_;
+
+        /** \brief Number of threads, 0 for as many as hardware threads. */
+        unsigned int            nthreads_;
+
+        /** \brief Threads of the parallel mode. */
+        WorkerPool              pool_;
+
+        /** \brief Cells of the group being updated in the parallel mode. */
+        std::vector<unsigned int> group_;
+
+        /** \brief Cells updated by a pass of the parallel mode, and their new times in the last round. */
+        std::vector<unsigned int> updates_;
+        std::vector<double>     newTimes_;
+
+        /** \brief Rounds of fewer cells than this are computed in the calling thread. */
+        static constexpr size_t minParallelGroup = 256;
 };
 
 #endif /* GMM_H_*/
@@ -0,0 +1,132 @@
+/*! \class GPUFIM
+    \brief Block Fast Iterative Method on a CUDA device, falling back to BFIM.
+
+    The speeds of the grid are uploaded to the device (see GPUGrid), which runs block FIM (see
+    gpu::solveFIM()): the grid is split into tiles of tileSize cells per side, each updated by
+    a block of device threads tileSize times per round, and tiles which changed and their
+    neighbors are updated in the next round until no time improves by more than the error.
+    The arrival times are downloaded to the grid at the end.
+
+    The whole grid is computed on the device, even if a goal is set. The solver runs BFIM on the
+    CPU instead (with nthreads threads) if the library was built without CUDA (-DUSE_CUDA=true),
+    there is no device, the grid has more than 3 dimensions or the propagation is limited
+    (Solver::setMaxArrivalTime(), setMaxDistance(), setCorridor()). ranOnDevice() tells which
+    one ran.
+
+    @par External documentation:
+        W. Jeong and R. Whitaker, A Fast Iterative Method for Eiknal Equations, SIAM J. Sci. Comput., 30(5), 2512–2534. 2008.
+        <a href="http://epubs.siam.org/doi/abs/10.1137/060670298">[PDF]</a>
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GPUFIM_HPP_
+#define GPUFIM_HPP_
+
+#include <fast_methods/fm/bfim.hpp>
+#include <fast_methods/gpu/gpugrid.hpp>
+
+template < class grid_t > class GPUFIM : public BFIM<grid_t> {
+
+    public:
+        /** @param error error threshold value that reveals if a cell has converged, as in FIM.
+            @param tileSize cells per side of the tiles, 0 for 16 in 2D and 8 in 3D.
+            @param nthreads number of threads of BFIM when it runs on the CPU, 0 to use as many as hardware threads. */
+        GPUFIM(double error = 0, unsigned tileSize = 0, unsigned nthreads = 0) : BFIM<grid_t>("GPUFIM", error, tileSize, nthreads),
+            E_(error), rounds_(0), onDevice_(false) {}
+
+        GPUFIM(const char * name, double error = 0, unsigned tileSize = 0, unsigned nthreads = 0) : BFIM<grid_t>(name, error, tileSize, nthreads),
+            E_(error), rounds_(0), onDevice_(false) {}
+
+        /** \brief Runs block FIM on the device, or BFIM if it cannot. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            onDevice_ = GPUGrid<grid_t>::supported() && !this->hasLimits() && gpu::available();
+            if (onDevice_) {
+                buffers_.upload(*grid_, init_points_);
+                onDevice_ = gpu::solveFIM(buffers_.getDims(), grid_->getLeafSize(), buffers_.getSpeeds(),
+                                          buffers_.getTimes(), E_, this->getTileSize(), rounds_);
+                if (onDevice_)
+                    buffers_.download(*grid_);
+                else
+                    console::warning("GPUFIM: the device failed, running BFIM instead.");
+            }
+            if (!onDevice_)
+                BFIM<grid_t>::computeInternal();
+        }
+
+        /** \brief Returns true if the last run was on the device. */
+        bool ranOnDevice
+        () const {
+            return onDevice_;
+        }
+
+        virtual void reset
+        () {
+            BFIM<grid_t>::reset();
+            rounds_ = 0;
+        }
+
+        virtual void printRunInfo
+        () const {
+            if (!onDevice_) {
+                BFIM<grid_t>::printRunInfo();
+                std::cout << '\t' << "Ran on the CPU: no CUDA device or the propagation is limited.\n";
+                return;
+            }
+            console::info("Block Fast Iterative Method (GPU)");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Device: " << gpu::deviceName() << '\n'
+                      << '\t' << "Tile size: " << this->getTileSize() << '\n'
+                      << '\t' << "Rounds: " << rounds_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+        }
+
+        /** \brief Returns the bytes allocated by the solver in the host, the copies of the speeds and times
+            given to the device included. */
+        virtual size_t memory
+        () const {
+            return BFIM<grid_t>::memory() + buffers_.memory();
+        }
+
+    protected:
+        using BFIM<grid_t>::grid_;
+        using BFIM<grid_t>::init_points_;
+        using BFIM<grid_t>::setup;
+        using BFIM<grid_t>::setup_;
+        using BFIM<grid_t>::name_;
+        using BFIM<grid_t>::time_;
+        using BFIM<grid_t>::resetTime_;
+
+    private:
+        /** \brief Error threshold value that reveals if a cell has converged. */
+        double E_;
+
+        /** \brief Rounds performed on the device. */
+        unsigned int rounds_;
+
+        /** \brief True if the last run was on the device. */
+        bool onDevice_;
+
+        /** \brief Speeds and times transferred to the device. */
+        GPUGrid<grid_t> buffers_;
+};
+
+#endif /* GPUFIM_HPP_*/
@@ -0,0 +1,124 @@
+/*! \class GPUFSM
+    \brief Fast Sweeping Method on a CUDA device, falling back to FSM.
+
+    The speeds of the grid are uploaded to the device (see GPUGrid), which sweeps the 2^n
+    directions (see gpu::solveSweeping()): the cells of a sweep are updated by levels, the
+    cells with the same sum of coordinates in the direction of the sweep, which do not depend
+    on each other. Each level is updated in parallel, so sweeps give the same result as the
+    sequential sweeps of FSM. Sweeps are repeated until all the directions are swept without
+    changing any time or maxSweeps sweeps are done. The arrival times are downloaded to the grid
+    at the end.
+
+    The whole grid is computed on the device, even if a goal is set. The solver runs FSM on the
+    CPU instead (with nthreads threads) if the library was built without CUDA (-DUSE_CUDA=true),
+    there is no device, the grid has more than 3 dimensions or the propagation is limited
+    (Solver::setMaxArrivalTime(), setMaxDistance(), setCorridor()). ranOnDevice() tells which
+    one ran.
+
+    @par External documentation:
+        M. Detrixhe, F. Gibou and C. Min, A parallel fast sweeping method for the Eikonal equation, J. Comput. Phys. 237 (2013), 46-55.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GPUFSM_HPP_
+#define GPUFSM_HPP_
+
+#include <fast_methods/fm/fsm.hpp>
+#include <fast_methods/gpu/gpugrid.hpp>
+
+template < class grid_t > class GPUFSM : public FSM<grid_t> {
+
+    public:
+        /** @param maxSweeps maximum number of sweeps.
+            @param nthreads number of threads of FSM when it runs on the CPU (see FSM). */
+        GPUFSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : FSM<grid_t>("GPUFSM", maxSweeps, nthreads),
+            onDevice_(false) {}
+
+        GPUFSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : FSM<grid_t>(name, maxSweeps, nthreads),
+            onDevice_(false) {}
+
+        /** \brief Sweeps on the device, or runs FSM if it cannot. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            onDevice_ = GPUGrid<grid_t>::supported() && !this->hasLimits() && gpu::available();
+            if (onDevice_) {
+                buffers_.upload(*grid_, init_points_);
+                onDevice_ = gpu::solveSweeping(buffers_.getDims(), grid_->getLeafSize(), buffers_.getSpeeds(),
+                                               buffers_.getTimes(), maxSweeps_, sweeps_);
+                if (onDevice_)
+                    buffers_.download(*grid_);
+                else {
+                    console::warning("GPUFSM: the device failed, running FSM instead.");
+                    sweeps_ = 0;
+                }
+            }
+            if (!onDevice_)
+                FSM<grid_t>::computeInternal();
+        }
+
+        /** \brief Returns true if the last run was on the device. */
+        bool ranOnDevice
+        () const {
+            return onDevice_;
+        }
+
+        virtual void printRunInfo
+        () const {
+            if (!onDevice_) {
+                FSM<grid_t>::printRunInfo();
+                std::cout << '\t' << "Ran on the CPU: no CUDA device or the propagation is limited.\n";
+                return;
+            }
+            console::info("Fast Sweeping Method (GPU)");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Device: " << gpu::deviceName() << '\n'
+                      << '\t' << "Maximum sweeps: " << maxSweeps_ << '\n'
+                      << '\t' << "Sweeps performed: " << sweeps_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+        }
+
+        /** \brief Returns the bytes allocated by the solver in the host, the copies of the speeds and times
+            given to the device included. */
+        virtual size_t memory
+        () const {
+            return FSM<grid_t>::memory() + buffers_.memory();
+        }
+
+    protected:
+        using FSM<grid_t>::grid_;
+        using FSM<grid_t>::init_points_;
+        using FSM<grid_t>::setup;
+        using FSM<grid_t>::setup_;
+        using FSM<grid_t>::name_;
+        using FSM<grid_t>::time_;
+        using FSM<grid_t>::resetTime_;
+        using FSM<grid_t>::sweeps_;
+        using FSM<grid_t>::maxSweeps_;
+
+    private:
+        /** \brief True if the last run was on the device. */
+        bool onDevice_;
+
+        /** \brief Speeds and times transferred to the device. */
+        GPUGrid<grid_t> buffers_;
+};
+
+#endif /* GPUFSM_HPP_*/
@@ -0,0 +1,468 @@
+/*! \class Hierarchical
+    \brief Coarse-to-fine wrapper of a solver for point to point queries on large grids.
+
+    setEnvironment() builds a coarse grid whose cells are blocks of factor^ndims cells of the
+    grid: the velocity of a block is the minimum of its cells, so a block with any obstacle is
+    an obstacle (min-pooling). Every query runs the solver on the coarse grid first, descends
+    its arrival times (GradientField) between the blocks of the initial point and the goal,
+    and dilates that path by radius blocks into a corridor (if the block of the initial point
+    or the goal is an obstacle, the closest one within radius which is not is taken). Then the
+    solver runs on the grid restricted to the cells of the corridor (Solver::setCorridor()):
+    cells out of it are not visited and keep an infinite arrival time.
+
+    The arrival times within the corridor are those of the solver restricted to it, so paths
+    are close to, but can be longer than, those of the full grid. If there is no coarse path
+    (passages narrower than a block are closed in the coarse grid) or the fine solve does not
+    connect the initial point and the goal, the solver runs again on the whole grid. Without
+    goal it runs on the whole grid.
+
+    solver_t can be FMM (and the rest of Eikonal solvers), FM2 or FM2Star: the arrival times and
+    the path are those of solver_t (FM2-based solvers march from the goal, and their velocities
+    map is computed for the whole grid). The coarse grid is built from the velocities of the grid
+    when setEnvironment() is called, so call it again if they change.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HIERARCHICAL_HPP_
+#define HIERARCHICAL_HPP_
+
+#include <vector>
+#include <array>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <chrono>
+
+#include <fast_methods/fm/solver.hpp>
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/gradientdescent/gradientfield.hpp>
+
+template < class grid_t, class solver_t = FMM<grid_t> > class Hierarchical : public Solver<grid_t> {
+
+    /** \brief Shorthand for number of dimensions. */
+    static constexpr size_t ndims_ = grid_t::getNDims();
+
+    /** \brief Shorthand for coordinates. */
+    typedef typename std::array<unsigned int, ndims_> Coord;
+
+    public:
+        /** \brief Path type encapsulation. */
+        typedef std::vector< std::array<double, grid_t::getNDims()> > path_t;
+
+        /** \brief factor is the size of the blocks of the coarse grid (in cells per dimension), radius the
+            dilation of the coarse path (in blocks). The rest of parameters are given to the constructor of
+            solver_t (for instance, the saturation distance of FM2). The name is that of solver_t after an H. */
+        template <class... Args>
+        Hierarchical
+        (unsigned int factor = 4, unsigned int radius = 2, Args... args) : Solver<grid_t>("Hierarchical"),
+            coarse_(args...), fine_(args...), factor_(std::max(factor, 1u)), radius_(radius), coarseTime_(0),
+            corridorCells_(0), fullRun_(false) {
+            name_ = "H" + fine_.getName();
+        }
+
+        /** \brief factor is the size of the blocks of the coarse grid (in cells per dimension), radius the
+            dilation of the coarse path (in blocks). The rest of parameters are given to the constructor of
+            solver_t (for instance, the saturation distance of FM2). */
+        template <class... Args>
+        Hierarchical
+        (const char * name, unsigned int factor = 4, unsigned int radius = 2, Args... args) : Solver<grid_t>(name),
+            coarse_(args...), fine_(args...), factor_(std::max(factor, 1u)), radius_(radius), coarseTime_(0),
+            corridorCells_(0), fullRun_(false) {}
+
+        /** \brief Sets the grid and builds the coarse grid from its velocities. */
+        virtual void setEnvironment
+        (grid_t * g) {
+            Solver<grid_t>::setEnvironment(g);
+            buildCoarseGrid();
+            coarse_.setEnvironment(&coarseGrid_);
+            fine_.setEnvironment(grid_);
+        }
+
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            fine_.setMaxArrivalTime(this->getMaxArrivalTime());
+            fine_.setMaxDistance(this->getMaxDistance());
+            if (!this->getGoals().empty())
+                fine_.setInitialAndGoalPoints(init_points_, this->getGoals(), goalsToReach_);
+            else
+                fine_.setInitialAndGoalPoints(init_points_, goal_idx_);
+
+            corridorCells_ = 0;
+            fullRun_ = int(goal_idx_) == -1 || !computeCorridor();
+            if (!fullRun_) {
+                fine_.setCorridor(&corridor_);
+                runFine();
+                if (std::isinf(grid_->getCell(goal_idx_).getArrivalTime()) ||
+                    std::isinf(grid_->getCell(init_points_[0]).getArrivalTime())) {
+                    fine_.reset();
+                    fullRun_ = true;
+                }
+            }
+            if (fullRun_) {
+                fine_.setCorridor(nullptr);
+                runFine();
+            }
+        }
+
+        /** \brief Computes the path of solver_t (see GradientDescent): from the goal for Eikonal solvers and
+            from the initial point for FM2-based solvers. */
+        virtual void computePath
+        (path_t * p, std::vector <double> * path_velocity, double step = 1) {
+            unsigned int idx = (grid_->getCell(goal_idx_).getArrivalTime() != 0) ? goal_idx_ : init_points_[0];
+            GradientDescent<grid_t>::apply(*grid_, idx, *p, *path_velocity, step);
+        }
+
+        virtual void reset
+        () {
+            Solver<grid_t>::reset();
+            coarse_.reset();
+            fine_.reset();
+        }
+
+        virtual void clear
+        () {
+            Solver<grid_t>::clear();
+            corridor_.clear();
+            coarseMask_.clear();
+            field_.clear();
+        }
+
+        /** \brief Returns the coarse grid. */
+        const grid_t & getCoarseGrid
+        () const {
+            return coarseGrid_;
+        }
+
+        /** \brief Returns the number of cells of the corridor of the last run, 0 if it ran on the whole grid. */
+        unsigned int getCorridorCells
+        () const {
+            return fullRun_ ? 0 : corridorCells_;
+        }
+
+        /** \brief Returns true if the last run was on the whole grid. */
+        bool ranOnWholeGrid
+        () const {
+            return fullRun_;
+        }
+
+        /** \brief Returns the time (ms) of the coarse solve and path of the last run. */
+        double getCoarseTime
+        () const {
+            return coarseTime_;
+        }
+
+        /** \brief Returns the time (ms) of the velocities maps of the last run, of the coarse and the fine
+            solvers (FM2-based solver_t). */
+        virtual double getTimeVelocities
+        () const {
+            return coarse_.getTimeVelocities() + fine_.getTimeVelocities();
+        }
+
+        /** \brief Returns the solver run on the grid. */
+        solver_t & getSolver
+        () {
+            return fine_;
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Hierarchical solver");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Block size: " << factor_ << ", corridor radius: " << radius_ << '\n'
+                      << '\t' << "Corridor cells: " << getCorridorCells() << " of " << grid_->size() << '\n'
+                      << '\t' << "Coarse time: " << coarseTime_ << " ms\n"
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            fine_.getCounters().print();
+        }
+
+        /** \brief Returns the bytes allocated by the coarse grid, both solvers, the gradient field of the
+            coarse path and the buffers of the corridor. */
+        virtual size_t memory
+        () const {
+            return Solver<grid_t>::memory() + coarseGrid_.memory() + coarse_.memory() + fine_.memory()
+                    - coarse_.sharedMemory() + field_.memory() + MemoryUsage::of(cinit_) + MemoryUsage::of(path_)
+                    + MemoryUsage::of(vels_) + MemoryUsage::of(blocks_) + MemoryUsage::of(coarseMask_)
+                    + MemoryUsage::of(corridor_);
+        }
+
+        virtual size_t sharedMemory
+        () const {
+            return fine_.sharedMemory();
+        }
+
+        /** \brief Returns the counters of the last run of the solver on the grid. */
+        virtual const OpCounters & getCounters
+        () const {
+            return fine_.getCounters();
+        }
+
+    protected:
+        using Solver<grid_t>::grid_;
+        using Solver<grid_t>::init_points_;
+        using Solver<grid_t>::goal_idx_;
+        using Solver<grid_t>::goalsToReach_;
+        using Solver<grid_t>::setup;
+        using Solver<grid_t>::setup_;
+        using Solver<grid_t>::name_;
+        using Solver<grid_t>::time_;
+        using Solver<grid_t>::resetTime_;
+
+    private:
+        /** \brief Coarse cell of cell idx of the grid. */
+        unsigned int coarseIdx
+        (unsigned int idx) const {
+            Coord c;
+            grid_->idx2coord(idx, c);
+            for (size_t i = 0; i < ndims_; ++i)
+                c[i] /= factor_;
+            unsigned int cidx;
+            coarseGrid_.coord2idx(c, cidx);
+            return cidx;
+        }
+
+        /** \brief Coarse cell of cell idx or, if it is an obstacle (the block has obstacles), the closest
+            coarse cell within radius_ which is not, as the corridor includes them. */
+        unsigned int freeBlock
+        (unsigned int idx) {
+            const unsigned int cidx = coarseIdx(idx);
+            const grid_t & ccoarse = coarseGrid_;
+            if (!ccoarse.getCell(cidx).isOccupied())
+                return cidx;
+            Coord center;
+            coarseGrid_.idx2coord(cidx, center);
+            unsigned int best = cidx;
+            int bestd2 = std::numeric_limits<int>::max();
+            forEachBlockAround(center, [&] (unsigned int b, const Coord & c) {
+                int d2 = 0;
+                for (size_t i = 0; i < ndims_; ++i)
+                    d2 += (int(c[i]) - int(center[i]))*(int(c[i]) - int(center[i]));
+                if (d2 < bestd2 && !ccoarse.getCell(b).isOccupied()) {
+                    best = b;
+                    bestd2 = d2;
+                }
+            });
+            return best;
+        }
+
+        /** \brief Calls f with the index and coordinates of every coarse cell within radius_ (in every
+            dimension) of coordinates center. */
+        template <class F>
+        void forEachBlockAround
+        (const Coord & center, const F & f) const {
+            const Coord cdims = coarseGrid_.getDimSizes();
+            Coord lo, hi, c;
+            for (size_t i = 0; i < ndims_; ++i) {
+                lo[i] = unsigned(std::max(int(center[i]) - int(radius_), 0));
+                hi[i] = unsigned(std::min(int(center[i]) + int(radius_) + 1, int(cdims[i])));
+            }
+            c = lo;
+            while (true) {
+                unsigned int cidx;
+                coarseGrid_.coord2idx(c, cidx);
+                f(cidx, c);
+                size_t i = 0;
+                for (; i < ndims_; ++i) {
+                    if (++c[i] < hi[i])
+                        break;
+                    c[i] = lo[i];
+                }
+                if (i == ndims_)
+                    break;
+            }
+        }
+
+        /** \brief Calls f with the index of every cell of the grid in coarse cell cidx. */
+        template <class F>
+        void forEachCellInBlock
+        (unsigned int cidx, const F & f) const {
+            const Coord dimsize = grid_->getDimSizes();
+            Coord lo, hi, c;
+            coarseGrid_.idx2coord(cidx, c);
+            for (size_t i = 0; i < ndims_; ++i) {
+                lo[i] = c[i]*factor_;
+                hi[i] = std::min(lo[i] + factor_, dimsize[i]);
+            }
+            c = lo;
+            while (true) {
+                unsigned int idx;
+                grid_->coord2idx(c, idx);
+                f(idx);
+                size_t i = 0;
+                for (; i < ndims_; ++i) {
+                    if (++c[i] < hi[i])
+                        break;
+                    c[i] = lo[i];
+                }
+                if (i == ndims_)
+                    break;
+            }
+        }
+
+        /** \brief Builds the coarse grid: blocks of factor_ cells per dimension with the minimum velocity
+            of their cells. */
+        void buildCoarseGrid
+        () {
+            const grid_t & cgrid = *grid_;
+            const Coord dimsize = grid_->getDimSizes();
+            Coord cdims;
+            for (size_t i = 0; i < ndims_; ++i)
+                cdims[i] = (dimsize[i] + factor_ - 1) / factor_;
+            coarseGrid_.resize(cdims);
+            coarseGrid_.setLeafSize(grid_->getLeafSize() * factor_);
+
+            OccupancyBitmap obstacles(coarseGrid_.size());
+            for (unsigned int cidx = 0; cidx < coarseGrid_.size(); ++cidx) {
+                if (coarseGrid_.isPadding(cidx))
+                    continue;
+                double vel = std::numeric_limits<double>::infinity();
+                forEachCellInBlock(cidx, [&cgrid, &vel] (unsigned int idx) {
+                    vel = std::min(vel, double(cgrid.getCell(idx).getVelocity()));
+                });
+                coarseGrid_.getCell(cidx).setVelocity(vel);
+                if (vel == 0)
+                    obstacles.set(cidx);
+            }
+            coarseGrid_.setOccupiedCells(std::move(obstacles));
+        }
+
+        /** \brief Solves the coarse grid and sets the corridor around its path. Returns false if there is
+            no coarse path. */
+        bool computeCorridor
+        () {
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            std::vector<unsigned int> & cinit = cinit_;
+            cinit.clear();
+            for (unsigned int i : init_points_)
+                cinit.push_back(freeBlock(i));
+            std::sort(cinit.begin(), cinit.end());
+            cinit.erase(std::unique(cinit.begin(), cinit.end()), cinit.end());
+            const unsigned int cgoal = freeBlock(goal_idx_);
+
+            const grid_t & ccoarse = coarseGrid_;
+            bool found = !ccoarse.getCell(cgoal).isOccupied();
+            for (unsigned int i : cinit)
+                if (i == cgoal || ccoarse.getCell(i).isOccupied())
+                    found = false;
+
+            typename GradientField<grid_t>::Path & path = path_;
+            path.clear();
+            if (found) {
+                coarse_.reset();
+                coarse_.setInitialAndGoalPoints(cinit, cgoal);
+                coarse_.compute();
+                field_.build(ccoarse);
+
+                // FM2-based solvers march from the goal.
+                unsigned int idx = (ccoarse.getCell(cgoal).getArrivalTime() != 0) ? cgoal : cinit[0];
+                vels_.clear();
+                found = field_.apply(idx, path, vels_);
+            }
+
+            if (found) {
+                // Blocks of the path dilated by radius_ blocks, then their cells.
+                coarseMask_.assign(coarseGrid_.size(), false);
+                std::vector<unsigned int> & blocks = blocks_;
+                blocks.clear();
+                for (const std::array<double, ndims_> & p : path) {
+                    Coord center;
+                    for (size_t i = 0; i < ndims_; ++i)
+                        center[i] = unsigned(p[i] + 0.5);
+                    forEachBlockAround(center, [this, &blocks] (unsigned int cidx, const Coord &) {
+                        if (!coarseMask_[cidx]) {
+                            coarseMask_[cidx] = true;
+                            blocks.push_back(cidx);
+                        }
+                    });
+                }
+                // The blocks of the initial points and the goal, if the path starts from a neighbor block.
+                for (unsigned int i : init_points_)
+                    if (!coarseMask_[coarseIdx(i)]) {
+                        coarseMask_[coarseIdx(i)] = true;
+                        blocks.push_back(coarseIdx(i));
+                    }
+                if (!coarseMask_[coarseIdx(goal_idx_)]) {
+                    coarseMask_[coarseIdx(goal_idx_)] = true;
+                    blocks.push_back(coarseIdx(goal_idx_));
+                }
+
+                corridor_.assign(grid_->size(), false);
+                unsigned int & cells = corridorCells_;
+                cells = 0;
+                for (unsigned int b : blocks)
+                    forEachCellInBlock(b, [this, &cells] (unsigned int idx) {
+                        corridor_[idx] = true;
+                        ++cells;
+                    });
+            }
+            coarseTime_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return found;
+        }
+
+        /** \brief Runs solver_t on the grid, which this solver left clean. */
+        void runFine
+        () {
+            grid_->setClean(true);
+            fine_.compute();
+            grid_->setClean(false);
+        }
+
+        /** \brief Grid of blocks of factor_ cells per dimension. */
+        grid_t                      coarseGrid_;
+
+        /** \brief Solver of the coarse grid. */
+        solver_t                    coarse_;
+
+        /** \brief Solver of the grid. */
+        solver_t                    fine_;
+
+        /** \brief Gradient of the coarse arrival times, to descend the coarse path. Kept until clear(). */
+        GradientField<grid_t>       field_;
+
+        /** \brief Buffers of computeCorridor(), kept across queries so that they do not allocate memory:
+            coarse initial points, coarse path and its velocities and blocks of the corridor. */
+        std::vector<unsigned int>                   cinit_;
+        typename GradientField<grid_t>::Path        path_;
+        std::vector<double>                         vels_;
+        std::vector<unsigned int>                   blocks_;
+
+        /** \brief Size of the blocks (cells per dimension). */
+        unsigned int                factor_;
+
+        /** \brief Dilation of the coarse path (blocks). */
+        unsigned int                radius_;
+
+        /** \brief Blocks of the corridor of the last run. */
+        std::vector<bool>           coarseMask_;
+
+        /** \brief Cells of the corridor of the last run. */
+        std::vector<bool>           corridor_;
+
+        /** \brief Time of the coarse solve and path of the last run (ms). */
+        double                      coarseTime_;
+
+        /** \brief Number of cells of the corridor of the last run. */
+        unsigned int                corridorCells_;
+
+        /** \brief True if the last run was on the whole grid. */
+        bool                        fullRun_;
+};
+
+#endif /* HIERARCHICAL_HPP_ */
@@ -11,8 +11,19 @@
         SIAM J. Sci. Comput., 32(5), 2853–2874. 2010.
         <a href="http://epubs.siam.org/doi/abs/10.1137/090749645">[More Info]</a>
 
-    NOTE: The sweeping directions are inverted with respect to the paper to make implementation easier. And sweeping
-    is implemented recursively (undetermined number of nested for loops) to achieve n-dimensional behaviour.
+    NOTE: The sweeping directions are inverted with respect to the paper to make implementation easier.
+
+    The locks are a bitmap with a bit per cell in row-major order and a count of unlocked cells per
+    row (the cells with the same coordinates but the first one). Sweeps visit the rows in the same
+    order as FSM, but rows without unlocked cells are skipped at once, and so are the words of 64
+    locked cells of the rest, so that most of the cells are not touched once the front has passed
+    or in large obstacle areas. Both are counted as BLOCK_SKIPS (and their cells as LOCKED_SKIPS).
+
+    With more than 1 thread, sweep directions run in parallel as in FSM. Each thread also has a private
+    copy of the locks, swept in the same way. After the reduction, a cell is unlocked if it is
+    unlocked in any copy or if the reduced time of a neighbor improved and is better than its own,
+    the rule of the sequential sweeps applied to the reduced times: a cell improved through
+    different neighbors in different copies is then solved again with both of them.
 
     Copyright (C) 2015 Javier V. Gomez
     www.javiervgomez.com
@@ -34,15 +45,24 @@
 
 #include <fast_methods/fm/fsm.hpp>
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/occupancybitmap.hpp>
 #include <fast_methods/utils/utils.h>
 
 /// \todo implement a more robust goal point stopping criterion.
-template < class grid_t > class LSM : public FSM<grid_t> {
+template < class grid_t > class LSM : public FSM<grid_t, LSM<grid_t> > {
+
+    /** \brief Shorthand for base solver, which calls sweepCopy() statically. */
+    typedef FSM<grid_t, LSM<grid_t> > FSMBase;
+    friend FSMBase;
 
     public:
-        LSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : FSM<grid_t>("LSM", maxSweeps) {}
+        typedef typename FSMBase::value_t value_t;
+
+        /** @param maxSweeps maximum number of sweeps.
+            @param nthreads number of threads, as in FSM. */
+        LSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : FSMBase("LSM", maxSweeps, nthreads) {}
 
-        LSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : FSM<grid_t>(name, maxSweeps) {}
+        LSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max(), unsigned nthreads = 1) : FSMBase(name, maxSweeps, nthreads) {}
 
         /** \brief Actual method that implements LSM. */
         virtual void computeInternal
@@ -50,96 +70,357 @@ template < class grid_t > class LSM : public FSM<grid_t> {
             if (!setup_)
                 setup();
 
-            // FMState::FROZEN - locked and FMState::OPEN - unlocked.
-            // The time this takes is negligible and if done in setup or
-            // setEnvironment it can affect other planners run in the same
-            // grid.
-            for(size_t i = 0; i < grid_->size(); ++i)
-                grid_->getCell(i).setState(FMState::FROZEN);
-
-            // Initialization
+            // Initialization: all the cells are locked but the neighbors of the initial points.
+            // The locks are a bitmap of their own, the states of the cells are not used.
+            constexpr size_t N = grid_t::getNDims();
+            nrows_ = 1;
+            for (size_t i = 1; i < N; ++i) {
+                rowStrides_[i] = nrows_;
+                nrows_ *= dimsize_[i];
+            }
+            unlockedCells_.resize(size_t(nrows_)*dimsize_[0]);
+            rowUnlocked_.assign(nrows_, 0);
             for (unsigned int i: init_points_) {
                 grid_->getCell(i).setArrivalTime(0);
-                unsigned int n_neighs = grid_->getNeighbors(i, neighbors_);
-                for (unsigned int j = 0; j < n_neighs; ++j)
-                    grid_->getCell(neighbors_[j]).setState(FMState::OPEN);
+                std::array<unsigned int, N> c;
+                grid_->idx2coord(i, c);
+                std::array<int, N> coords;
+                unsigned int row = 0;
+                for (size_t k = 0; k < N; ++k) {
+                    coords[k] = c[k];
+                    if (k > 0)
+                        row += c[k]*rowStrides_[k];
+                }
+                // Any time is better than -infinity, so all the neighbors are unlocked.
+                unlockNeighbors(i, coords, row, -std::numeric_limits<double>::infinity(),
+                                [] (unsigned int) { return 0.; }, unlockedCells_, rowUnlocked_);
             }
 
-            // Getting dimsizes and filling the other dimensions.
             keepSweeping_ = true;
             stopPropagation_ = false;
 
-            while (keepSweeping_ && !stopPropagation_ && sweeps_ < maxSweeps_) {
+            if (this->getNumberOfThreads() > 1) {
+                parallelSweeps();
+                return;
+            }
+
+            while (keepSweeping_ && !stopPropagation_ && !stopped_ && sweeps_ < maxSweeps_) {
                 keepSweeping_ = false;
                 setSweep();
                 ++sweeps_;
-                recursiveIteration(grid_t::getNDims()-1);
+                FAST_METHODS_COUNT(SWEEPS);
+                sweepUnlocked(unlockedCells_, rowUnlocked_, incs_, inits_, ends_, true,
+                              [this] (unsigned int idx, const std::array<int, N> & coords, unsigned int row) {
+                    solveUnlocked(idx, coords, row);
+                });
             }
         }
 
-        virtual void reset
-        () {
-            FSM<grid_t>::reset();
-            for(size_t i = 0; i < grid_->size(); ++i)
-                grid_->getCell(i).setState(FMState::FROZEN);
-        }
-
         virtual void printRunInfo
         () const {
             console::info("Lock Sweeping Method");
             std::cout << '\t' << name_ << '\n'
                       << '\t' << "Maximum sweeps: " << maxSweeps_ << '\n'
                       << '\t' << "Sweeps performed: " << sweeps_ << '\n'
-                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+                      << '\t' << "Threads: " << this->getNumberOfThreads() << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the locks and the copies of the times of the threads. */
+        virtual size_t memory
+        () const {
+            return FSMBase::memory() + unlockedCells_.memory() + MemoryUsage::of(rowUnlocked_) + MemoryUsage::of(improved_);
         }
 
     protected:
-        /** \brief Actually executes one solving iteration of the LSM. */
-        virtual void solveForIdx
-        (unsigned idx) {
-            if (grid_->getCell(idx).getState() == FMState::OPEN) {
-                const double prevTime = grid_->getCell(idx).getArrivalTime();
-                const double newTime = solveEikonal(idx);
-
-                // Update time if better and unlock neighbors with higher time.
-                if(utils::isTimeBetterThan(newTime, prevTime)) {
-                    grid_->getCell(idx).setArrivalTime(newTime);
-                    keepSweeping_ = true;
-                    unsigned int n_neighs = grid_->getNeighbors(idx, neighbors_);
-                    for (unsigned int i = 0; i < n_neighs; ++i)
-                        if (utils::isTimeBetterThan(newTime, grid_->getCell(neighbors_[i]).getArrivalTime()))
-                            grid_->getCell(neighbors_[i]).setState(FMState::OPEN);
+        typedef typename FSMBase::SweepCopy SweepCopy;
+
+        /** \brief The shared locks are those of the sequential sweeps. */
+        virtual void initializeParallelSweeps
+        () {
+            improved_.resize(grid_->size());
+        }
+
+        virtual void initializeCopy
+        (SweepCopy & c) {
+            FSMBase::initializeCopy(c);
+            c.unlockedCells = unlockedCells_;
+            c.rowUnlocked = rowUnlocked_;
+        }
+
+        /** \brief Reduces the times and marks the cells whose time improved. */
+        virtual void reduceCopies
+        (unsigned int begin, unsigned int end, unsigned int ncopies) {
+            for (unsigned int i = begin; i < end; ++i) {
+                value_t t = times_[i];
+                for (unsigned int k = 0; k < ncopies; ++k)
+                    t = std::min(t, copies_[k].times[i]);
+                improved_[i] = utils::isTimeBetterThan(t, times_[i]);
+                times_[i] = t;
+            }
+        }
+
+        /** \brief Unlocks the cells unlocked in any copy and the neighbors with a higher time of the cells
+            whose time improved. */
+        virtual void finishReduction
+        (unsigned int ncopies) {
+            constexpr size_t N = grid_t::getNDims();
+            const grid_t & grid = *grid_;
+            unlockedCells_ = copies_[0].unlockedCells;
+            for (unsigned int k = 1; k < ncopies; ++k) {
+                const std::vector<uint64_t> & words = copies_[k].unlockedCells.getWords();
+                for (size_t w = 0; w < words.size(); ++w)
+                    if (words[w])
+                        unlockedCells_.orWord(w, words[w]);
+            }
+            for (unsigned int r = 0; r < nrows_; ++r)
+                rowUnlocked_[r] = unlockedCells_.count(size_t(r)*dimsize_[0], size_t(r + 1)*dimsize_[0]);
+
+            for (unsigned int i = 0; i < improved_.size(); ++i)
+                if (improved_[i]) {
+                    std::array<unsigned int, N> c;
+                    grid.idx2coord(i, c);
+                    std::array<int, N> coords;
+                    unsigned int row = 0;
+                    for (size_t k = 0; k < N; ++k) {
+                        coords[k] = c[k];
+                        if (k > 0)
+                            row += c[k]*rowStrides_[k];
+                    }
+                    unlockNeighbors(i, coords, row, times_[i], [this] (unsigned int j) { return times_[j]; },
+                                    unlockedCells_, rowUnlocked_);
+                }
+        }
+
+        /** \brief Sweeps a private copy in direction dir (as FSM::sweepCopy()), visiting only the cells
+            unlocked in the copy. */
+        void sweepCopy
+        (SweepCopy & c, unsigned int dir) {
+            constexpr size_t N = grid_t::getNDims();
+            std::array<int, N> inc, first, last;
+            for (size_t i = 0; i < N; ++i) {
+                inc[i] = ((dir >> i) & 1) ? 1 : -1;
+                first[i] = (inc[i] == 1) ? lo_[i] : hi_[i] - 1;
+                last[i] = (inc[i] == 1) ? hi_[i] : lo_[i] - 1;
+            }
+            sweepUnlocked(c.unlockedCells, c.rowUnlocked, inc, first, last, false,
+                          [this, &c] (unsigned int idx, const std::array<int, N> & coords, unsigned int row) {
+                solveUnlockedInCopy(c, idx, coords, row);
+            });
+        }
+
+        /** \brief Sweeps the rows of the limits box from first to last (excluded) with increments inc, as
+            FSM. Only the cells unlocked in cells (rowUnlocked, the unlocked cells per row) are given to
+            solve(idx, coords, row), which has to lock them: rows without unlocked cells are skipped, and
+            so are the words of 64 locked cells of the rest, finding the next unlocked cell of a word with
+            count trailing (leading, if decreasing) zeros. Cells unlocked ahead in the row are visited.
+            If checkStop, the sweep stops after the row in which a stop is requested. */
+        template <class F>
+        void sweepUnlocked
+        (const OccupancyBitmap & cells, const std::vector<unsigned int> & rowUnlocked,
+         const std::array<int, grid_t::getNDims()> & inc, const std::array<int, grid_t::getNDims()> & first,
+         const std::array<int, grid_t::getNDims()> & last, bool checkStop, F solve) {
+            constexpr size_t N = grid_t::getNDims();
+            const grid_t & grid = *grid_;
+            const std::vector<uint64_t> & words = cells.getWords();
+            const unsigned int rowCells = std::abs(last[0] - first[0]);
+            std::array<int, N> coords = first;
+            while (!(checkStop && stopped_)) {
+                unsigned int base = 0;
+                unsigned int row = 0;
+                for (size_t i = 1; i < N; ++i) {
+                    base += grid.getCoordOffset(i, coords[i]);
+                    row += coords[i]*rowStrides_[i];
+                }
+
+                if (rowUnlocked[row] == 0) {
+                    FAST_METHODS_COUNT_N(LOCKED_SKIPS, rowCells);
+                    FAST_METHODS_COUNT(BLOCK_SKIPS);
+                }
+                else {
+                    // Words may have cells of the previous and next rows, which are beyond the ends.
+                    const size_t rowPos = size_t(row)*dimsize_[0];
+                    int x = first[0];
+                    if (inc[0] == 1) {
+                        while (x < last[0]) {
+                            const size_t p = rowPos + x;
+                            const uint64_t bits = words[p >> 6] >> (p & 63);
+                            const int next = bits ? x + __builtin_ctzll(bits) : x + 64 - int(p & 63);
+                            if (!bits)
+                                FAST_METHODS_COUNT(BLOCK_SKIPS);
+                            FAST_METHODS_COUNT_N(LOCKED_SKIPS, std::min(next, last[0]) - x);
+                            x = next;
+                            if (bits && x < last[0]) {
+                                coords[0] = x;
+                                solve(base + grid.getCoordOffset(0, x), coords, row);
+                                ++x;
+                            }
+                        }
+                    }
+                    else {
+                        while (x > last[0]) {
+                            const size_t p = rowPos + x;
+                            const uint64_t bits = words[p >> 6] << (63 - (p & 63));
+                            const int next = bits ? x - __builtin_clzll(bits) : x - int(p & 63) - 1;
+                            if (!bits)
+                                FAST_METHODS_COUNT(BLOCK_SKIPS);
+                            FAST_METHODS_COUNT_N(LOCKED_SKIPS, x - std::max(next, last[0]));
+                            x = next;
+                            if (bits && x > last[0]) {
+                                coords[0] = x;
+                                solve(base + grid.getCoordOffset(0, x), coords, row);
+                                --x;
+                            }
+                        }
+                    }
+                }
+                if (checkStop)
+                    stopRequested(std::numeric_limits<double>::quiet_NaN(), rowCells);
+
+                // Next row.
+                size_t i = 1;
+                for (; i < N; ++i) {
+                    coords[i] += inc[i];
+                    if (coords[i] != last[i])
+                        break;
+                    coords[i] = first[i];
                 }
-                // EXPERIMENTAL - Value not updated, it has converged
-                else if(!isnan(newTime) && !isinf(newTime) && (idx == goal_idx_))
-                    stopPropagation_ = true;
+                if (i >= N)
+                    break;
+            }
+        }
+
+        /** \brief Actually executes one solving iteration of the LSM on the unlocked cell idx, at the given
+            coordinates and row. The cell is locked and, if its time improves, the neighbors with a
+            higher time are unlocked. */
+        void solveUnlocked
+        (unsigned int idx, const std::array<int, grid_t::getNDims()> & coords, unsigned int row) {
+            lock(unlockedCells_, rowUnlocked_, size_t(row)*dimsize_[0] + coords[0], row);
+            const double prevTime = grid_->getCell(idx).getArrivalTime();
+            const double newTime = solveEikonal(idx);
+
+            // Cells beyond the limits are not computed, only locked.
+            if (!isWithinLimits(idx, newTime))
+                return;
+
+            // Update time if better and unlock neighbors with higher time.
+            if(utils::isTimeBetterThan(newTime, prevTime)) {
+                grid_->getCell(idx).setArrivalTime(newTime);
+                keepSweeping_ = true;
+                const grid_t & grid = *grid_;
+                unlockNeighbors(idx, coords, row, newTime, [&grid] (unsigned int j) { return grid.getCell(j).getArrivalTime(); },
+                                unlockedCells_, rowUnlocked_);
+            }
+            // EXPERIMENTAL - Value not updated, it has converged
+            else if(!isnan(newTime) && !isinf(newTime) && (idx == goal_idx_))
+                stopPropagation_ = true;
+        }
 
-                grid_->getCell(idx).setState(FMState::FROZEN);
+        /** \brief solveUnlocked() on a private copy. */
+        void solveUnlockedInCopy
+        (SweepCopy & c, unsigned int idx, const std::array<int, grid_t::getNDims()> & coords, unsigned int row) {
+            lock(c.unlockedCells, c.rowUnlocked, size_t(row)*dimsize_[0] + coords[0], row);
+            const value_t newTime = solveEikonal(c.times, idx);
+            // Cells beyond the limits are not computed, only locked.
+            if (!isWithinLimits(idx, newTime))
+                return;
+            if (utils::isTimeBetterThan(newTime, c.times[idx])) {
+                c.times[idx] = newTime;
+                c.changed = true;
+                unlockNeighbors(idx, coords, row, newTime, [&c] (unsigned int j) { return c.times[j]; },
+                                c.unlockedCells, c.rowUnlocked);
             }
+            else if (!isnan(newTime) && !isinf(newTime) && (idx == goal_idx_))
+                c.converged = true;
+        }
+
+        /** \brief Unlocks in cells (rowUnlocked, the unlocked cells per row) the free neighbors of cell idx,
+            at the given coordinates and row, whose time (times(j)) is higher than t. */
+        template <class T>
+        void unlockNeighbors
+        (unsigned int idx, const std::array<int, grid_t::getNDims()> & coords, unsigned int row, double t,
+         T times, OccupancyBitmap & cells, std::vector<unsigned int> & rowUnlocked) {
+            const grid_t & grid = *grid_;
+            FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+            const size_t p = size_t(row)*dimsize_[0] + coords[0];
+            for (size_t k = 0; k < grid_t::getNDims(); ++k) {
+                const unsigned int offset = grid.getCoordOffset(k, coords[k]);
+                const size_t stride = (k == 0) ? 1 : size_t(rowStrides_[k])*dimsize_[0];
+                const unsigned int rowStride = (k == 0) ? 0 : rowStrides_[k];
+                if (coords[k] > 0) {
+                    const unsigned int j = idx - offset + grid.getCoordOffset(k, coords[k] - 1);
+                    if (!grid.getCell(j).isOccupied() && utils::isTimeBetterThan(t, times(j)))
+                        unlock(cells, rowUnlocked, p - stride, row - rowStride);
+                }
+                if (coords[k] + 1 < dimsize_[k]) {
+                    const unsigned int j = idx - offset + grid.getCoordOffset(k, coords[k] + 1);
+                    if (!grid.getCell(j).isOccupied() && utils::isTimeBetterThan(t, times(j)))
+                        unlock(cells, rowUnlocked, p + stride, row + rowStride);
+                }
+            }
+        }
+
+        /** \brief Unlocks the cell at row-major position p, in the given row. */
+        static inline void unlock
+        (OccupancyBitmap & cells, std::vector<unsigned int> & rowUnlocked, size_t p, unsigned int row) {
+            if (!cells.test(p)) {
+                cells.set(p);
+                ++rowUnlocked[row];
+            }
+        }
+
+        /** \brief Locks the unlocked cell at row-major position p, in the given row. */
+        static inline void lock
+        (OccupancyBitmap & cells, std::vector<unsigned int> & rowUnlocked, size_t p, unsigned int row) {
+            cells.reset(p);
+            --rowUnlocked[row];
         }
 
         // Inherited members from FSM.
-        using FSM<grid_t>::grid_;
-        using FSM<grid_t>::init_points_;
-        using FSM<grid_t>::goal_idx_;
-        using FSM<grid_t>::setup_;
-        using FSM<grid_t>::setup;
-        using FSM<grid_t>::name_;
-        using FSM<grid_t>::time_;
-        using FSM<grid_t>::recursiveIteration;
-        using FSM<grid_t>::solveEikonal;
-        using FSM<grid_t>::setSweep;
-        using FSM<grid_t>::sweeps_;
-        using FSM<grid_t>::maxSweeps_;
-        using FSM<grid_t>::keepSweeping_;
-        using FSM<grid_t>::stopPropagation_;
-        using FSM<grid_t>::incs_;
-        using FSM<grid_t>::inits_;
-        using FSM<grid_t>::ends_;
-        using FSM<grid_t>::d_;
-
-        /** \brief Auxiliar array which stores the neighbor of each iteration of the computeFM() function. */
-        std::array <unsigned int, 2*grid_t::getNDims()> neighbors_;
+        using FSMBase::grid_;
+        using FSMBase::init_points_;
+        using FSMBase::goal_idx_;
+        using FSMBase::setup_;
+        using FSMBase::setup;
+        using FSMBase::name_;
+        using FSMBase::time_;
+        using FSMBase::resetTime_;
+        using FSMBase::solveEikonal;
+        using FSMBase::setSweep;
+        using FSMBase::sweeps_;
+        using FSMBase::maxSweeps_;
+        using FSMBase::keepSweeping_;
+        using FSMBase::stopPropagation_;
+        using FSMBase::stopped_;
+        using FSMBase::stopRequested;
+        using FSMBase::counters_;
+        using FSMBase::parallelSweeps;
+        using FSMBase::copies_;
+        using FSMBase::times_;
+        using FSMBase::lo_;
+        using FSMBase::hi_;
+        using FSMBase::incs_;
+        using FSMBase::inits_;
+        using FSMBase::ends_;
+        using FSMBase::dimsize_;
+        using FSMBase::isWithinLimits;
+
+        /** \brief Cells whose time improved in the last iteration of the parallel sweeps, 1 if so. */
+        std::vector<unsigned char> improved_;
+
+        /** \brief Locks of the sequential sweeps: a bit per cell, set if unlocked, by row-major position so
+            that the cells of a row are consecutive bits whatever the layout of the grid. */
+        OccupancyBitmap unlockedCells_;
+
+        /** \brief Number of unlocked cells of each row (cells with the same coordinates but the first one). */
+        std::vector<unsigned int> rowUnlocked_;
+
+        /** \brief Number of rows, and rows between consecutive coordinates of each dimension (but the first). */
+        unsigned int nrows_;
+        std::array<unsigned int, grid_t::getNDims()> rowStrides_;
 };
 
 #endif /* LSM_HPP_*/
@@ -0,0 +1,622 @@
+/*! \class PFMM
+    \brief Implements a parallel Fast Marching Method by domain decomposition.
+
+    The grid is split into subdomains (blocks of blockSize cells per side). Each subdomain
+    is an nDGridMap on its own, with a ghost layer of one cell around it which holds the
+    arrival times of the neighbor subdomains, and its own heap of type heap_t (any heap
+    which can be used with FMM). Subdomains are allocated the first time the front reaches
+    them and kept for the next queries.
+
+    The propagation is done in rounds. Each round:
+    - Every subdomain marches (as FMM) the cells of its narrow band with arrival time lower
+      than the bound of the round, in parallel (WorkerPool).
+    - Ghost layers are updated from the boundary cells which changed in the neighbor
+      subdomains. If a ghost cell receives a smaller arrival time, its neighbor within the
+      subdomain is updated and, if its time improves, it goes back to the narrow band even
+      if it was frozen. When the cells after it are marched again they are also updated
+      even if frozen, so the regions which were marched with a worse arrival time are rolled
+      back and re-marched.
+    - The bound of the next round is the minimum arrival time of all the narrow bands plus
+      stride*leafsize.
+
+    The algorithm finishes when all narrow bands are empty, or when the goal is frozen and
+    there is no lower arrival time in any narrow band. The arrival times are those for which
+    no cell can be improved more than utils::COMP_MARGIN, as for FMM, so both match up to
+    the rounding errors of computing the times in a different order (1e-9 relative in the
+    tests done). Heuristics are not supported.
+
+    Larger strides lead to fewer rounds (synchronizations) but more re-marched cells.
+
+    @par External documentation:
+        M. Breuss, E. Cristiani, P. Gwosdek and O. Vogel, An adaptive domain-decomposition technique for
+        parallelization of the fast marching method, Applied Mathematics and Computation, 218(1), 32-44, 2011.
+        <a href="http://dx.doi.org/10.1016/j.amc.2011.05.041">[DOI]</a>
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PFMM_HPP_
+#define PFMM_HPP_
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <limits>
+
+#include <fast_methods/fm/eikonalsolver.hpp>
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/datastructures/fmdaryheap.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+#include <fast_methods/utils/utils.h>
+
+template < class grid_t, class heap_t = FMDaryHeap<typename grid_t::cell_t> > class PFMM : public EikonalSolver<grid_t> {
+
+    public:
+        typedef typename EikonalSolver<grid_t>::value_t value_t;
+
+        /** @param nthreads number of threads, 0 to use as many as hardware threads.
+            @param blockSize cells per side of the subdomains, 0 for 64 in 2D, 32 in 3D and 8 otherwise.
+            @param stride width of the rounds, in cells (see class description). */
+        PFMM(unsigned nthreads = 0, unsigned blockSize = 0, double stride = 16) : EikonalSolver<grid_t>("PFMM"),
+            nthreads_(nthreads), blockSize_(blockSize), stride_(stride), rounds_(0), epoch_(0) {}
+
+        PFMM(const char * name, unsigned nthreads = 0, unsigned blockSize = 0, double stride = 16) : EikonalSolver<grid_t>(name),
+            nthreads_(nthreads), blockSize_(blockSize), stride_(stride), rounds_(0), epoch_(0) {}
+
+        virtual ~PFMM() { clear(); }
+
+        /** \brief Splits the grid if it changed and starts the threads. */
+        virtual void setup
+        () {
+            EikonalSolver<grid_t>::setup();
+            if (splitGrid_ != grid_ || splitDims_ != grid_->getDimSizes())
+                split();
+            pool_.resize(nthreads_);
+        }
+
+        /** \brief Actual method that implements parallel FMM. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            // Velocities are read again in each query.
+            ++epoch_;
+            touched_.clear();
+            rounds_ = 0;
+
+            // Algorithm initialization.
+            for (const unsigned int & i: init_points_) {
+                std::array<unsigned int, grid_t::getNDims()> coords;
+                grid_->idx2coord(i, coords);
+                const unsigned int s = subdomainOf(coords);
+                touch(s);
+                Subdomain & sub = *subs_[s];
+                const unsigned int l = localIdx(sub, coords);
+                sub.grid.getCell(l).setArrivalTime(0);
+                sub.grid.getCell(l).setState(FMState::NARROW);
+                sub.heap.push(sub.grid.getCellPtr(l));
+                FAST_METHODS_COUNT(HEAP_PUSHES);
+                sub.minTime = 0;
+            }
+
+            const bool hasGoal = int(goal_idx_) != -1;
+            std::array<unsigned int, grid_t::getNDims()> goalCoords;
+            unsigned int goalSub = 0;
+            if (hasGoal) {
+                grid_->idx2coord(goal_idx_, goalCoords);
+                goalSub = subdomainOf(goalCoords);
+            }
+
+            // Main loop, a round per iteration.
+            while (true) {
+                value_t minTime = std::numeric_limits<value_t>::infinity();
+                for (unsigned int s : touched_)
+                    minTime = std::min(minTime, subs_[s]->minTime);
+                if (std::isinf(minTime))
+                    break;
+                if (hasGoal && subs_[goalSub] && subs_[goalSub]->epoch == epoch_) {
+                    const Subdomain & sub = *subs_[goalSub];
+                    const auto & goal = sub.grid.getCell(localIdx(sub, goalCoords));
+                    if (goal.getState() == FMState::FROZEN && goal.getArrivalTime() <= minTime)
+                        break;
+                }
+                ++rounds_;
+
+                // Marching.
+                const value_t bound = minTime + stride_*leafsize_;
+                active_.clear();
+                for (unsigned int s : touched_)
+                    if (subs_[s]->minTime <= bound)
+                        active_.push_back(s);
+                runParallel(active_, [this, bound] (unsigned int s) { march(*subs_[s], bound); });
+
+                // Subdomains next to the faces changed read their ghost layers, and then update
+                // their cells next to the ghost cells improved (two steps, as these cells can be
+                // read by other subdomains).
+                active_.clear();
+                for (unsigned int n = 0, ntouched = touched_.size(); n < ntouched; ++n) {
+                    const unsigned int s = touched_[n];
+                    for (unsigned int f = 0; f < 2*grid_t::getNDims(); ++f)
+                        if (subs_[s]->changed & (1 << f)) {
+                            const unsigned int nb = neighborSubdomain(s, f);
+                            touch(nb);
+                            if (!subs_[nb]->incoming)
+                                active_.push_back(nb);
+                            subs_[nb]->incoming |= 1 << (f ^ 1);
+                        }
+                    subs_[s]->changed = 0;
+                }
+                runParallel(active_, [this] (unsigned int s) { readGhosts(s); });
+                runParallel(active_, [this] (unsigned int s) { updateFromGhosts(*subs_[s]); });
+            }
+
+            // Results are copied to the grid.
+            for (unsigned int s : touched_)
+                writeBack(*subs_[s]);
+        }
+
+        /** \brief Returns the number of threads used. */
+        unsigned int getNumberOfThreads
+        () const {
+            if (nthreads_ > 0)
+                return nthreads_;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /** \brief Returns the number of cells per side of the subdomains. */
+        unsigned int getBlockSize
+        () const {
+            if (blockSize_ > 0)
+                return blockSize_;
+            return (grid_t::getNDims() == 2) ? 64 : ((grid_t::getNDims() == 3) ? 32 : 8);
+        }
+
+        virtual void clear
+        () {
+            EikonalSolver<grid_t>::clear();
+            subs_.clear();
+            touched_.clear();
+            splitGrid_ = nullptr;
+            rounds_ = 0;
+        }
+
+        virtual void reset
+        () {
+            EikonalSolver<grid_t>::reset();
+            rounds_ = 0;
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Parallel Fast Marching Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Block size: " << getBlockSize() << '\n'
+                      << '\t' << "Stride: " << stride_ << '\n'
+                      << '\t' << "Threads: " << getNumberOfThreads() << '\n'
+                      << '\t' << "Subdomains reached: " << touched_.size() << '\n'
+                      << '\t' << "Rounds: " << rounds_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the subdomains reached (their grids, narrow bands and
+            boundaries) and the lists of subdomains. */
+        virtual size_t memory
+        () const {
+            size_t bytes = EikonalSolver<grid_t>::memory() + MemoryUsage::of(subs_) + MemoryUsage::of(touched_)
+                    + MemoryUsage::of(active_) + heap_t::sharedMemory();
+            for (const std::unique_ptr<Subdomain> & s : subs_)
+                if (s)
+                    bytes += sizeof(Subdomain) + s->grid.memory() + s->heap.memory() + MemoryUsage::of(s->boundary)
+                            + MemoryUsage::of(s->ghosts) + MemoryUsage::of(s->faces) + MemoryUsage::of(s->globals)
+                            + MemoryUsage::of(s->pending);
+            return bytes;
+        }
+
+        virtual size_t sharedMemory
+        () const {
+            return heap_t::sharedMemory();
+        }
+
+    protected:
+        /** \brief A block of the grid with a ghost layer, and its narrow band. */
+        struct Subdomain {
+            /** \brief Cells of the block and its ghost layer. */
+            grid_t                                          grid;
+
+            /** \brief Narrow band of the subdomain. */
+            heap_t                                          heap;
+
+            /** \brief Coordinates of the first cell of the block. */
+            std::array<unsigned int, grid_t::getNDims()>    origin;
+
+            /** \brief Cells of the block per dimension. */
+            std::array<unsigned int, grid_t::getNDims()>    ext;
+
+            /** \brief For each face, cells of the block next to it and ghost cells next to them (empty if
+                the face is on the border of the grid), in the same order. Face 2*i is the lower one of
+                dimension i and 2*i+1 the upper one. The cells of face 2*i+1 of a subdomain are in the
+                same order as the ghost cells of face 2*i of the next one. */
+            std::array<std::vector<unsigned int>, 2*grid_t::getNDims()> boundary, ghosts;
+
+            /** \brief For each cell, faces of the block it is next to (bit per face), and bit 2*ndims
+                set for ghost cells. */
+            std::vector<unsigned short>                     faces;
+
+            /** \brief Faces with a neighbor subdomain. */
+            unsigned int                                    linked;
+
+            /** \brief Cell of the global grid of each cell of the block, in row-major order. */
+            std::vector<unsigned int>                       globals;
+
+            /** \brief Cells of the block next to ghost cells improved in the last exchange. */
+            std::vector<unsigned int>                       pending;
+
+            /** \brief Minimum arrival time of the narrow band, infinity if empty. */
+            value_t                                         minTime;
+
+            /** \brief Faces with cells frozen since the last exchange. */
+            unsigned int                                    changed;
+
+            /** \brief Faces from which the ghost cells have to be read. */
+            unsigned int                                    incoming;
+
+            /** \brief Query in which the subdomain was last initialized. */
+            unsigned int                                    epoch;
+        };
+
+        /** \brief Computes the subdomains of the grid. They are not allocated until reached. */
+        void split
+        () {
+            const unsigned int bs = getBlockSize();
+            unsigned int nsubs = 1;
+            for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+                nsubsDim_[i] = (grid_->getDimSizes()[i] + bs - 1)/bs;
+                subStride_[i] = nsubs;
+                nsubs *= nsubsDim_[i];
+            }
+            subs_.clear();
+            subs_.resize(nsubs);
+            touched_.clear();
+            splitGrid_ = grid_;
+            splitDims_ = grid_->getDimSizes();
+        }
+
+        /** \brief Allocates subdomain s if it is not, and initializes it if it was not reached in this
+            query: the grid is cleaned and the velocities are copied from the global grid. */
+        void touch
+        (unsigned int s) {
+            if (!subs_[s])
+                build(s);
+            Subdomain & sub = *subs_[s];
+            if (sub.epoch == epoch_)
+                return;
+
+            sub.grid.clean();
+            sub.heap.clear();
+            const grid_t & grid = *grid_;
+            forEachCell(sub, [&] (unsigned int k, const std::array<unsigned int, grid_t::getNDims()> & c) {
+                sub.grid.getCell(localIdx(sub, c, false)).setOccupancy(grid.getCell(sub.globals[k]).getOccupancy());
+            });
+            sub.pending.clear();
+            sub.minTime = std::numeric_limits<value_t>::infinity();
+            sub.changed = 0;
+            sub.incoming = 0;
+            sub.epoch = epoch_;
+            sub.grid.setClean(false);
+            touched_.push_back(s);
+        }
+
+        /** \brief Allocates subdomain s: its grid, faces and the cells of the global grid. */
+        void build
+        (unsigned int s) {
+            constexpr size_t N = grid_t::getNDims();
+            const unsigned int bs = getBlockSize();
+            subs_[s].reset(new Subdomain);
+            Subdomain & sub = *subs_[s];
+
+            std::array<unsigned int, N> dims;
+            sub.linked = 0;
+            for (size_t i = 0; i < N; ++i) {
+                const unsigned int c = (s / subStride_[i]) % nsubsDim_[i];
+                sub.origin[i] = c*bs;
+                sub.ext[i] = std::min(bs, splitDims_[i] - c*bs);
+                dims[i] = sub.ext[i] + 2;
+                sub.linked |= (c > 0) << 2*i;
+                sub.linked |= (c + 1 < nsubsDim_[i]) << (2*i+1);
+            }
+            sub.grid.setLeafSize(grid_->getLeafSize());
+            sub.grid.setBrickSize(grid_->getBrickSize());
+            sub.grid.resize(dims);
+            sub.heap.setMaxSize(sub.grid.size());
+            sub.epoch = 0;
+
+            // Ghost cells (and padding) are not marched.
+            sub.faces.assign(sub.grid.size(), 1 << 2*N);
+
+            unsigned int ncells = 1;
+            for (size_t i = 0; i < N; ++i)
+                ncells *= sub.ext[i];
+            sub.globals.resize(ncells);
+            forEachCell(sub, [&] (unsigned int k, const std::array<unsigned int, N> & c) {
+                std::array<unsigned int, N> g;
+                unsigned short faces = 0;
+                for (size_t i = 0; i < N; ++i) {
+                    g[i] = sub.origin[i] + c[i];
+                    faces |= (c[i] == 0) << 2*i;
+                    faces |= (c[i] + 1 == sub.ext[i]) << (2*i+1);
+                }
+                grid_->coord2idx(g, sub.globals[k]);
+                const unsigned int l = localIdx(sub, c, false);
+                sub.faces[l] = faces;
+
+                for (unsigned int f = 0; f < 2*N; ++f) {
+                    if (!(faces & (1 << f)))
+                        continue;
+                    sub.boundary[f].push_back(l);
+                    if (sub.linked & (1 << f)) {
+                        std::array<unsigned int, N> lg = c;
+                        for (size_t i = 0; i < N; ++i)
+                            ++lg[i];
+                        lg[f/2] = (f & 1) ? sub.ext[f/2] + 1 : 0;
+                        unsigned int gi;
+                        sub.grid.coord2idx(lg, gi);
+                        sub.ghosts[f].push_back(gi);
+                    }
+                }
+            });
+            // Cells outside the grid have infinite arrival time, their velocity does not matter.
+            for (unsigned int i = 0; i < sub.grid.size(); ++i)
+                if (sub.faces[i] >> 2*N)
+                    sub.grid[i].setOccupancy(0);
+        }
+
+        /** \brief Calls f(k, c) for the cells of the block of sub in row-major order, k being the position
+            of the cell (index in globals) and c its coordinates within the block. */
+        template <class F>
+        void forEachCell
+        (const Subdomain & sub, F && f) const {
+            constexpr size_t N = grid_t::getNDims();
+            std::array<unsigned int, N> c;
+            c.fill(0);
+            const unsigned int ncells = sub.globals.size();
+            for (unsigned int k = 0; k < ncells; ++k) {
+                f(k, c);
+                for (size_t i = 0; i < N; ++i) {
+                    if (++c[i] < sub.ext[i])
+                        break;
+                    c[i] = 0;
+                }
+            }
+        }
+
+        /** \brief Marches the cells of the narrow band of sub with arrival time up to bound, as FMM does, but
+            updating also frozen cells if their arrival time improves. */
+        void march
+        (Subdomain & sub, value_t bound) {
+            const grid_t & cgrid = sub.grid;
+            std::array<unsigned int, 2*grid_t::getNDims()> neighs;
+            value_t minTime = std::numeric_limits<value_t>::infinity();
+            while (!sub.heap.empty()) {
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, sub.heap.size());
+                const unsigned int idxMin = sub.heap.popMinIdx();
+                FAST_METHODS_COUNT(HEAP_POPS);
+                const value_t t = cgrid.getCell(idxMin).getArrivalTime();
+                if (t > bound) {
+                    sub.heap.push(sub.grid.getCellPtr(idxMin));
+                    FAST_METHODS_COUNT(HEAP_PUSHES);
+                    minTime = t;
+                    break;
+                }
+                sub.grid.getCell(idxMin).setState(FMState::FROZEN);
+                sub.changed |= sub.faces[idxMin] & sub.linked;
+
+                const unsigned int n_neighs = cgrid.getNeighbors(idxMin, neighs);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
+                for (unsigned int s = 0; s < n_neighs; ++s) {
+                    const unsigned int j = neighs[s];
+                    if ((sub.faces[j] >> 2*grid_t::getNDims()) || cgrid.getCell(j).isOccupied())
+                        continue;
+                    updateCell(sub, j);
+                }
+            }
+            sub.minTime = minTime;
+        }
+
+        /** \brief Updates the arrival time of cell j of sub. If it improves, j is set as NARROW (even if it
+            was frozen) and pushed or updated in the narrow band. */
+        inline void updateCell
+        (Subdomain & sub, unsigned int j) {
+            const grid_t & cgrid = sub.grid;
+            const value_t t = solveEikonal(cgrid, j);
+            if (!utils::isTimeBetterThan(t, cgrid.getCell(j).getArrivalTime()) || !isWithinLimits(sub, j, t))
+                return;
+
+            const bool narrow = cgrid.getCell(j).getState() == FMState::NARROW;
+            sub.grid.getCell(j).setArrivalTime(t);
+            if (narrow) {
+                sub.heap.increase(sub.grid.getCellPtr(j));
+                FAST_METHODS_COUNT(HEAP_INCREASES);
+            }
+            else {
+                sub.grid.getCell(j).setState(FMState::NARROW);
+                sub.heap.push(sub.grid.getCellPtr(j));
+                FAST_METHODS_COUNT(HEAP_PUSHES);
+            }
+            sub.minTime = std::min(sub.minTime, t);
+        }
+
+        /** \brief Solver::isWithinLimits() for cell j of sub. */
+        inline bool isWithinLimits
+        (const Subdomain & sub, unsigned int j, value_t t) const {
+            if (t > maxTime_)
+                return false;
+            if (std::isinf(maxDistance_) && !corridor_)
+                return true;
+            std::array<unsigned int, grid_t::getNDims()> c;
+            sub.grid.idx2coord(j, c);
+            for (size_t i = 0; i < grid_t::getNDims(); ++i)
+                c[i] += sub.origin[i] - 1; // Ghost layer.
+            if (corridor_) {
+                unsigned int idx;
+                grid_->coord2idx(c, idx);
+                if (!(*corridor_)[idx])
+                    return false;
+            }
+            return std::isinf(maxDistance_) || isWithinDistance(c);
+        }
+
+        /** \brief Copies to the ghost cells of subdomain s the frozen cells of the neighbor subdomains
+            through the faces set in incoming, if they improve them. Only the ghost cells of s are modified. */
+        void readGhosts
+        (unsigned int s) {
+            Subdomain & sub = *subs_[s];
+            for (unsigned int f = 0; f < 2*grid_t::getNDims(); ++f) {
+                if (!(sub.incoming & (1 << f)))
+                    continue;
+                const Subdomain & nb = *subs_[neighborSubdomain(s, f)];
+                const std::vector<unsigned int> & owners = nb.boundary[f ^ 1];
+                for (unsigned int k = 0; k < owners.size(); ++k) {
+                    const auto & owner = nb.grid.getCell(owners[k]);
+                    const unsigned int g = sub.ghosts[f][k];
+                    if (owner.getState() != FMState::FROZEN ||
+                        !utils::isTimeBetterThan(owner.getArrivalTime(), sub.grid.getCell(g).getArrivalTime()))
+                        continue;
+                    sub.grid.getCell(g).setArrivalTime(owner.getArrivalTime());
+                    sub.pending.push_back(sub.boundary[f][k]);
+                }
+            }
+            sub.incoming = 0;
+        }
+
+        /** \brief Updates the cells next to the ghost cells improved by readGhosts(). */
+        void updateFromGhosts
+        (Subdomain & sub) {
+            for (unsigned int j : sub.pending)
+                if (!sub.grid.getCell(j).isOccupied())
+                    updateCell(sub, j);
+            sub.pending.clear();
+        }
+
+        /** \brief Copies the arrival times of the cells reached to the grid. */
+        void writeBack
+        (const Subdomain & sub) {
+            forEachCell(sub, [&] (unsigned int k, const std::array<unsigned int, grid_t::getNDims()> & c) {
+                const auto & cell = sub.grid.getCell(localIdx(sub, c, false));
+                if (!std::isinf(cell.getArrivalTime())) {
+                    grid_->getCell(sub.globals[k]).setArrivalTime(cell.getArrivalTime());
+                    grid_->getCell(sub.globals[k]).setState(cell.getState());
+                }
+            });
+        }
+
+        /** \brief Runs f(s) for the subdomains in subs with the threads of the pool. */
+        template <class F>
+        void runParallel
+        (const std::vector<unsigned int> & subs, F && f) {
+            std::atomic<unsigned int> next(0);
+            pool_.run([&subs, &next, &f] (unsigned int) {
+                for (unsigned int k = next++; k < subs.size(); k = next++)
+                    f(subs[k]);
+            });
+        }
+
+        /** \brief Returns the subdomain of the cell with coordinates coords. */
+        unsigned int subdomainOf
+        (const std::array<unsigned int, grid_t::getNDims()> & coords) const {
+            const unsigned int bs = getBlockSize();
+            unsigned int s = 0;
+            for (size_t i = 0; i < grid_t::getNDims(); ++i)
+                s += (coords[i] / bs)*subStride_[i];
+            return s;
+        }
+
+        /** \brief Returns the index in sub.grid of the cell with coordinates coords, in the global grid
+            or within the block. */
+        unsigned int localIdx
+        (const Subdomain & sub, const std::array<unsigned int, grid_t::getNDims()> & coords, bool global = true) const {
+            std::array<unsigned int, grid_t::getNDims()> l;
+            for (size_t i = 0; i < grid_t::getNDims(); ++i)
+                l[i] = coords[i] - (global ? sub.origin[i] : 0) + 1;
+            unsigned int li;
+            sub.grid.coord2idx(l, li);
+            return li;
+        }
+
+        /** \brief Returns the neighbor subdomain of s through face f. */
+        inline unsigned int neighborSubdomain
+        (unsigned int s, unsigned int f) const {
+            return (f & 1) ? s + subStride_[f/2] : s - subStride_[f/2];
+        }
+
+        using EikonalSolver<grid_t>::grid_;
+        using EikonalSolver<grid_t>::init_points_;
+        using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::setup_;
+        using EikonalSolver<grid_t>::name_;
+        using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
+        using EikonalSolver<grid_t>::solveEikonal;
+        using EikonalSolver<grid_t>::leafsize_;
+        using EikonalSolver<grid_t>::maxTime_;
+        using EikonalSolver<grid_t>::maxDistance_;
+        using EikonalSolver<grid_t>::corridor_;
+        using EikonalSolver<grid_t>::isWithinDistance;
+        using EikonalSolver<grid_t>::counters_;
+
+    private:
+        /** \brief Number of threads, 0 for as many as hardware threads. */
+        unsigned int nthreads_;
+
+        /** \brief Cells per side of the subdomains, 0 for the default of getBlockSize(). */
+        unsigned int blockSize_;
+
+        /** \brief Width of the rounds in cells. */
+        double stride_;
+
+        /** \brief Rounds performed. */
+        unsigned int rounds_;
+
+        /** \brief Incremented every query, subdomains with a different epoch are initialized when reached. */
+        unsigned int epoch_;
+
+        /** \brief Threads marching the subdomains. */
+        WorkerPool pool_;
+
+        /** \brief Subdomains, nullptr until reached for the first time. */
+        std::vector<std::unique_ptr<Subdomain> > subs_;
+
+        /** \brief Subdomains reached in the current query. */
+        std::vector<unsigned int> touched_;
+
+        /** \brief Subdomains to process in the current step of a round. */
+        std::vector<unsigned int> active_;
+
+        /** \brief Number of subdomains per dimension. */
+        std::array<unsigned int, grid_t::getNDims()> nsubsDim_;
+
+        /** \brief Subdomain index increment for each dimension. */
+        std::array<unsigned int, grid_t::getNDims()> subStride_;
+
+        /** \brief Grid and dimensions the subdomains were computed for. */
+        const grid_t * splitGrid_ = nullptr;
+        std::array<unsigned int, grid_t::getNDims()> splitDims_ = {};
+};
+
+#endif /* PFMM_HPP_*/
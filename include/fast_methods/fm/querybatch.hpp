@@ -0,0 +1,222 @@
+/*! \class QueryBatch
+    \brief Solves many independent queries (initial points and goal) on the same environment
+    in parallel.
+
+    Each thread of the batch has its own solver_t instance and its own grid, which are
+    reused for all the queries the thread solves: after a query the solver is reset, so only
+    the cells touched by the query are restored (see nDGridMap::clean()). For FMCellSoA
+    grids, the grids of the threads are solution layers of the environment (see
+    nDGridMap::shareEnvironment()), so the velocities are shared instead of copied. For the
+    rest of cell types each thread copies the environment once.
+
+    Queries are handed out to the threads one at a time from a shared counter, so threads
+    which finish early take the remaining queries.
+
+    The environment must not be modified while a batch runs. Layers (and copies) are created
+    in the first run, call clear() if the environment changes its size, obstacles or, for
+    non-layered grids, its velocities.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef QUERYBATCH_HPP_
+#define QUERYBATCH_HPP_
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+
+#include <fast_methods/fm/fmm.hpp>
+#include <fast_methods/gradientdescent/gradientdescent.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+
+template < class grid_t, class solver_t = FMM<grid_t> > class QueryBatch {
+
+    public:
+        typedef typename grid_t::value_t value_t;
+
+        /** \brief Shorthand for real points. */
+        typedef std::array<double, grid_t::getNDims()> Point;
+
+        /** \brief Shorthand for path type of real points. */
+        typedef std::vector<Point> Path;
+
+        /** \brief Initial points and goal (-1 for none) of a query, as indices of the grid. */
+        struct Query {
+            Query(const std::vector<unsigned int> & init, unsigned int goal = -1) : init_points(init), goal_idx(goal) {}
+
+            std::vector<unsigned int>   init_points;
+            unsigned int                goal_idx;
+        };
+
+        /** \brief Called for every query once solved, with its number, the grid holding the solution
+            and the solver. Called from the threads of the batch. */
+        typedef std::function<void (unsigned int, grid_t &, solver_t &)> callback_t;
+
+        /** @param env environment, the grid holding the velocities.
+            @param nthreads number of threads, 0 to use as many as hardware threads. */
+        QueryBatch(const grid_t & env, unsigned int nthreads = 0) :
+            QueryBatch(env, [] () { return new solver_t(); }, nthreads) {}
+
+        /** @param env environment, the grid holding the velocities.
+            @param factory returns a new solver, called once per thread.
+            @param nthreads number of threads, 0 to use as many as hardware threads. */
+        QueryBatch(const grid_t & env, const std::function<solver_t * ()> & factory, unsigned int nthreads = 0) :
+            env_(&env), factory_(factory), nthreads_(nthreads), nqueries_(0), time_(0) {}
+
+        /** \brief Solves the queries and calls f for each of them. */
+        void run
+        (const std::vector<Query> & queries, const callback_t & f) {
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            setup();
+            std::atomic<unsigned int> next(0);
+            pool_.run([this, &queries, &f, &next] (unsigned int t) {
+                Worker & w = *workers_[t];
+                for (unsigned int q = next++; q < queries.size(); q = next++) {
+                    w.solver->setInitialAndGoalPoints(queries[q].init_points, queries[q].goal_idx);
+                    w.solver->compute();
+                    f(q, w.grid, *w.solver);
+                    w.solver->reset();
+                }
+            });
+            nqueries_ = queries.size();
+            time_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /** \brief Solves the queries and returns their arrival times, in row-major order (see
+            nDGridMap::rowMajor2idx()). */
+        std::vector<std::vector<value_t> > computeArrivalTimes
+        (const std::vector<Query> & queries) {
+            std::vector<std::vector<value_t> > times(queries.size());
+            run(queries, [&times] (unsigned int q, grid_t & grid, solver_t &) {
+                const grid_t & cgrid = grid;
+                times[q].resize(cgrid.getNumberOfCells());
+                for (unsigned int i = 0; i < cgrid.getNumberOfCells(); ++i)
+                    times[q][i] = cgrid.getCell(cgrid.rowMajor2idx(i)).getArrivalTime();
+            });
+            return times;
+        }
+
+        /** \brief Solves the queries and returns the paths from their goals to the closest initial point,
+            computed with GradientDescent. Paths of queries without goal, or with goal not reached, are empty. */
+        std::vector<Path> computePaths
+        (const std::vector<Query> & queries, double step = 1) {
+            std::vector<Path> paths(queries.size());
+            run(queries, [&queries, &paths, step] (unsigned int q, grid_t & grid, solver_t &) {
+                unsigned int idx = queries[q].goal_idx;
+                if (int(idx) == -1 || std::isinf(grid.getCell(idx).getArrivalTime()))
+                    return;
+                std::vector<double> velocities;
+                GradientDescent<grid_t>::apply(grid, idx, paths[q], velocities, step);
+            });
+            return paths;
+        }
+
+        /** \brief Removes the solvers and grids of the threads, they are created again in the next run. */
+        void clear
+        () {
+            workers_.clear();
+        }
+
+        /** \brief Returns the number of threads. */
+        unsigned int getNumberOfThreads
+        () const {
+            if (nthreads_ > 0)
+                return nthreads_;
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /** \brief Returns the time of the last run in ms. */
+        double getTime
+        () const {
+            return time_;
+        }
+
+        /** \brief Returns the number of queries per second of the last run. */
+        double getQueriesPerSecond
+        () const {
+            return (time_ > 0) ? 1000*nqueries_/time_ : 0;
+        }
+
+        void printRunInfo
+        () const {
+            console::info("Query batch");
+            std::cout << '\t' << "Threads: " << getNumberOfThreads() << '\n'
+                      << '\t' << "Layers: " << (grid_t::canShareEnvironment() ? "yes" : "no (copies)") << '\n'
+                      << '\t' << "Queries: " << nqueries_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Queries per second: " << getQueriesPerSecond() << '\n';
+        }
+
+    protected:
+        /** \brief Solver and grid of a thread. */
+        struct Worker {
+            grid_t                      grid;
+            std::unique_ptr<solver_t>   solver;
+        };
+
+        /** \brief Starts the threads and creates their solvers and grids if not done yet. */
+        void setup
+        () {
+            pool_.resize(nthreads_);
+            while (workers_.size() < pool_.size()) {
+                workers_.emplace_back(new Worker);
+                Worker & w = *workers_.back();
+                w.solver.reset(factory_());
+                setEnvironment(w, std::integral_constant<bool, grid_t::canShareEnvironment()>());
+            }
+        }
+
+        /** \brief The grid of the worker is a solution layer of the environment. */
+        void setEnvironment
+        (Worker & w, std::true_type) {
+            w.solver->setEnvironmentLayer(*env_, &w.grid);
+        }
+
+        /** \brief The grid of the worker is a copy of the environment. */
+        void setEnvironment
+        (Worker & w, std::false_type) {
+            w.grid = *env_;
+            w.solver->setEnvironment(&w.grid);
+        }
+
+    private:
+        /** \brief Grid holding the velocities. */
+        const grid_t * env_;
+
+        /** \brief Creates the solvers of the threads. */
+        std::function<solver_t * ()> factory_;
+
+        /** \brief Number of threads, 0 for as many as hardware threads. */
+        unsigned int nthreads_;
+
+        /** \brief Threads solving the queries. */
+        WorkerPool pool_;
+
+        /** \brief Solver and grid of each thread. */
+        std::vector<std::unique_ptr<Worker> > workers_;
+
+        /** \brief Number of queries of the last run. */
+        unsigned int nqueries_;
+
+        /** \brief Time of the last run in ms. */
+        double time_;
+};
+
+#endif /* QUERYBATCH_HPP_*/
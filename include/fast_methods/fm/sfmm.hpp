@@ -41,7 +41,7 @@
 #include <fast_methods/ndgridmap/fmcell.h>
 #include <fast_methods/datastructures/fmpriorityqueue.hpp>
 
-template < class grid_t, class cell_t = FMCell>  class SFMM : public FMM<grid_t, FMPriorityQueue<cell_t>> {
+template < class grid_t, class cell_t = typename grid_t::cell_t>  class SFMM : public FMM<grid_t, FMPriorityQueue<cell_t>> {
 
     /** \brief Shorthand for base solver. */
     typedef FMM<grid_t, FMPriorityQueue<cell_t>> FMMBase;
@@ -38,7 +38,7 @@
 
 #include <fast_methods/fm/sfmm.hpp>
 
-template < class grid_t, class cell_t = FMCell>  class SFMMStar : public SFMM<grid_t, cell_t> {
+template < class grid_t, class cell_t = typename grid_t::cell_t>  class SFMMStar : public SFMM<grid_t, cell_t> {
     public:
         SFMMStar(HeurStrategy h = TIME) : SFMM<grid_t, cell_t>("SFMM*", h) {}
         SFMMStar(const char * name, HeurStrategy h = TIME) : SFMM<grid_t, cell_t>(name, h){}
@@ -5,6 +5,41 @@
     It uses as a main container the nDGridMap class. The nDGridMap template paramenter
     has to be an FMCell or something inherited from it.
 
+    The propagation can be bounded by a maximum arrival time (setMaxArrivalTime()) and a
+    maximum Euclidean distance to the closest initial point (setMaxDistance()). Solvers do not
+    set arrival times beyond the limits, so those cells keep an infinite arrival time, and
+    they stop when no cell within the limits can be improved. The maximum distance restricts the
+    environment to the cells within it: cells within the distance only reachable through farther
+    cells keep an infinite arrival time (or a larger one, if reachable by a longer path).
+    A corridor (setCorridor()) restricts the environment in the same way to the cells of a mask.
+
+    Instead of a goal point, a set of goals can be given with the number of them which have to
+    be frozen to finish (all of them, the first one...). Goals are kept in a bitmap of the size
+    of the grid, so solvers check whether a frozen cell is a goal in constant time
+    (goalFrozen()). FMM (and FMM*, SFMM...), UFMM, GMM and FIM finish when enough goals are
+    frozen; the rest of solvers compute the whole grid.
+
+    computeAsync() runs compute() in a new thread and returns its future. A running solve can
+    be stopped from any thread with cancel(), or with a CancelToken shared with other solvers
+    (setCancelToken()): FMM (and derived), FIM, GMM, UFMM, FSM, VFSM, LSM and DDQM check it every
+    getCheckInterval() iterations of their main loops (cells frozen, or updated by sweeping
+    and iterative methods) and stop leaving the cells computed so far (wasCancelled() is then
+    true). At the same points they call the progress callback, if set, with the number of
+    iterations and the current front time (the arrival time of the cells being frozen by
+    marching methods, NaN for the rest). The grid has to be reset before the next query, as
+    after any run.
+
+    The same checks enforce a time budget (setTimeBudget(), ms since compute() started) and an
+    iteration budget (setIterationBudget()): the solver stops at the first check past them,
+    leaving a valid partial field (wasBudgetExceeded()). Finite arrival times are the times of
+    actual paths, so they are upper bounds of the exact ones: frozen cells of marching methods
+    are final, and getFrontTime() is a lower bound of the times of the rest (of the time of the
+    goal for FMM* with heuristics). Sweeping and iterative methods stop after the row or pass
+    being updated. isGoalReached() tells whether the goal got an arrival time.
+
+    memory() returns the bytes allocated by the structures of the solver (heaps, active lists,
+    copies of the times...), kept across queries, and nDGridMap::memory() those of the grid.
+
     Copyright (C) 2014 Javier V. Gomez
     www.javiervgomez.com
 
@@ -29,20 +64,40 @@
 #include <numeric>
 #include <fstream>
 #include <array>
+#include <vector>
 #include <chrono>
+#include <limits>
+#include <future>
+#include <functional>
 
 #include <boost/concept_check.hpp>
 
 #include <fast_methods/console/console.h>
+#include <fast_methods/utils/canceltoken.hpp>
+#include <fast_methods/utils/opcounters.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
 
 /// \todo Init and goal points are not checked to be in the map.
 template <class grid_t>
 class Solver {
 
     public:
-        Solver() :name_("GenericSolver"), setup_(false) {}
-
-        Solver(const std::string& name) : name_(name), setup_(false) {}
+        /** \brief Function called with the number of iterations and the current front time (see setProgressCallback()). */
+        typedef std::function<void (unsigned long, double)> ProgressCallback;
+
+        Solver() :name_("GenericSolver"), setup_(false), setupTime_(0), resetTime_(0),
+            maxTime_(std::numeric_limits<double>::infinity()), maxDistance_(std::numeric_limits<double>::infinity()),
+            corridor_(nullptr), goalsToReach_(0), goalsFrozen_(0), ownToken_(true), checkInterval_(1024),
+            iterations_(0), checkCount_(0), stopped_(false), cancelled_(false), budgetExceeded_(false),
+            timeBudget_(std::numeric_limits<double>::infinity()), iterationBudget_(0),
+            frontTime_(std::numeric_limits<double>::quiet_NaN()) {}
+
+        Solver(const std::string& name) : name_(name), setup_(false), setupTime_(0), resetTime_(0),
+            maxTime_(std::numeric_limits<double>::infinity()), maxDistance_(std::numeric_limits<double>::infinity()),
+            corridor_(nullptr), goalsToReach_(0), goalsFrozen_(0), ownToken_(true), checkInterval_(1024),
+            iterations_(0), checkCount_(0), stopped_(false), cancelled_(false), budgetExceeded_(false),
+            timeBudget_(std::numeric_limits<double>::infinity()), iterationBudget_(0),
+            frontTime_(std::numeric_limits<double>::quiet_NaN()) {}
 
         virtual ~Solver() { clear(); }
 
@@ -53,11 +108,33 @@ class Solver {
             grid_->clean();
         }
 
+        /** \brief Makes layer a solution layer of env (see nDGridMap::shareEnvironment()) and sets it as
+            the grid. Solvers running on different layers of the same environment do not interfere. */
+        void setEnvironmentLayer
+        (const grid_t & env, grid_t * layer) {
+            layer->shareEnvironment(env);
+            setEnvironment(layer);
+        }
+
         /** \brief Sets the initial and goal points by the indices of the grid. */
         virtual void setInitialAndGoalPoints
         (const std::vector<unsigned int> & init_points, unsigned int goal_idx) {
             init_points_ = init_points;
             goal_idx_ = goal_idx;
+            clearGoals();
+        }
+
+        /** \brief Sets the initial points and a set of goals by the indices of the grid. The propagation
+            finishes when k different goals are frozen: 1 to finish at the first goal reached, 0
+            (default) to finish when all of them are. There is no single goal (goal point of the
+            heuristics or the path). */
+        virtual void setInitialAndGoalPoints
+        (const std::vector<unsigned int> & init_points, const std::vector<unsigned int> & goals, unsigned int k = 0) {
+            setInitialAndGoalPoints(init_points, -1);
+            goals_ = goals;
+            std::sort(goals_.begin(), goals_.end());
+            goals_.erase(std::unique(goals_.begin(), goals_.end()), goals_.end());
+            goalsToReach_ = (k == 0) ? goals_.size() : std::min<size_t>(k, goals_.size());
         }
 
         /** \brief Sets the initial points by the indices of the grid. */
@@ -89,6 +166,128 @@ class Solver {
             setInitialAndGoalPoints(init_points, -1);
         }
 
+        /** \brief Cells with arrival time larger than t are not computed (they keep an infinite
+            arrival time). Infinity (default) for no limit. */
+        virtual void setMaxArrivalTime
+        (double t) {
+            maxTime_ = t;
+        }
+
+        /** \brief Cells farther than d (in the units of the leaf size) from every initial point are
+            not computed (they keep an infinite arrival time). Infinity (default) for no limit. */
+        virtual void setMaxDistance
+        (double d) {
+            maxDistance_ = d;
+        }
+
+        /** \brief Only the cells i with (*mask)[i] true are computed, the rest keep an infinite arrival
+            time. The mask is indexed as the grid and is not copied. nullptr (default) for the whole grid. */
+        virtual void setCorridor
+        (const std::vector<bool> * mask) {
+            corridor_ = mask;
+        }
+
+        /** \brief Returns the mask given to setCorridor(). */
+        const std::vector<bool> * getCorridor
+        () const {
+            return corridor_;
+        }
+
+        /** \brief Returns the maximum arrival time computed. */
+        double getMaxArrivalTime
+        () const {
+            return maxTime_;
+        }
+
+        /** \brief Returns the goals set with setInitialAndGoalPoints(init_points, goals, k), sorted. */
+        const std::vector<unsigned int> & getGoals
+        () const {
+            return goals_;
+        }
+
+        /** \brief Returns the number of goals frozen in the last run. */
+        unsigned int getGoalsFrozen
+        () const {
+            return goalsFrozen_;
+        }
+
+        /** \brief Returns the maximum distance to the initial points of the cells computed. */
+        double getMaxDistance
+        () const {
+            return maxDistance_;
+        }
+
+        /** \brief Returns true if a maximum arrival time or distance, or a corridor, is set. */
+        bool hasLimits
+        () const {
+            return !std::isinf(maxTime_) || !std::isinf(maxDistance_) || corridor_;
+        }
+
+        /** \brief Returns true if arrival time t of cell idx is within the maximum arrival time,
+            distance and corridor. It is const, so threads can call it while solving. Requires setup(). */
+        inline bool isWithinLimits
+        (unsigned int idx, double t) const {
+            if (t > maxTime_)
+                return false;
+            if (corridor_ && !(*corridor_)[idx])
+                return false;
+            if (std::isinf(maxDistance_))
+                return true;
+            std::array<unsigned int, grid_t::getNDims()> coords;
+            grid_->idx2coord(idx, coords);
+            return isWithinDistance(coords);
+        }
+
+        /** \brief Returns true if the cell with coordinates coords is within the maximum distance. */
+        bool isWithinDistance
+        (const std::array<unsigned int, grid_t::getNDims()> & coords) const {
+            for (const std::array<unsigned int, grid_t::getNDims()> & c : initCoords_) {
+                double d2 = 0;
+                for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+                    const double d = double(coords[i]) - double(c[i]);
+                    d2 += d*d;
+                }
+                if (d2 <= maxDistance2_)
+                    return true;
+            }
+            return false;
+        }
+
+        /** \brief Computes the box containing the cells which can be within the limits: the bounding box
+            of the initial points enlarged by the maximum distance, or by the maximum arrival time
+            times the maximum speed of the grid. Cells in [lo, hi) in every dimension. Returns false
+            (and the whole grid) if there are no limits. Requires setup(). */
+        bool getLimitsBox
+        (std::array<int, grid_t::getNDims()> & lo, std::array<int, grid_t::getNDims()> & hi) const {
+            const std::array<unsigned int, grid_t::getNDims()> dimsize = grid_->getDimSizes();
+            double r = maxDistance_;
+            if (!std::isinf(maxTime_))
+                r = std::min(r, maxTime_ * grid_->getMaxSpeed());
+            if (std::isinf(r) || std::isnan(r)) {
+                for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+                    lo[i] = 0;
+                    hi[i] = dimsize[i];
+                }
+                return false;
+            }
+
+            // One more cell since discrete arrival times can be lower than the distance over the speed.
+            const int cells = int(std::ceil(r / grid_->getLeafSize())) + 1;
+            std::array<unsigned int, grid_t::getNDims()> coords;
+            for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+                lo[i] = dimsize[i];
+                hi[i] = 0;
+            }
+            for (unsigned int idx : init_points_) {
+                grid_->idx2coord(idx, coords);
+                for (size_t i = 0; i < grid_t::getNDims(); ++i) {
+                    lo[i] = std::min(lo[i], std::max(0, int(coords[i]) - cells));
+                    hi[i] = std::max(hi[i], std::min(int(dimsize[i]), int(coords[i]) + cells + 1));
+                }
+            }
+            return true;
+        }
+
         /** \brief Checks that the solver is ready to run. Sets the grid unclean. */
         virtual void setup
         () {
@@ -122,15 +321,166 @@ class Solver {
             }
             grid_->setClean(false);
             setup_ = true;
+
+            goalsFrozen_ = 0;
+            if (!goals_.empty()) {
+                if (goalMask_.size() < grid_->size())
+                    goalMask_.resize(grid_->size(), false);
+                for (unsigned int g : goals_)
+                    goalMask_[g] = true;
+            }
+
+            initCoords_.clear();
+            if (!std::isinf(maxDistance_)) {
+                maxDistance2_ = maxDistance_ / grid_->getLeafSize();
+                maxDistance2_ *= maxDistance2_;
+                initCoords_.resize(init_points_.size());
+                for (size_t i = 0; i < init_points_.size(); ++i)
+                    grid_->idx2coord(init_points_[i], initCoords_[i]);
+            }
         }
 
-        /** \brief Computes the distances map. Will call setup() if not done already. */
+        /** \brief Computes the distances map. Will call setup() if not done already, timed apart (see
+            getSetupTime()). */
         void compute
         () {
+            setupTime_ = 0;
+            if (!setup_) {
+                const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+                setup();
+                setupTime_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
             start_ = std::chrono::steady_clock::now();
+            iterations_ = 0;
+            checkCount_ = 0;
+            stopped_ = false;
+            cancelled_ = false;
+            budgetExceeded_ = false;
+            frontTime_ = std::numeric_limits<double>::quiet_NaN();
+            counters_.clear();
             computeInternal();
             end_ = std::chrono::steady_clock::now();
-            time_ = std::chrono::duration_cast<std::chrono::milliseconds>(end_-start_).count();
+            time_ = std::chrono::duration<double, std::milli>(end_-start_).count();
+        }
+
+        /** \brief Runs compute() in a new thread. The solver and its grid must not be used until the
+            future returned is ready, except to cancel() it. */
+        std::future<void> computeAsync
+        () {
+            return std::async(std::launch::async, [this] () { compute(); });
+        }
+
+        /** \brief Asks the running solve to stop, cancelling the token of the solver. It can be called
+            from any thread. The token of the solver stays cancelled until reset(). */
+        void cancel
+        () {
+            cancel_.cancel();
+        }
+
+        /** \brief Uses token instead of the token of the solver, so that cancelling it stops this solver
+            (and the rest of solvers using it). Tokens given are not reset by reset(). */
+        void setCancelToken
+        (const CancelToken & token) {
+            cancel_ = token;
+            ownToken_ = false;
+        }
+
+        /** \brief Returns the token checked by the solver. */
+        const CancelToken & getCancelToken
+        () const {
+            return cancel_;
+        }
+
+        /** \brief Returns true if the last run was stopped by a cancellation. Cells not computed keep
+            an infinite arrival time, as beyond the limits. */
+        bool wasCancelled
+        () const {
+            return cancelled_;
+        }
+
+        /** \brief Solves are stopped once they have run for ms milliseconds (checked every
+            getCheckInterval() iterations). Infinity (default) for no budget. */
+        void setTimeBudget
+        (double ms) {
+            timeBudget_ = ms;
+        }
+
+        /** \brief Returns the time budget (ms). */
+        double getTimeBudget
+        () const {
+            return timeBudget_;
+        }
+
+        /** \brief Solves are stopped once they have done n iterations (cells frozen or updated). It is
+            checked every getCheckInterval() iterations, so up to that many more can be done. 0
+            (default) for no budget. */
+        void setIterationBudget
+        (unsigned long n) {
+            iterationBudget_ = n;
+        }
+
+        /** \brief Returns the iteration budget, 0 for none. */
+        unsigned long getIterationBudget
+        () const {
+            return iterationBudget_;
+        }
+
+        /** \brief Returns true if the last run was stopped by the time or iteration budget. */
+        bool wasBudgetExceeded
+        () const {
+            return budgetExceeded_;
+        }
+
+        /** \brief Returns the number of iterations of the last run counted by the checks (see
+            getCheckInterval()). 0 for solvers which do not check. */
+        unsigned long getIterations
+        () const {
+            return iterations_;
+        }
+
+        /** \brief Returns the front time at the last check of the last run: if it was stopped by a
+            marching method, the arrival times of the cells not frozen are not lower (with heuristics,
+            the time of the goal). NaN if there was no check or the solver has no front. */
+        double getFrontTime
+        () const {
+            return frontTime_;
+        }
+
+        /** \brief Returns true if the goal point (or the number of goals required) got a finite arrival
+            time in the last run. It is final unless the run was stopped, and an upper bound otherwise
+            (a path can be extracted anyway). False if no goal was set. */
+        bool isGoalReached
+        () const {
+            if (int(goal_idx_) != -1)
+                return !std::isinf(grid_->getCell(goal_idx_).getArrivalTime());
+            if (goalsToReach_ == 0)
+                return false;
+            unsigned int reached = 0;
+            for (unsigned int g : goals_)
+                if (!std::isinf(grid_->getCell(g).getArrivalTime()))
+                    ++reached;
+            return reached >= goalsToReach_;
+        }
+
+        /** \brief Sets the function called every getCheckInterval() iterations with the number of
+            iterations done and the current front time. It is called from the thread running the
+            solver. An empty function (default) for none. */
+        void setProgressCallback
+        (const ProgressCallback & f) {
+            progress_ = f;
+        }
+
+        /** \brief Sets the number of iterations between checks of the token (and calls to the progress
+            callback). 1024 by default. */
+        void setCheckInterval
+        (unsigned int k) {
+            checkInterval_ = std::max(1u, k);
+        }
+
+        /** \brief Returns the number of iterations between checks of the token. */
+        unsigned int getCheckInterval
+        () const {
+            return checkInterval_;
         }
 
         /** \brief Actual compute function to be implemented in each solver. */
@@ -168,14 +518,20 @@ class Solver {
         () {
             init_points_.clear();
             goal_idx_ = -1;
+            clearGoals();
             setup_ = false;
         }
 
-        /** \brief Clears temporal data, so it is ready to run again. */
+        /** \brief Clears temporal data, so it is ready to run again. Only the cells accessed by the
+            last run are restored (see nDGridMap::clean()). */
         virtual void reset
         () {
             setup_ = false;
+            if (ownToken_)
+                cancel_.reset();
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
             grid_->clean();
+            resetTime_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
 
         /** \brief Returns a pointer to the grid used. */
@@ -184,17 +540,69 @@ class Solver {
             return grid_;
         }
 
+        /** \brief Returns the time (ms, with the resolution of steady_clock) of the last compute(), not
+            including setup(). */
         virtual double getTime
         () const {
             return time_;
         }
 
+        /** \brief Returns the time (ms) the last compute() spent in setup(), 0 if it was already set up. */
+        double getSetupTime
+        () const {
+            return setupTime_;
+        }
+
+        /** \brief Returns the time (ms) of the velocities map of the last run, for solvers which compute
+            one before their wave (see FM2). 0 for the rest. */
+        virtual double getTimeVelocities
+        () const {
+            return 0;
+        }
+
+        /** \brief Returns the time (ms) the last reset() took to clean the grid. */
+        virtual double getResetTime
+        () const {
+            return resetTime_;
+        }
+
         virtual void printRunInfo
         () const {
             console::warning("No run info available.");
         }
 
+        /** \brief Returns the operation counters of the last run (see OpCounters), all 0 unless the
+            library is built with FAST_METHODS_COUNTERS. Solvers running other solvers return theirs. */
+        virtual const OpCounters & getCounters
+        () const {
+            return counters_;
+        }
+
+        /** \brief Returns the number of bytes allocated by the solver, not including the grid. Solvers
+            running other solvers include theirs. */
+        virtual size_t memory
+        () const {
+            return MemoryUsage::of(init_points_) + MemoryUsage::of(initCoords_) + MemoryUsage::of(goals_)
+                    + MemoryUsage::of(goalMask_);
+        }
+
+        /** \brief Returns the bytes of memory() shared with the rest of solvers of the same type (the pools
+            of the nodes of their heaps, see PoolAllocator), to count them once when adding solvers. */
+        virtual size_t sharedMemory
+        () const {
+            return 0;
+        }
+
     protected:
+        /** \brief Prints the memory of the solver and of its grid, as a line of printRunInfo(). */
+        void printMemory
+        () const {
+            std::cout << '\t' << "Memory: " << MemoryUsage::toString(memory());
+            if (grid_)
+                std::cout << " (grid: " << MemoryUsage::toString(grid_->memory()) << ')';
+            std::cout << '\n';
+        }
+
         /** \brief Performs different check before a solver can proceed. */
         int sanityChecks
         () {
@@ -212,9 +620,69 @@ class Solver {
             for (int ip : init_points_)
                 if(int(goal_idx_) == ip) return 6;
 
+            for (unsigned int g : goals_) {
+                if (grid_->getCell(g).isOccupied()) return 5;
+                if (std::find(init_points_.begin(), init_points_.end(), g) != init_points_.end()) return 6;
+            }
+
             return 0;
         }
 
+        /** \brief Called by solvers when cell idx is frozen (once per cell). Returns true if it is
+            the goal point, or if it is one of the goals and the number of goals to be frozen is
+            reached, so that the propagation can finish. */
+        inline bool goalFrozen
+        (unsigned int idx) {
+            if (idx == goal_idx_)
+                return true;
+            if (goalsToReach_ == 0 || !goalMask_[idx])
+                return false;
+            goalMask_[idx] = false;
+            return ++goalsFrozen_ >= goalsToReach_;
+        }
+
+        /** \brief Called by the main loops of the solvers after n iterations (cells frozen or updated),
+            with the current front time (NaN if there is none). Every checkInterval_ iterations it
+            calls the progress callback and checks the token. Returns true if the solver has to
+            stop, also in later calls. */
+        inline bool stopRequested
+        (double frontTime, unsigned int n = 1) {
+            iterations_ += n;
+            checkCount_ += n;
+            if (checkCount_ < checkInterval_)
+                return stopped_;
+            checkCount_ = 0;
+            return checkStop(frontTime);
+        }
+
+        /** \brief Calls the progress callback and checks the token and the budgets. Returns true if the
+            solver has to stop. */
+        bool checkStop
+        (double frontTime) {
+            frontTime_ = frontTime;
+            if (progress_)
+                progress_(iterations_, frontTime);
+            if (cancel_.isCancelled())
+                cancelled_ = true;
+            if (iterationBudget_ > 0 && iterations_ >= iterationBudget_)
+                budgetExceeded_ = true;
+            if (!std::isinf(timeBudget_) &&
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count() >= timeBudget_)
+                budgetExceeded_ = true;
+            stopped_ = cancelled_ || budgetExceeded_;
+            return stopped_;
+        }
+
+        /** \brief Removes the goals and their bits of the bitmap. */
+        void clearGoals
+        () {
+            for (unsigned int g : goals_)
+                if (g < goalMask_.size())
+                    goalMask_[g] = false;
+            goals_.clear();
+            goalsToReach_ = 0;
+        }
+
         /** \brief Grid container. */
         grid_t*                     grid_;
 
@@ -233,8 +701,80 @@ class Solver {
         /** \brief Time measurement variables. */
         std::chrono::time_point<std::chrono::steady_clock> start_, end_;
 
-        /** \brief Time elapsed by the compute method. */
+        /** \brief Time elapsed by the compute method (ms, with fractions). */
         double                      time_;
+
+        /** \brief Time elapsed by setup() in the last compute (ms, with fractions). */
+        double                      setupTime_;
+
+        /** \brief Time elapsed cleaning the grid in the last reset (ms, with fractions). */
+        double                      resetTime_;
+
+        /** \brief Maximum arrival time computed. */
+        double                      maxTime_;
+
+        /** \brief Maximum distance to the initial points of the cells computed. */
+        double                      maxDistance_;
+
+        /** \brief Square of the maximum distance in cells. */
+        double                      maxDistance2_;
+
+        /** \brief Cells which can be computed, nullptr for all (see setCorridor()). */
+        const std::vector<bool> *   corridor_;
+
+        /** \brief Coordinates of the initial points, used for the maximum distance. */
+        std::vector<std::array<unsigned int, grid_t::getNDims()> > initCoords_;
+
+        /** \brief Goals, sorted (see setInitialAndGoalPoints(init_points, goals, k)). */
+        std::vector<unsigned int>   goals_;
+
+        /** \brief Number of goals to be frozen to finish, 0 if there are no goals. */
+        unsigned int                goalsToReach_;
+
+        /** \brief Number of goals frozen in the current run. */
+        unsigned int                goalsFrozen_;
+
+        /** \brief True for the goals not frozen yet in the current run. */
+        std::vector<bool>           goalMask_;
+
+        /** \brief Token checked to stop (see cancel()). */
+        CancelToken                 cancel_;
+
+        /** \brief True if cancel_ is the token of the solver, reset by reset(). */
+        bool                        ownToken_;
+
+        /** \brief Function called every checkInterval_ iterations, if any. */
+        ProgressCallback            progress_;
+
+        /** \brief Iterations between checks of the token. */
+        unsigned int                checkInterval_;
+
+        /** \brief Iterations of the current run. */
+        unsigned long               iterations_;
+
+        /** \brief Iterations since the last check of the token. */
+        unsigned int                checkCount_;
+
+        /** \brief True if the current run has to stop (or the last one was stopped). */
+        bool                        stopped_;
+
+        /** \brief True if the current run was stopped by the token. */
+        bool                        cancelled_;
+
+        /** \brief True if the current run was stopped by a budget. */
+        bool                        budgetExceeded_;
+
+        /** \brief Time budget (ms), infinity for none. */
+        double                      timeBudget_;
+
+        /** \brief Iteration budget, 0 for none. */
+        unsigned long               iterationBudget_;
+
+        /** \brief Front time at the last check. */
+        double                      frontTime_;
+
+        /** \brief Operation counters of the current run. */
+        OpCounters                  counters_;
 };
 
 #endif /* SOLVER_H_*/
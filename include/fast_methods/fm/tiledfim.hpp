@@ -0,0 +1,365 @@
+/*! \class TiledFIM
+    \brief Block Fast Iterative Method on a TiledGrid, for grids larger than memory.
+
+    Tiles are processed one at a time with the tiles around it, acquired from the cache of the
+    grid so that the arrival times of the cells of its faces can be read. A tile is processed
+    by FIM until it converges: its cells which can be improved from the current times start
+    the active list, and neighbors of converged cells within the tile are added to it. When
+    times of cells of a face decrease, the tile across the face is scheduled with the lowest
+    of those times. Tiles are taken from a heap of those times, as FMM does with cells, so
+    that the front moves across the grid and tiles are mostly read when the front arrives and
+    written back when it leaves. The algorithm finishes when no tile is scheduled, with the
+    converged (FIM) solution of the whole grid.
+
+    Memory is that of the cache of the grid (TiledGrid::setCacheSize()), at least a tile and
+    its neighbors, plus arrays of one tile and a few values per tile. Cells with velocity
+    lower than utils::COMP_MARGIN are obstacles.
+
+    It is not a Solver, since TiledGrid is not an nDGridMap, but it has the same interface for
+    the initial points, compute() and the times. Arrival times are kept in the grid.
+
+    The grid is assumed to be squared, that is Delta(x) = Delta(y) = leafsize_
+
+    @par External documentation:
+        W. Jeong and R. Whitaker, A Fast Iterative Method for Eiknal Equations, SIAM J. Sci. Comput., 30(5), 2512–2534. 2008.
+        <a href="http://epubs.siam.org/doi/abs/10.1137/060670298">[PDF]</a>
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILEDFIM_HPP_
+#define TILEDFIM_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <queue>
+#include <limits>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+#include <fast_methods/ndgridmap/tiledgrid.hpp>
+#include <fast_methods/fm/eikonalkernel.hpp>
+#include <fast_methods/console/console.h>
+#include <fast_methods/utils/utils.h>
+
+template <size_t ndims> class TiledFIM {
+
+    public:
+        typedef TiledGrid<ndims> grid_t;
+        typedef typename grid_t::Tile tile_t;
+        typedef typename grid_t::coord_t coord_t;
+
+        /** @param error error threshold value that reveals if a cell has converged, as in FIM. */
+        TiledFIM(double error = 0) : name_("TiledFIM"), grid_(nullptr), E_(error), time_(-1), processed_(0), loads_(0), writes_(0) {}
+
+        TiledFIM(const char * name, double error = 0) : name_(name), grid_(nullptr), E_(error), time_(-1), processed_(0), loads_(0), writes_(0) {}
+
+        /** \brief Sets the tiled grid to solve. */
+        void setEnvironment
+        (grid_t * g) {
+            grid_ = g;
+            const unsigned int ts = grid_->getTileSize();
+            const unsigned int n = grid_->getCellsPerTile();
+            for (size_t d = 0; d < ndims; ++d)
+                stride_[d] = grid_->strideInTile(d);
+
+            // Bits 2*d and 2*d+1 are set for the cells of the lower and upper faces in dimension d.
+            faceMask_.resize(n);
+            for (unsigned int l = 0; l < n; ++l) {
+                unsigned int mask = 0, rem = l;
+                for (size_t d = 0; d < ndims; ++d) {
+                    const unsigned int c = rem % ts;
+                    rem /= ts;
+                    if (c == 0)
+                        mask |= 1u << (2*d);
+                    if (c == ts - 1)
+                        mask |= 1u << (2*d + 1);
+                }
+                faceMask_[l] = mask;
+            }
+            inList_.assign(n, 0);
+        }
+
+        /** \brief Sets the coordinates of the initial points. */
+        void setInitialPoints
+        (const std::vector<coord_t> & init_points) {
+            init_points_ = init_points;
+        }
+
+        /** \brief Computes the arrival times of the whole grid, which are kept in the grid (see
+            TiledGrid::getArrivalTime() and TiledGrid::saveGridValuesBinary()). */
+        void compute
+        () {
+            if (grid_ == nullptr || !grid_->isOpen()) {
+                console::error("TiledFIM: no tiled grid set.");
+                exit(1);
+            }
+            if (init_points_.empty()) {
+                console::error("TiledFIM: no initial points set.");
+                exit(1);
+            }
+            const std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            const uint64_t loads = grid_->getTileLoads(), writes = grid_->getTileWrites();
+            processed_ = 0;
+            grid_->resetTimes();
+            key_.assign(grid_->getNumberOfTiles(), std::numeric_limits<double>::infinity());
+            heap_ = heap_t();
+
+            for (const coord_t & c : init_points_) {
+                unsigned int l;
+                const unsigned int t = grid_->getTile(c, l);
+                tile_t & tile = grid_->acquire(t);
+                tile.times[l] = 0;
+                tile.dirty = true;
+                grid_->release(tile);
+                schedule(t, 0);
+                // The tiles across the faces of the point do not see it through their neighbors.
+                for (unsigned int mask = faceMask_[l]; mask; mask &= mask - 1) {
+                    const unsigned int f = __builtin_ctz(mask);
+                    const unsigned int u = grid_->getNeighborTile(t, f/2, f & 1);
+                    if (u < grid_->getNumberOfTiles())
+                        schedule(u, 0);
+                }
+            }
+
+            while (!heap_.empty()) {
+                const std::pair<double, unsigned int> top = heap_.top();
+                heap_.pop();
+                if (top.first != key_[top.second])
+                    continue;
+                key_[top.second] = std::numeric_limits<double>::infinity();
+                processTile(top.second);
+                ++processed_;
+            }
+            grid_->flush();
+
+            loads_ = grid_->getTileLoads() - loads;
+            writes_ = grid_->getTileWrites() - writes;
+            time_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        /** \brief Returns the time of the last compute(), in ms. */
+        double getTime
+        () const {
+            return time_;
+        }
+
+        /** \brief Returns the number of tiles processed by the last compute(), a tile can be processed
+            several times. */
+        uint64_t getTilesProcessed
+        () const {
+            return processed_;
+        }
+
+        /** \brief Returns the name of the solver. */
+        const std::string & getName
+        () const {
+            return name_;
+        }
+
+        void printRunInfo
+        () const {
+            console::info("Tiled (out-of-core) Fast Iterative Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Tile size: " << grid_->getTileSize() << '\n'
+                      << '\t' << "Tiles: " << grid_->getNumberOfTiles() << '\n'
+                      << '\t' << "Cache: " << grid_->getCacheSize() << " tiles, "
+                      << grid_->getCacheMemory() / (1024.0*1024.0) << " MB\n"
+                      << '\t' << "Tiles processed: " << processed_ << '\n'
+                      << '\t' << "Tiles read: " << loads_ << '\n'
+                      << '\t' << "Tiles written: " << writes_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+        }
+
+    private:
+        typedef std::priority_queue<std::pair<double, unsigned int>, std::vector<std::pair<double, unsigned int> >,
+                                    std::greater<std::pair<double, unsigned int> > > heap_t;
+
+        /** \brief Schedules tile t with key k if it is lower than its current one. */
+        inline void schedule
+        (unsigned int t, double k) {
+            if (k < key_[t]) {
+                key_[t] = k;
+                heap_.push(std::make_pair(k, t));
+            }
+        }
+
+        /** \brief Runs FIM on tile t until it converges and schedules the neighbor tiles whose faces changed. */
+        void processTile
+        (unsigned int t) {
+            tile_t & tile = grid_->acquire(t);
+            for (size_t d = 0; d < ndims; ++d)
+                for (unsigned int up = 0; up < 2; ++up) {
+                    const unsigned int u = grid_->getNeighborTile(t, d, up);
+                    neighTiles_[2*d + up] = u;
+                    neighs_[2*d + up] = (u < grid_->getNumberOfTiles()) ? &grid_->acquire(u) : nullptr;
+                }
+            faceMin_.fill(std::numeric_limits<double>::infinity());
+
+            const unsigned int n = grid_->getCellsPerTile();
+            list_.clear();
+            for (unsigned int l = 0; l < n; ++l)
+                if (updateCell(tile, l)) {
+                    inList_[l] = 1;
+                    list_.push_back(l);
+                }
+
+            while (!list_.empty()) {
+                next_.clear();
+                for (unsigned int x : list_) {
+                    const double p = tile.times[x];
+                    const double q = solveEikonal(tile, x);
+                    if (q < p)
+                        setTime(tile, x, q);
+                    if (p - q > E_) { // Not converged.
+                        next_.push_back(x);
+                        continue;
+                    }
+                    inList_[x] = 0;
+                    const unsigned int mask = faceMask_[x];
+                    for (size_t d = 0; d < ndims; ++d) {
+                        if (!(mask & (1u << (2*d))))
+                            addNeighbor(tile, x - stride_[d]);
+                        if (!(mask & (1u << (2*d + 1))))
+                            addNeighbor(tile, x + stride_[d]);
+                    }
+                }
+                list_.swap(next_);
+            }
+
+            for (unsigned int f = 0; f < 2*ndims; ++f)
+                if (neighs_[f] != nullptr) {
+                    grid_->release(*neighs_[f]);
+                    if (!std::isinf(faceMin_[f]))
+                        schedule(neighTiles_[f], faceMin_[f]);
+                }
+            grid_->release(tile);
+        }
+
+        /** \brief Adds cell l of the tile to the active list if its time improves. */
+        inline void addNeighbor
+        (tile_t & tile, unsigned int l) {
+            if (!inList_[l] && updateCell(tile, l)) {
+                inList_[l] = 1;
+                next_.push_back(l);
+            }
+        }
+
+        /** \brief Updates the time of cell l if it improves, returns true if it did. */
+        inline bool updateCell
+        (tile_t & tile, unsigned int l) {
+            if (tile.velocities[l] < utils::COMP_MARGIN)
+                return false;
+            const double q = solveEikonal(tile, l);
+            if (!(q < tile.times[l]))
+                return false;
+            setTime(tile, l, q);
+            return true;
+        }
+
+        inline void setTime
+        (tile_t & tile, unsigned int l, double q) {
+            tile.times[l] = q;
+            tile.dirty = true;
+            for (unsigned int mask = faceMask_[l]; mask; mask &= mask - 1) {
+                const unsigned int f = __builtin_ctz(mask);
+                if (q < faceMin_[f])
+                    faceMin_[f] = q;
+            }
+        }
+
+        /** \brief Solves the Eikonal equation for cell l of the tile, reading the cells of the faces of
+            the neighbor tiles. */
+        double solveEikonal
+        (const tile_t & tile, unsigned int l) const {
+            const unsigned int ts = grid_->getTileSize();
+            const double Tl = tile.times[l];
+            const unsigned int mask = faceMask_[l];
+            std::array<double, ndims> T;
+            unsigned int a = 0;
+            for (size_t d = 0; d < ndims; ++d) {
+                const unsigned int far = (ts - 1)*stride_[d];
+                double minus = std::numeric_limits<double>::infinity(), plus = minus;
+                if (!(mask & (1u << (2*d))))
+                    minus = tile.times[l - stride_[d]];
+                else if (neighs_[2*d] != nullptr)
+                    minus = neighs_[2*d]->times[l + far];
+                if (!(mask & (1u << (2*d + 1))))
+                    plus = tile.times[l + stride_[d]];
+                else if (neighs_[2*d + 1] != nullptr)
+                    plus = neighs_[2*d + 1]->times[l - far];
+                const double minTInDim = std::min(minus, plus);
+                if (!std::isinf(minTInDim) && minTInDim < Tl) {
+                    T[d] = minTInDim;
+                    ++a;
+                }
+                else
+                    T[d] = std::numeric_limits<double>::infinity();
+            }
+            if (a == 0)
+                return std::numeric_limits<double>::infinity();
+
+            EikonalSort<double, ndims>::sort(T);
+            const double h = grid_->getLeafSize();
+            const double vel = tile.velocities[l];
+            return EikonalKernel<double, ndims>::solve(T, a, h / vel, h*h / (vel*vel));
+        }
+
+        std::string name_;
+
+        grid_t * grid_;
+
+        /** \brief Error threshold value that reveals if a cell has converged. */
+        double E_;
+
+        /** \brief Coordinates of the initial points. */
+        std::vector<coord_t> init_points_;
+
+        /** \brief Time of the last compute(), in ms. */
+        double time_;
+
+        /** \brief Tiles processed, read and written by the last compute(). */
+        uint64_t processed_, loads_, writes_;
+
+        /** \brief Local index offset of the next cell in each dimension within a tile. */
+        std::array<unsigned int, ndims> stride_;
+
+        /** \brief Faces of the tile each cell belongs to, see setEnvironment(). */
+        std::vector<unsigned int> faceMask_;
+
+        /** \brief 1 for the cells of the tile being processed which are in its active list. */
+        std::vector<unsigned char> inList_;
+
+        /** \brief Active lists of the tile being processed. */
+        std::vector<unsigned int> list_, next_;
+
+        /** \brief Neighbor tiles of the tile being processed (nullptr if out of the grid) and their indices. */
+        std::array<tile_t *, 2*ndims> neighs_;
+        std::array<unsigned int, 2*ndims> neighTiles_;
+
+        /** \brief Lowest time written in each face of the tile being processed. */
+        std::array<double, 2*ndims> faceMin_;
+
+        /** \brief Lowest time of the faces next to each scheduled tile, infinity if it is not scheduled. */
+        std::vector<double> key_;
+
+        /** \brief Scheduled tiles by key_. Entries whose key is not the current one are skipped. */
+        heap_t heap_;
+};
+
+#endif /* TILEDFIM_HPP_*/
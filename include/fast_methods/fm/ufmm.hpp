@@ -6,6 +6,11 @@
 
     The grid is assumed to be squared, that is Delta(x) = Delta(y) = leafsize_
 
+    The narrow band is an FMUntidyQueue of s buckets and maximum increment inc. If inc is
+    0 or lower, it is computed in setup() from the speeds of the grid as the largest time
+    to cross a cell, leafsize_ / min speed, so arrival times in the narrow band do not
+    exceed the queue.
+
     @par External documentation:
         L. Yatziv, A.Bartesaghi and G. Sapiro, O(n) implementation of the fast marching algorithm, Journal of Computational Physics. 212(2): 393-399. 2006.
         <a href="http://www.sciencedirect.com/science/article/pii/S0021999105003736">[PDF]</a>
@@ -34,7 +39,7 @@
 #include <fast_methods/fm/eikonalsolver.hpp>
 #include <fast_methods/datastructures/fmuntidyqueue.hpp>
 
-template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver<grid_t> {
+template <class grid_t, class cell_t = typename grid_t::cell_t> class UFMM : public EikonalSolver<grid_t> {
 
     public:
         UFMM
@@ -48,6 +53,17 @@ template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver
 
         virtual ~UFMM() { clear(); }
 
+        virtual void setup
+        () {
+            EikonalSolver<grid_t>::setup();
+            if (heap_inc_ <= 0) {
+                // One more bucket, since arrival times are compared to the start of the first bucket.
+                const double minSpeed = grid_->getMinSpeed();
+                const double inc = (minSpeed > 0) ? leafsize_ / minSpeed : 1;
+                narrow_band_->setMaxIncrement(inc * (heap_s_ + 1) / heap_s_);
+            }
+        }
+
         /** \brief Actual method that implements UFMM. */
         virtual void computeInternal
         () {
@@ -61,7 +77,8 @@ template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver
             // Algorithm initialization
             for (unsigned int &i : init_points_) { // For each initial point
                 grid_->getCell(i).setArrivalTime(0);
-                narrow_band_->push( &(grid_->getCell(i)) );
+                narrow_band_->push( grid_->getCellPtr(i) );
+                FAST_METHODS_COUNT(HEAP_PUSHES);
             }
 
             // Main loop.
@@ -71,27 +88,34 @@ template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver
                                                  // of the untidy queue implementation.
                 grid_->getCell(idxMin).setState(FMState::FROZEN);
                 n_neighs = grid_->getNeighbors(idxMin, neighbors_);
+                FAST_METHODS_COUNT(NEIGHBOR_QUERIES);
                 for (unsigned int s = 0; s < n_neighs; ++s) { // For each neighbor.
                     j = neighbors_[s];
                     if ( (grid_->getCell(j).getState() == FMState::FROZEN) || grid_->getCell(j).isOccupied())
                         continue;
                     else {
                         double new_arrival_time = solveEikonal(j);
+                        if (!isWithinLimits(j, new_arrival_time))
+                            continue;
                         if (grid_->getCell(j).getState() == FMState::NARROW) { // Updating narrow band if necessary.
                             if (utils::isTimeBetterThan(new_arrival_time, grid_->getCell(j).getArrivalTime()) ) {
                                 grid_->getCell(j).setArrivalTime(new_arrival_time);
-                                narrow_band_->increase( &(grid_->getCell(j)) );
+                                narrow_band_->increase( grid_->getCellPtr(j) );
+                                FAST_METHODS_COUNT(HEAP_INCREASES);
                             }
                         }
                         else {
                             grid_->getCell(j).setState(FMState::NARROW);
                             grid_->getCell(j).setArrivalTime(new_arrival_time);
-                            narrow_band_->push( &(grid_->getCell(j)) );
+                            narrow_band_->push( grid_->getCellPtr(j) );
+                            FAST_METHODS_COUNT(HEAP_PUSHES);
                         } // neighbors open.
                     } // neighbors not frozen.
                 } // For each neighbor.
+                FAST_METHODS_COUNT_MAX(PEAK_NARROW_BAND, narrow_band_->size());
                 narrow_band_->pop();
-                if (idxMin == goal_idx_)
+                FAST_METHODS_COUNT(HEAP_POPS);
+                if (goalFrozen(idxMin) || stopRequested(grid_->getCell(idxMin).getArrivalTime()))
                     stopWavePropagation = true;
             } // while narrow band is not empty
         }
@@ -101,8 +125,21 @@ template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver
             console::info("Untidy Fast Marching Method");
             std::cout << '\t' << name_ << '\n'
                       << '\t' << "Number of buckets: " << heap_s_ << '\n'
-                      << '\t' << "Maximum increment " << heap_inc_ << '\n'
-                      << '\t' << "Elapsed time: " << time_ << " ms\n";
+                      << '\t' << "Maximum increment: ";
+            if (heap_inc_ > 0)
+                std::cout << heap_inc_ << '\n';
+            else
+                std::cout << "auto" << '\n';
+            std::cout << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the untidy queue. */
+        virtual size_t memory
+        () const {
+            return EikonalSolver<grid_t>::memory() + (narrow_band_ ? sizeof(*narrow_band_) + narrow_band_->memory() : 0);
         }
 
         virtual void clear
@@ -121,17 +158,23 @@ template <class grid_t, class cell_t = FMCell> class UFMM : public EikonalSolver
         using EikonalSolver<grid_t>::solveEikonal;
         using EikonalSolver<grid_t>::init_points_;
         using EikonalSolver<grid_t>::goal_idx_;
+        using EikonalSolver<grid_t>::goalFrozen;
+        using EikonalSolver<grid_t>::stopRequested;
+        using EikonalSolver<grid_t>::counters_;
         using EikonalSolver<grid_t>::setup;
         using EikonalSolver<grid_t>::setup_;
+        using EikonalSolver<grid_t>::leafsize_;
         using EikonalSolver<grid_t>::neighbors_;
+        using EikonalSolver<grid_t>::isWithinLimits;
         using EikonalSolver<grid_t>::name_;
         using EikonalSolver<grid_t>::time_;
+        using EikonalSolver<grid_t>::resetTime_;
 
     private:
         /** \brief Number of buckets in the heap. */
         unsigned                heap_s_;
 
-        /** \brief Size (maximum increment) of the heap. */
+        /** \brief Size (maximum increment) of the heap, 0 or lower to compute it from the speeds. */
         double                  heap_inc_;
 
         /** \brief Heap Instance of the priority queue used. */
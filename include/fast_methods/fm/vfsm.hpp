@@ -0,0 +1,477 @@
+/*! \class VFSM
+    \brief Implements a vectorized version of the Fast Sweeping Method.
+
+    It uses as a main container the nDGridMap class. The nDGridMap type T
+    has to use an FMCell or derived.
+
+    Within a sweep, FSM updates a cell after its preceding neighbors in every dimension,
+    so the cells of a row along dimension 0 can not be updated at once. VFSM updates a strip
+    of consecutive rows along dimension 1 as a wavefront: at step t, lane k of the strip updates
+    cell t-k of its row. The preceding neighbors of a cell are then updated in previous
+    steps and the following ones in later steps, exactly as in FSM, so the results after
+    every sweep are the same as FSM ones.
+
+    Arrival times and velocities of a strip are copied into an internal structure of
+    arrays in which the cells of a step are contiguous. The Eikonal update of all the lanes
+    of a step is done as in EikonalKernel::solve() but without data-dependent branches,
+    so the compiler vectorizes it (SSE/AVX/NEON depending on the target flags, for instance
+    -march=native). Results are bit by bit equal to FSM ones as long as the compiler does not
+    reassociate or contract floating point operations (-fassociative-math, enabled by
+    -ffast-math, and fused multiply-adds with -march=native) differently in both solvers.
+    Otherwise, differences are in the order of the rounding error.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VFSM_HPP_
+#define VFSM_HPP_
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+
+#include <fast_methods/fm/fsm.hpp>
+#include <fast_methods/fm/eikonalkernel.hpp>
+#include <fast_methods/utils/utils.h>
+
+template < class grid_t > class VFSM : public FSM<grid_t> {
+
+    static_assert(grid_t::getNDims() > 1, "VFSM requires at least 2 dimensions.");
+
+    /** \brief Shorthand for the number of dimensions. */
+    static constexpr size_t ndims_ = grid_t::getNDims();
+
+    /** \brief Maximum number of rows updated at once. */
+    static constexpr std::ptrdiff_t maxLanes_ = 32;
+
+    public:
+        typedef typename FSM<grid_t>::value_t value_t;
+
+        VFSM(unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : FSM<grid_t>("VFSM", maxSweeps) {}
+
+        VFSM(const char * name, unsigned maxSweeps = std::numeric_limits<unsigned>::max()) : FSM<grid_t>(name, maxSweeps) {}
+
+        /** \brief Executes FSM setup and allocates the strip arrays. */
+        virtual void setup
+        () {
+            FSM<grid_t>::setup();
+            lanes_ = maxLanes_;
+            laneStride_ = lanes_ + 2;
+            nSteps_ = dimsize_[0] + lanes_ - 1;
+
+            // A padding step at each side. Lanes -1 and lanes_ hold the neighbor rows of the strip.
+            // Positions not corresponding to a cell are never modified.
+            const size_t n = (nSteps_ + 2) * laneStride_;
+            times_.assign(n, std::numeric_limits<value_t>::infinity());
+            vels_.assign(n, 0);
+            mins_.assign((ndims_ - 2) * n, std::numeric_limits<value_t>::infinity());
+        }
+
+        /** \brief Actual method that implements VFSM. */
+        virtual void computeInternal
+        () {
+            if (!setup_)
+                setup();
+
+            // Strips span whole rows: bounded propagations are swept by FSM in the box of the limits.
+            if (this->hasLimits()) {
+                FSM<grid_t>::computeInternal();
+                return;
+            }
+
+            // Initialization
+            for (unsigned int i: init_points_) // For each initial point
+                grid_->getCell(i).setArrivalTime(0);
+
+            keepSweeping_ = true;
+            stopPropagation_ = false;
+
+            while (keepSweeping_ && !stopPropagation_ && !stopped_ && sweeps_ < maxSweeps_) {
+                keepSweeping_ = false;
+                setSweep();
+                ++sweeps_;
+                FAST_METHODS_COUNT(SWEEPS);
+                sweep();
+            }
+        }
+
+        virtual void clear
+        () {
+            FSM<grid_t>::clear();
+            times_.clear();
+            vels_.clear();
+            mins_.clear();
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Vectorized Fast Sweeping Method");
+            std::cout << '\t' << name_ << '\n'
+                      << '\t' << "Maximum sweeps: " << maxSweeps_ << '\n'
+                      << '\t' << "Sweeps performed: " << sweeps_ << '\n'
+                      << '\t' << "Lanes: " << lanes_ << '\n'
+                      << '\t' << "Elapsed time: " << time_ << " ms\n"
+                      << '\t' << "Reset time: " << resetTime_ << " ms\n";
+            this->printMemory();
+            counters_.print();
+        }
+
+        /** \brief Returns the bytes allocated by the times, velocities and minima of the slabs. */
+        virtual size_t memory
+        () const {
+            return FSM<grid_t>::memory() + MemoryUsage::of(times_) + MemoryUsage::of(vels_) + MemoryUsage::of(mins_);
+        }
+
+    protected:
+        /** \brief Performs a complete sweep in the current sweep directions, in the same order as
+            FSM::recursiveIteration(): dimensions 2..ndims-1 as nested loops and, within them,
+            strips of lanes_ rows of dimension 1. */
+        void sweep
+        () {
+            // Coordinates of the goal along the sweep directions.
+            std::array<int, ndims_> goal;
+            goal.fill(-1);
+            if (int(goal_idx_) != -1) {
+                std::array<unsigned int, ndims_> coords;
+                grid_->idx2coord(goal_idx_, coords);
+                for (size_t i = 0; i < ndims_; ++i)
+                    goal[i] = sweepCoord(coords[i], i);
+            }
+
+            std::array<int, ndims_> c; // Coordinates of dimensions 2..ndims-1 along the sweep directions.
+            c.fill(0);
+            bool slabsLeft = true;
+            while (slabsLeft && !stopped_) {
+                int base = 0;
+                bool goalInSlab = true;
+                for (size_t i = 2; i < ndims_; ++i) {
+                    slabCoords_[i] = sweepCoord(c[i], i);
+                    base += grid_->getCoordOffset(i, slabCoords_[i]);
+                    goalInSlab = goalInSlab && (c[i] == goal[i]);
+                }
+
+                for (int r = 0; r < dimsize_[1] && !stopped_; r += lanes_) {
+                    const bool goalInStrip = goalInSlab && goal[1] >= r && goal[1] < r + lanes_;
+                    solveStrip(base, r, goalInStrip ? goal[0] + goal[1] - r : -1, goal[1] - r);
+                    stopRequested(std::numeric_limits<double>::quiet_NaN(), dimsize_[0]*std::min<int>(lanes_, dimsize_[1] - r));
+                }
+
+                // Next slab.
+                slabsLeft = false;
+                for (size_t i = 2; i < ndims_; ++i) {
+                    if (++c[i] < dimsize_[i]) {
+                        slabsLeft = true;
+                        break;
+                    }
+                    c[i] = 0;
+                }
+            }
+        }
+
+        /** \brief Updates the strip of rows r..r+lanes_-1 (along the sweep direction of dimension 1)
+            of the slab whose first cell has index base. If the goal is in the strip, it is
+            updated at step goalStep by lane goalLane. */
+        void solveStrip
+        (int base, int r, std::ptrdiff_t goalStep, std::ptrdiff_t goalLane) {
+            loadStrip(base, r);
+
+            for (std::ptrdiff_t t = 0; t < nSteps_; ++t) {
+                if (t != goalStep) {
+                    solveStep(t);
+                    continue;
+                }
+
+                // EXPERIMENTAL - Value not updated, it has converged
+                const std::ptrdiff_t g = stripIndex(t, goalLane);
+                const value_t prevTime = times_[g];
+                solveStep(t);
+                if (!(vels_[g] < utils::COMP_MARGIN)) {
+                    const double newTime = solveCell(t, goalLane, prevTime);
+                    if (!utils::isTimeBetterThan(newTime, prevTime) && !isnan(newTime) && !isinf(newTime))
+                        stopPropagation_ = true;
+                }
+            }
+
+            storeStrip(base, r);
+        }
+
+        /** \brief Equivalent to FSM::solveForIdx() for all the lanes of step t. Each part of
+            EikonalKernel::solve() is done for all the lanes in a separate loop: the solutions
+            for 1 to ndims dimensions are all computed and, at the end, the one at which
+            EikonalKernel::solve() would have stopped is selected. These loops have no
+            data-dependent branches, so they are vectorized by the compiler. */
+        void solveStep
+        (std::ptrdiff_t t) {
+            const std::ptrdiff_t n = maxLanes_;
+            FAST_METHODS_COUNT_N(EIKONAL_SOLVES, n);
+            const std::ptrdiff_t s = stripIndex(t, 0);
+            value_t * tc = times_.data() + s;
+            const value_t * tm = tc - laneStride_; // Previous step.
+            const value_t * tp = tc + laneStride_; // Next step.
+            const value_t * vel = vels_.data() + s;
+
+            // Counters and flags are stored as value_t, so that all the arrays have the same vector width.
+            value_t prevTime[maxLanes_];
+            value_t T[ndims_][maxLanes_];
+            value_t a[maxLanes_];
+
+            // Minimum neighbor times of each dimension (along dimension 0 they are in the same lane
+            // and along dimension 1 in the adjacent lanes), discarding those which do not improve
+            // the cell. Infinity never does.
+            for (std::ptrdiff_t k = 0; k < n; ++k) {
+                prevTime[k] = tc[k];
+                const value_t min0 = (tm[k] < tp[k]) ? tm[k] : tp[k];
+                const value_t min1 = (tm[k-1] < tp[k+1]) ? tm[k-1] : tp[k+1];
+                const bool valid0 = min0 < prevTime[k];
+                const bool valid1 = min1 < prevTime[k];
+                T[0][k] = valid0 ? min0 : std::numeric_limits<value_t>::infinity();
+                T[1][k] = valid1 ? min1 : std::numeric_limits<value_t>::infinity();
+                a[k] = (valid0 ? value_t(1) : value_t(0)) + (valid1 ? value_t(1) : value_t(0));
+            }
+            for (size_t i = 2; i < ndims_; ++i) {
+                const value_t * m = mins_.data() + (i - 2) * times_.size() + s;
+                for (std::ptrdiff_t k = 0; k < n; ++k) {
+                    const bool valid = m[k] < prevTime[k];
+                    T[i][k] = valid ? m[k] : std::numeric_limits<value_t>::infinity();
+                    a[k] += valid ? value_t(1) : value_t(0);
+                }
+            }
+
+            for (std::ptrdiff_t k = 0; k < n; ++k) {
+                std::array<value_t, ndims_> Tk;
+                for (size_t i = 0; i < ndims_; ++i)
+                    Tk[i] = T[i][k];
+                EikonalSort<value_t, ndims_>::sort(Tk);
+                for (size_t i = 0; i < ndims_; ++i)
+                    T[i][k] = Tk[i];
+            }
+
+            // updatedT[i] is the solution using i+1 dimensions and stop[i] is 1 if EikonalKernel::solve()
+            // would return it (provided that it did not stop before).
+            const double leafsize = leafsize_;
+            const double leafsize2 = leafsize2_;
+            value_t updatedT[ndims_][maxLanes_];
+            value_t stop[ndims_][maxLanes_];
+            value_t sumT[maxLanes_];
+            value_t sumTT[maxLanes_];
+            double h2v2[maxLanes_];
+
+            // Solve for 1 dimension.
+            for (std::ptrdiff_t k = 0; k < n; ++k) {
+                updatedT[0][k] = T[0][k] + leafsize / vel[k];
+                stop[0][k] = ((a[k] <= 1) | ((updatedT[0][k] - T[1][k]) < utils::COMP_MARGIN)) ? 1 : 0;
+                h2v2[k] = leafsize2 / (vel[k]*vel[k]);
+                sumT[k] = 0;
+                sumTT[k] = 0;
+            }
+
+            // Solve for any number > 1 of dimensions.
+            for (unsigned int i = 2; i <= ndims_; ++i) {
+                value_t * Ti = updatedT[i-1];
+                const value_t * Tnext = T[(i < ndims_) ? i : 0];
+                const bool last = (i == ndims_);
+                const value_t qa = i;
+                for (std::ptrdiff_t k = 0; k < n; ++k) {
+                    const value_t T0 = T[0][k];
+                    const value_t dT = T[i-1][k] - T0;
+                    sumT[k] += dT;
+                    sumTT[k] += dT*dT;
+
+                    const value_t qb = -2*sumT[k];
+                    const value_t qc = sumTT[k] - h2v2[k];
+                    const value_t quad_term = qb*qb - 4*qa*qc;
+                    // sqrt() is NaN if quad_term < 0, replaced by infinity.
+                    const value_t root = T0 + (-qb + std::sqrt(quad_term))/(2*qa);
+                    Ti[k] = (quad_term < 0) ? std::numeric_limits<value_t>::infinity() : root;
+                    stop[i-1][k] = ((i == a[k]) | (!last & ((Ti[k] - Tnext[k]) < utils::COMP_MARGIN))) ? 1 : 0;
+                }
+            }
+
+            // Selecting backwards the first solution with stop[i] == 1. The result of each
+            // iteration is written in another array: it avoids conditional stores.
+            value_t selected[2][maxLanes_];
+            const value_t * newTime = updatedT[ndims_-1];
+            for (size_t i = ndims_-1; i > 0; --i) {
+                value_t * sel = selected[i % 2];
+                for (std::ptrdiff_t k = 0; k < n; ++k) {
+                    const value_t solution = updatedT[i-1][k];
+                    const value_t previous = newTime[k];
+                    sel[k] = (stop[i-1][k] != 0) ? solution : previous;
+                }
+                newTime = sel;
+            }
+
+            // If a == 0, T[0] is infinity and so is the selected solution.
+            for (std::ptrdiff_t k = 0; k < n; ++k) {
+                const bool better = !(vel[k] < utils::COMP_MARGIN) & utils::isTimeBetterThan(newTime[k], prevTime[k]);
+                tc[k] = better ? newTime[k] : prevTime[k];
+            }
+
+            // Counted apart, so that the loop above has a single select on better.
+            value_t changed = 0;
+            for (std::ptrdiff_t k = 0; k < n; ++k)
+                changed += (tc[k] != prevTime[k]) ? value_t(1) : value_t(0);
+            keepSweeping_ |= (changed > 0);
+        }
+
+        /** \brief Scalar version of solveStep() for lane k, returns the solution of the Eikonal
+            equation for the cell given its time before step t. */
+        double solveCell
+        (std::ptrdiff_t t, std::ptrdiff_t k, value_t prevTime) const {
+            FAST_METHODS_COUNT(EIKONAL_SOLVES);
+            const std::ptrdiff_t s = stripIndex(t, k);
+            std::array<value_t, ndims_> T;
+            T[0] = std::min(times_[s - laneStride_], times_[s + laneStride_]);
+            T[1] = std::min(times_[s - laneStride_ - 1], times_[s + laneStride_ + 1]);
+            for (size_t i = 2; i < ndims_; ++i)
+                T[i] = mins_[(i - 2) * times_.size() + s];
+
+            unsigned int a = 0;
+            for (size_t i = 0; i < ndims_; ++i) {
+                if (T[i] < prevTime)
+                    ++a;
+                else
+                    T[i] = std::numeric_limits<value_t>::infinity();
+            }
+            if (a == 0)
+                return std::numeric_limits<value_t>::infinity();
+
+            EikonalSort<value_t, ndims_>::sort(T);
+            const value_t vel = vels_[s];
+            return EikonalKernel<value_t, ndims_>::solve(T, a, leafsize_ / vel, leafsize2_ / (vel*vel));
+        }
+
+        /** \brief Copies the strip of rows r..r+lanes_-1 of the slab starting at base, and its
+            neighbor rows, from the grid to the strip arrays. Rows out of the grid are copied as
+            infinity with velocity 0. */
+        void loadStrip
+        (int base, int r) {
+            const value_t inf = std::numeric_limits<value_t>::infinity();
+            for (std::ptrdiff_t k = -1; k <= lanes_; ++k) {
+                const int row = r + k;
+                const bool halo = k < 0 || k == lanes_;
+                std::ptrdiff_t s = stripIndex(k, k); // First cell of lane k along the sweep direction.
+
+                if (row < 0 || row >= dimsize_[1]) {
+                    for (int i = 0; i < dimsize_[0]; ++i, s += laneStride_) {
+                        times_[s] = inf;
+                        if (halo)
+                            continue;
+                        vels_[s] = 0;
+                        for (size_t j = 2; j < ndims_; ++j)
+                            mins_[(j - 2) * times_.size() + s] = inf;
+                    }
+                    continue;
+                }
+
+                // Index offsets to the neighbors in dimensions > 1, the same for all the cells of the row.
+                std::array<int, ndims_> prev, next;
+                for (size_t j = 2; j < ndims_; ++j) {
+                    const int offset = grid_->getCoordOffset(j, slabCoords_[j]);
+                    prev[j] = (slabCoords_[j] > 0) ? int(grid_->getCoordOffset(j, slabCoords_[j] - 1)) - offset : 0;
+                    next[j] = (slabCoords_[j] < dimsize_[j] - 1) ? int(grid_->getCoordOffset(j, slabCoords_[j] + 1)) - offset : 0;
+                }
+
+                const int rowBase = base + grid_->getCoordOffset(1, sweepCoord(row, 1));
+                for (int i = 0; i < dimsize_[0]; ++i, s += laneStride_) {
+                    const int idx = rowBase + grid_->getCoordOffset(0, sweepCoord(i, 0));
+                    times_[s] = grid_->getCell(idx).getArrivalTime();
+                    if (halo)
+                        continue;
+                    vels_[s] = grid_->getCell(idx).getVelocity();
+
+                    // Neighbors in dimensions > 1 are not modified while the strip is updated.
+                    for (size_t j = 2; j < ndims_; ++j) {
+                        const value_t t1 = (slabCoords_[j] > 0) ? value_t(grid_->getCell(idx + prev[j]).getArrivalTime()) : inf;
+                        const value_t t2 = (slabCoords_[j] < dimsize_[j] - 1) ? value_t(grid_->getCell(idx + next[j]).getArrivalTime()) : inf;
+                        mins_[(j - 2) * times_.size() + s] = std::min(t1, t2);
+                    }
+                }
+            }
+        }
+
+        /** \brief Copies the arrival times of the strip of rows r..r+lanes_-1 of the slab starting
+            at base from the strip arrays to the grid. */
+        void storeStrip
+        (int base, int r) {
+            for (std::ptrdiff_t k = 0; k < lanes_ && r + k < dimsize_[1]; ++k) {
+                const int rowBase = base + grid_->getCoordOffset(1, sweepCoord(r + k, 1));
+                std::ptrdiff_t s = stripIndex(k, k);
+                for (int i = 0; i < dimsize_[0]; ++i, s += laneStride_)
+                    grid_->getCell(rowBase + grid_->getCoordOffset(0, sweepCoord(i, 0))).setArrivalTime(times_[s]);
+            }
+        }
+
+        /** \brief Index in the strip arrays of lane k (-1..lanes_) at step t (-1..nSteps_). */
+        inline std::ptrdiff_t stripIndex
+        (std::ptrdiff_t t, std::ptrdiff_t k) const {
+            return (t + 1) * laneStride_ + k + 1;
+        }
+
+        /** \brief Coordinate along the current sweep direction of dimension dim, and vice versa. */
+        inline int sweepCoord
+        (int coord, size_t dim) const {
+            return (incs_[dim] == 1) ? coord : dimsize_[dim] - 1 - coord;
+        }
+
+        using FSM<grid_t>::grid_;
+        using FSM<grid_t>::init_points_;
+        using FSM<grid_t>::goal_idx_;
+        using FSM<grid_t>::setup_;
+        using FSM<grid_t>::name_;
+        using FSM<grid_t>::time_;
+        using FSM<grid_t>::resetTime_;
+        using FSM<grid_t>::leafsize_;
+        using FSM<grid_t>::leafsize2_;
+        using FSM<grid_t>::setSweep;
+        using FSM<grid_t>::sweeps_;
+        using FSM<grid_t>::maxSweeps_;
+        using FSM<grid_t>::keepSweeping_;
+        using FSM<grid_t>::stopPropagation_;
+        using FSM<grid_t>::stopped_;
+        using FSM<grid_t>::stopRequested;
+        using FSM<grid_t>::counters_;
+        using FSM<grid_t>::incs_;
+        using FSM<grid_t>::inits_;
+        using FSM<grid_t>::dimsize_;
+
+        /** \brief Arrival times of the strip: step by step, laneStride_ values per step. */
+        std::vector<value_t>                times_;
+
+        /** \brief Velocities of the strip. */
+        std::vector<value_t>                vels_;
+
+        /** \brief Minimum arrival time of the neighbors in dimensions 2..ndims-1 of the strip cells. */
+        std::vector<value_t>                mins_;
+
+        /** \brief Coordinates of dimensions 2..ndims-1 of the slab being updated. */
+        std::array<int, ndims_>             slabCoords_;
+
+        /** \brief Number of rows updated at once. */
+        std::ptrdiff_t                      lanes_;
+
+        /** \brief Number of values stored per step (lanes_ plus the 2 neighbor rows). */
+        std::ptrdiff_t                      laneStride_;
+
+        /** \brief Number of steps needed to update a strip. */
+        std::ptrdiff_t                      nSteps_;
+};
+
+template < class grid_t > constexpr size_t VFSM<grid_t>::ndims_;
+template < class grid_t > constexpr std::ptrdiff_t VFSM<grid_t>::maxLanes_;
+
+#endif /* VFSM_HPP_*/
@@ -5,14 +5,29 @@
     has to be an FMCell or something inherited from it. It also uses a heap type in order
     to specify the underlying FMM.
 
-    IMPORTANT NOTE: When running FM2 many times on the same grid it is recommended
-    to completely restart the grid (erase and create or resize). See test_fm2.cpp.
+    The velocities map (first wave) is cached: later queries on the same grid restore it
+    instead of computing it again, as long as the obstacles (nDGridMap::getOccupiedCells()),
+    the saturation distance and the leaf size do not change. If the velocities of the grid
+    are modified in any other way, call invalidateVelocitiesMap() before modifying them,
+    which also restores the velocities the map was computed from. setEnvironment() discards
+    the cached map without restoring them.
+
+    The first wave is FMM from all the obstacles by default. setFirstWave(WAVE_EDT) computes
+    the exact Euclidean distance to the obstacles instead, with the separable distance
+    transform of Felzenszwalb and Huttenlocher: one pass per dimension over all the rows of the
+    grid along it, split among threads, in linear time. Distances are those of a grid with
+    velocity 1 out of the obstacles, as the first wave of binary maps. They are exact, so they
+    are lower than those of FMM, mostly next to the obstacles and in diagonal directions.
 
     @par External documentation:
         FM2:
           A. Valero, J.V. Gómez, S. Garrido and L. Moreno,
           The Path to Efficiency: Fast Marching Method for Safer, More Efficient Mobile Robot Trajectories,
           IEEE Robotics and Automation Magazine, Vol. 20, No. 4, 2013.
+        Distance transform:
+          P.F. Felzenszwalb and D.P. Huttenlocher,
+          Distance Transforms of Sampled Functions,
+          Theory of Computing, Vol. 8, 2012.
 
     Copyright (C) 2014 Javier V. Gomez and Jose Pardeiro
     www.javiervgomez.com
@@ -39,14 +54,22 @@
 #include <fstream>
 #include <array>
 #include <limits>
+#include <iterator>
+#include <functional>
+#include <memory>
 
 #include <fast_methods/fm/fmm.hpp>
 #include <fast_methods/gradientdescent/gradientdescent.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+
+/** \brief Computation of the first wave (velocities map) of FM2-based solvers: FMM from the obstacles
+    (WAVE_FMM) or the exact Euclidean distance transform of the obstacles (WAVE_EDT). */
+enum FM2Wave {WAVE_FMM = 0, WAVE_EDT};
 
 /// \todo Include support to other solvers (GMM, FIM, UFMM). It requires a better way of setting parameters.
 //template < class grid_t, class solver_t = FMM<grid_t> > class FM2 : public Solver<grid_t> {
 
-template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public Solver<grid_t> {
+template < class grid_t, class heap_t = FMDaryHeap<typename grid_t::cell_t> > class FM2 : public Solver<grid_t> {
     public:
     
         /** \brief Path type encapsulation. */
@@ -54,13 +77,17 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
 
         /** \brief maxDistance sets the velocities map saturation distance in real units (before normalization). */
         FM2
-        (double maxDistance = -1) : Solver<grid_t>("FM2"), maxDistance_(maxDistance) {
+        (double maxDistance = -1) : Solver<grid_t>("FM2"), maxDistance_(maxDistance), time_vels_(0),
+            binary_occupancies_(false), vels_cached_(false), vels_in_grid_(false), cache_hits_(0), cache_misses_(0), map_updates_(0),
+            wave_(WAVE_FMM), nthreads_(0) {
             solver_ = new FMM<grid_t, heap_t> ();
         }
 
         /** \brief maxDistance sets the velocities map saturation distance in real units (before normalization). */
         FM2
-        (const char * name, double maxDistance = -1) : Solver<grid_t>(name), maxDistance_(maxDistance) {
+        (const char * name, double maxDistance = -1) : Solver<grid_t>(name), maxDistance_(maxDistance), time_vels_(0),
+            binary_occupancies_(false), vels_cached_(false), vels_in_grid_(false), cache_hits_(0), cache_misses_(0), map_updates_(0),
+            wave_(WAVE_FMM), nthreads_(0) {
             solver_ = new FMM<grid_t, heap_t> ();
         }
 
@@ -69,8 +96,9 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
         /** \brief Sets the environment to run the solver and sets the sources for the velocities map computation. */
         virtual void setEnvironment
         (grid_t * g) {
+            dropVelocitiesMap();
             Solver<grid_t>::setEnvironment(g);
-            grid_->getOccupiedCells(fm2_sources_);
+            fm2_sources_ = grid_->getOccupancyBitmap();
             solver_->setEnvironment(grid_);
         }
 
@@ -84,13 +112,14 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
                 exit(1);
             }
 
-            if (fm2_sources_.empty()) {
+            if (!fm2_sources_ || fm2_sources_->none()) {
                 console::error("Map has no obstacles. FM2-based solver is not running.");
                 exit(1);
             }
         }
 
-        /** \brief Implements the actual FM2 method. */
+        /** \brief Implements the actual FM2 method. The limits of the propagation (see Solver), and the
+            corridor, only apply to the second wave, the velocities map is computed for the whole grid. */
         virtual void computeInternal
         () {
             if (!setup_)
@@ -102,51 +131,246 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
             start_ = std::chrono::steady_clock::now();
 
             // According to the theoretical basis the wave is expanded from the goal point to the initial point.
-            std::vector <unsigned int> wave_init;
-            wave_init.push_back(goal_idx_);
+            wave_init_.assign(1, goal_idx_);
             unsigned int wave_goal = init_points_[0];
 
-            solver_->setInitialAndGoalPoints(wave_init, wave_goal);
+            solver_->setInitialAndGoalPoints(wave_init_, wave_goal);
+            solver_->setMaxArrivalTime(this->getMaxArrivalTime());
+            solver_->setMaxDistance(this->getMaxDistance());
+            solver_->setCorridor(this->getCorridor());
             solver_->compute();
             // Restore the actual grid status.
             grid_->setClean(false);
         }
 
+        /** \brief Sets how the first wave is computed (see FM2Wave). nthreads are the threads of the
+            distance transform, 0 for as many as hardware threads. The cached map of the other wave is
+            discarded. */
+        void setFirstWave
+        (FM2Wave wave, unsigned int nthreads = 0) {
+            if (wave != wave_)
+                invalidateVelocitiesMap();
+            wave_ = wave;
+            nthreads_ = nthreads;
+        }
+
+        /** \brief Returns how the first wave is computed. */
+        FM2Wave getFirstWave
+        () const {
+            return wave_;
+        }
+
         /** \brief Computes the velocities map of the FM2 algorithm. If  maxDistance_ != -1 then the map is saturated
-            to the set value. It is then normalized: velocities in [0,1]. */
+            to the set value. It is then normalized: velocities in [0,1]. If the map of the current obstacles
+            is cached it is restored instead. */
         void computeVelocitiesMap
         () {
-            // Forces not to clean the grid.
-            grid_->setClean(true);
-            solver_->setInitialPoints(fm2_sources_);
-            solver_->compute();
-            time_vels_ = solver_->getTime();
-            start_ = std::chrono::steady_clock::now();
+            // Bitmaps are not modified once set in the grid, so the same one means the same obstacles.
+            const std::shared_ptr<const OccupancyBitmap> obstacles = grid_->getOccupancyBitmap();
+            const bool sameObstacles = obstacles == fm2_sources_ || (obstacles && fm2_sources_ && *obstacles == *fm2_sources_);
+            if (vels_cached_ && sameObstacles && maxDistance_ == cached_max_distance_ &&
+                grid_->getLeafSize() == cached_leaf_size_ && cached_vels_.size() == grid_->size()) {
+                restoreVelocitiesMap();
+                return;
+            }
+            if (vels_in_grid_)
+                restoreOccupancies();
+            fm2_sources_ = obstacles;
+            ++cache_misses_;
+            saveOccupancies();
+
+            if (wave_ == WAVE_EDT) {
+                time_vels_ = 0;
+                start_ = std::chrono::steady_clock::now();
+                distanceTransform();
+                max_value_ = 0;
+                for (unsigned int i = 0; i < grid_->size(); ++i)
+                    if (!std::isinf(dists_[i]) && dists_[i] > max_value_)
+                        max_value_ = dists_[i];
+            }
+            else {
+                // Forces not to clean the grid.
+                grid_->setClean(true);
+                solver_->setMaxArrivalTime(std::numeric_limits<double>::infinity());
+                solver_->setMaxDistance(std::numeric_limits<double>::infinity());
+                solver_->setCorridor(nullptr);
+                std::vector<unsigned int> sources;
+                fm2_sources_->toIndices(sources);
+                solver_->setInitialPoints(sources);
+                solver_->compute();
+                time_vels_ = solver_->getTime();
+                start_ = std::chrono::steady_clock::now();
+                max_value_ = grid_->getMaxValue();
+                dists_.resize(grid_->size());
+                for (unsigned int i = 0; i < grid_->size(); ++i)
+                    dists_[i] = grid_->getCell(i).getValue();
+            }
             // Rescaling and saturating to relative velocities: [0,1]
-            double maxValue = grid_->getMaxValue();
-            double maxVelocity = 0;
-
-            if (maxDistance_ != -1)
-                maxVelocity = maxDistance_ / grid_->getLeafSize();
-
+            cached_vels_.resize(grid_->size());
             for (unsigned int i = 0; i < grid_->size(); ++i) {
-                double vel = grid_->getCell(i).getValue() / maxValue;
-
-                if (maxDistance_ != -1)
-                    if (vel < maxVelocity)
-                        grid_->getCell(i).setVelocity(vel / maxVelocity);
-                    else
-                        grid_->getCell(i).setVelocity(1);
-                else
-                    grid_->getCell(i).setVelocity(vel);
+                grid_->getCell(i).setVelocity(velocityOf(dists_[i]));
+                cached_vels_[i] = grid_->getCell(i).getVelocity();
 
                 // Restarting grid values for second wave expasion.
                 grid_->getCell(i).setValue(std::numeric_limits<double>::infinity());
                 grid_->getCell(i).setState(FMState::OPEN);
                 grid_->setClean(true);
             }
+            vels_cached_ = true;
+            vels_in_grid_ = true;
+            cached_max_distance_ = maxDistance_;
+            cached_leaf_size_ = grid_->getLeafSize();
+            end_ = std::chrono::steady_clock::now();
+            time_vels_ += std::chrono::duration<double, std::milli>(end_-start_).count();
+        }
+
+        /** \brief Discards the cached velocities map, so the next query computes it again, and restores the
+            velocities of the grid it was computed from. To be called before modifying the velocities
+            of the grid other than through the obstacles. */
+        void invalidateVelocitiesMap
+        () {
+            if (vels_in_grid_)
+                restoreOccupancies();
+            dropVelocitiesMap();
+        }
+
+        /** \brief Adds and removes obstacles (cells indices) and updates the velocities map without
+            computing it again: only the distances to the obstacles which can change are marched
+            again, as in dynamic distance maps. Cells downwind of the removed obstacles are raised
+            (set to infinity) and marched again together with the cells lowered by the added
+            obstacles, stopping where the velocities saturate. Velocities are then updated for
+            those cells only.
+
+            The normalization of the map (the maximum distance to the obstacles) is that of the last
+            full computation, so results differ from computing the map again if the maximum changes
+            (velocities are saturated to 1). If the map is not cached, the obstacles of the grid are
+            modified and the map is computed in the next query. With WAVE_EDT the distance transform
+            is computed again (it takes linear time) with the same normalization. The second wave
+            values of the grid are not modified: call reset() before the next query as usual. */
+        void updateObstacles
+        (const std::vector<unsigned int> & added, const std::vector<unsigned int> & removed) {
+            start_ = std::chrono::steady_clock::now();
+            OccupancyBitmap sources(grid_->size());
+            if (fm2_sources_ && fm2_sources_->size() >= grid_->size())
+                sources = *fm2_sources_;
+            else if (fm2_sources_)
+                fm2_sources_->forEach([&sources] (unsigned int i) { if (i < sources.size()) sources.set(i); });
+
+            // Added cells which are already obstacles and removed cells which are not are ignored.
+            std::vector<unsigned int> add, rem;
+            for (unsigned int i : added)
+                if (!sources.test(i))
+                    add.push_back(i);
+            for (unsigned int i : removed)
+                if (sources.test(i))
+                    rem.push_back(i);
+            std::sort(add.begin(), add.end());
+            add.erase(std::unique(add.begin(), add.end()), add.end());
+            std::sort(rem.begin(), rem.end());
+            rem.erase(std::unique(rem.begin(), rem.end()), rem.end());
+
+            for (unsigned int i : add)
+                sources.set(i);
+            for (unsigned int i : rem)
+                sources.reset(i);
+            grid_->setOccupiedCells(std::move(sources));
+            fm2_sources_ = grid_->getOccupancyBitmap();
+
+            if (!vels_cached_) {
+                for (unsigned int i : add)
+                    grid_->getCell(i).setVelocity(0);
+                for (unsigned int i : rem)
+                    grid_->getCell(i).setVelocity(1);
+                return;
+            }
+
+            // Binary occupancies are given by fm2_sources_, already updated.
+            if (!binary_occupancies_) {
+                for (unsigned int i : add)
+                    occupancies_[i] = 0;
+                for (unsigned int i : rem)
+                    occupancies_[i] = 1;
+            }
+
+            if (wave_ == WAVE_EDT) {
+                distanceTransform();
+                for (unsigned int i = 0; i < grid_->size(); ++i) {
+                    const double vel = velocityOf(dists_[i]);
+                    if (vel != cached_vels_[i]) {
+                        cached_vels_[i] = vel;
+                        grid_->getCell(i).setVelocity(vel);
+                    }
+                }
+                ++map_updates_;
+                end_ = std::chrono::steady_clock::now();
+                time_vels_ = std::chrono::duration<double, std::milli>(end_-start_).count();
+                return;
+            }
+
+            const double maxDist = saturationDistance();
+            changed_.clear();
+
+            // Raise: cells whose distance could come from the removed obstacles.
+            raised_.clear();
+            for (unsigned int i : rem) {
+                raised_.push_back(std::make_pair(i, dists_[i]));
+                dists_[i] = std::numeric_limits<double>::infinity();
+            }
+            std::array<unsigned int, 2*grid_t::getNDims()> neighs;
+            for (size_t r = 0; r < raised_.size(); ++r) {
+                const unsigned int n = grid_->getNeighbors(raised_[r].first, neighs);
+                for (unsigned int k = 0; k < n; ++k) {
+                    const unsigned int j = neighs[k];
+                    if (dists_[j] > raised_[r].second && dists_[j] < maxDist) {
+                        raised_.push_back(std::make_pair(j, dists_[j]));
+                        dists_[j] = std::numeric_limits<double>::infinity();
+                    }
+                }
+            }
+
+            // Lower: the added obstacles and the raised cells reachable from the rest are marched.
+            band_.clear();
+            for (unsigned int i : add) {
+                dists_[i] = 0;
+                pushBand(i);
+            }
+            for (const std::pair<unsigned int, double> & r : raised_) {
+                changed_.push_back(r.first);
+                if (occupancyOf(r.first) > 0) {
+                    const double t = solveDistance(r.first);
+                    if (t < maxDist) {
+                        dists_[r.first] = t;
+                        pushBand(r.first);
+                    }
+                }
+            }
+            while (!band_.empty()) {
+                std::pop_heap(band_.begin(), band_.end(), std::greater<std::pair<double, unsigned int> >());
+                const std::pair<double, unsigned int> b = band_.back();
+                band_.pop_back();
+                if (b.first != dists_[b.second])
+                    continue;
+                changed_.push_back(b.second);
+                const unsigned int n = grid_->getNeighbors(b.second, neighs);
+                for (unsigned int k = 0; k < n; ++k) {
+                    const unsigned int j = neighs[k];
+                    if (occupancyOf(j) > 0) {
+                        const double t = solveDistance(j);
+                        if (t < dists_[j] && t < maxDist) {
+                            dists_[j] = t;
+                            pushBand(j);
+                        }
+                    }
+                }
+            }
+
+            for (unsigned int i : changed_) {
+                cached_vels_[i] = velocityOf(dists_[i]);
+                grid_->getCell(i).setVelocity(cached_vels_[i]);
+            }
+            ++map_updates_;
             end_ = std::chrono::steady_clock::now();
-            time_vels_ += std::chrono::duration_cast<std::chrono::milliseconds>(end_-start_).count();
+            time_vels_ = std::chrono::duration<double, std::milli>(end_-start_).count();
         }
 
         /** \brief Encapsulates the path extraction.
@@ -160,14 +384,15 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
         virtual void computePath
         (path_t * p, std::vector <double> * path_velocity, double step = 1) {
             path_t* path_ = p;
-            GradientDescent< nDGridMap<FMCell, grid_t::getNDims()> > grad;
+            GradientDescent<grid_t> grad;
             grad.apply(*grid_,init_points_[0],*path_, *path_velocity, step);
         }
 
         virtual void clear
         () {
             Solver<grid_t>::clear();
-            fm2_sources_.clear();
+            fm2_sources_.reset();
+            dropVelocitiesMap();
             maxDistance_ = -1;
             delete solver_;
         }
@@ -178,12 +403,63 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
             solver_->reset();
         }
 
-        /** \brief Returns velocities map computation time. */
+        /** \brief Returns velocities map computation time, or the time to restore it if it was cached or the time of the last updateObstacles(). */
         virtual double getTimeVelocities
         () const {
             return time_vels_;
         }
 
+        /** \brief Returns the number of queries which restored the cached velocities map. */
+        unsigned int getVelocitiesCacheHits
+        () const {
+            return cache_hits_;
+        }
+
+        /** \brief Returns the number of updateObstacles() calls which updated the cached velocities map. */
+        unsigned int getVelocitiesMapUpdates
+        () const {
+            return map_updates_;
+        }
+
+        /** \brief Returns the number of queries which computed the velocities map. */
+        unsigned int getVelocitiesCacheMisses
+        () const {
+            return cache_misses_;
+        }
+
+        virtual void printRunInfo
+        () const {
+            console::info("Fast Marching Square");
+            std::cout << '\t' << "First wave: " << (wave_ == WAVE_EDT ? "distance transform" : "FMM") << '\n'
+                      << '\t' << "Velocities map time: " << time_vels_ << " ms" << '\n'
+                      << '\t' << "Velocities map cache hits: " << cache_hits_ << '\n'
+                      << '\t' << "Velocities map cache misses: " << cache_misses_ << '\n'
+                      << '\t' << "Velocities map updates: " << map_updates_ << '\n'
+                      << '\t' << "Second wave time: " << time_ << " ms" << '\n';
+            this->printMemory();
+            solver_->getCounters().print();
+        }
+
+        /** \brief Returns the bytes allocated by the inner solver of the waves, the cached velocities map and
+            the buffers of the first wave and of updateObstacles(). */
+        virtual size_t memory
+        () const {
+            return Solver<grid_t>::memory() + sizeof(*solver_) + solver_->memory() + MemoryUsage::of(wave_init_)
+                    + MemoryUsage::of(cached_vels_) + MemoryUsage::of(occupancies_) + MemoryUsage::of(dists_)
+                    + MemoryUsage::of(raised_) + MemoryUsage::of(band_) + MemoryUsage::of(changed_);
+        }
+
+        virtual size_t sharedMemory
+        () const {
+            return solver_->sharedMemory();
+        }
+
+        /** \brief Returns the counters of the second wave of the last run. */
+        virtual const OpCounters & getCounters
+        () const {
+            return solver_->getCounters();
+        }
+
     protected:
         using Solver<grid_t>::grid_;
         using Solver<grid_t>::init_points_;
@@ -193,8 +469,9 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
         using Solver<grid_t>::start_;
         using Solver<grid_t>::end_;
 
-        /** \brief Wave propagation sources for the Fast Marching Square velocities map computation.*/
-        std::vector<unsigned int>   fm2_sources_;
+        /** \brief Wave propagation sources for the Fast Marching Square velocities map computation: the
+            obstacles of the grid, shared with it (see nDGridMap::getOccupancyBitmap()). */
+        std::shared_ptr<const OccupancyBitmap> fm2_sources_;
         
         /** \brief Underlying FMM-based solver. */
         FMM<grid_t, heap_t> *       solver_;
@@ -204,6 +481,282 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2 : public
 
         /** \brief Time elapsed in the velocities map computation. */
         double                      time_vels_;
+
+        /** \brief Initial point of the second wave (the goal), kept so that queries do not allocate memory. */
+        std::vector<unsigned int>   wave_init_;
+
+    private:
+        /** \brief Writes the cached velocities map into the grid and cleans it for the second wave. */
+        void restoreVelocitiesMap
+        () {
+            start_ = std::chrono::steady_clock::now();
+            ++cache_hits_;
+            grid_->clean();
+            // The grid could have been reloaded with the same obstacles, so the map is always written.
+            restoreVelocities(cached_vels_);
+            vels_in_grid_ = true;
+            end_ = std::chrono::steady_clock::now();
+            time_vels_ = std::chrono::duration<double, std::milli>(end_-start_).count();
+        }
+
+        /** \brief Velocity of a cell at distance d to the obstacles (first wave arrival time), given the
+            saturation distance and the normalization of the map. */
+        double velocityOf
+        (double d) const {
+            const double vel = d / max_value_;
+            if (maxDistance_ != -1) {
+                const double maxVelocity = maxDistance_ / grid_->getLeafSize();
+                return (vel < maxVelocity) ? vel / maxVelocity : 1;
+            }
+            return (vel < 1) ? vel : 1;
+        }
+
+        /** \brief Distance from which velocities are saturated to 1. dists_ is exact for lower distances and
+            not lower than this one for the rest (cells not updated by updateObstacles() past it). */
+        double saturationDistance
+        () const {
+            if (maxDistance_ != -1)
+                return max_value_ * maxDistance_ / grid_->getLeafSize();
+            return max_value_;
+        }
+
+        /** \brief Solves the Eikonal equation of the first wave for cell idx, from dists_ and the velocities
+            the map was computed from. */
+        double solveDistance
+        (unsigned int idx) const {
+            constexpr size_t N = grid_t::getNDims();
+            std::array<double, N> T;
+            std::array<unsigned int, 2> neighs;
+            unsigned int a = 0;
+            for (unsigned int dim = 0; dim < N; ++dim) {
+                const unsigned int n = grid_->getNeighborsInDim(idx, neighs, dim);
+                double minTInDim = std::numeric_limits<double>::infinity();
+                for (unsigned int j = 0; j < n; ++j)
+                    minTInDim = std::min(minTInDim, dists_[neighs[j]]);
+                if (!std::isinf(minTInDim) && minTInDim < dists_[idx]) {
+                    T[dim] = minTInDim;
+                    ++a;
+                }
+                else
+                    T[dim] = std::numeric_limits<double>::infinity();
+            }
+            if (a == 0)
+                return std::numeric_limits<double>::infinity();
+
+            EikonalSort<double, N>::sort(T);
+            const double leafsize = grid_->getLeafSize();
+            const double vel = occupancyOf(idx);
+            return EikonalKernel<double, N>::solve(T, a, leafsize / vel, leafsize*leafsize / (vel*vel));
+        }
+
+        /** \brief Computes dists_ as the Euclidean distance (in units of the leaf size) from every cell to
+            the closest cell of fm2_sources_: the squared distance along every dimension in turn, each
+            thread taking a part of the rows. */
+        void distanceTransform
+        () {
+            constexpr size_t N = grid_t::getNDims();
+            const std::array<unsigned int, N> dimsize = grid_->getDimSizes();
+            dists_.assign(grid_->size(), std::numeric_limits<double>::infinity());
+            fm2_sources_->forEachRun([this] (unsigned int first, unsigned int last) {
+                if (first < dists_.size())
+                    std::fill(dists_.begin() + first, dists_.begin() + std::min<size_t>(last, dists_.size()), 0);
+            });
+
+            pool_.resize(nthreads_);
+            unsigned int maxsize = 0;
+            for (size_t d = 0; d < N; ++d)
+                maxsize = std::max(maxsize, dimsize[d]);
+            for (size_t d = 0; d < N; ++d) {
+                const unsigned int n = dimsize[d];
+                const unsigned int rows = grid_->getNumberOfCells() / n;
+                pool_.run([this, d, n, rows, maxsize, &dimsize] (unsigned int t) {
+                    std::vector<double> f(maxsize), g(maxsize), z(maxsize + 1);
+                    std::vector<unsigned int> offsets(maxsize), v(maxsize);
+                    for (unsigned int k = 0; k < n; ++k)
+                        offsets[k] = grid_->getCoordOffset(d, k);
+                    const unsigned int first = unsigned((unsigned long long)(rows) * t / pool_.size());
+                    const unsigned int last = unsigned((unsigned long long)(rows) * (t + 1) / pool_.size());
+                    for (unsigned int r = first; r < last; ++r) {
+                        // Index of the first cell of row r, from its coordinates in the other dimensions.
+                        unsigned int base = 0, rem = r;
+                        for (size_t i = 0; i < N; ++i)
+                            if (i != d) {
+                                base += grid_->getCoordOffset(i, rem % dimsize[i]);
+                                rem /= dimsize[i];
+                            }
+                        for (unsigned int k = 0; k < n; ++k)
+                            f[k] = dists_[base + offsets[k]];
+                        squaredDistance1D(f, n, v, z, g);
+                        for (unsigned int k = 0; k < n; ++k)
+                            dists_[base + offsets[k]] = g[k];
+                    }
+                });
+            }
+
+            const double leafsize = grid_->getLeafSize();
+            for (double & d : dists_)
+                d = std::sqrt(d) * leafsize;
+        }
+
+        /** \brief One dimensional squared distance transform of the first n values of f: g[q] is set to the
+            minimum of (q - p)^2 + f[p] for all p, from the lower envelope of those parabolas. v and z are
+            scratch arrays of n and n+1 elements. */
+        static void squaredDistance1D
+        (const std::vector<double> & f, unsigned int n, std::vector<unsigned int> & v, std::vector<double> & z,
+         std::vector<double> & g) {
+            int k = -1;
+            for (unsigned int q = 0; q < n; ++q) {
+                if (std::isinf(f[q]))
+                    continue;
+                if (k < 0) {
+                    k = 0;
+                    v[0] = q;
+                    z[0] = -std::numeric_limits<double>::infinity();
+                    z[1] = std::numeric_limits<double>::infinity();
+                    continue;
+                }
+                double s;
+                while (true) {
+                    const unsigned int p = v[k];
+                    s = ((f[q] + double(q)*q) - (f[p] + double(p)*p)) / (2.0*q - 2.0*p);
+                    if (s > z[k])
+                        break;
+                    --k;
+                }
+                ++k;
+                v[k] = q;
+                z[k] = s;
+                z[k+1] = std::numeric_limits<double>::infinity();
+            }
+            if (k < 0) {
+                std::fill_n(g.begin(), n, std::numeric_limits<double>::infinity());
+                return;
+            }
+
+            k = 0;
+            for (unsigned int q = 0; q < n; ++q) {
+                while (z[k+1] < q)
+                    ++k;
+                const double d = double(q) - v[k];
+                g[q] = d*d + f[v[k]];
+            }
+        }
+
+        /** \brief Pushes cell idx with its distance into the band of updateObstacles(). */
+        void pushBand
+        (unsigned int idx) {
+            band_.push_back(std::make_pair(dists_[idx], idx));
+            std::push_heap(band_.begin(), band_.end(), std::greater<std::pair<double, unsigned int> >());
+        }
+
+        /** \brief Saves the velocities the map is computed from, restored by restoreOccupancies(). Those of
+            binary maps (0 in the obstacles, 1 elsewhere) are not copied: fm2_sources_ gives them. */
+        void saveOccupancies
+        () {
+            binary_occupancies_ = fm2_sources_ && fm2_sources_->size() >= grid_->size();
+            for (unsigned int i = 0; binary_occupancies_ && i < grid_->size(); ++i)
+                binary_occupancies_ = grid_->getCell(i).getVelocity() == (fm2_sources_->test(i) ? 0 : 1);
+            if (binary_occupancies_) {
+                std::vector<double>().swap(occupancies_);
+                return;
+            }
+            occupancies_.resize(grid_->size());
+            for (unsigned int i = 0; i < grid_->size(); ++i)
+                occupancies_[i] = grid_->getCell(i).getVelocity();
+        }
+
+        /** \brief Velocity of cell idx in the grid the map was computed from. */
+        inline double occupancyOf
+        (unsigned int idx) const {
+            if (binary_occupancies_)
+                return fm2_sources_->test(idx) ? 0 : 1;
+            return occupancies_[idx];
+        }
+
+        /** \brief Sets the velocities of the grid to those the map was computed from. */
+        void restoreOccupancies
+        () {
+            if (!binary_occupancies_) {
+                restoreVelocities(occupancies_);
+                return;
+            }
+            for (unsigned int i = 0; i < grid_->size(); ++i)
+                grid_->getCell(i).setVelocity(1);
+            fm2_sources_->forEach([this] (unsigned int i) {
+                if (i < grid_->size())
+                    grid_->getCell(i).setVelocity(0);
+            });
+        }
+
+        /** \brief Sets the velocities of the grid. */
+        void restoreVelocities
+        (const std::vector<double> & vels) {
+            for (unsigned int i = 0; i < grid_->size(); ++i)
+                grid_->getCell(i).setVelocity(vels[i]);
+        }
+
+        /** \brief Discards the cached velocities map without modifying the grid. */
+        void dropVelocitiesMap
+        () {
+            vels_cached_ = false;
+            vels_in_grid_ = false;
+            cached_vels_.clear();
+            occupancies_.clear();
+            binary_occupancies_ = false;
+            dists_.clear();
+        }
+
+        /** \brief Velocities map of fm2_sources_, cached_max_distance_ and cached_leaf_size_, if vels_cached_. */
+        std::vector<double>         cached_vels_;
+
+        /** \brief Velocities of the grid from which the cached map was computed, empty if binary_occupancies_. */
+        std::vector<double>         occupancies_;
+
+        /** \brief True if the velocities the cached map was computed from are binary, given by fm2_sources_. */
+        bool                        binary_occupancies_;
+
+        /** \brief First wave arrival times (distances to the obstacles) of the cached map, see saturationDistance(). */
+        std::vector<double>         dists_;
+
+        /** \brief Maximum distance to the obstacles when the cached map was computed, which normalizes it. */
+        double                      max_value_;
+
+        /** \brief Cells raised by updateObstacles() with their previous distance. Kept to reuse its memory. */
+        std::vector<std::pair<unsigned int, double> >   raised_;
+
+        /** \brief Narrow band of updateObstacles(), a binary heap of distances and cells. */
+        std::vector<std::pair<double, unsigned int> >   band_;
+
+        /** \brief Cells whose velocity is updated by updateObstacles(). */
+        std::vector<unsigned int>   changed_;
+
+        /** \brief Saturation distance of the cached map. */
+        double                      cached_max_distance_;
+
+        /** \brief Leaf size of the grid of the cached map. */
+        double                      cached_leaf_size_;
+
+        /** \brief True if the velocities map is cached. */
+        bool                        vels_cached_;
+
+        /** \brief True if the cached map was written into the grid. */
+        bool                        vels_in_grid_;
+
+        /** \brief Queries which restored and computed the velocities map. */
+        unsigned int                cache_hits_;
+        unsigned int                cache_misses_;
+
+        /** \brief Calls to updateObstacles() which updated the cached map. */
+        unsigned int                map_updates_;
+
+        /** \brief How the first wave is computed. */
+        FM2Wave                     wave_;
+
+        /** \brief Threads of the distance transform, 0 for as many as hardware threads. */
+        unsigned int                nthreads_;
+
+        /** \brief Threads of the distance transform. */
+        WorkerPool                  pool_;
 };
 
 #endif /* FM2_H_*/
@@ -48,7 +48,7 @@
 /// \todo Include support to other solvers (GMM, FIM, UFMM). Requires theoretical work on heuristics on these methods.
 // template < class grid_t, class solver_t = FMM<grid_t> > class FM2Star : public FM2<grid_t> {
 
-template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2Star : public FM2<grid_t, heap_t> {
+template < class grid_t, class heap_t = FMDaryHeap<typename grid_t::cell_t> > class FM2Star : public FM2<grid_t, heap_t> {
 
     /** \brief Path type encapsulation. */
     typedef std::vector< std::array<double, grid_t::getNDims()> > path_t;
@@ -65,13 +65,6 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2Star : pub
         FM2Star
         (const char * name, HeurStrategy heurStrategy = TIME, double maxDistance = -1) : FM2Base(name, maxDistance), heurStrategy_(heurStrategy) { }
 
-        /** \brief Overloaded from FM2. In this case the precomputeDistances() method is called. */
-        virtual void setInitialAndGoalPoints
-        (const std::vector<unsigned int> & init_points, unsigned int goal_idx) {
-            FM2Base::setInitialAndGoalPoints(init_points, goal_idx);
-            solver_->precomputeDistances();
-        }
-
         /** \brief Sets up the solver to check whether is ready to run. */
         virtual void setup
         () {
@@ -95,12 +88,14 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2Star : pub
             start_ = std::chrono::steady_clock::now();
 
             // According to the theoretical basis the wave is expanded from the goal point to the initial point.
-            std::vector <unsigned int> wave_init;
-            wave_init.push_back(goal_idx_);
+            wave_init_.assign(1, goal_idx_);
             unsigned int wave_goal = init_points_[0];
 
-            solver_->setInitialAndGoalPoints(wave_init, wave_goal);
+            solver_->setInitialAndGoalPoints(wave_init_, wave_goal);
             solver_->setHeuristics(heurStrategy_);
+            solver_->setMaxArrivalTime(this->getMaxArrivalTime());
+            solver_->setMaxDistance(this->getMaxDistance());
+            solver_->setCorridor(this->getCorridor());
             solver_->compute();
             // Restore the actual grid status.
             grid_->setClean(false);
@@ -111,6 +106,7 @@ template < class grid_t, class heap_t = FMDaryHeap<FMCell> > class FM2Star : pub
         using FM2Base::init_points_;
         using FM2Base::goal_idx_;
         using FM2Base::solver_;
+        using FM2Base::wave_init_;
         using FM2Base::setup;
         using FM2Base::setup_;
         using FM2Base::start_;
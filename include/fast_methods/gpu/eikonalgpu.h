@@ -0,0 +1,65 @@
+/*! \file eikonalgpu.h
+    \brief Device (CUDA) backend of GPUFIM and GPUFSM.
+
+    Grids are given to the device as arrays in row-major order of up to 3 dimensions
+    (cell x + dims[0]*(y + dims[1]*z), unused dimensions of size 1): the speed of every cell
+    (0 for obstacles) and the arrival times, 0 for the initial points and infinity elsewhere,
+    which are overwritten with the solution. The update of the cells is that of EikonalKernel.
+
+    The library is built with this backend only when CMake is run with -DUSE_CUDA=true.
+    Otherwise (or if there is no CUDA device) available() returns false and the solvers
+    fall back to their CPU versions. Device buffers are kept between solves and reallocated
+    when a larger grid is given; solves are serialized.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EIKONALGPU_H_
+#define EIKONALGPU_H_
+
+#include <string>
+#include <vector>
+
+namespace gpu {
+
+    /** \brief Returns true if the library was built with the CUDA backend and there is a device. */
+    bool available();
+
+    /** \brief Returns the name of the device used, empty if there is none. */
+    std::string deviceName();
+
+    /** \brief Block Fast Iterative Method: tiles of tileSize cells per side (tileSize in the
+        dimensions of size 1) are updated by a block of device threads, tileSize times per round.
+        Tiles which changed and their neighbors are updated in the next round, until no time
+        improves by more than error. Returns false if the device failed.
+        @param dims size of the 3 dimensions.
+        @param rounds rounds performed. */
+    bool solveFIM
+    (const unsigned int * dims, double leafsize, const std::vector<double> & speeds,
+     std::vector<double> & times, double error, unsigned int tileSize, unsigned int & rounds);
+
+    /** \brief Fast Sweeping Method: the cells of each sweep are updated by levels (cells with
+        the same sum of coordinates in the direction of the sweep) in parallel, which gives the
+        same result as sweeping them in order. Directions are swept until an iteration over
+        all of them (2^n for n dimensions larger than 1) changes no time, or maxSweeps sweeps are
+        done. Returns false if the device failed.
+        @param dims size of the 3 dimensions.
+        @param sweeps sweeps performed. */
+    bool solveSweeping
+    (const unsigned int * dims, double leafsize, const std::vector<double> & speeds,
+     std::vector<double> & times, unsigned int maxSweeps, unsigned int & sweeps);
+}
+
+#endif /* EIKONALGPU_H_ */
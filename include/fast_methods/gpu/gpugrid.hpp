@@ -0,0 +1,126 @@
+/*! \class GPUGrid
+    \brief Host arrays given to the device backend (see eikonalgpu.h) by GPUFIM and GPUFSM.
+
+    upload() copies the speeds of the cells of an nDGridMap, in row-major order for any layout
+    of the grid, and sets the times of the initial points to 0; download() copies the arrival
+    times computed back to the cells reached, which are set as FROZEN, so that the grid can be
+    used as if a CPU solver had run (GradientDescent, GridWriter...). Grids of up to 3 dimensions
+    are supported.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GPUGRID_HPP_
+#define GPUGRID_HPP_
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <cmath>
+
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+#include <fast_methods/gpu/eikonalgpu.h>
+
+template <class grid_t> class GPUGrid {
+
+    /** \brief Shorthand for number of dimensions. */
+    static constexpr size_t ndims_ = grid_t::getNDims();
+
+    public:
+        /** \brief Returns true if the grid type can be solved on the device. */
+        static constexpr bool supported
+        () {
+            return ndims_ <= 3;
+        }
+
+        /** \brief Copies the speeds of grid (0 for obstacles) and the initial points. */
+        void upload
+        (const grid_t & grid, const std::vector<unsigned int> & init_points) {
+            const std::array<unsigned int, ndims_> d = grid.getDimSizes();
+            for (size_t i = 0; i < 3; ++i)
+                dims_[i] = (i < ndims_) ? d[i] : 1;
+
+            const unsigned int n = grid.getNumberOfCells();
+            speeds_.resize(n);
+            times_.assign(n, std::numeric_limits<double>::infinity());
+            for (unsigned int i = 0; i < n; ++i) {
+                const unsigned int idx = grid.rowMajor2idx(i);
+                speeds_[i] = grid.getCell(idx).isOccupied() ? 0 : double(grid.getCell(idx).getVelocity());
+            }
+
+            // Indices of grids not bricked are already in row-major order.
+            std::array<unsigned int, ndims_> coords;
+            for (unsigned int idx : init_points) {
+                if (grid.getBrickSize() == 1) {
+                    times_[idx] = 0;
+                    continue;
+                }
+                grid.idx2coord(idx, coords);
+                unsigned int i = 0;
+                for (size_t j = ndims_; j-- > 0;)
+                    i = i*d[j] + coords[j];
+                times_[i] = 0;
+            }
+        }
+
+        /** \brief Copies the arrival times to the cells of grid with finite time. */
+        void download
+        (grid_t & grid) const {
+            for (unsigned int i = 0; i < times_.size(); ++i) {
+                if (std::isinf(times_[i]))
+                    continue;
+                const unsigned int idx = grid.rowMajor2idx(i);
+                grid.getCell(idx).setArrivalTime(times_[i]);
+                grid.getCell(idx).setState(FMState::FROZEN);
+            }
+        }
+
+        /** \brief Size of the 3 dimensions given to the device. */
+        const unsigned int * getDims
+        () const {
+            return dims_.data();
+        }
+
+        /** \brief Speeds in row-major order. */
+        const std::vector<double> & getSpeeds
+        () const {
+            return speeds_;
+        }
+
+        /** \brief Arrival times in row-major order, written by the device. */
+        std::vector<double> & getTimes
+        () {
+            return times_;
+        }
+
+        /** \brief Returns the bytes allocated in the host for the speeds and times. The device memory is
+            not included. */
+        size_t memory
+        () const {
+            return MemoryUsage::of(speeds_) + MemoryUsage::of(times_);
+        }
+
+    private:
+        /** \brief Size of the dimensions, 1 for those the grid does not have. */
+        std::array<unsigned int, 3> dims_;
+
+        /** \brief Speeds of the cells. */
+        std::vector<double> speeds_;
+
+        /** \brief Arrival times of the cells. */
+        std::vector<double> times_;
+};
+
+#endif /* GPUGRID_HPP_ */
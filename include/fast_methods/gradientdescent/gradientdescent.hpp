@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <cmath>
 #include <numeric>
+#include <vector>
 
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
 #include <fast_methods/ndgridmap/fmcell.h>
@@ -65,16 +66,25 @@ template <class grid_t> class GradientDescent {
            black border around the map image. */
       static void apply
       (grid_t & grid, unsigned int & idx, Path & path, std::vector <double> & path_velocity, double step = 1) {
+          descend(grid, [&grid] (unsigned int i) { return grid[i].getValue(); }, idx, path, path_velocity, step);
+      }
 
-          Coord current_coord;
-          Point current_point;
-          Coord dimsize = grid.getDimSizes();
+      /** \brief apply() descending the given times, indexed as the cells of grid, instead of the arrival
+          times of the grid. For solvers computing some of the times in their own arrays (as BFMM). */
+      static void apply
+      (grid_t & grid, const std::vector<typename grid_t::value_t> & times, unsigned int & idx, Path & path,
+       std::vector <double> & path_velocity, double step = 1) {
+          descend(grid, [&times] (unsigned int i) { return double(times[i]); }, idx, path, path_velocity, step);
+      }
 
-          std::array<unsigned int, ndims_-1> d_; //  Same as nDGridMap class auxiliar array d_.
-          d_[0] = dimsize[0];
-          for (size_t i = 1; i < ndims_; ++i)
-              d_[i] = dimsize[i]*d_[i-1];
+    private:
+      /** \brief Descends the times given by value(index) from idx until a time 0. */
+      template <class F>
+      static void descend
+      (grid_t & grid, const F & value, unsigned int & idx, Path & path, std::vector <double> & path_velocity, double step) {
 
+          Coord current_coord;
+          Point current_point;
           grid.idx2coord(idx, current_coord);
           std::copy_n( current_coord.begin(), ndims_, current_point.begin() ); // Cast to int.
           path.push_back(current_point);
@@ -82,21 +92,26 @@ template <class grid_t> class GradientDescent {
 
           std::array<double, ndims_> grads;
 
-          while(grid[idx].getArrivalTime() != 0) {
-              // Every iteration the gradient is computed for all dimensions. If is infinite, we convert it to 1 (keeping the sign).
+          while(value(idx) != 0) {
+              // Every iteration the gradient is computed for all dimensions. If is infinite, we convert it to 1 (keeping the sign),
+              // and if both neighbors are infinite (not reached) to 0.
               // The static_cast are necessary because the conversion between coordinate (we check the value in coordinates) and points
               // (the path is composed by continuous points).
 
               // First dimension done apart.
-              grads[0] = - grid[idx-1].getValue()/2 + grid[idx+1].getValue()/2;
+              grads[0] = - value(grid.getNeighborIdx(idx, 0, false))/2 + value(grid.getNeighborIdx(idx, 0, true))/2;
               if (isinf(grads[0]))
                   grads[0] = sgn<double>(grads[0]);
+              else if (isnan(grads[0]))
+                  grads[0] = 0;
               double max_grad = std::abs(grads[0]);
 
               for (size_t i = 1; i < ndims_; ++i) {
-                  grads[i] = - grid[idx-d_[i-1]].getValue()/2 + grid[idx+d_[i-1]].getValue()/2;
+                  grads[i] = - value(grid.getNeighborIdx(idx, i, false))/2 + value(grid.getNeighborIdx(idx, i, true))/2;
                   if (isinf(grads[i]))
                       grads[i] = sgn<double>(grads[i]);
+                  else if (isnan(grads[i]))
+                      grads[i] = 0;
                   if (std::abs(max_grad) < std::abs(grads[i]))
                       max_grad = grads[i];
               }
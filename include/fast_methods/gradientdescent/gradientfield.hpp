@@ -0,0 +1,292 @@
+/*! \class GradientField
+    \brief Gradient of the arrival times of a grid, computed once per solve, to extract many
+    paths from the same arrival times (for instance, the paths from many goals to the
+    initial points of a solve).
+
+    build() stores, for every cell, its arrival time and its gradient: central differences, or
+    one-sided differences next to cells not reached (obstacles), interleaved so that a cell
+    takes ndims+1 consecutive values of type T (T = float halves the memory). apply() descends
+    the field from a cell: the gradient at every point of the path is interpolated (bilinear in
+    2D, trilinear in 3D...) from the cells around it with finite arrival time, so the path is
+    not bound to the gradient of the nearest cell. As in GradientDescent, steps have the given
+    length in the dimension of the largest gradient, and the path finishes at the first cell
+    with time 0. The path is reserved from the arrival time of its first cell and the maximum
+    speed of the grid.
+
+    The field does not refer to the arrival times once built, so the solver can be reset or
+    run again, but velocities of the paths are read from the grid given to build(). The batch
+    version of apply() extracts the paths in parallel, handing them out to the threads from a
+    shared counter.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GRADIENTFIELD_HPP_
+#define GRADIENTFIELD_HPP_
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+#include <fast_methods/gradientdescent/gradientdescent.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+
+template <class grid_t, typename T = double> class GradientField {
+
+    /** \brief Shorthand for number of dimensions. */
+    static constexpr size_t ndims_ = grid_t::getNDims();
+
+    /** \brief Number of values stored per cell: arrival time and gradient. */
+    static constexpr size_t stride_ = ndims_ + 1;
+
+    /** \brief Shorthand for coordinates. */
+    typedef typename std::array<unsigned int, ndims_> Coord;
+
+    public:
+        /** \brief Shorhand for real points. */
+        typedef typename std::array<double, ndims_> Point;
+
+        /** \brief Shorthand for path type of real points. */
+        typedef typename std::vector <Point> Path;
+
+        /** @param nthreads number of threads of the batch version of apply(), 0 for as many as
+                   hardware threads. */
+        GradientField(unsigned int nthreads = 1) : grid_(nullptr), maxSpeed_(0), nthreads_(nthreads) {}
+
+        /** \brief Computes the field from the arrival times of grid. */
+        void build
+        (const grid_t & grid) {
+            build(grid, [&grid] (unsigned int i) { return double(grid.getCell(i).getArrivalTime()); });
+        }
+
+        /** \brief Computes the field from the given times, indexed as the cells of grid, instead
+            of the arrival times of the grid (as the backward times of BFMM). */
+        void build
+        (const grid_t & grid, const std::vector<typename grid_t::value_t> & times) {
+            build(grid, [&times] (unsigned int i) { return double(times[i]); });
+        }
+
+        /** \brief Computes the path from idx to the first cell with time 0 and the velocity of
+            the grid in every point. Both are appended to path and path_velocity, and idx is set
+            to the last cell. Returns false, without the last cell, if idx was not reached or the
+            descent did not finish in 4 times the steps expected. Steps which would end in a cell
+            not reached (an obstacle) go to the neighbor cell with the lowest time instead. */
+        bool apply
+        (unsigned int & idx, Path & path, std::vector<double> & path_velocity, double step = 1) const {
+            const double t0 = field_[idx*stride_];
+            if (std::isinf(t0))
+                return false;
+
+            // The path cannot be longer than t0*maxSpeed_/leafsize cells, and steps are at least step long.
+            const size_t expected = size_t(t0*maxSpeed_/(grid_->getLeafSize()*step)) + 2;
+            path.reserve(path.size() + expected + 1);
+            path_velocity.reserve(path_velocity.size() + expected + 1);
+
+            Coord coord;
+            Point point;
+            grid_->idx2coord(idx, coord);
+            std::copy_n(coord.begin(), ndims_, point.begin());
+            path.push_back(point);
+            path_velocity.push_back(grid_->getCell(idx).getVelocity());
+
+            std::array<double, ndims_> grads;
+            std::array<unsigned int, 2*ndims_> neighs;
+            for (size_t n = 0; field_[idx*stride_] != 0; ++n) {
+                if (n == 4*expected)
+                    return false;
+
+                interpolate(point, grads);
+                double max_grad = 0;
+                for (size_t i = 0; i < ndims_; ++i)
+                    max_grad = std::max(max_grad, std::abs(grads[i]));
+
+                unsigned int next = idx;
+                Point next_point;
+                if (max_grad > 0) {
+                    for (size_t i = 0; i < ndims_; ++i) {
+                        next_point[i] = std::min(std::max(point[i] - step*grads[i]/max_grad, 0.), double(dimsize_[i] - 1));
+                        coord[i] = unsigned(next_point[i] + 0.5);
+                    }
+                    grid_->coord2idx(coord, next);
+                }
+                if (max_grad == 0 || std::isinf(field_[next*stride_])) {
+                    // Into an obstacle (or flat): moving to the neighbor cell with the lowest time instead.
+                    const unsigned int nn = grid_->getNeighbors(idx, neighs);
+                    next = idx;
+                    for (unsigned int j = 0; j < nn; ++j)
+                        if (field_[neighs[j]*stride_] < field_[next*stride_])
+                            next = neighs[j];
+                    if (next == idx)
+                        return false;
+                    grid_->idx2coord(next, coord);
+                    std::copy_n(coord.begin(), ndims_, next_point.begin());
+                }
+                idx = next;
+                point = next_point;
+                path.push_back(point);
+                path_velocity.push_back(grid_->getCell(idx).getVelocity());
+            }
+            // Adding exactly the last point at the end.
+            std::copy_n(coord.begin(), ndims_, point.begin());
+            path.push_back(point);
+            path_velocity.push_back(grid_->getCell(idx).getVelocity());
+            return true;
+        }
+
+        /** \brief Computes the paths from every cell in idxs in parallel. Paths of cells not
+            reached, or of descents not finished, are empty. */
+        void apply
+        (const std::vector<unsigned int> & idxs, std::vector<Path> & paths,
+         std::vector<std::vector<double> > & path_velocities, double step = 1) {
+            paths.assign(idxs.size(), Path());
+            path_velocities.assign(idxs.size(), std::vector<double>());
+
+            pool_.resize(nthreads_);
+            std::atomic<unsigned int> next(0);
+            pool_.run([this, &idxs, &paths, &path_velocities, step, &next] (unsigned int) {
+                for (unsigned int p = next++; p < idxs.size(); p = next++) {
+                    unsigned int idx = idxs[p];
+                    if (!apply(idx, paths[p], path_velocities[p], step)) {
+                        paths[p].clear();
+                        path_velocities[p].clear();
+                    }
+                }
+            });
+        }
+
+        /** \brief Sets the number of threads of the batch version of apply(), 0 for as many as
+            hardware threads. */
+        void setNumberOfThreads
+        (unsigned int nthreads) {
+            nthreads_ = nthreads;
+        }
+
+        /** \brief Returns the gradient stored for cell idx in dimension dim. */
+        inline double getGradient
+        (unsigned int idx, unsigned int dim) const {
+            return field_[idx*stride_ + 1 + dim];
+        }
+
+        /** \brief Drops the field. */
+        void clear
+        () {
+            field_.clear();
+            field_.shrink_to_fit();
+            grid_ = nullptr;
+        }
+
+        /** \brief Returns the bytes allocated by the field. */
+        size_t memory
+        () const {
+            return MemoryUsage::of(field_);
+        }
+
+    private:
+        /** \brief Stores the times value(i) and their gradients for all the cells of grid. */
+        template <class F>
+        void build
+        (const grid_t & grid, const F & value) {
+            grid_ = &grid;
+            dimsize_ = grid.getDimSizes();
+            maxSpeed_ = grid.getMaxSpeed();
+            field_.assign(grid.size()*stride_, T(0));
+
+            const double inf = std::numeric_limits<double>::infinity();
+            std::array<unsigned int, 2> neighs;
+            for (unsigned int idx = 0; idx < grid.size(); ++idx) {
+                if (grid.isPadding(idx))
+                    continue;
+                const double t = value(idx);
+                field_[idx*stride_] = t;
+                if (std::isinf(t))
+                    continue;
+                for (unsigned int i = 0; i < ndims_; ++i) {
+                    // Neighbors out of the grid are taken as not reached.
+                    double prev = inf, next = inf;
+                    const unsigned int n = grid.getNeighborsInDim(idx, neighs, i);
+                    for (unsigned int j = 0; j < n; ++j) {
+                        if (neighs[j] < idx)
+                            prev = value(neighs[j]);
+                        else
+                            next = value(neighs[j]);
+                    }
+                    double g = 0;
+                    if (!std::isinf(prev) && !std::isinf(next))
+                        g = next/2 - prev/2;
+                    else if (!std::isinf(prev))
+                        g = t - prev;
+                    else if (!std::isinf(next))
+                        g = next - t;
+                    field_[idx*stride_ + 1 + i] = g;
+                }
+            }
+        }
+
+        /** \brief Interpolates the gradient at point from the 2^ndims cells around it with finite
+            time (the cell nearest to point is one of them). */
+        void interpolate
+        (const Point & point, std::array<double, ndims_> & grads) const {
+            std::array<std::array<unsigned int, 2>, ndims_> offsets;
+            std::array<std::array<double, 2>, ndims_> weights;
+            for (size_t i = 0; i < ndims_; ++i) {
+                const unsigned int c = std::min(unsigned(point[i]), dimsize_[i] > 1 ? dimsize_[i] - 2 : 0u);
+                const double w = std::min(std::max(point[i] - c, 0.), 1.);
+                offsets[i][0] = grid_->getCoordOffset(i, c);
+                offsets[i][1] = grid_->getCoordOffset(i, std::min(c + 1, dimsize_[i] - 1));
+                weights[i][0] = 1 - w;
+                weights[i][1] = w;
+            }
+
+            grads.fill(0);
+            for (unsigned int corner = 0; corner < (1u << ndims_); ++corner) {
+                unsigned int idx = 0;
+                double w = 1;
+                for (size_t i = 0; i < ndims_; ++i) {
+                    const unsigned int b = (corner >> i) & 1;
+                    idx += offsets[i][b];
+                    w *= weights[i][b];
+                }
+                const T * f = &field_[idx*stride_];
+                if (w == 0 || std::isinf(f[0]))
+                    continue;
+                for (size_t i = 0; i < ndims_; ++i)
+                    grads[i] += w*f[1 + i];
+            }
+        }
+
+        /** \brief Grid the field was built from. */
+        const grid_t * grid_;
+
+        /** \brief Size of the dimensions of the grid. */
+        Coord dimsize_;
+
+        /** \brief Maximum speed of the grid, to reserve the paths. */
+        double maxSpeed_;
+
+        /** \brief Arrival time and gradient of every cell, stride_ values per cell. */
+        std::vector<T> field_;
+
+        /** \brief Number of threads of the batch version of apply(). */
+        unsigned int nthreads_;
+
+        /** \brief Threads of the batch version of apply(). */
+        WorkerPool pool_;
+};
+
+#endif /* GRADIENTFIELD_HPP_ */
@@ -0,0 +1,160 @@
+/*! \class AsyncGridWriter
+    \brief Saves grids from a background thread, so that the caller does not wait for the files
+    to be written (for instance, the grid of every run of a benchmark).
+
+    saveGridValues() and saveVelocities() copy the values of the grid in row-major order (see
+    GridSnapshot) and queue them, so the grid can be reset or solved again right after. Copies
+    are written by a single thread, in the order they were queued, with GridWriter::save(). The
+    queue is bounded to capacity grids: when it is full the caller waits for the writer, so that
+    the memory of the queue is bounded if grids are produced faster than they are written.
+    wait() returns when all the queued grids are written, and the destructor waits for them.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ASYNCGRIDWRITER_HPP_
+#define ASYNCGRIDWRITER_HPP_
+
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include <fast_methods/io/gridwriter.hpp>
+
+class AsyncGridWriter {
+
+    public:
+        /** @param capacity maximum number of grids queued (at least 1). */
+        AsyncGridWriter(unsigned int capacity = 4) : capacity_(std::max(capacity, 1u)), busy_(false), stop_(false) {}
+
+        ~AsyncGridWriter() {
+            wait();
+            if (thread_.joinable()) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+                notEmpty_.notify_one();
+                thread_.join();
+            }
+        }
+
+        AsyncGridWriter(const AsyncGridWriter &) = delete;
+        AsyncGridWriter & operator=(const AsyncGridWriter &) = delete;
+
+        /** \brief Queues the values (arrival times) of grid to be saved in filename, in the given format. */
+        template <class grid_t>
+        void saveGridValues
+        (const std::string & filename, const grid_t & grid, GridFormat format = GRID_BINARY) {
+            save(filename, grid, format, GridBinary::PAYLOAD_VALUES);
+        }
+
+        /** \brief Queues the velocities of grid to be saved in filename, in the given format. */
+        template <class grid_t>
+        void saveVelocities
+        (const std::string & filename, const grid_t & grid, GridFormat format = GRID_BINARY) {
+            save(filename, grid, format, GridBinary::PAYLOAD_VELOCITIES);
+        }
+
+        /** \brief Waits until all the queued grids are written. */
+        void wait
+        () {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_.wait(lock, [this] () { return queue_.empty() && !busy_; });
+        }
+
+        /** \brief Returns the number of grids queued or being written. */
+        size_t pending
+        () const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return queue_.size() + (busy_ ? 1 : 0);
+        }
+
+        /** \brief Returns the maximum number of grids queued. */
+        unsigned int getCapacity
+        () const {
+            return capacity_;
+        }
+
+    private:
+        /** \brief Copies the payload of grid and queues the job writing it. */
+        template <class grid_t>
+        void save
+        (const std::string & filename, const grid_t & grid, GridFormat format, uint32_t payload) {
+            typedef GridSnapshot<typename grid_t::value_t> snapshot_t;
+            std::shared_ptr<snapshot_t> snap = std::make_shared<snapshot_t>();
+            snap->copy(grid, payload);
+            push([filename, snap, format] () { GridWriter::save(filename.c_str(), *snap, format); });
+        }
+
+        /** \brief Queues job, waiting while the queue is full. The thread is started by the first job. */
+        void push
+        (std::function<void()> job) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!thread_.joinable())
+                    thread_ = std::thread(&AsyncGridWriter::loop, this);
+                notFull_.wait(lock, [this] () { return queue_.size() < capacity_; });
+                queue_.push_back(std::move(job));
+            }
+            notEmpty_.notify_one();
+        }
+
+        /** \brief Writes the queued grids until the writer is destroyed. */
+        void loop
+        () {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                notEmpty_.wait(lock, [this] () { return stop_ || !queue_.empty(); });
+                if (queue_.empty())
+                    return;
+                std::function<void()> job = std::move(queue_.front());
+                queue_.pop_front();
+                busy_ = true;
+                lock.unlock();
+                notFull_.notify_one();
+                job();
+                lock.lock();
+                busy_ = false;
+                if (queue_.empty())
+                    idle_.notify_all();
+            }
+        }
+
+        /** \brief Maximum number of grids queued. */
+        const unsigned int capacity_;
+
+        /** \brief Jobs writing the queued grids. */
+        std::deque<std::function<void()> > queue_;
+
+        /** \brief True while the writer writes a grid. */
+        bool busy_;
+
+        /** \brief Set to finish the thread. */
+        bool stop_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable notEmpty_, notFull_, idle_;
+
+        /** \brief Thread writing the grids. */
+        std::thread thread_;
+};
+
+#endif /* ASYNCGRIDWRITER_HPP_ */
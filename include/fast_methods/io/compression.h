@@ -0,0 +1,48 @@
+/*! \file compression.h
+    \brief Compression of the binary grid files (see GridBinary), used by GridWriter and MapLoader.
+
+    Compressed files are zstd frames of a whole .fmgrid file, so they can also be decompressed
+    with the zstd command line tool. The library compresses them only when CMake is run with
+    -DUSE_ZSTD=true; otherwise available() returns false, grids are saved uncompressed and
+    compressed files cannot be loaded (isCompressed() still detects them).
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPRESSION_H_
+#define COMPRESSION_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace compression {
+
+    /** \brief Returns true if the library was built with zstd. */
+    bool available();
+
+    /** \brief Returns true if data starts as a zstd frame. */
+    bool isCompressed
+    (const unsigned char * data, size_t size);
+
+    /** \brief Compresses size bytes of data into out. Returns false if it could not. */
+    bool compress
+    (const unsigned char * data, size_t size, std::vector<unsigned char> & out, int level = 3);
+
+    /** \brief Decompresses the frame of size bytes in data into out. Returns false if it could not. */
+    bool decompress
+    (const unsigned char * data, size_t size, std::vector<unsigned char> & out);
+}
+
+#endif /* COMPRESSION_H_ */
@@ -0,0 +1,138 @@
+/*! \class GridBinary
+    \brief Binary .fmgrid format shared by MapLoader::loadMapFromBinary() and
+    GridWriter::saveVelocitiesBinary() / saveGridValuesBinary().
+
+    All the fields are little-endian:
+
+        magic "FMGRID\0\0"                   (8 bytes)
+        version                              (uint32, currently 1)
+        ndims                                (uint32)
+        dtype                                (uint32, DTYPE_FLOAT32 or DTYPE_FLOAT64)
+        payload                              (uint32, PAYLOAD_VELOCITIES or PAYLOAD_VALUES)
+        leafsize                             (float64)
+        dimsize[0] ... dimsize[ndims-1]      (uint32 each)
+        padding up to a multiple of 8 bytes
+        ncells values in row-major order     (dtype each)
+
+    so the values of a file of ndims dimensions start at dataOffset(ndims) and the file is
+    dataOffset(ndims) + ncells*size of dtype bytes long.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef GRIDBINARY_HPP_
+#define GRIDBINARY_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+class GridBinary {
+    public:
+        /** \brief Version written, the only one read. */
+        static constexpr uint32_t VERSION = 1;
+
+        /** \brief Types of the values. */
+        static constexpr uint32_t DTYPE_FLOAT32 = 1;
+        static constexpr uint32_t DTYPE_FLOAT64 = 2;
+
+        /** \brief Contents of the values: velocities (occupancies), as loaded by MapLoader, or
+            values of the cells (arrival times). */
+        static constexpr uint32_t PAYLOAD_VELOCITIES = 0;
+        static constexpr uint32_t PAYLOAD_VALUES = 1;
+
+        /** \brief Size of the fixed part of the header: magic, 4 uint32 and the leaf size. */
+        static constexpr size_t FIXED_HEADER = 32;
+
+        /** \brief Returns the magic bytes which start the files. */
+        static const char * magic
+        () {
+            return "FMGRID\0\0";
+        }
+
+        /** \brief Offset of the values in a file of ndims dimensions. */
+        static constexpr size_t dataOffset
+        (size_t ndims) {
+            return (FIXED_HEADER + 4*ndims + 7) / 8 * 8;
+        }
+
+        /** \brief Size of the values of type dtype, 0 if dtype is not valid. */
+        static constexpr size_t dtypeSize
+        (uint32_t dtype) {
+            return (dtype == DTYPE_FLOAT32) ? 4 : ((dtype == DTYPE_FLOAT64) ? 8 : 0);
+        }
+
+        /** \brief Reads a little-endian uint32. */
+        static inline uint32_t readU32
+        (const unsigned char * p) {
+            return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        }
+
+        /** \brief Reads a little-endian uint64. */
+        static inline uint64_t readU64
+        (const unsigned char * p) {
+            return uint64_t(readU32(p)) | (uint64_t(readU32(p + 4)) << 32);
+        }
+
+        /** \brief Reads a little-endian float32. */
+        static inline float readF32
+        (const unsigned char * p) {
+            const uint32_t u = readU32(p);
+            float f;
+            std::memcpy(&f, &u, 4);
+            return f;
+        }
+
+        /** \brief Reads a little-endian float64. */
+        static inline double readF64
+        (const unsigned char * p) {
+            const uint64_t u = readU64(p);
+            double d;
+            std::memcpy(&d, &u, 8);
+            return d;
+        }
+
+        /** \brief Writes a little-endian uint32. */
+        static inline void writeU32
+        (unsigned char * p, uint32_t u) {
+            for (unsigned int i = 0; i < 4; ++i)
+                p[i] = (u >> (8*i)) & 0xff;
+        }
+
+        /** \brief Writes a little-endian uint64. */
+        static inline void writeU64
+        (unsigned char * p, uint64_t u) {
+            writeU32(p, uint32_t(u));
+            writeU32(p + 4, uint32_t(u >> 32));
+        }
+
+        /** \brief Writes a little-endian float32. */
+        static inline void writeF32
+        (unsigned char * p, float f) {
+            uint32_t u;
+            std::memcpy(&u, &f, 4);
+            writeU32(p, u);
+        }
+
+        /** \brief Writes a little-endian float64. */
+        static inline void writeF64
+        (unsigned char * p, double d) {
+            uint64_t u;
+            std::memcpy(&u, &d, 8);
+            writeU64(p, u);
+        }
+};
+
+#endif /* GRIDBINARY_HPP_ */
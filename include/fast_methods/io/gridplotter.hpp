@@ -58,7 +58,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
         template<class T, size_t ndims> 
         static void plotMap
-        (nDGridMap<T, ndims> & grid, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             CImg<bool> img(d[0],d[1],1,1,0);
             // Filling the image flipping Y dim. We want now top left to be the (0,0).
@@ -81,7 +81,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
         template<class T, size_t ndims>
         static void plotOccupancyMap
-        (nDGridMap<T, ndims> & grid, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             CImg<double> img(d[0],d[1],1,1,0);
             // Filling the image flipping Y dim. We want now top left to be the (0,0).
@@ -101,7 +101,7 @@ class GridPlotter {
            IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getValue() method. */
         template<class T, size_t ndims = 2>
         static void plotArrivalTimes
-        (nDGridMap<T, ndims> & grid, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             double max_val = grid.getMaxValue();
             CImg<double> img(d[0],d[1],1,1,0);
@@ -123,7 +123,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
         template<class T, size_t ndims = 2>
         static void plotMapPath
-        (nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             CImg<double> img(d[0],d[1],1,3,0);
 
@@ -151,7 +151,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
         template<class T, size_t ndims = 2>
         static void plotOccupancyPath
-        (nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             CImg<double> img(d[0],d[1],1,3,0);
             // Filling the image flipping Y dim. We want now top left to be the (0,0).
@@ -177,7 +177,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
         template<class T, size_t ndims = 2>
         static void plotMapPaths
-        (nDGridMap<T, ndims> & grid, const Paths2D & paths, std::string name = "") {
+        (const nDGridMap<T, ndims> & grid, const Paths2D & paths, std::string name = "") {
             std::array<unsigned int,2> d = grid.getDimSizes();
             CImg<double> img(d[0],d[1],1,3,0);
 
@@ -209,7 +209,7 @@ class GridPlotter {
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getOccupancy() method. */
       template<class T, size_t ndims = 2>
       static void plotArrivalTimesPath
-      (nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
+      (const nDGridMap<T, ndims> & grid, const Path2D & path, std::string name = "") {
           std::array<unsigned int,2> d = grid.getDimSizes();
           double max_val = grid.getMaxValue();
           CImg<double> img(d[0],d[1],1,1,0);
@@ -233,7 +233,7 @@ class GridPlotter {
           IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool getValue() method. */
        template<class T, size_t ndims = 2>
        static void plotFMStates
-       (nDGridMap<T, ndims> & grid, std::string name = "") {
+       (const nDGridMap<T, ndims> & grid, std::string name = "") {
            std::array<unsigned int,2> d = grid.getDimSizes();
            //double max_val = grid.getMaxValue();
            CImg<unsigned int> img(d[0],d[1],1,1,0);
@@ -21,8 +21,53 @@
 #define GRIDWRITER_H_
 
 #include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
+#include <fast_methods/io/gridbinary.hpp>
+#include <fast_methods/io/compression.h>
+#include <fast_methods/console/console.h>
+
+/** \brief Formats in which GridWriter saves grids: text (.grid), binary (.fmgrid, see GridBinary)
+    and binary compressed with zstd (.fmgrid.zst, see compression.h). */
+enum GridFormat {GRID_TEXT = 0, GRID_BINARY, GRID_COMPRESSED};
+
+/** \brief Copy of the values or velocities of a grid in row-major order, with the information of
+    the header of the files, so that it can be saved after the grid changes (see AsyncGridWriter). */
+template <typename T> struct GridSnapshot {
+    /** \brief Type of the cells (first line of text files). */
+    std::string                 type;
+
+    /** \brief Leaf size of the grid. */
+    double                      leafsize;
+
+    /** \brief Size of the dimensions. */
+    std::vector<unsigned int>   dimsize;
+
+    /** \brief GridBinary::PAYLOAD_VALUES or GridBinary::PAYLOAD_VELOCITIES. */
+    uint32_t                    payload;
+
+    /** \brief Values of the cells in row-major order. */
+    std::vector<T>              values;
+
+    /** \brief Copies the values (payload GridBinary::PAYLOAD_VALUES) or the velocities of grid. */
+    template <class grid_t>
+    void copy
+    (const grid_t & grid, uint32_t p = GridBinary::PAYLOAD_VALUES) {
+        type = grid.getCell(0).type();
+        leafsize = grid.getLeafSize();
+        const std::array<unsigned int, grid_t::getNDims()> d = grid.getDimSizes();
+        dimsize.assign(d.begin(), d.end());
+        payload = p;
+        values.resize(grid.getNumberOfCells());
+        for (unsigned int i = 0; i < values.size(); ++i) {
+            const unsigned int idx = grid.rowMajor2idx(i);
+            values[i] = (p == GridBinary::PAYLOAD_VALUES) ? grid.getCell(idx).getValue() : grid.getCell(idx).getVelocity();
+        }
+    }
+};
 
 // TODO: include checks which ensure that the grids are adecuate for the functions used.
 // TODO: there should be a check when writing grid: it is written already? erase and write. Something like that.
@@ -45,21 +90,10 @@ class GridWriter {
             Use the parsegrid.m Matlab script to parse the data. */
         template <class T, size_t ndims>
         static void saveGridValues
-        (const char * filename, nDGridMap<T, ndims> & grid) {
-            std::ofstream ofs;
-            ofs.open (filename,  std::ofstream::out | std::ofstream::trunc);
-
-            ofs << grid.getCell(0).type() << '\n';
-            ofs << grid.getLeafSize() << '\n' << ndims;
-
-            std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
-            for (unsigned int i = 0; i < ndims; ++i)
-                ofs << '\n' << dimsize[i] << "\t";
-
-            for (unsigned int i = 0; i < grid.size(); ++i)
-                ofs << '\n' << grid.getCell(i).getValue();
-
-            ofs.close();
+        (const char * filename, const nDGridMap<T, ndims> & grid) {
+            const std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
+            saveText(filename, grid.getCell(0).type(), grid.getLeafSize(), dimsize.size(), dimsize.data(), grid.getNumberOfCells(),
+                     [&grid] (unsigned int i) { return grid.getCell(grid.rowMajor2idx(i)).getValue(); });
         }
 
         /** \brief Saves grid velocities in ASCII format into the specified file.
@@ -79,21 +113,65 @@ class GridWriter {
             Use the parsegrid.m Matlab script to parse the data. */
         template <class T, size_t ndims>
         static void saveVelocities
-        (const char * filename, nDGridMap<T, ndims> & grid) {
-            std::ofstream ofs;
-            ofs.open (filename,  std::ofstream::out | std::ofstream::trunc);
+        (const char * filename, const nDGridMap<T, ndims> & grid) {
+            const std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
+            saveText(filename, grid.getCell(0).type(), grid.getLeafSize(), dimsize.size(), dimsize.data(), grid.getNumberOfCells(),
+                     [&grid] (unsigned int i) { return grid.getCell(grid.rowMajor2idx(i)).getVelocity(); });
+        }
 
-            ofs << grid.getCell(0).type() << '\n';
-            ofs << grid.getLeafSize() << '\n' << ndims;
+        /** \brief Saves grid velocities in the binary .fmgrid format (see GridBinary), which
+            MapLoader::loadMapFromBinary() loads. Values are saved in the precision of the grid.
+            If compress is true the file is compressed with zstd (if the library was built
+            with it, see compression.h). */
+        template <class T, size_t ndims>
+        static void saveVelocitiesBinary
+        (const char * filename, const nDGridMap<T, ndims> & grid, bool compress = false) {
+            typedef typename nDGridMap<T, ndims>::value_t value_t;
+            const std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
+            saveBinary<value_t>(filename, grid.getLeafSize(), dimsize.size(), dimsize.data(), grid.getNumberOfCells(),
+                                GridBinary::PAYLOAD_VELOCITIES, compress,
+                                [&grid] (unsigned int i) { return grid.getCell(grid.rowMajor2idx(i)).getVelocity(); });
+        }
 
-            std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
-            for (unsigned int i = 0; i < ndims; ++i)
-                ofs << '\n' << dimsize[i] << "\t";
+        /** \brief Saves grid values (arrival times) in the binary .fmgrid format (see GridBinary),
+            in the precision of the grid, compressed with zstd if compress is true. */
+        template <class T, size_t ndims>
+        static void saveGridValuesBinary
+        (const char * filename, const nDGridMap<T, ndims> & grid, bool compress = false) {
+            typedef typename nDGridMap<T, ndims>::value_t value_t;
+            const std::array<unsigned int, ndims> dimsize = grid.getDimSizes();
+            saveBinary<value_t>(filename, grid.getLeafSize(), dimsize.size(), dimsize.data(), grid.getNumberOfCells(),
+                                GridBinary::PAYLOAD_VALUES, compress,
+                                [&grid] (unsigned int i) { return grid.getCell(grid.rowMajor2idx(i)).getValue(); });
+        }
 
-            for (unsigned int i = 0; i < grid.size(); ++i)
-                ofs << '\n' << grid.getCell(i).getVelocity();
+        /** \brief Saves grid values in the given format. */
+        template <class T, size_t ndims>
+        static void saveGridValues
+        (const char * filename, const nDGridMap<T, ndims> & grid, GridFormat format) {
+            if (format == GRID_TEXT)
+                saveGridValues(filename, grid);
+            else
+                saveGridValuesBinary(filename, grid, format == GRID_COMPRESSED);
+        }
 
-            ofs.close();
+        /** \brief Saves a snapshot of a grid in the given format, as the functions above save the grid. */
+        template <typename T>
+        static void save
+        (const char * filename, const GridSnapshot<T> & snap, GridFormat format) {
+            const std::vector<T> & values = snap.values;
+            auto value = [&values] (unsigned int i) { return values[i]; };
+            if (format == GRID_TEXT)
+                saveText(filename, snap.type, snap.leafsize, snap.dimsize.size(), snap.dimsize.data(), values.size(), value);
+            else
+                saveBinary<T>(filename, snap.leafsize, snap.dimsize.size(), snap.dimsize.data(), values.size(),
+                              snap.payload, format == GRID_COMPRESSED, value);
+        }
+
+        /** \brief Returns the extension of the files of format. */
+        static const char * extension
+        (GridFormat format) {
+            return (format == GRID_TEXT) ? ".grid" : ((format == GRID_BINARY) ? ".fmgrid" : ".fmgrid.zst");
         }
 
         /** \brief Saves the 2D path in an ASCII file with the following format:
@@ -109,7 +187,7 @@ class GridWriter {
             Use the parsegrid.m and parsepath.m Matlab scripts to parse the data. */
         template <class T, size_t ndims>
         static void savePath
-        (const char * filename, nDGridMap<T, ndims> & grid, std::vector< std::array<double,ndims> > & path) {
+        (const char * filename, const nDGridMap<T, ndims> & grid, std::vector< std::array<double,ndims> > & path) {
             std::ofstream ofs;
             ofs.open (filename,  std::ofstream::out | std::ofstream::trunc);
 
@@ -141,7 +219,7 @@ class GridWriter {
             Use the parsegrid.m and parsepathvelocity.m Matlab scripts to parse the data. */
         template <class T, size_t ndims>
         static void savePathVelocity
-        (const char * filename, nDGridMap<T, ndims> & grid, std::vector< std::array<double,ndims> > & path, std::vector <double> path_velocity) {
+        (const char * filename, const nDGridMap<T, ndims> & grid, std::vector< std::array<double,ndims> > & path, std::vector <double> path_velocity) {
             std::ofstream ofs;
             ofs.open (filename,  std::ofstream::out | std::ofstream::trunc);
 
@@ -160,6 +238,93 @@ class GridWriter {
 
             ofs.close();
         }
+
+    private:
+        /** \brief Saves n values, value(i) for i in row-major order, in ASCII format. */
+        template <class F>
+        static void saveText
+        (const char * filename, const std::string & type, double leafsize, size_t ndims, const unsigned int * dimsize,
+         size_t n, const F & value) {
+            std::ofstream ofs;
+            ofs.open (filename,  std::ofstream::out | std::ofstream::trunc);
+
+            ofs << type << '\n';
+            ofs << leafsize << '\n' << ndims;
+
+            for (unsigned int i = 0; i < ndims; ++i)
+                ofs << '\n' << dimsize[i] << "\t";
+
+            for (unsigned int i = 0; i < n; ++i)
+                ofs << '\n' << value(i);
+
+            ofs.close();
+        }
+
+        /** \brief Saves n values of type value_t, value(i) for i in row-major order, in the binary format.
+            Compressed files are built in memory and compressed at once. */
+        template <typename value_t, class F>
+        static void saveBinary
+        (const char * filename, double leafsize, size_t ndims, const unsigned int * dimsize, size_t n,
+         uint32_t payload, bool compress, const F & value) {
+            const bool single = sizeof(value_t) == 4;
+            const size_t bytes = single ? 4 : 8;
+
+            std::vector<unsigned char> header(GridBinary::dataOffset(ndims), 0);
+            std::memcpy(header.data(), GridBinary::magic(), 8);
+            GridBinary::writeU32(&header[8], GridBinary::VERSION);
+            GridBinary::writeU32(&header[12], ndims);
+            GridBinary::writeU32(&header[16], single ? GridBinary::DTYPE_FLOAT32 : GridBinary::DTYPE_FLOAT64);
+            GridBinary::writeU32(&header[20], payload);
+            GridBinary::writeF64(&header[24], leafsize);
+            for (unsigned int i = 0; i < ndims; ++i)
+                GridBinary::writeU32(&header[GridBinary::FIXED_HEADER + 4*i], dimsize[i]);
+
+            if (compress && !compression::available()) {
+                console::warning("GridWriter: built without zstd, saving the grid uncompressed.");
+                compress = false;
+            }
+
+            std::ofstream ofs;
+            ofs.open (filename,  std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+            if (compress) {
+                std::vector<unsigned char> file(header);
+                file.resize(header.size() + n*bytes);
+                encodeValues<value_t>(&file[header.size()], 0, n, value);
+                std::vector<unsigned char> compressed;
+                if (compression::compress(file.data(), file.size(), compressed))
+                    ofs.write(reinterpret_cast<const char *>(compressed.data()), compressed.size());
+                else {
+                    console::warning("GridWriter: compression failed, saving the grid uncompressed.");
+                    ofs.write(reinterpret_cast<const char *>(file.data()), file.size());
+                }
+                ofs.close();
+                return;
+            }
+
+            ofs.write(reinterpret_cast<const char *>(header.data()), header.size());
+
+            // Values are written in chunks.
+            std::vector<unsigned char> chunk(bytes*4096);
+            for (size_t i = 0; i < n; i += 4096) {
+                const size_t m = std::min<size_t>(4096, n - i);
+                encodeValues<value_t>(chunk.data(), i, m, value);
+                ofs.write(reinterpret_cast<const char *>(chunk.data()), m*bytes);
+            }
+
+            ofs.close();
+        }
+
+        /** \brief Writes value(first) ... value(first + n - 1) little-endian into out. */
+        template <typename value_t, class F>
+        static void encodeValues
+        (unsigned char * out, size_t first, size_t n, const F & value) {
+            for (size_t j = 0; j < n; ++j) {
+                if (sizeof(value_t) == 4)
+                    GridBinary::writeF32(out + 4*j, value(first + j));
+                else
+                    GridBinary::writeF64(out + 8*j, value(first + j));
+            }
+        }
 };
 
 #endif /* GRIDWRITER_H_ */
@@ -0,0 +1,294 @@
+/*! \class MapGenerator
+    \brief Auxiliar static class which generates synthetic maps of any size and number of dimensions
+    into nDGridMap, to benchmark the solvers on parametrized problems (see BenchmarkSuite).
+
+    Obstacles are:
+    - NO_OBSTACLES: free space.
+    - RANDOM_OBSTACLES: every cell is an obstacle with probability density.
+    - MAZE_OBSTACLES: a perfect maze (every free cell reachable from every other, by a single path
+      between rooms) carved by a randomized depth-first search on a lattice of rooms, with corridors
+      of 1/density - 1 cells and walls of 1 cell, which gives a density of walls of about density
+      in 2D (more in higher dimensions).
+    - BARRIER_OBSTACLES: walls of 1 cell across dimension 0 every 1/density cells, each one with a
+      door of a tenth of the size of every other dimension at a random position.
+
+    Velocities (the occupancy of free cells) are:
+    - UNIFORM_VELOCITY: 1.
+    - SMOOTH_VELOCITY: 1 + 0.5*prod(sin(4*pi*x_d/size_d)), in [0.5, 1.5].
+    - PIECEWISE_VELOCITY: 8 blocks per dimension, each one with a random velocity among 0.25, 0.5, 1
+      and 2.
+
+    The same seed generates the same map, whatever the number of threads filling it: random
+    values are hashes of the seed and the coordinates, not drawn from a shared generator.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPGENERATOR_HPP_
+#define MAPGENERATOR_HPP_
+
+#include <vector>
+#include <array>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/ndgridmap.hpp>
+
+/** \brief Obstacles of the maps generated by MapGenerator. */
+enum ObstacleMap {NO_OBSTACLES = 0, RANDOM_OBSTACLES, MAZE_OBSTACLES, BARRIER_OBSTACLES};
+
+/** \brief Velocities of the maps generated by MapGenerator. */
+enum VelocityField {UNIFORM_VELOCITY = 0, SMOOTH_VELOCITY, PIECEWISE_VELOCITY};
+
+class MapGenerator {
+    public:
+        /** \brief Resizes the grid to dimsize and fills it with the obstacles and velocities given.
+
+            @param grid nDGridMap of any number of dimensions (2 at least)
+            @param dimsize size of every dimension
+            @param obstacles kind of obstacles
+            @param density density of the obstacles, in (0,1) (ignored for NO_OBSTACLES)
+            @param velocities velocity field of the free cells
+            @param seed seed of the random obstacles, doors, mazes and velocities
+            @param nthreads threads filling the grid, 0 for as many as hardware threads. */
+        template<class T, size_t ndims>
+        static void generate
+        (nDGridMap<T, ndims> & grid, const std::array<unsigned int, ndims> & dimsize, ObstacleMap obstacles,
+         double density, VelocityField velocities, uint64_t seed = 1, unsigned int nthreads = 0) {
+            static_assert(ndims >= 2 && ndims <= 8, "Maps are generated for 2 to 8 dimensions.");
+            grid.resize(dimsize);
+            density = std::min(std::max(density, 1e-6), 1.0);
+
+            // Corridors of the maze, or separation of the barriers, and their doors.
+            const unsigned int period = (obstacles == MAZE_OBSTACLES) ?
+                std::max(2u, unsigned(std::lround(1/density))) : std::max(1u, unsigned(std::lround(1/density)));
+            std::array<unsigned int, ndims> rooms, doorSize;
+            for (unsigned int d = 0; d < ndims; ++d) {
+                rooms[d] = (dimsize[d] + period - 1) / period;
+                doorSize[d] = std::max(1u, dimsize[d] / 10);
+            }
+            std::vector<uint8_t> passages;
+            if (obstacles == MAZE_OBSTACLES)
+                carveMaze(rooms, seed, passages);
+
+            OccupancyBitmap obs(grid.size());
+            grid.setOccupancies([&] (unsigned int r, unsigned int x) {
+                std::array<unsigned int, ndims> c;
+                c[0] = x;
+                for (unsigned int d = 1; d < ndims; ++d) {
+                    c[d] = r % dimsize[d];
+                    r /= dimsize[d];
+                }
+                return isObstacle(c, dimsize, obstacles, density, period, rooms, passages, doorSize, seed) ?
+                    0. : velocity(c, dimsize, velocities, seed);
+            }, obs, 0, std::numeric_limits<unsigned int>::max(), nthreads);
+            grid.setOccupiedCells(std::move(obs));
+        }
+
+        /** \brief Returns the indices of n different free cells of the grid chosen at random (fewer if there
+            are not so many free cells). */
+        template<class T, size_t ndims>
+        static std::vector<unsigned int> randomFreeCells
+        (const nDGridMap<T, ndims> & grid, unsigned int n, uint64_t seed = 1) {
+            std::vector<unsigned int> cells;
+            std::vector<bool> taken(grid.getNumberOfCells(), false);
+            const size_t free = grid.getNumberOfCells() - grid.getNumberOfOccupiedCells();
+            for (unsigned int k = 0; k < n && cells.size() < free; ++k) {
+                // From a random cell in row-major order to the next free one not taken.
+                unsigned int i = hash(seed, 0x5EED + k) % grid.getNumberOfCells();
+                while (taken[i] || grid[grid.rowMajor2idx(i)].isOccupied())
+                    i = (i + 1) % grid.getNumberOfCells();
+                taken[i] = true;
+                cells.push_back(grid.rowMajor2idx(i));
+            }
+            return cells;
+        }
+
+        /** \brief Parses the name of the obstacles (none, random, maze or barriers). Returns false if unknown. */
+        static bool parseObstacles
+        (const std::string & s, ObstacleMap & o) {
+            for (unsigned int i = 0; i < 4; ++i)
+                if (s == name(ObstacleMap(i))) {
+                    o = ObstacleMap(i);
+                    return true;
+                }
+            return false;
+        }
+
+        /** \brief Parses the name of the velocities (uniform, smooth or piecewise). Returns false if unknown. */
+        static bool parseVelocities
+        (const std::string & s, VelocityField & v) {
+            for (unsigned int i = 0; i < 3; ++i)
+                if (s == name(VelocityField(i))) {
+                    v = VelocityField(i);
+                    return true;
+                }
+            return false;
+        }
+
+        /** \brief Returns the name of the obstacles. */
+        static const char * name
+        (ObstacleMap o) {
+            static const char * names[] = {"none", "random", "maze", "barriers"};
+            return names[o];
+        }
+
+        /** \brief Returns the name of the velocities. */
+        static const char * name
+        (VelocityField v) {
+            static const char * names[] = {"uniform", "smooth", "piecewise"};
+            return names[v];
+        }
+
+    private:
+        /** \brief Mixes seed and v (splitmix64). */
+        static inline uint64_t hash
+        (uint64_t seed, uint64_t v) {
+            uint64_t z = seed*0x9E3779B97F4A7C15ull + v + 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /** \brief Returns a value in [0,1) from seed and v. */
+        static inline double uniform
+        (uint64_t seed, uint64_t v) {
+            return (hash(seed, v) >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        /** \brief Row-major index of c in a lattice of size dimsize. */
+        template <size_t ndims>
+        static inline uint64_t index
+        (const std::array<unsigned int, ndims> & c, const std::array<unsigned int, ndims> & dimsize) {
+            uint64_t i = 0;
+            for (unsigned int d = ndims; d-- > 0;)
+                i = i*dimsize[d] + c[d];
+            return i;
+        }
+
+        /** \brief Carves a perfect maze in a lattice of rooms with a randomized depth-first search: bit d of
+            passages[i] is set if room i is open to the next room in dimension d. */
+        template <size_t ndims>
+        static void carveMaze
+        (const std::array<unsigned int, ndims> & rooms, uint64_t seed, std::vector<uint8_t> & passages) {
+            size_t nrooms = 1;
+            std::array<size_t, ndims> stride;
+            for (unsigned int d = 0; d < ndims; ++d) {
+                stride[d] = nrooms;
+                nrooms *= rooms[d];
+            }
+            passages.assign(nrooms, 0);
+            std::vector<bool> visited(nrooms, false);
+            std::vector<size_t> stack(1, 0);
+            visited[0] = true;
+            std::mt19937_64 rng(seed);
+            std::array<size_t, 2*ndims> next;
+            while (!stack.empty()) {
+                const size_t room = stack.back();
+                unsigned int n = 0;
+                for (unsigned int d = 0; d < ndims; ++d) {
+                    const unsigned int c = (room / stride[d]) % rooms[d];
+                    if (c > 0 && !visited[room - stride[d]])
+                        next[n++] = 2*d;
+                    if (c + 1 < rooms[d] && !visited[room + stride[d]])
+                        next[n++] = 2*d + 1;
+                }
+                if (n == 0) {
+                    stack.pop_back();
+                    continue;
+                }
+                const size_t dir = next[rng() % n], d = dir / 2;
+                const size_t neighbor = (dir & 1) ? room + stride[d] : room - stride[d];
+                passages[std::min(room, neighbor)] |= uint8_t(1u << d);
+                visited[neighbor] = true;
+                stack.push_back(neighbor);
+            }
+        }
+
+        /** \brief Returns true if the cell of coordinates c is an obstacle. */
+        template <size_t ndims>
+        static bool isObstacle
+        (const std::array<unsigned int, ndims> & c, const std::array<unsigned int, ndims> & dimsize, ObstacleMap obstacles,
+         double density, unsigned int period, const std::array<unsigned int, ndims> & rooms,
+         const std::vector<uint8_t> & passages, const std::array<unsigned int, ndims> & doorSize, uint64_t seed) {
+            switch (obstacles) {
+                case RANDOM_OBSTACLES:
+                    return uniform(seed, index(c, dimsize)) < density;
+                case MAZE_OBSTACLES:
+                {
+                    // Walls are the last cell of every room in each dimension: cells in more than one wall
+                    // are pillars, and cells in one are open if the passage to the next room was carved.
+                    std::array<unsigned int, ndims> room;
+                    unsigned int walls = 0, wall = 0;
+                    for (unsigned int d = 0; d < ndims; ++d) {
+                        room[d] = c[d] / period;
+                        if (c[d] % period == period - 1) {
+                            ++walls;
+                            wall = d;
+                        }
+                    }
+                    if (walls == 0)
+                        return false;
+                    if (walls > 1 || room[wall] + 1 >= rooms[wall])
+                        return true;
+                    return !(passages[index(room, rooms)] & (1u << wall));
+                }
+                case BARRIER_OBSTACLES:
+                {
+                    if (c[0] % period != period/2 || c[0] == 0)
+                        return false;
+                    const unsigned int barrier = c[0] / period;
+                    for (unsigned int d = 1; d < ndims; ++d) {
+                        const unsigned int first = hash(seed, uint64_t(barrier)*ndims + d) % (dimsize[d] - doorSize[d] + 1);
+                        if (c[d] < first || c[d] >= first + doorSize[d])
+                            return true;
+                    }
+                    return false;
+                }
+                default:
+                    return false;
+            }
+        }
+
+        /** \brief Returns the velocity of the free cell of coordinates c. */
+        template <size_t ndims>
+        static double velocity
+        (const std::array<unsigned int, ndims> & c, const std::array<unsigned int, ndims> & dimsize, VelocityField velocities,
+         uint64_t seed) {
+            switch (velocities) {
+                case SMOOTH_VELOCITY:
+                {
+                    double v = 0.5;
+                    for (unsigned int d = 0; d < ndims; ++d)
+                        v *= std::sin(4*M_PI*(c[d] + 0.5)/dimsize[d]);
+                    return 1 + v;
+                }
+                case PIECEWISE_VELOCITY:
+                {
+                    static const double speeds[] = {0.25, 0.5, 1, 2};
+                    std::array<unsigned int, ndims> block, blocks;
+                    for (unsigned int d = 0; d < ndims; ++d) {
+                        blocks[d] = 8;
+                        block[d] = std::min(7u, unsigned(uint64_t(c[d])*8/dimsize[d]));
+                    }
+                    return speeds[hash(seed, 0xB10C + index(block, blocks)) % 4];
+                }
+                default:
+                    return 1;
+            }
+        }
+};
+
+#endif /* MAPGENERATOR_HPP_ */
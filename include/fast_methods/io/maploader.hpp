@@ -20,9 +20,23 @@
 #ifndef MAPLOADER_H_
 #define MAPLOADER_H_
 
+#include <fstream>
+#include <vector>
+#include <array>
+#include <string>
+#include <limits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <CImg.h>
 
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
+#include <fast_methods/io/gridbinary.hpp>
+#include <fast_methods/io/compression.h>
 
 
 using namespace cimg_library;
@@ -35,36 +49,88 @@ class MapLoader {
         /** \brief Loads the initial binary map for a given grid. It is based on the
             nDGridMap::setOccupancy() which has to be bool valued.
 
-            The image should be 256bits grayscale and only 2D grids should be passed.
+            The image should be 256bits grayscale. 2D grids are loaded from images and 3D grids
+            from volumes, multi-slice files CImg reads (multi-page TIFF, Analyze/NIfTI,
+            INRIMAGE, .cimg...), slice z being the z coordinate. Occupancies are pixel/255.
 
-            It also stores all the false values as initial points for a later compute() function in FM2.
+            The pixels are converted in a single pass over the buffer of the image, its rows split
+            among nthreads threads (see nDGridMap::setOccupancies()), which also finds the occupied
+            cells.
 
             The Y dimension flipping is because nDGridMap works in X-Y coordinates, not in image indices as CImg.
 
             IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool setOccupancy() method.
 
             @param filename file to be open
-            @param grid 2D nDGridmap
-            @param init_points stores the indices of all the values which are false. */
+            @param grid 2D or 3D nDGridmap
+            @param nthreads threads converting the pixels, 0 for as many as hardware threads. */
         template<class T, size_t ndims>
         static void loadMapFromImg
-        (const char * filename, nDGridMap<T, ndims> & grid) {
-            std::vector<unsigned int> obs;
-            CImg<double> img(filename);
+        (const char * filename, nDGridMap<T, ndims> & grid, unsigned int nthreads = 0) {
+            // Pixels are read as floats, which hold 8 and 16 bits pixels exactly, to halve the memory of volumes.
+            CImg<float> img(filename);
             std::array<unsigned int, ndims> dimsize;
+            dimsize.fill(1);
             dimsize[0] = img.width();
             dimsize[1] = img.height();
+            if (ndims > 2)
+                dimsize[2] = img.depth();
             grid.resize(dimsize);
 
             // Filling the grid flipping Y dim. We want bottom left to be the (0,0).
-            cimg_forXY(img,x,y) {
-                double occupancy = img(x,y)/255;
-                unsigned int idx = img.width()*(img.height()-y-1)+x;
-                grid[idx].setOccupancy(occupancy);
-                if (grid[idx].isOccupied())
-                    obs.push_back(idx);
+            const float * data = img.data();
+            const unsigned int w = img.width(), h = img.height();
+            OccupancyBitmap obs(grid.size());
+            grid.setOccupancies([data, w, h] (unsigned int r, unsigned int x) {
+                const size_t z = r / h, y = h - (r % h) - 1;
+                return double(data[x + w*(y + h*z)]) / 255;
+            }, obs, 0, std::numeric_limits<unsigned int>::max(), nthreads);
+            grid.setOccupiedCells(std::move(obs));
+        }
+
+        /** \brief Loads a 3D grid from a stack of 2D images, slices[z] being the slice of coordinate z, as
+            loadMapFromImg() loads each of them. Slices are read one at a time. All the images must have
+            the same size.
+
+            @param slices files of the slices, by increasing z
+            @param grid 3D nDGridmap
+            @param nthreads threads converting the pixels, 0 for as many as hardware threads.
+            @return 1 if the grid was loaded, 0 otherwise. */
+        template<class T, size_t ndims>
+        static int loadMapFromImageStack
+        (const std::vector<std::string> & slices, nDGridMap<T, ndims> & grid, unsigned int nthreads = 0) {
+            if (ndims != 3) {
+                console::error("Image stacks can only be loaded into 3D grids.");
+                return 0;
+            }
+            if (slices.empty()) {
+                console::error("No slices given.");
+                return 0;
+            }
+            std::array<unsigned int, ndims> dimsize;
+            OccupancyBitmap obs;
+            for (unsigned int z = 0; z < slices.size(); ++z) {
+                CImg<float> img(slices[z].c_str());
+                const unsigned int w = img.width(), h = img.height();
+                if (z == 0) {
+                    dimsize.fill(1);
+                    dimsize[0] = w;
+                    dimsize[1] = h;
+                    dimsize[ndims - 1] = slices.size();
+                    grid.resize(dimsize);
+                    obs.resize(grid.size());
+                }
+                else if (w != dimsize[0] || h != dimsize[1]) {
+                    console::error("Slice " + slices[z] + " has a different size than the first one.");
+                    return 0;
                 }
+                const float * data = img.data();
+                grid.setOccupancies([data, w, h] (unsigned int r, unsigned int x) {
+                    return double(data[x + w*(h - (r % h) - 1)]) / 255;
+                }, obs, z*h, h, nthreads);
+            }
             grid.setOccupiedCells(std::move(obs));
+            return 1;
         }
 
         /** \brief Loads the initial binary map for a given grid. It is based on the
@@ -95,7 +161,6 @@ class MapLoader {
         static int loadMapFromText
         (const char * filename, nDGridMap<T, ndims> & grid) {
             std::ifstream file;
-            std::vector<unsigned int> obs;
             file.open(filename);
 
             if (file.is_open())
@@ -122,14 +187,16 @@ class MapLoader {
                 grid.resize(dimsize);
                 grid.setLeafSize(leafsize);
 
+                OccupancyBitmap obs(grid.size());
                 double occupancy;
-                for (unsigned int i = 0; i < grid.size(); ++i)
+                for (unsigned int i = 0; i < grid.getNumberOfCells(); ++i)
                 {
                     file >> occupancy;
-                    grid[i].setOccupancy(occupancy);
+                    const unsigned int idx = grid.rowMajor2idx(i);
+                    grid[idx].setOccupancy(occupancy);
 
-                    if (grid[i].isOccupied())
-                        obs.push_back(i);
+                    if (grid[idx].isOccupied())
+                        obs.set(idx);
                 }
                 grid.setOccupiedCells(std::move(obs));
                 return 1;
@@ -140,6 +207,121 @@ class MapLoader {
                 return 0;
             }
         }
+
+        /** \brief Loads the velocities map of a binary .fmgrid file (see GridBinary), as saved by
+            GridWriter::saveVelocitiesBinary(). The file is memory-mapped and the cells are filled
+            directly from the mapping, in row-major order for any layout of the grid. Values of
+            either precision are converted to the precision of the grid. Compressed files are
+            decompressed in memory first (see compression.h).
+
+            IMPORTANT NOTE: no type-checkings are done. T type has to be Cell or any class with bool setOccupancy() method.
+
+            @param filename binary file to be open
+            @param grid nDGridmap of the dimensions of the file
+            @return 1 if the grid was loaded, 0 otherwise. */
+        template<class T, size_t ndims>
+        static int loadMapFromBinary
+        (const char * filename, nDGridMap<T, ndims> & grid) {
+            const int fd = open(filename, O_RDONLY);
+            if (fd < 0) {
+                console::error("File not found.");
+                return 0;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || size_t(st.st_size) < GridBinary::dataOffset(0)) {
+                console::error("Not a binary grid file.");
+                close(fd);
+                return 0;
+            }
+            const size_t length = st.st_size;
+            void * map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED) {
+                console::error("Binary grid file could not be mapped.");
+                return 0;
+            }
+            madvise(map, length, MADV_SEQUENTIAL);
+
+            const unsigned char * data = static_cast<const unsigned char *>(map);
+            int loaded = 0;
+            if (compression::isCompressed(data, length)) {
+                std::vector<unsigned char> file;
+                if (!compression::available())
+                    console::error("The binary grid file is compressed and the library was built without zstd.");
+                else if (!compression::decompress(data, length, file))
+                    console::error("The binary grid file could not be decompressed.");
+                else
+                    loaded = loadMapFromBinary(file.data(), file.size(), grid);
+            }
+            else
+                loaded = loadMapFromBinary(data, length, grid);
+            munmap(map, length);
+            return loaded;
+        }
+
+    private:
+        /** \brief Loads a binary .fmgrid file of length bytes given in data. */
+        template<class T, size_t ndims>
+        static int loadMapFromBinary
+        (const unsigned char * data, size_t length, nDGridMap<T, ndims> & grid) {
+            if (length < GridBinary::dataOffset(ndims)) {
+                console::error("Not a binary grid file.");
+                return 0;
+            }
+            if (std::memcmp(data, GridBinary::magic(), 8) != 0) {
+                console::error("Not a binary grid file.");
+                return 0;
+            }
+            if (GridBinary::readU32(data + 8) != GridBinary::VERSION) {
+                console::error("Unsupported version of the binary grid file.");
+                return 0;
+            }
+            if (GridBinary::readU32(data + 12) != ndims) {
+                console::error("Number of dimensions specified does not match the loaded grid.");
+                exit(1);
+            }
+            const uint32_t dtype = GridBinary::readU32(data + 16);
+            const size_t bytes = GridBinary::dtypeSize(dtype);
+            if (bytes == 0 || GridBinary::readU32(data + 20) != GridBinary::PAYLOAD_VELOCITIES) {
+                console::error("The binary grid file does not store velocities of a known type.");
+                return 0;
+            }
+
+            // The cells are checked against the values in the file as they are multiplied, so that
+            // ncells*bytes cannot overflow.
+            const size_t maxCells = (length - GridBinary::dataOffset(ndims)) / bytes;
+            std::array<unsigned int, ndims> dimsize;
+            size_t ncells = 1;
+            for (size_t i = 0; i < ndims; ++i) {
+                dimsize[i] = GridBinary::readU32(data + GridBinary::FIXED_HEADER + 4*i);
+                if (dimsize[i] != 0 && ncells > maxCells / dimsize[i]) {
+                    console::error("The binary grid file is truncated.");
+                    return 0;
+                }
+                ncells *= dimsize[i];
+            }
+            if (length < GridBinary::dataOffset(ndims) + ncells*bytes) {
+                console::error("The binary grid file is truncated.");
+                return 0;
+            }
+
+            grid.resize(dimsize);
+            grid.setLeafSize(GridBinary::readF64(data + 24));
+
+            OccupancyBitmap obs(grid.size());
+            const unsigned char * values = data + GridBinary::dataOffset(ndims);
+            for (unsigned int i = 0; i < grid.getNumberOfCells(); ++i) {
+                const unsigned char * v = values + i*bytes;
+                const double occupancy = (dtype == GridBinary::DTYPE_FLOAT64) ? GridBinary::readF64(v) : GridBinary::readF32(v);
+                const unsigned int idx = grid.rowMajor2idx(i);
+                grid[idx].setOccupancy(occupancy);
+
+                if (grid[idx].isOccupied())
+                    obs.set(idx);
+            }
+            grid.setOccupiedCells(std::move(obs));
+            return 1;
+        }
 };
 
 #endif /* MAPLOADER_H_ */
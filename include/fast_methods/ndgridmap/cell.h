@@ -31,30 +31,40 @@
 
 
 /// \todo No checks are done (out of bounds, etc) to improve efficienty. Overload functions to add optional input checking.
-class Cell {
+/** \brief Generic cell. value_type is the scalar type used to store values and occupancies
+    (double or float). Use the Cell typedef for the double precision version.
 
-    friend std::ostream& operator << (std::ostream & os, Cell & c);
+    Accessors are not virtual: grids store their cells by value and solvers access them through
+    the cell type of the grid, so the calls are inlined and cells have no virtual table pointer.
+    Derived cells hide the members they redefine (as FMCell does with setDefault()). */
+template <class value_type> class CellT {
+
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, CellT<U> & c);
 
     public:
+        /** \brief Scalar type of the values stored in the cell. */
+        typedef value_type value_t;
+
         /** \brief Default constructor: sets value_ to -1 and occupancy_ to true (clear cell, not occupied). */
-        Cell() : value_(-1), occupancy_(1) {}
+        CellT() : value_(-1), occupancy_(1) {}
 
-        Cell(double v, double o = 1) : value_(v), occupancy_(o) {}
+        CellT(value_t v, value_t o = 1) : value_(v), occupancy_(o) {}
 
-        virtual inline void setValue(double v)            {value_ = v;}
-        virtual inline void setOccupancy(double o)        {occupancy_ = o;}
-        virtual std::string type()                        {return std::string("Cell - Basic cell");}
-        virtual inline void setIndex(int i)               {index_ = i;}
+        inline void setValue(value_t v)           {value_ = v;}
+        inline void setOccupancy(value_t o)       {occupancy_ = o;}
+        std::string type() const;
+        inline void setIndex(int i)               {index_ = i;}
 
         /** \brief Sets default values for the cell. Concretely, restarts value_ = -1 but
             occupancy_ is not modified. */
-        virtual void setDefault();
+        inline void setDefault()                  {value_ = -1;}
 
-        virtual inline double getValue() const             {return value_;}
-        virtual inline double getOccupancy() const         {return occupancy_;}
-        virtual inline unsigned int getIndex() const       {return index_;}
+        inline value_t getValue() const            {return value_;}
+        inline value_t getOccupancy() const        {return occupancy_;}
+        inline unsigned int getIndex() const       {return index_;}
 
-        virtual inline bool isOccupied() const {
+        inline bool isOccupied() const {
             if (occupancy_ < utils::COMP_MARGIN)
                 return true;
             return false;
@@ -62,13 +72,25 @@ class Cell {
 
     protected:
         /** \brief Value of the cell. */
-        double value_;
+        value_t value_;
 
         /** \brief Binary occupancy, true means clear, false occupied. */
-        double occupancy_;
+        value_t occupancy_;
 
         /** \briefbIndex within the grid. Useful when used in heaps. */
         unsigned int index_;
 };
 
+/** \brief Double precision cell. */
+typedef CellT<double> Cell;
+
+/** \brief Single precision cell. */
+typedef CellT<float> CellF;
+
+template <> std::string CellT<double>::type() const;
+template <> std::string CellT<float>::type() const;
+
+extern template class CellT<double>;
+extern template class CellT<float>;
+
 #endif /* CELL_H_*/
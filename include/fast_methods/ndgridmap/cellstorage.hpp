@@ -0,0 +1,115 @@
+/*! \class CellStorage
+    \brief Storage policy used by nDGridMap to hold its cells. The default
+    implementation is an array of cell objects (array of structures).
+
+    Cell types which are not stored as objects (for instance, FMCellSoA) specialize
+    this class. The specialization decides which type is returned when a cell is
+    accessed (reference) and which type is used by the heaps to refer to a cell
+    (pointer and const_pointer).
+
+    Copyright (C) 2014 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CELLSTORAGE_HPP_
+#define CELLSTORAGE_HPP_
+
+#include <vector>
+#include <cstddef>
+
+template <class T> class CellStorage {
+
+    public:
+        /** \brief Type returned when accessing a cell. */
+        typedef T &         reference;
+
+        /** \brief Type returned when accessing a cell of a const grid. */
+        typedef const T &   const_reference;
+
+        /** \brief Type used by heaps and queues to refer to a cell. */
+        typedef T *         pointer;
+
+        /** \brief Type used by heaps and queues to refer to a cell which is not modified. */
+        typedef const T *   const_pointer;
+
+        /** \brief True if cells are not allocated until written (see FMCellSparse). */
+        static constexpr bool sparse = false;
+
+        /** \brief True if grids can be solution layers (see nDGridMap::shareEnvironment()). */
+        static constexpr bool layers = false;
+
+        /** \brief Resizes the storage to n cells initialized with default values and
+            sets the index_ member of each of them. */
+        void resize
+        (size_t n) {
+            cells_.clear();
+            cells_.resize(n, T());
+
+            // Setting the index_ member of the cells, which a-priori is unknown.
+            for (size_t i = 0; i < cells_.size(); ++i)
+                cells_[i].setIndex(i);
+        }
+
+        /** \brief Returns the cell with index idx. */
+        inline reference operator[]
+        (size_t idx) {
+            return cells_[idx];
+        }
+
+        /** \brief Returns the cell with index idx. */
+        inline const_reference operator[]
+        (size_t idx) const {
+            return cells_[idx];
+        }
+
+        /** \brief Returns the pointer type the heaps store for the cell with index idx. */
+        inline pointer getPointer
+        (size_t idx) {
+            return &cells_[idx];
+        }
+
+        /** \brief Calls setDefault() on every cell. */
+        void setDefault
+        () {
+            for (T & c : cells_)
+                c.setDefault();
+        }
+
+        /** \brief Returns the number of cells stored. */
+        inline size_t size
+        () const {
+            return cells_.size();
+        }
+
+        /** \brief Returns the number of bytes allocated for the cells. */
+        size_t memory
+        () const {
+            return cells_.capacity()*sizeof(T);
+        }
+
+        /** \brief Erases all the cells. */
+        void clear
+        () {
+            cells_.clear();
+        }
+
+    private:
+        /** \brief Main container. */
+        std::vector<T> cells_;
+};
+
+template <class T> constexpr bool CellStorage<T>::sparse;
+template <class T> constexpr bool CellStorage<T>::layers;
+
+#endif /* CELLSTORAGE_HPP_ */
@@ -0,0 +1,207 @@
+/*! \class ExternalBuffer
+    \brief Description of an array of values of the cells of a grid owned by the caller (for
+    instance, a costmap received from another process): the address of the value of cell
+    (0, 0...), the type of its elements and the offset in bytes between the values of
+    consecutive cells in each dimension.
+
+    Used with FMCellExternal grids (see nDGridMap::setExternalBuffers()), which read and
+    write those values in place instead of copying them. Strides can be negative (for
+    instance, an image with its Y dimension flipped) and are those of a contiguous array
+    in row-major order if not given. Elements must be aligned to their size.
+
+    ExternalArray is the view of a buffer used by the grids: it converts the elements to and
+    from value_t and, if the buffer is contiguous, computes the address of a cell from its index
+    without divisions.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EXTERNALBUFFER_HPP_
+#define EXTERNALBUFFER_HPP_
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cstddef>
+
+class ExternalBuffer {
+
+    public:
+        /** \brief Types of the elements of a buffer. */
+        enum DType {FLOAT32 = 1, FLOAT64 = 2};
+
+        /** \brief No buffer. */
+        ExternalBuffer() : data_(nullptr), dtype_(FLOAT64) {}
+
+        /** @param data address of the value of cell (0, 0...). The caller keeps the buffer alive while it is used.
+            @param dtype type of the elements.
+            @param strides bytes between the values of consecutive cells in each dimension. Empty for a
+                   contiguous array in row-major order. */
+        ExternalBuffer
+        (void * data, DType dtype, const std::vector<std::ptrdiff_t> & strides = std::vector<std::ptrdiff_t>()) :
+            data_(static_cast<char *>(data)), dtype_(dtype), strides_(strides) {}
+
+        /** \brief Buffer of floats. */
+        ExternalBuffer
+        (float * data, const std::vector<std::ptrdiff_t> & strides = std::vector<std::ptrdiff_t>()) :
+            ExternalBuffer(data, FLOAT32, strides) {}
+
+        /** \brief Buffer of doubles. */
+        ExternalBuffer
+        (double * data, const std::vector<std::ptrdiff_t> & strides = std::vector<std::ptrdiff_t>()) :
+            ExternalBuffer(data, FLOAT64, strides) {}
+
+        /** \brief Returns true if there is no buffer. */
+        inline bool empty() const {return data_ == nullptr;}
+
+        inline char * getData() const {return data_;}
+
+        inline DType getDType() const {return dtype_;}
+
+        /** \brief Returns the strides in bytes, empty for a contiguous array in row-major order. */
+        inline const std::vector<std::ptrdiff_t> & getStrides() const {return strides_;}
+
+        /** \brief Returns the size in bytes of the elements of type dtype. */
+        static constexpr std::size_t dtypeSize
+        (DType dtype) {
+            return (dtype == FLOAT32) ? sizeof(float) : sizeof(double);
+        }
+
+    private:
+        /** \brief Address of the value of cell (0, 0...). */
+        char *                          data_;
+
+        /** \brief Type of the elements. */
+        DType                           dtype_;
+
+        /** \brief Bytes between consecutive cells in each dimension. */
+        std::vector<std::ptrdiff_t>     strides_;
+};
+
+/** \brief View of an ExternalBuffer (or of an array of the grid) as the values of the cells of a
+    row-major grid, indexed by the index of the cells. */
+template <class value_t>
+class ExternalArray {
+
+    public:
+        ExternalArray() : base_(nullptr), dtype_(ExternalBuffer::FLOAT64), step_(0) {}
+
+        /** \brief Views buffer as the values of a grid of dimensions dimsize. */
+        template <size_t ndims>
+        void bind
+        (const ExternalBuffer & buffer, const std::array<unsigned int, ndims> & dimsize) {
+            base_ = buffer.getData();
+            dtype_ = buffer.getDType();
+            strides_ = buffer.getStrides();
+            if (strides_.empty()) {
+                strides_.resize(ndims);
+                std::ptrdiff_t s = ExternalBuffer::dtypeSize(dtype_);
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    strides_[i] = s;
+                    s *= dimsize[i];
+                }
+            }
+
+            // The index of a cell is its offset (in cells) if the strides are those of any array in row-major order.
+            d_.resize(ndims);
+            step_ = strides_[0];
+            unsigned int n = 1;
+            for (unsigned int i = 0; i < ndims; ++i) {
+                if (strides_[i] != step_*std::ptrdiff_t(n))
+                    step_ = 0;
+                n *= dimsize[i];
+                d_[i] = n;
+            }
+        }
+
+        /** \brief Views the contiguous array data. */
+        void bind
+        (value_t * data) {
+            base_ = reinterpret_cast<char *>(data);
+            dtype_ = (sizeof(value_t) == sizeof(float)) ? ExternalBuffer::FLOAT32 : ExternalBuffer::FLOAT64;
+            step_ = sizeof(value_t);
+            strides_.clear();
+            d_.clear();
+        }
+
+        inline value_t get
+        (size_t idx) const {
+            const char * p = base_ + offset(idx);
+            return (dtype_ == ExternalBuffer::FLOAT32) ? value_t(*reinterpret_cast<const float *>(p)) :
+                                                          value_t(*reinterpret_cast<const double *>(p));
+        }
+
+        /** \brief The buffer is not owned by the view, so it can be written through a const view. */
+        inline void set
+        (size_t idx, value_t v) const {
+            char * p = base_ + offset(idx);
+            if (dtype_ == ExternalBuffer::FLOAT32)
+                *reinterpret_cast<float *>(p) = float(v);
+            else
+                *reinterpret_cast<double *>(p) = double(v);
+        }
+
+        /** \brief Sets the first n values to v. */
+        void fill
+        (size_t n, value_t v) const {
+            if (isContiguous() && dtype_ == ExternalBuffer::FLOAT32)
+                std::fill_n(reinterpret_cast<float *>(base_), n, float(v));
+            else if (isContiguous())
+                std::fill_n(reinterpret_cast<double *>(base_), n, double(v));
+            else
+                for (size_t i = 0; i < n; ++i)
+                    set(i, v);
+        }
+
+        /** \brief Returns true if it views a contiguous array (of the grid or the caller). */
+        inline bool isContiguous
+        () const {
+            return step_ == std::ptrdiff_t(ExternalBuffer::dtypeSize(dtype_));
+        }
+
+    private:
+        /** \brief Offset in bytes of the value of cell idx: divisions are only required for strides
+            which are not those of an array in row-major order. */
+        inline std::ptrdiff_t offset
+        (size_t idx) const {
+            if (step_ != 0)
+                return std::ptrdiff_t(idx)*step_;
+
+            std::ptrdiff_t off = 0;
+            for (size_t i = d_.size() - 1; i > 0; --i) {
+                const size_t c = idx/d_[i-1];
+                idx -= c*d_[i-1];
+                off += std::ptrdiff_t(c)*strides_[i];
+            }
+            return off + std::ptrdiff_t(idx)*strides_[0];
+        }
+
+        /** \brief Address of the value of cell 0. */
+        char *                          base_;
+
+        /** \brief Type of the elements. */
+        ExternalBuffer::DType           dtype_;
+
+        /** \brief Bytes per cell if the index of a cell is its offset in cells, 0 otherwise. */
+        std::ptrdiff_t                  step_;
+
+        /** \brief Bytes between consecutive cells in each dimension. */
+        std::vector<std::ptrdiff_t>     strides_;
+
+        /** \brief Partial products of the dimension sizes, as nDGridMap::d_. */
+        std::vector<unsigned int>       d_;
+};
+
+#endif /* EXTERNALBUFFER_HPP_ */
@@ -30,38 +30,54 @@
 #include <fast_methods/ndgridmap/cell.h>
 
 /** \brief Possible states of the FMCells*/
-enum class FMState {OPEN, NARROW, FROZEN};
+enum class FMState : unsigned char {OPEN, NARROW, FROZEN};
 
 /// \todo Overload functions to add the option of input checking. No checks are faster.
-class FMCell : public Cell{
-    friend std::ostream& operator << (std::ostream & os, const FMCell & c);
+/** \brief Fast Marching cell. value_type is the scalar type used to store arrival times,
+    velocities and heuristic values (double or float). Use the FMCell or FMCellF typedefs.
+    As in Cell, accessors are not virtual. */
+template <class value_type> class FMCellT : public CellT<value_type> {
+
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, const FMCellT<U> & c);
 
     public:
+        /** \brief Scalar type of the values stored in the cell. */
+        typedef value_type value_t;
+
         /** \brief Default constructor which performs and implicit Fast Marching-like initialization of the grid. */
-        FMCell() : Cell(std::numeric_limits<double>::infinity(), 1), state_(FMState::OPEN), bucket_(0), hValue_(0) {}
+        FMCellT() : CellT<value_t>(std::numeric_limits<value_t>::infinity(), 1), state_(FMState::OPEN), bucket_(0), hValue_(0) {}
 
-        virtual ~FMCell() {}
+        inline void setVelocity(value_t v)          {occupancy_ = v;}
+        inline void setArrivalTime(value_t at)      {value_= at;}
+        inline void setHeuristicTime(value_t hv)    {hValue_ = hv;}
+        inline void setState(FMState state)         {state_ = state;}
+        inline void setBucket(int b)                {bucket_ = b;}
 
-        virtual inline void setVelocity(double v)           {occupancy_ = v;}
-        virtual inline void setArrivalTime(double at)       {value_= at;}
-        virtual inline void setHeuristicTime(double hv)     {hValue_ = hv;}
-        virtual inline void setState(FMState state)         {state_ = state;}
-        virtual inline void setBucket(int b)                {bucket_ = b;}
-        
         /** \brief Sets default values for the cell. Concretely, restarts value_ = Inf, state_ = OPEN and
             hValue_ = 0 but occupancy_ is not modified. */
-        virtual void setDefault();
+        inline void setDefault
+        () {
+            value_ = std::numeric_limits<value_t>::infinity();
+            bucket_ = 0;
+            hValue_ = 0;
+            state_ = FMState::OPEN;
+        }
 
-        std::string type() {return std::string("FMCell - Fast Marching cell");}
+        std::string type() const;
 
-        virtual inline double getArrivalTime() const              {return value_;}
-        virtual inline double getHeuristicValue() const           {return hValue_;}
-        virtual inline double getTotalValue() const               {return value_ + hValue_;}
-        virtual inline double getVelocity() const                 {return occupancy_;}
-        virtual inline FMState getState() const                   {return state_;}
-        virtual inline int getBucket() const                      {return bucket_;}
+        inline value_t getArrivalTime() const             {return value_;}
+        inline value_t getHeuristicValue() const          {return hValue_;}
+        inline value_t getTotalValue() const              {return value_ + hValue_;}
+        inline value_t getVelocity() const                {return occupancy_;}
+        inline FMState getState() const                   {return state_;}
+        inline int getBucket() const                      {return bucket_;}
 
     protected:
+        using CellT<value_t>::value_;
+        using CellT<value_t>::occupancy_;
+        using CellT<value_t>::index_;
+
         /** \brief State of the cell. */
         FMState state_;
 
@@ -69,7 +85,19 @@ class FMCell : public Cell{
         int bucket_;
 
         /** \brief Heuristic value. */
-        double hValue_;
+        value_t hValue_;
 };
 
+/** \brief Double precision Fast Marching cell. */
+typedef FMCellT<double> FMCell;
+
+/** \brief Single precision Fast Marching cell: halves the memory of arrival times and velocities. */
+typedef FMCellT<float> FMCellF;
+
+template <> std::string FMCellT<double>::type() const;
+template <> std::string FMCellT<float>::type() const;
+
+extern template class FMCellT<double>;
+extern template class FMCellT<float>;
+
 #endif /* FMCELL_H_*/
@@ -0,0 +1,318 @@
+/*! \class FMCellExternal
+    \brief Fast Marching cell which reads its velocity, and optionally writes its arrival time,
+    in place in buffers owned by the caller (for instance, the costmap of a perception stack).
+
+    Used as nDGridMap<FMCellExternal, ndims>, the grid is a structure of arrays as FMCellSoA
+    grids are, but the velocities and arrival times are views of ExternalBuffer described by the
+    caller with nDGridMap::setExternalBuffers(): floats or doubles, with any strides. Then,
+    the map does not have to be copied into the grid cell by cell before every solve and
+    the arrival times are found in the output buffer after it. States, heuristic values and
+    buckets are arrays of the grid, as well as velocities and arrival times until buffers
+    are set. Resizing the grid goes back to its own arrays.
+
+    Velocities are converted to value_t when read: FMCellExternalF solves single precision
+    maps without converting them, FMCellExternal solves them in double precision. Buffers with
+    the strides of an array in row-major order are accessed without divisions. Only row-major
+    grids can use external buffers.
+
+    Heaps refer to these cells through FMCellExternalPtr, obtained with nDGridMap::getCellPtr().
+    An FMCellExternal object is only valid while the grid it was obtained from is not resized.
+    Solution layers (see nDGridMap::shareEnvironment()) share the velocities of the environment.
+
+    IMPORTANT NOTE: no checks are done in the set functions.
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FMCELLEXTERNAL_H_
+#define FMCELLEXTERNAL_H_
+
+#include <iostream>
+#include <string>
+#include <limits>
+#include <vector>
+#include <array>
+#include <memory>
+#include <algorithm>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/ndgridmap/externalbuffer.hpp>
+#include <fast_methods/utils/utils.h>
+#include <fast_methods/utils/memoryusage.hpp>
+
+/** \brief Views and arrays holding the members of all the FMCellExternal of a grid. */
+template <class value_t>
+struct FMCellExternalDataT {
+    /** \brief Values of the cells (times of arrival), in the output buffer or in ownValues_. */
+    ExternalArray<value_t>  values_;
+
+    /** \brief Occupancies of the cells (velocities), in the velocities buffer or in ownOccupancies_. */
+    ExternalArray<value_t>  occupancies_;
+
+    /** \brief States of the cells. */
+    std::vector<FMState>    states_;
+
+    /** \brief Heuristic values of the cells. */
+    std::vector<value_t>    hValues_;
+
+    /** \brief Buckets of the cells, used when sorted with FMUntidyQueue. */
+    std::vector<int>        buckets_;
+
+    /** \brief Values of the cells while there is no output buffer. */
+    std::vector<value_t>    ownValues_;
+
+    /** \brief Occupancies of the cells while there is no velocities buffer, shared with the solution layers. */
+    std::shared_ptr<std::vector<value_t> > ownOccupancies_;
+};
+
+template <class value_type>
+class FMCellExternalT {
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, const FMCellExternalT<U> & c);
+
+    public:
+        /** \brief Scalar type of the values stored in the cell. */
+        typedef value_type                      value_t;
+
+        /** \brief Arrays the cell refers to. */
+        typedef FMCellExternalDataT<value_t>    data_t;
+
+        FMCellExternalT(data_t * data, unsigned int idx) : data_(data), idx_(idx) {}
+
+        inline void setValue(value_t v)                 {data_->values_.set(idx_, v);}
+        inline void setOccupancy(value_t o)             {data_->occupancies_.set(idx_, o);}
+        inline void setVelocity(value_t v)              {data_->occupancies_.set(idx_, v);}
+        inline void setArrivalTime(value_t at)          {data_->values_.set(idx_, at);}
+        inline void setHeuristicTime(value_t hv)        {data_->hValues_[idx_] = hv;}
+        inline void setState(FMState state)             {data_->states_[idx_] = state;}
+        inline void setBucket(int b)                    {data_->buckets_[idx_] = b;}
+
+        /** \brief The index is implicit in the position of the cell. Does nothing. */
+        inline void setIndex(int)                       {}
+
+        /** \brief Sets default values for the cell. Concretely, restarts value_ = Inf, state_ = OPEN and
+            hValue_ = 0 but occupancy_ is not modified. */
+        inline void setDefault
+        () {
+            data_->values_.set(idx_, std::numeric_limits<value_t>::infinity());
+            data_->buckets_[idx_] = 0;
+            data_->hValues_[idx_] = 0;
+            data_->states_[idx_] = FMState::OPEN;
+        }
+
+        std::string type() const;
+
+        inline value_t getValue() const                 {return data_->values_.get(idx_);}
+        inline value_t getOccupancy() const             {return data_->occupancies_.get(idx_);}
+        inline unsigned int getIndex() const            {return idx_;}
+        inline value_t getArrivalTime() const           {return data_->values_.get(idx_);}
+        inline value_t getHeuristicValue() const        {return data_->hValues_[idx_];}
+        inline value_t getTotalValue() const            {return data_->values_.get(idx_) + data_->hValues_[idx_];}
+        inline value_t getVelocity() const              {return data_->occupancies_.get(idx_);}
+        inline FMState getState() const                 {return data_->states_[idx_];}
+        inline int getBucket() const                    {return data_->buckets_[idx_];}
+
+        inline bool isOccupied() const {
+            return data_->occupancies_.get(idx_) < utils::COMP_MARGIN;
+        }
+
+    protected:
+        /** \brief Arrays of the grid this cell belongs to. */
+        data_t *        data_;
+
+        /** \brief Index within the grid. */
+        unsigned int    idx_;
+};
+
+/** \brief Pointer-like object used by the heaps to refer to an FMCellExternal. */
+template <class value_t>
+class FMCellExternalPtrT {
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, const FMCellExternalPtrT<U> & p);
+
+    public:
+        FMCellExternalPtrT(FMCellExternalDataT<value_t> * data, unsigned int idx) : cell_(data, idx) {}
+
+        inline FMCellExternalT<value_t> * operator->()              {return &cell_;}
+        inline const FMCellExternalT<value_t> * operator->() const  {return &cell_;}
+        inline FMCellExternalT<value_t> & operator*()               {return cell_;}
+        inline const FMCellExternalT<value_t> & operator*() const   {return cell_;}
+
+        inline bool operator==
+        (const FMCellExternalPtrT & p) const {
+            return cell_.getIndex() == p.cell_.getIndex();
+        }
+
+        inline bool operator!=
+        (const FMCellExternalPtrT & p) const {
+            return !(*this == p);
+        }
+
+    private:
+        /** \brief Cell pointed to. */
+        FMCellExternalT<value_t> cell_;
+};
+
+/** \brief Double precision external cell. */
+typedef FMCellExternalT<double>     FMCellExternal;
+typedef FMCellExternalPtrT<double>  FMCellExternalPtr;
+
+/** \brief Single precision external cell. */
+typedef FMCellExternalT<float>      FMCellExternalF;
+typedef FMCellExternalPtrT<float>   FMCellExternalFPtr;
+
+template <> std::string FMCellExternalT<double>::type() const;
+template <> std::string FMCellExternalT<float>::type() const;
+
+/** \brief Storage for FMCellExternal grids: views of the buffers of the caller plus the arrays written by the solvers. */
+template <class value_t> class CellStorage<FMCellExternalT<value_t> > {
+
+    public:
+        typedef FMCellExternalT<value_t>        reference;
+        typedef const FMCellExternalT<value_t>  const_reference;
+        typedef FMCellExternalPtrT<value_t>     pointer;
+        typedef FMCellExternalPtrT<value_t>     const_pointer;
+
+        static constexpr bool sparse = false;
+
+        /** \brief Velocities can be shared with solution layers. */
+        static constexpr bool layers = true;
+
+        CellStorage() {}
+
+        /** \brief Copies the arrays of the grid, velocities included. The copy views the same buffers. */
+        CellStorage
+        (const CellStorage & s) : data_(s.data_) {
+            if (s.data_.ownOccupancies_)
+                data_.ownOccupancies_ = std::make_shared<std::vector<value_t> >(*s.data_.ownOccupancies_);
+            rebind(s);
+        }
+
+        CellStorage & operator=
+        (const CellStorage & s) {
+            CellStorage copy(s);
+            std::swap(data_, copy.data_);
+            return *this;
+        }
+
+        /** \brief Moving the arrays keeps their addresses, so the views are still valid. */
+        CellStorage(CellStorage &&) = default;
+
+        CellStorage & operator=(CellStorage &&) = default;
+
+        /** \brief Resizes the arrays to n cells initialized with FMCell default values. Buffers are no longer used. */
+        void resize
+        (size_t n) {
+            data_.ownValues_.assign(n, std::numeric_limits<value_t>::infinity());
+            data_.ownOccupancies_ = std::make_shared<std::vector<value_t> >(n, 1);
+            data_.values_.bind(data_.ownValues_.data());
+            data_.occupancies_.bind(data_.ownOccupancies_->data());
+            data_.states_.assign(n, FMState::OPEN);
+            data_.hValues_.assign(n, 0);
+            data_.buckets_.assign(n, 0);
+        }
+
+        /** \brief Reads the velocities from the buffer velocities and writes the values in the buffer values,
+            of a grid of dimensions dimsize. Empty buffers keep the current velocities or values. All the
+            cells are restarted, values included. */
+        template <size_t ndims>
+        void setBuffers
+        (const ExternalBuffer & velocities, const ExternalBuffer & values, const std::array<unsigned int, ndims> & dimsize) {
+            if (!velocities.empty()) {
+                data_.occupancies_.bind(velocities, dimsize);
+                data_.ownOccupancies_.reset();
+            }
+            if (!values.empty()) {
+                data_.values_.bind(values, dimsize);
+                std::vector<value_t>().swap(data_.ownValues_);
+            }
+            setDefault();
+        }
+
+        inline reference operator[]
+        (size_t idx) {
+            return reference(&data_, idx);
+        }
+
+        /** \brief The returned cell must not be modified. */
+        inline const_reference operator[]
+        (size_t idx) const {
+            return reference(const_cast<FMCellExternalDataT<value_t> *>(&data_), idx);
+        }
+
+        inline pointer getPointer
+        (size_t idx) {
+            return pointer(&data_, idx);
+        }
+
+        /** \brief Uses the velocities of env (its arrays or its buffer) and allocates the rest of the
+            arrays with the size of env, initialized with default values. */
+        void shareOccupancies
+        (const CellStorage & env) {
+            const size_t n = env.size();
+            data_.ownValues_.assign(n, std::numeric_limits<value_t>::infinity());
+            data_.values_.bind(data_.ownValues_.data());
+            data_.ownOccupancies_ = env.data_.ownOccupancies_;
+            data_.occupancies_ = env.data_.occupancies_;
+            data_.states_.assign(n, FMState::OPEN);
+            data_.hValues_.assign(n, 0);
+            data_.buckets_.assign(n, 0);
+        }
+
+        /** \brief Restarts values, states, heuristic values and buckets. Occupancies are not modified. */
+        void setDefault
+        () {
+            data_.values_.fill(size(), std::numeric_limits<value_t>::infinity());
+            std::fill(data_.states_.begin(), data_.states_.end(), FMState::OPEN);
+            std::fill(data_.hValues_.begin(), data_.hValues_.end(), 0);
+            std::fill(data_.buckets_.begin(), data_.buckets_.end(), 0);
+        }
+
+        inline size_t size
+        () const {
+            return data_.states_.size();
+        }
+
+        /** \brief Returns the number of bytes allocated for the cells by the grid, velocities included even
+            if they are shared with other grids. The buffers of the caller are not included. */
+        size_t memory
+        () const {
+            return MemoryUsage::of(data_.states_) + MemoryUsage::of(data_.hValues_) + MemoryUsage::of(data_.buckets_)
+                    + MemoryUsage::of(data_.ownValues_) + (data_.ownOccupancies_ ? MemoryUsage::of(*data_.ownOccupancies_) : 0);
+        }
+
+        void clear
+        () {
+            data_ = FMCellExternalDataT<value_t>();
+        }
+
+    private:
+        /** \brief Views the arrays of this storage where s viewed its own arrays. */
+        void rebind
+        (const CellStorage & s) {
+            if (!s.data_.ownValues_.empty())
+                data_.values_.bind(data_.ownValues_.data());
+            if (s.data_.ownOccupancies_)
+                data_.occupancies_.bind(data_.ownOccupancies_->data());
+        }
+
+        /** \brief The actual views and arrays. */
+        FMCellExternalDataT<value_t> data_;
+};
+
+template <class value_t> constexpr bool CellStorage<FMCellExternalT<value_t> >::sparse;
+template <class value_t> constexpr bool CellStorage<FMCellExternalT<value_t> >::layers;
+
+#endif /* FMCELLEXTERNAL_H_*/
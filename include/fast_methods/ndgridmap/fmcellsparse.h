@@ -0,0 +1,255 @@
+/*! \class FMCellSparse
+    \brief Fast Marching cell of a sparse grid, for very large grids of which only a
+    small part is used (for instance, goal-bounded queries in mostly-free 3D volumes).
+
+    Used as nDGridMap<FMCellSparse, ndims>, the grid is bricked (8x8x8 cells per brick
+    in 3D by default, see nDGridMap::setBrickSize()) and each brick is stored as a chunk
+    of a structure of arrays, as FMCellSoA does. Chunks are not allocated until one of
+    their cells is set to a value different from the default one: arrival time infinity,
+    velocity 1, state OPEN and heuristic value 0. Reading cells does not allocate memory,
+    so resizing a sparse grid is immediate and the memory used is proportional to the
+    part of the grid explored by the solvers.
+
+    The grid does not store neighbor masks per cell either. Heaps (FMDaryHeap) store their
+    handles in chunks too.
+    Solvers iterating over all the cells (FSM, LSM, FM2...) work, but end up
+    allocating the whole grid. Only grids of 3 or more dimensions can be sparse.
+
+    Heaps refer to these cells through FMCellSparsePtr, obtained with nDGridMap::getCellPtr().
+    FMCellSparseF stores arrival times, velocities and heuristic values as float.
+
+    IMPORTANT NOTE: no checks are done in the set functions.
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FMCELLSPARSE_H_
+#define FMCELLSPARSE_H_
+
+#include <iostream>
+#include <string>
+#include <limits>
+
+#include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/datastructures/chunkedarray.hpp>
+#include <fast_methods/utils/utils.h>
+
+/** \brief Chunked arrays holding the members of all the FMCellSparse of a grid. */
+template <class value_t>
+struct FMCellSparseDataT {
+    FMCellSparseDataT() :
+        values_(0, std::numeric_limits<value_t>::infinity()),
+        occupancies_(0, 1),
+        states_(0, FMState::OPEN),
+        hValues_(0, 0),
+        buckets_(0, 0) {}
+
+    /** \brief Values of the cells (times of arrival). */
+    ChunkedArray<value_t>   values_;
+
+    /** \brief Occupancies of the cells (velocities). */
+    ChunkedArray<value_t>   occupancies_;
+
+    /** \brief States of the cells. */
+    ChunkedArray<FMState>   states_;
+
+    /** \brief Heuristic values of the cells. */
+    ChunkedArray<value_t>   hValues_;
+
+    /** \brief Buckets of the cells, used when sorted with FMUntidyQueue. */
+    ChunkedArray<int>       buckets_;
+};
+
+template <class value_type>
+class FMCellSparseT {
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, const FMCellSparseT<U> & c);
+
+    public:
+        /** \brief Scalar type of the values stored in the cell. */
+        typedef value_type                  value_t;
+
+        /** \brief Arrays the cell refers to. */
+        typedef FMCellSparseDataT<value_t>  data_t;
+
+        FMCellSparseT(data_t * data, unsigned int idx) : data_(data), idx_(idx) {}
+
+        inline void setValue(value_t v)                 {data_->values_.set(idx_, v);}
+        inline void setOccupancy(value_t o)             {data_->occupancies_.set(idx_, o);}
+        inline void setVelocity(value_t v)              {data_->occupancies_.set(idx_, v);}
+        inline void setArrivalTime(value_t at)          {data_->values_.set(idx_, at);}
+        inline void setHeuristicTime(value_t hv)        {data_->hValues_.set(idx_, hv);}
+        inline void setState(FMState state)             {data_->states_.set(idx_, state);}
+        inline void setBucket(int b)                    {data_->buckets_.set(idx_, b);}
+
+        /** \brief The index is implicit in the position of the cell. Does nothing. */
+        inline void setIndex(int)                       {}
+
+        /** \brief Sets default values for the cell. Concretely, restarts value_ = Inf, state_ = OPEN and
+            hValue_ = 0 but occupancy_ is not modified. */
+        inline void setDefault
+        () {
+            data_->values_.set(idx_, std::numeric_limits<value_t>::infinity());
+            data_->buckets_.set(idx_, 0);
+            data_->hValues_.set(idx_, 0);
+            data_->states_.set(idx_, FMState::OPEN);
+        }
+
+        std::string type() const;
+
+        inline value_t getValue() const                 {return data_->values_.get(idx_);}
+        inline value_t getOccupancy() const             {return data_->occupancies_.get(idx_);}
+        inline unsigned int getIndex() const            {return idx_;}
+        inline value_t getArrivalTime() const           {return data_->values_.get(idx_);}
+        inline value_t getHeuristicValue() const        {return data_->hValues_.get(idx_);}
+        inline value_t getTotalValue() const            {return data_->values_.get(idx_) + data_->hValues_.get(idx_);}
+        inline value_t getVelocity() const              {return data_->occupancies_.get(idx_);}
+        inline FMState getState() const                 {return data_->states_.get(idx_);}
+        inline int getBucket() const                    {return data_->buckets_.get(idx_);}
+
+        inline bool isOccupied() const {
+            return data_->occupancies_.get(idx_) < utils::COMP_MARGIN;
+        }
+
+    protected:
+        /** \brief Arrays of the grid this cell belongs to. */
+        data_t *        data_;
+
+        /** \brief Index within the grid. */
+        unsigned int    idx_;
+};
+
+/** \brief Pointer-like object used by the heaps to refer to an FMCellSparse. */
+template <class value_t>
+class FMCellSparsePtrT {
+    template <class U>
+    friend std::ostream& operator << (std::ostream & os, const FMCellSparsePtrT<U> & p);
+
+    public:
+        FMCellSparsePtrT(FMCellSparseDataT<value_t> * data, unsigned int idx) : cell_(data, idx) {}
+
+        inline FMCellSparseT<value_t> * operator->()                {return &cell_;}
+        inline const FMCellSparseT<value_t> * operator->() const    {return &cell_;}
+        inline FMCellSparseT<value_t> & operator*()                 {return cell_;}
+        inline const FMCellSparseT<value_t> & operator*() const     {return cell_;}
+
+        inline bool operator==
+        (const FMCellSparsePtrT & p) const {
+            return cell_.getIndex() == p.cell_.getIndex();
+        }
+
+        inline bool operator!=
+        (const FMCellSparsePtrT & p) const {
+            return !(*this == p);
+        }
+
+    private:
+        /** \brief Cell pointed to. */
+        FMCellSparseT<value_t> cell_;
+};
+
+/** \brief Double precision sparse cell. */
+typedef FMCellSparseT<double>       FMCellSparse;
+typedef FMCellSparsePtrT<double>    FMCellSparsePtr;
+
+/** \brief Single precision sparse cell. */
+typedef FMCellSparseT<float>        FMCellSparseF;
+typedef FMCellSparsePtrT<float>     FMCellSparseFPtr;
+
+template <> std::string FMCellSparseT<double>::type() const;
+template <> std::string FMCellSparseT<float>::type() const;
+
+/** \brief Sparse storage for FMCellSparse grids: chunks of 2^chunkBits cells allocated on first write. */
+template <class value_t> class CellStorage<FMCellSparseT<value_t> > {
+
+    public:
+        typedef FMCellSparseT<value_t>          reference;
+        typedef const FMCellSparseT<value_t>    const_reference;
+        typedef FMCellSparsePtrT<value_t>       pointer;
+        typedef FMCellSparsePtrT<value_t>       const_pointer;
+
+        /** \brief Cells are allocated in chunks when written. */
+        static constexpr bool sparse = true;
+
+        /** \brief Sparse grids cannot be solution layers. */
+        static constexpr bool layers = false;
+
+        /** \brief Resizes the arrays to n cells with FMCell default values, in chunks of
+            2^chunkBits cells. No memory is allocated for the cells. */
+        void resize
+        (size_t n, unsigned int chunkBits) {
+            data_.values_.resize(n, chunkBits);
+            data_.occupancies_.resize(n, chunkBits);
+            data_.states_.resize(n, chunkBits);
+            data_.hValues_.resize(n, chunkBits);
+            data_.buckets_.resize(n, chunkBits);
+        }
+
+        inline reference operator[]
+        (size_t idx) {
+            return reference(&data_, idx);
+        }
+
+        /** \brief The returned cell must not be modified. */
+        inline const_reference operator[]
+        (size_t idx) const {
+            return reference(const_cast<FMCellSparseDataT<value_t> *>(&data_), idx);
+        }
+
+        inline pointer getPointer
+        (size_t idx) {
+            return pointer(&data_, idx);
+        }
+
+        /** \brief Restarts values, states, heuristic values and buckets of the allocated chunks.
+            Occupancies are not modified. */
+        void setDefault
+        () {
+            data_.values_.fillAllocated(std::numeric_limits<value_t>::infinity());
+            data_.states_.fillAllocated(FMState::OPEN);
+            data_.hValues_.fillAllocated(0);
+            data_.buckets_.fillAllocated(0);
+        }
+
+        inline size_t size
+        () const {
+            return data_.values_.size();
+        }
+
+        /** \brief Returns the number of bytes allocated for the cells. */
+        size_t memory
+        () const {
+            return data_.values_.memory() + data_.occupancies_.memory() + data_.states_.memory()
+                    + data_.hValues_.memory() + data_.buckets_.memory();
+        }
+
+        void clear
+        () {
+            data_.values_.clear();
+            data_.occupancies_.clear();
+            data_.states_.clear();
+            data_.hValues_.clear();
+            data_.buckets_.clear();
+        }
+
+    private:
+        /** \brief The actual arrays. */
+        FMCellSparseDataT<value_t> data_;
+};
+
+template <class value_t> constexpr bool CellStorage<FMCellSparseT<value_t> >::sparse;
+template <class value_t> constexpr bool CellStorage<FMCellSparseT<value_t> >::layers;
+
+#endif /* FMCELLSPARSE_H_*/
@@ -10,6 +10,38 @@
     It has 2 template parameters: - the cells employed, should be Cell class or inherited.
                                   - number of dimensions of the grid. Helps compiler to optimize.
 
+    The cells are held by CellStorage<T>. By default, it is an array of cells. FMCellSoA
+    grids store each cell member in a separate array instead (structure of arrays).
+
+    By default, cells are indexed in row-major order. Grids of 3 or more dimensions can
+    instead be divided in cubic bricks of 2^k cells per side (see setBrickSize()): bricks are
+    stored one after the other in row-major order and the cells of a brick are stored
+    contiguously, also in row-major order. Then, neighbors in every dimension are close
+    in memory, which reduces the cache misses of the solvers in large 3D grids. Dimensions
+    are padded to a multiple of the brick size. Padding cells are included in size() but
+    they are occupied and they are never returned as neighbors. Indices are only obtained
+    through coord2idx(), getNeighbors() and the rest of the indexing functions, so solvers
+    work with any layout. Files are always read and written in row-major order (see rowMajor2idx()).
+
+    Grids of sparse cells (FMCellSparse) are always bricked (8 cells per brick side by default)
+    and each brick is allocated the first time one of its cells is written. In this case,
+    neighbor masks are computed from the position of the cell within its brick instead of
+    being stored per cell.
+
+    The grid keeps track of the blocks of cells accessed through the non-const accessors
+    (operator[](), getCell() and getCellPtr()) since it was last cleaned, so that clean()
+    only restores those blocks. Then, resetting the grid after a goal-directed query costs
+    as much as the cells the query touched instead of the whole grid.
+
+    FMCellExternal grids use the velocities (and arrival times) of buffers of the caller in place,
+    instead of arrays of their own (see setExternalBuffers()).
+
+    FMCellSoA grids can be solution layers of another grid, the environment (see
+    shareEnvironment()). A layer shares the velocities, obstacles and neighbor masks of
+    its environment and only allocates the arrays solvers write (arrival times, states,
+    heuristic values and buckets), so many queries can be solved on the same map at the
+    same time, each one on its own layer, without copying the map.
+
     Copyright (C) 2014 Javier V. Gomez and Jose Pardeiro
     www.javiervgomez.com
 
@@ -37,21 +69,33 @@
 #include <sstream>
 
 #include <utility>
+#include <limits>
+#include <cstdint>
+#include <type_traits>
+#include <memory>
 
 #include <fast_methods/console/console.h>
+#include <fast_methods/ndgridmap/cellstorage.hpp>
+#include <fast_methods/ndgridmap/occupancybitmap.hpp>
+#include <fast_methods/ndgridmap/externalbuffer.hpp>
+#include <fast_methods/utils/workerpool.hpp>
+#include <fast_methods/utils/memoryusage.hpp>
 
-/// \todo Neighbors precomputation could speed things up.
 /// \todo Improve coord2idx function in order to just pass n coordinates and not an array.
 /// \todo Create d_ with 1 and d_[1] size of X, d_[2] size of Y, etc, to generalize dimensions.
 
 template <class T, size_t ndims> class nDGridMap {
 
+    static_assert(!CellStorage<T>::sparse || ndims >= 3, "Only grids of 3 or more dimensions can be sparse.");
+
     friend std::ostream& operator <<
-    (std::ostream & os, nDGridMap<T,ndims> & g) {
+    (std::ostream & os, const nDGridMap<T,ndims> & g) {
         os << console::str_info("Grid cell information");
         os << "\t" << g.getCell(0).type() << std::endl;
         os << "\t" << g.ncells_ << " cells." << std::endl;
         os << "\t" << g.leafsize_ << " leafsize (m)." << std::endl;
+        if (g.brickBits_ > 0)
+            os << "\t" << g.getBrickSize() << " cells per brick side." << std::endl;
         os << "\t" << ndims << " dimensions:" << std::endl;
 
         for (unsigned int i = 0; i < ndims; ++i)
@@ -61,15 +105,34 @@ template <class T, size_t ndims> class nDGridMap {
     }
 
     public:
+        /** \brief Type of the cells of the grid. */
+        typedef T                                       cell_t;
+
+        /** \brief Scalar type of the values stored in the cells (double or float). */
+        typedef typename T::value_t                     value_t;
+
+        /** \brief Type returned when accessing a cell. */
+        typedef typename CellStorage<T>::reference      cell_reference_t;
+
+        /** \brief Type returned when accessing a cell of a const grid. */
+        typedef typename CellStorage<T>::const_reference cell_const_reference_t;
+
+        /** \brief Type used by heaps and queues to refer to a cell of the grid. */
+        typedef typename CellStorage<T>::pointer        cell_pointer_t;
 
-      nDGridMap () : leafsize_(1.0f), clean_(true) {}
+      nDGridMap () : leafsize_(1.0f), ncells_(0), clean_(true), brickBits_(defaultBrickBits()), dirtyBits_(minDirtyBits) {}
 
       /** @param dimsize constains the size of each dimension.
-          @param leafsize real cell size (assumed to be cubic). 1 unit by default. */
+          @param leafsize real cell size (assumed to be cubic). 1 unit by default.
+          @param brickSize size of the bricks, 1 (row-major) or a power of 2. See setBrickSize(). By default (0),
+                 row-major order, or bricks of 8 cells per side for sparse grids. */
         nDGridMap
-        (const std::array<unsigned int, ndims> & dimsize, double leafsize = 1.0f) :
+        (const std::array<unsigned int, ndims> & dimsize, double leafsize = 1.0f, unsigned int brickSize = 0) :
         leafsize_(leafsize),
-        clean_(true) {
+        clean_(true),
+        brickBits_(defaultBrickBits()),
+        dirtyBits_(minDirtyBits) {
+            setBrickBits(brickSize);
             resize(dimsize);
         }
 
@@ -78,25 +141,116 @@ template <class T, size_t ndims> class nDGridMap {
         (const std::array<unsigned int, ndims> & dimsize) {
             dimsize_ = dimsize;
             // Computing the total number of cells and the auxiliar array d_.
-            ncells_= 1;
+            unsigned int n = 1;
             for (unsigned int i = 0; i < ndims; ++i) {
-                ncells_ *= dimsize_[i];
-                d_[i] = ncells_;
+                n *= dimsize_[i];
+                d_[i] = n;
+            }
+
+            // Strides of the layout. In row-major order there is a brick per cell.
+            const unsigned int bsize = 1u << brickBits_;
+            ncells_ = 1u << (brickBits_*ndims);
+            for (unsigned int i = 0; i < ndims; ++i) {
+                brickStride_[i] = ncells_;
+                ncells_ *= (dimsize_[i] + bsize - 1) >> brickBits_;
+                stride_[i] = (brickBits_ == 0) ? brickStride_[i] : 1u << (brickBits_*i);
+                crossStride_[i] = brickStride_[i] - (bsize - 1)*stride_[i];
             }
 
             //Resizing gridmap and initializing with default values.
-            cells_.clear();
-            cells_.resize(ncells_, T());
+            resizeStorage(std::integral_constant<bool, CellStorage<T>::sparse>());
+            computeNeighborMasks(std::integral_constant<bool, CellStorage<T>::sparse>());
 
-            // Setting the index_ member of the cells, which a-priori is unknown.
-            for (unsigned int i = 0; i < cells_.size(); ++i)
-                cells_[i].setIndex(i);
+            // Dirty blocks are bricks of sparse and large-bricked grids.
+            dirtyBits_ = std::max<unsigned int>(minDirtyBits, brickBits_*ndims);
+            dirty_.assign((((ncells_ + (1u << dirtyBits_) - 1) >> dirtyBits_) + 63) >> 6, 0);
             clean_ = true;
         }
 
+        /** \brief Sets the size of the bricks in which the grid is divided: 1 for row-major order
+            or a power of 2 (8 is a good choice for 3D FMCell grids). 0 sets the default layout:
+            row-major order, or bricks of 8 cells per side for sparse grids. Only grids
+            of 3 or more dimensions can be bricked and sparse grids are always bricked. The grid
+            is resized (and so cleared) if it was not empty. */
+        void setBrickSize
+        (unsigned int brickSize) {
+            setBrickBits(brickSize);
+            if (ncells_ > 0)
+                resize(dimsize_);
+        }
+
+        /** \brief Returns the size of the bricks, 1 if cells are in row-major order. */
+        inline unsigned int getBrickSize() const { return 1u << brickBits_; }
+
+        /** \brief Makes this grid a solution layer of env: it gets the dimensions, layout, velocities,
+            obstacles and neighbor masks of env, which are shared instead of copied, and only the
+            arrays written by the solvers are allocated, with default values. Velocities must be
+            modified through env, not through its layers. Only available for FMCellSoA and FMCellExternal grids. */
+        void shareEnvironment
+        (const nDGridMap & env) {
+            dimsize_ = env.dimsize_;
+            leafsize_ = env.leafsize_;
+            ncells_ = env.ncells_;
+            d_ = env.d_;
+            stride_ = env.stride_;
+            crossStride_ = env.crossStride_;
+            brickStride_ = env.brickStride_;
+            brickBits_ = env.brickBits_;
+            neighMasks_ = env.neighMasks_;
+            brickLimits_ = env.brickLimits_;
+            fullMask_ = env.fullMask_;
+            occupied_ = env.occupied_;
+            cells_.shareOccupancies(env.cells_);
+            dirtyBits_ = env.dirtyBits_;
+            dirty_.assign(env.dirty_.size(), 0);
+            clean_ = true;
+        }
+
+        /** \brief Makes the cells read their velocities from the buffer velocities and write their arrival
+            times in the buffer times, owned by the caller, instead of copying them (see ExternalBuffer). An
+            empty buffer keeps the current velocities or times. The buffers are described for the
+            dimensions of the grid, which has to be resized before, and they are used until the grid is
+            resized. The grid is restarted, so the times are set to infinity. The obstacles are
+            computed from the velocities if obstacles is true (required by FM2), otherwise they are
+            cleared. Only available for FMCellExternal grids, in row-major order.
+            @return 1 if the buffers are used, 0 otherwise. */
+        int setExternalBuffers
+        (const ExternalBuffer & velocities, const ExternalBuffer & times = ExternalBuffer(), bool obstacles = false) {
+            if (brickBits_ > 0) {
+                console::error("External buffers can only be used by grids in row-major order.");
+                return 0;
+            }
+            for (const ExternalBuffer * b : {&velocities, &times})
+                if (!b->getStrides().empty() && b->getStrides().size() != ndims) {
+                    console::error("External buffers need a stride per dimension.");
+                    return 0;
+                }
+            cells_.setBuffers(velocities, times, dimsize_);
+            std::fill(dirty_.begin(), dirty_.end(), 0);
+            clean_ = true;
+
+            occupied_.reset();
+            if (obstacles) {
+                OccupancyBitmap obs(ncells_);
+                const CellStorage<T> & cells = cells_;
+                for (unsigned int idx = 0; idx < ncells_; ++idx)
+                    if (cells[idx].isOccupied())
+                        obs.set(idx);
+                occupied_ = std::make_shared<const OccupancyBitmap>(std::move(obs));
+            }
+            return 1;
+        }
+
         /** \brief Returns the cell with index idx. */
-        inline T & operator[]
+        inline cell_reference_t operator[]
         (unsigned int idx) {
+            markDirty(idx);
+            return cells_[idx];
+        }
+
+        /** \brief Returns the cell with index idx. */
+        inline cell_const_reference_t operator[]
+        (unsigned int idx) const {
             return cells_[idx];
         }
 
@@ -106,96 +260,181 @@ template <class T, size_t ndims> class nDGridMap {
         inline void setLeafSize(const double leafsize) { leafsize_ = leafsize; }
 
         /** \brief Returns the cell with index idx. */
-        inline T & getCell
+        inline cell_reference_t getCell
         (unsigned int idx) {
+            markDirty(idx);
             return cells_[idx];
-            }
+        }
+
+        /** \brief Returns the cell with index idx. */
+        inline cell_const_reference_t getCell
+        (unsigned int idx) const {
+            return cells_[idx];
+        }
+
+        /** \brief Returns the object heaps and queues use to refer to the cell with index idx. */
+        inline cell_pointer_t getCellPtr
+        (unsigned int idx) {
+            markDirty(idx);
+            return cells_.getPointer(idx);
+        }
 
         /** \brief Returns the size of each dimension. */
         inline std::array<unsigned int, ndims> getDimSizes() const { return dimsize_;}
 
          /** \brief Returns the minimum value of neighbors of cell idx in dimension dim. */
         double getMinValueInDim
-        (unsigned int idx, unsigned int dim) {
-            n_neighs = 0; // How many neighbors obtained in that dimension.
-            getNeighborsInDim(idx,n_,dim);
-
-            if (n_neighs == 1)
-                return cells_[n_[0]].getValue();
-            else
-                return (cells_[n_[0]].getValue()<cells_[n_[1]].getValue()) ? cells_[n_[0]].getValue() : cells_[n_[1]].getValue();
+        (unsigned int idx, unsigned int dim) const {
+            // Out of the grid neighbors are replaced by the cell itself and discarded with the mask.
+            const neighmask_t m = getMask(idx);
+            const double v1 = (m & (1 << 2*dim)) ? cells_[idx-prevStride(idx, dim)].getValue() : std::numeric_limits<double>::infinity();
+            const double v2 = (m & (2 << 2*dim)) ? cells_[idx+nextStride(idx, dim)].getValue() : std::numeric_limits<double>::infinity();
+            return (v1 < v2) ? v1 : v2;
         }
 
         /** \brief Returns number of valid neighbors for cell idx in dimension dim, stored in m. */
         unsigned int getNumberNeighborsInDim
-        (int idx, std::array<unsigned int, ndims> &m, unsigned int dim)   {
-            n_neighs = 0;
-            getNeighborsInDim(idx,n_,dim);
-            m = n_;
-            return n_neighs;
+        (unsigned int idx, std::array<unsigned int, 2> & m, unsigned int dim) const {
+            return getNeighborsInDim(idx, m, dim);
         }
 
         /** \brief Computes the indices of the 4-connectivity neighbors. As it is based
             on arrays (to improve performance) the number of neighbors found is
-            returned since the neighs array will have always the same size. */
+            returned since the neighs array will have always the same size.
+
+            Neighbors are obtained as idx -+ stride in each dimension, in that order (in bricked
+            grids the stride depends on whether the neighbor is in the same brick). The
+            precomputed mask of the cell tells which of them are within the grid, so
+            no divisions nor branches are required.
+
+            The grid is not modified, so it can be called concurrently. */
         unsigned int getNeighbors
-        (unsigned int idx, std::array<unsigned int, 2*ndims> & neighs) {
-            n_neighs = 0;
-            for (unsigned int i = 0; i < ndims; ++i)
-                getNeighborsInDim(idx,neighs,i);
+        (unsigned int idx, std::array<unsigned int, 2*ndims> & neighs) const {
+            const neighmask_t m = getMask(idx);
+            unsigned int n = 0;
+            for (unsigned int i = 0; i < ndims; ++i) {
+                // Always written, only kept (counted) if the neighbor exists.
+                neighs[n] = idx - prevStride(idx, i);
+                n += (m >> 2*i) & 1;
+                neighs[n] = idx + nextStride(idx, i);
+                n += (m >> (2*i+1)) & 1;
+            }
+            return n;
+        }
 
-            return n_neighs;
+        /** \brief Returns the 4-connectivity neighbors of cell idx by value: the indices in first
+            and their number in second. */
+        std::pair<std::array<unsigned int, 2*ndims>, unsigned int> getNeighbors
+        (unsigned int idx) const {
+            std::pair<std::array<unsigned int, 2*ndims>, unsigned int> neighs;
+            neighs.second = getNeighbors(idx, neighs.first);
+            return neighs;
         }
 
-        /** \brief Computes the indices of the 4-connectivity neighbors of cell idx in a specified direction dim.
-            This function is designed to be used within getNeighbors() or getMinValueInDim()
-            since it increments the private member n_neighs and it is only reset in
-            those functions. */
-        void getNeighborsInDim
-        (unsigned int idx, std::array<unsigned int, 2*ndims>& neighs, unsigned int dim) {
-            unsigned int c1,c2; // Candidate neighbors in dimension.
-            if (dim == 0) {
-                c1 = idx-1;
-                c2 = idx+1;
-            }
-            else {
-                c1 = idx-d_[dim-1];
-                c2 = idx+d_[dim-1];
-            }
-            // Checking neighbor 1: is in the same n-dimensional slice (row, plane, cube, etc)?
-            if ((c1 >= 0) && (c1/d_[dim] == idx/d_[dim]))
-                neighs[n_neighs++] = c1;
-            // Checking neighbor 2. Full check, not necessary: if >ncells_ then is in another slice.
-            if (c2/d_[dim] == idx/d_[dim])
-                neighs[n_neighs++] = c2;
-        }
-
-        /** \brief Special version (because of neighbors array size) of this function to be used with getMinValueInDim(). */
-        void getNeighborsInDim
-        (unsigned int idx, std::array<unsigned int, 2>& neighs, unsigned int dim) {
-            // Candidate neighbors in dimension.
-            unsigned int c1,c2;
-            if (dim == 0) {
-                c1 = idx-1;
-                c2 = idx+1;
+        /** \brief Calls f(j) for each 4-connectivity neighbor j of cell idx, in the
+            same order as getNeighbors(). Intended for solvers which process the
+            neighbors in place, without an intermediate array. */
+        template <class F>
+        inline void forEachNeighbor
+        (unsigned int idx, F && f) const {
+            const neighmask_t m = getMask(idx);
+            for (unsigned int i = 0; i < ndims; ++i) {
+                if (m & (1 << 2*i))
+                    f(idx - prevStride(idx, i));
+                if (m & (2 << 2*i))
+                    f(idx + nextStride(idx, i));
             }
-            else {
-                c1 = idx-d_[dim-1];
-                c2 = idx+d_[dim-1];
+        }
+
+        /** \brief Calls f(idx) for each cell of the grid and f(idx, j) for each of its neighbors j.
+            Bulk version of forEachNeighbor(): interior cells (all neighbors within the grid)
+            take a path without mask tests. */
+        template <class F>
+        void forEachCellNeighbors
+        (F && f) const {
+            for (unsigned int idx = 0; idx < ncells_; ++idx) {
+                if (getMask(idx) == fullMask_)
+                    for (unsigned int i = 0; i < ndims; ++i) {
+                        f(idx, idx - prevStride(idx, i));
+                        f(idx, idx + nextStride(idx, i));
+                    }
+                else
+                    forEachNeighbor(idx, [&f, idx](unsigned int j) { f(idx, j); });
             }
-            // Checking neighbor 1: is in the same n-dimensional slice (row, plane, cube, etc)?
-            if ((c1 >= 0) && (c1/d_[dim] == idx/d_[dim]))
-                neighs[n_neighs++] = c1;
-            // Checking neighbor 2. Full check, not necessary: if >ncells_ then is in another slice.
-            if (c2/d_[dim] == idx/d_[dim])
-                neighs[n_neighs++] = c2;
+        }
+
+        /** \brief Returns true if all the neighbors of cell idx are within the grid. */
+        inline bool isInterior
+        (unsigned int idx) const {
+            return getMask(idx) == fullMask_;
+        }
+
+        /** \brief Returns the index offset between neighbor cells in each dimension:
+            1, dimsize[0], dimsize[0]*dimsize[1]... In bricked grids, it is the offset
+            between neighbor cells of the same brick: 1, brickSize, brickSize^2... */
+        inline const std::array<unsigned int, ndims> & getStrides
+        () const {
+            return stride_;
+        }
+
+        /** \brief Returns the index of the neighbor of cell idx in dimension dim: the previous one
+            if forward is false and the next one otherwise. It is not checked whether the
+            neighbor is within the grid. */
+        inline unsigned int getNeighborIdx
+        (unsigned int idx, unsigned int dim, bool forward) const {
+            return forward ? idx + nextStride(idx, dim) : idx - prevStride(idx, dim);
+        }
+
+        /** \brief Returns the contribution of coordinate c of dimension dim to the index of a cell:
+            the index is the sum of the contributions of its coordinates. Allows solvers to iterate
+            over the coordinates of the grid without calling coord2idx() for every cell. */
+        inline unsigned int getCoordOffset
+        (unsigned int dim, unsigned int c) const {
+            return (c >> brickBits_)*brickStride_[dim] + ((c & brickMask()) << (brickBits_*dim));
+        }
+
+        /** \brief Computes the indices of the 4-connectivity neighbors of cell idx in a specified direction dim.
+            They are stored in neighs starting at position n (so that the neighbors of several
+            dimensions can be accumulated in the same array) and n is incremented accordingly.
+            Returns the number of neighbors found in this dimension. */
+        template <size_t N>
+        unsigned int getNeighborsInDim
+        (unsigned int idx, std::array<unsigned int, N> & neighs, unsigned int & n, unsigned int dim) const {
+            const neighmask_t m = getMask(idx);
+            const unsigned int n0 = n;
+            if (m & (1 << 2*dim))
+                neighs[n++] = idx - prevStride(idx, dim);
+            if (m & (2 << 2*dim))
+                neighs[n++] = idx + nextStride(idx, dim);
+            return n - n0;
+        }
+
+        /** \brief Computes the indices of the (up to 2) neighbors of cell idx in dimension dim.
+            Returns the number of neighbors found. */
+        unsigned int getNeighborsInDim
+        (unsigned int idx, std::array<unsigned int, 2> & neighs, unsigned int dim) const {
+            unsigned int n = 0;
+            return getNeighborsInDim(idx, neighs, n, dim);
         }
 
         /** \brief Transforms from index to coordinates. */
         unsigned int idx2coord
-        (unsigned int idx, std::array<unsigned int, ndims> & coords) {
+        (unsigned int idx, std::array<unsigned int, ndims> & coords) const {
             if (coords.size() != ndims)
                 return -1;
+            else if (brickBits_ > 0) {
+                // The lowest bits are the coordinates within the brick.
+                unsigned int brick = idx >> (brickBits_*ndims);
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    unsigned int b = brick;
+                    if (i + 1 < ndims) {
+                        const unsigned int nbricks = brickStride_[i+1]/brickStride_[i];
+                        b = brick % nbricks;
+                        brick /= nbricks;
+                    }
+                    coords[i] = (b << brickBits_) + ((idx >> (brickBits_*i)) & brickMask());
+                }
+            }
             else {
                 coords[ndims-1] = idx/d_[ndims-2]; // First step done apart.
                 unsigned int aux = idx - coords[ndims-1]*d_[ndims-2];
@@ -210,20 +449,49 @@ template <class T, size_t ndims> class nDGridMap {
 
         /** \brief Transforms from coordinates to index. */
         unsigned int coord2idx
-        (const std::array<unsigned int, ndims> & coords, unsigned int & idx) {
+        (const std::array<unsigned int, ndims> & coords, unsigned int & idx) const {
             if (coords.size() != ndims)
                 return -1;
             else {
-                idx = coords[0];
+                idx = getCoordOffset(0, coords[0]);
                 for(unsigned int i = 1; i < ndims; ++i)
-                    idx += coords[i]*d_[i-1];
+                    idx += getCoordOffset(i, coords[i]);
             }
             return 1;
         }
 
+        /** \brief Transforms from the index the cell would have in row-major order to its index.
+            Grid loaders and writers use it so that files are in row-major order for any layout. */
+        inline unsigned int rowMajor2idx
+        (unsigned int i) const {
+            if (brickBits_ == 0)
+                return i;
+
+            unsigned int idx = 0;
+            for (unsigned int j = ndims - 1; j > 0; --j) {
+                idx += getCoordOffset(j, i/d_[j-1]);
+                i %= d_[j-1];
+            }
+            return idx + getCoordOffset(0, i);
+        }
+
+        /** \brief Returns true if idx is a padding cell of a bricked grid, not within the grid. */
+        inline bool isPadding
+        (unsigned int idx) const {
+            if (brickBits_ == 0)
+                return false;
+
+            std::array<unsigned int, ndims> coords;
+            idx2coord(idx, coords);
+            for (unsigned int i = 0; i < ndims; ++i)
+                if (coords[i] >= dimsize_[i])
+                    return true;
+            return false;
+        }
+
        /** \brief Shows the coordinates from an index. */
         void showCoords
-        (unsigned int idx) {
+        (unsigned int idx) const {
             std::array<unsigned int, ndims> coords;
             idx2coord(idx, coords);
             for (unsigned int i = 0; i < ndims; ++i)
@@ -233,7 +501,7 @@ template <class T, size_t ndims> class nDGridMap {
 
         /** \brief Shows the coordinates from a set of coordinates. */
          void showCoords
-         (std::array<unsigned int, ndims> coords) {
+         (std::array<unsigned int, ndims> coords) const {
              for (unsigned int i = 0; i < ndims; ++i)
                  std::cout << coords[i] << "\t";
              std::cout << '\n';
@@ -241,25 +509,48 @@ template <class T, size_t ndims> class nDGridMap {
 
         /** \brief Shows the index from the coordinates. */
         void showIdx
-        (const std::array<unsigned int, ndims> & coords) {
+        (const std::array<unsigned int, ndims> & coords) const {
             unsigned int idx;
             coord2idx(coords, idx);
             std::cout << idx << '\n';
         }
 
-         /** \brief Returns number of cells in the grid. */
+        /** \brief Returns true if the cells are allocated when written (FMCellSparse grids). */
+        static constexpr bool isSparse() {return CellStorage<T>::sparse;}
+
+        /** \brief Returns true if the grid can be a solution layer (FMCellSoA and FMCellExternal grids, see shareEnvironment()). */
+        static constexpr bool canShareEnvironment() {return CellStorage<T>::layers;}
+
+        /** \brief Returns the number of bytes allocated by the grid: cells, bitmap of the occupied cells,
+            neighbor masks and dirty blocks. Those shared with the solution layers are included. */
+        size_t memory
+        () const {
+            return cells_.memory() + (occupied_ ? occupied_->memory() : 0) + (neighMasks_ ? MemoryUsage::of(*neighMasks_) : 0)
+                    + MemoryUsage::of(brickLimits_) + MemoryUsage::of(dirty_);
+        }
+
+         /** \brief Returns number of cells in the grid (including padding cells in bricked grids),
+             that is, indices are in the range [0, size()). */
         inline unsigned int size
         () const {
             return ncells_;
         }
 
+        /** \brief Returns the number of cells within the grid, the product of the dimension sizes.
+            It is size() minus the padding cells of bricked grids. */
+        inline unsigned int getNumberOfCells
+        () const {
+            return d_[ndims-1];
+        }
+
         /** \brief Returns the maximum value of the cells in the grid. */
         inline double getMaxValue
         () const {
             double max = 0;
-            for (const T & c:cells_) {
-                if (!isinf(c.getValue()) && c.getValue() > max)
-                    max = c.getValue();
+            for (unsigned int i = 0; i < ncells_; ++i) {
+                const double v = cells_[i].getValue();
+                if (!isinf(v) && v > max && !isPadding(i))
+                    max = v;
             }
             return max;
         }
@@ -276,26 +567,58 @@ template <class T, size_t ndims> class nDGridMap {
             clean_ = c;
         }
 
-        /** \brief Cleans the grid if it is not clean already. Calls Cell::setDefault() */
+        /** \brief Cleans the grid if it is not clean already. Calls Cell::setDefault() on the cells
+            of the blocks accessed since the grid was last cleaned (see markDirty()), or on all
+            the cells if more than a quarter of them were accessed. */
         void clean
         () {
             if(!clean_) {
-                for (T & c:cells_)
-                    c.setDefault();
+                if (getDirtyCells() > ncells_/4)
+                    cells_.setDefault();
+                else
+                    for (unsigned int w = 0; w < dirty_.size(); ++w)
+                        for (uint64_t bits = dirty_[w]; bits != 0; bits &= bits - 1) {
+                            const unsigned int b = 64*w + __builtin_ctzll(bits);
+                            const unsigned int end = std::min(ncells_, (b + 1) << dirtyBits_);
+                            for (unsigned int idx = b << dirtyBits_; idx < end; ++idx)
+                                cells_[idx].setDefault();
+                        }
+                std::fill(dirty_.begin(), dirty_.end(), 0);
                 clean_ = true;
             }
         }
 
+        /** \brief Marks the block of cell idx as modified, to be restored by the next clean(). Cells
+            accessed through the non-const accessors are marked automatically. */
+        inline void markDirty
+        (unsigned int idx) {
+            const unsigned int b = idx >> dirtyBits_;
+            dirty_[b >> 6] |= uint64_t(1) << (b & 63);
+        }
+
+        /** \brief Returns the number of cells clean() will restore: those of the blocks accessed since
+            the grid was last cleaned. */
+        inline size_t getDirtyCells
+        () const {
+            size_t n = 0;
+            for (uint64_t bits : dirty_)
+                n += __builtin_popcountll(bits);
+            return n << dirtyBits_;
+        }
+
         /** \brief Erases the content of the grid. Must be resized later. */
         void clear
         () {
             cells_.clear();
-            occupied_.clear();
+            neighMasks_.reset();
+            brickLimits_.clear();
+            occupied_.reset();
+            dirty_.clear();
         }
 
         /** \brief Returns "size(dim(0)) \t size(dim(1)) \t..." */
-        std::string getDimSizesStr()
-        {
+        std::string getDimSizesStr
+        () const {
             std::stringstream ss;
             for(const auto& d : dimsize_)
                 ss << d << "\t";
@@ -305,19 +628,80 @@ template <class T, size_t ndims> class nDGridMap {
         /** \brief Sets the cells which are occupied. Usually called by grid loaders. */
         inline void setOccupiedCells
         (const std::vector<unsigned int> & obs) {
-            occupied_ = obs;
+            size_t n = size();
+            for (unsigned int i : obs)
+                n = std::max(n, size_t(i) + 1);
+            occupied_ = std::make_shared<const OccupancyBitmap>(n, obs);
         }
 
-        /** \brief Sets (by move semantics) the cells which are occupied. Usually called by grid loaders. */
+        /** \brief Sets (by move semantics) the cells which are occupied, one bit per cell of the grid.
+            Usually called by grid loaders. */
         inline void setOccupiedCells
-        (std::vector<unsigned int>&& obs) {
-            occupied_ = std::move(obs);
+        (OccupancyBitmap&& obs) {
+            occupied_ = std::make_shared<const OccupancyBitmap>(std::move(obs));
         }
 
-        /** \brief Returns the indices of the occupied cells of the grid. */
+        /** \brief Returns the indices of the occupied cells of the grid, in increasing order. */
         inline void getOccupiedCells
         (std::vector<unsigned int> & obs) const {
-            obs = occupied_;
+            if (occupied_)
+                occupied_->toIndices(obs);
+            else
+                obs.clear();
+        }
+
+        /** \brief Returns the bitmap of the occupied cells, shared with the grid (not copied), or
+            nullptr if they were not set. It is not modified by setOccupiedCells(), which replaces it. */
+        inline std::shared_ptr<const OccupancyBitmap> getOccupancyBitmap
+        () const {
+            return occupied_;
+        }
+
+        /** \brief Returns the number of occupied cells. */
+        inline size_t getNumberOfOccupiedCells
+        () const {
+            return occupied_ ? occupied_->count() : 0;
+        }
+
+        /** \brief Sets the occupancy of the cells of nrows rows from firstRow to occupancy(row, x), x being
+            the coordinate in dimension 0 and rows the lines of cells along dimension 0 in row-major
+            order (row r of a 3D grid has y = r % size(dim(1)) and z = r / size(dim(1))), and sets the
+            cells which become occupied in obs, of size(). Rows are split among nthreads threads (0 for
+            as many as hardware threads; sparse grids are filled by the calling thread), which set the
+            bits of obs a word at a time. Cells are not marked as dirty. Used by grid loaders, which
+            then call setOccupiedCells(obs). */
+        template <class F>
+        void setOccupancies
+        (F occupancy, OccupancyBitmap & obs, unsigned int firstRow = 0,
+         unsigned int nrows = std::numeric_limits<unsigned int>::max(), unsigned int nthreads = 0) {
+            const unsigned int rows = getNumberOfCells() / dimsize_[0];
+            if (firstRow >= rows)
+                return;
+            nrows = std::min(nrows, rows - firstRow);
+            WorkerPool pool(CellStorage<T>::sparse ? 1 : ((nthreads > 0) ? nthreads : std::max(1u, std::thread::hardware_concurrency())));
+            pool.run([this, &occupancy, &obs, &pool, firstRow, nrows] (unsigned int t) {
+                const unsigned int first = firstRow + unsigned((unsigned long long)(nrows) * t / pool.size());
+                const unsigned int last = firstRow + unsigned((unsigned long long)(nrows) * (t + 1) / pool.size());
+                size_t word = 0;
+                uint64_t bits = 0;
+                for (unsigned int r = first; r < last; ++r) {
+                    const unsigned int base = rowMajor2idx(r*dimsize_[0]);
+                    for (unsigned int x = 0; x < dimsize_[0]; ++x) {
+                        const unsigned int idx = (brickBits_ == 0) ? base + x : base + getCoordOffset(0, x);
+                        cells_[idx].setOccupancy(occupancy(r, x));
+                        if ((idx >> 6) != word) {
+                            if (bits)
+                                obs.orWord(word, bits);
+                            word = idx >> 6;
+                            bits = 0;
+                        }
+                        if (cells_[idx].isOccupied())
+                            bits |= uint64_t(1) << (idx & 63);
+                    }
+                }
+                if (bits)
+                    obs.orWord(word, bits);
+            });
         }
 
         /** \brief Makes the number of dimensions of the grid available at compilation time. */
@@ -325,12 +709,12 @@ template <class T, size_t ndims> class nDGridMap {
 
         /** \brief Returns the avegare velocity ignoring those with 0 velocitie (obstacles). */
         double getAvgSpeed
-        () {
+        () const {
             double sum = 0;
             unsigned int nObs = 0;
-            for (const T & c : cells_) {
-                if (!c.isOccupied())
-                    sum += c.getVelocity();
+            for (unsigned int i = 0; i < ncells_; ++i) {
+                if (!cells_[i].isOccupied() && !isPadding(i))
+                    sum += cells_[i].getVelocity();
                 else
                     ++nObs;
             }
@@ -339,17 +723,184 @@ template <class T, size_t ndims> class nDGridMap {
 
         /** \brief Returns the maximum speed (occupancy value) in the grid. */
         double getMaxSpeed
-        () {
+        () const {
             double max = 0;
-            for (const T & c : cells_)
-                if (max < c.getVelocity())
-                    max = c.getVelocity();
+            for (unsigned int i = 0; i < ncells_; ++i)
+                if (max < cells_[i].getVelocity() && !isPadding(i))
+                    max = cells_[i].getVelocity();
             return max;
         }
 
+        /** \brief Returns the minimum speed of the grid ignoring obstacles (0 if all the cells are obstacles). */
+        double getMinSpeed
+        () const {
+            double min = 0;
+            for (unsigned int i = 0; i < ncells_; ++i)
+                if (!cells_[i].isOccupied() && !isPadding(i) && (min == 0 || cells_[i].getVelocity() < min))
+                    min = cells_[i].getVelocity();
+            return min;
+        }
+
     private:
+        /** \brief Smallest unsigned type with 2 bits per dimension. */
+        typedef typename std::conditional<(2*ndims <= 8), uint8_t,
+                    typename std::conditional<(2*ndims <= 16), uint16_t, uint32_t>::type>::type neighmask_t;
+
+        /** \brief Returns the mask of the coordinates within a brick. */
+        inline unsigned int brickMask
+        () const {
+            return (1u << brickBits_) - 1;
+        }
+
+        /** \brief Index offset from cell idx to its previous neighbor in dimension dim. The lowest
+            bits of the index are the coordinates within the brick (none in row-major order,
+            in which every neighbor is in another brick). */
+        inline unsigned int prevStride
+        (unsigned int idx, unsigned int dim) const {
+            return ((idx >> (brickBits_*dim)) & brickMask()) == 0 ? crossStride_[dim] : stride_[dim];
+        }
+
+        /** \brief Index offset from cell idx to its next neighbor in dimension dim. */
+        inline unsigned int nextStride
+        (unsigned int idx, unsigned int dim) const {
+            return ((idx >> (brickBits_*dim)) & brickMask()) == brickMask() ? crossStride_[dim] : stride_[dim];
+        }
+
+        /** \brief Sets brickBits_ from the brick size, 0 for the default layout. */
+        void setBrickBits
+        (unsigned int brickSize) {
+            if (brickSize == 0) {
+                brickBits_ = defaultBrickBits();
+                return;
+            }
+
+            unsigned int bits = 0;
+            while ((2u << bits) <= brickSize)
+                ++bits;
+
+            if ((1u << bits) != brickSize)
+                console::warning("The brick size has to be a power of 2. Using the default layout.");
+            else if (bits > 0 && ndims < 3)
+                console::warning("Only grids of 3 or more dimensions can be bricked. Using row-major order.");
+            else if (bits == 0 && isSparse())
+                console::warning("Sparse grids have to be bricked. Using the default brick size.");
+            else {
+                brickBits_ = bits;
+                return;
+            }
+            brickBits_ = defaultBrickBits();
+        }
+
+        /** \brief Row-major order, bricks of 8 cells per side for sparse grids. */
+        static constexpr unsigned int defaultBrickBits() {return isSparse() ? 3 : 0;}
+
+        /** \brief Returns the neighbors mask of cell idx. */
+        inline neighmask_t getMask
+        (unsigned int idx) const {
+            return isSparse() ? getBrickMask(idx) : (*neighMasks_)[idx];
+        }
+
+        /** \brief Computes the neighbors mask of cell idx of a sparse grid from its coordinates within
+            the brick and the limits of the brick. */
+        inline neighmask_t getBrickMask
+        (unsigned int idx) const {
+            const uint16_t * limits = &brickLimits_[2*ndims*(idx >> (brickBits_*ndims))];
+            neighmask_t m = 0;
+            for (unsigned int i = 0; i < ndims; ++i) {
+                const unsigned int c = (idx >> (brickBits_*i)) & brickMask();
+                m |= neighmask_t(c >= limits[2*i]) << 2*i;
+                m |= neighmask_t(c < limits[2*i+1]) << (2*i+1);
+            }
+            return m;
+        }
+
+        void resizeStorage
+        (std::false_type) {
+            cells_.resize(ncells_);
+        }
+
+        /** \brief Sparse grids are allocated by bricks. */
+        void resizeStorage
+        (std::true_type) {
+            cells_.resize(ncells_, brickBits_*ndims);
+        }
+
+        /** \brief Computes the neighbors mask of every cell. Coordinates are carried
+            incrementally so no divisions are required. Padding cells are set
+            as occupied and without neighbors. */
+        void computeNeighborMasks
+        (std::false_type) {
+            computeFullMask();
+            // A new array, the previous one may be shared with solution layers.
+            std::shared_ptr<std::vector<neighmask_t> > masks = std::make_shared<std::vector<neighmask_t> >(ncells_, 0);
+            if (brickBits_ > 0)
+                for (unsigned int idx = 0; idx < ncells_; ++idx)
+                    if (isPadding(idx))
+                        cells_[idx].setOccupancy(0);
+
+            std::array<unsigned int, ndims> coords;
+            coords.fill(0);
+            for (unsigned int n = 0; n < d_[ndims-1]; ++n) {
+                unsigned int idx;
+                coord2idx(coords, idx);
+                neighmask_t m = 0;
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    if (coords[i] > 0)
+                        m |= neighmask_t(1) << 2*i;
+                    if (coords[i] + 1 < dimsize_[i])
+                        m |= neighmask_t(2) << 2*i;
+                }
+                (*masks)[idx] = m;
+
+                // Next coordinates.
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    if (++coords[i] < dimsize_[i])
+                        break;
+                    coords[i] = 0;
+                }
+            }
+            neighMasks_ = masks;
+        }
+
+        /** \brief Computes the limits of every brick of a sparse grid: in each dimension, the
+            lowest coordinate within the brick with a previous neighbor and the one after the
+            highest coordinate with a next neighbor. Padding cells have no neighbors since
+            they are out of these limits and they are never reached. */
+        void computeNeighborMasks
+        (std::true_type) {
+            computeFullMask();
+            const unsigned int bsize = 1u << brickBits_;
+            const unsigned int nbricks = ncells_ >> (brickBits_*ndims);
+            brickLimits_.resize(2*ndims*nbricks);
+
+            std::array<unsigned int, ndims> b; // Brick coordinates.
+            b.fill(0);
+            for (unsigned int q = 0; q < nbricks; ++q) {
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    const bool last = (b[i] + 1)*bsize >= dimsize_[i];
+                    brickLimits_[2*ndims*q + 2*i] = (b[i] > 0) ? 0 : 1;
+                    brickLimits_[2*ndims*q + 2*i + 1] = last ? dimsize_[i] - 1 - b[i]*bsize : bsize;
+                }
+
+                // Next brick.
+                for (unsigned int i = 0; i < ndims; ++i) {
+                    if (++b[i] < (dimsize_[i] + bsize - 1) >> brickBits_)
+                        break;
+                    b[i] = 0;
+                }
+            }
+        }
+
+        /** \brief Computes the mask of a cell with all its neighbors within the grid. */
+        void computeFullMask
+        () {
+            fullMask_ = 0;
+            for (unsigned int i = 0; i < 2*ndims; ++i)
+                fullMask_ |= neighmask_t(1) << i;
+        }
+
         /** \brief Main container for the class. */
-        std::vector<T> cells_;
+        CellStorage<T> cells_;
 
         /** \brief Size of each dimension. */
         std::array<unsigned int, ndims> dimsize_;
@@ -369,16 +920,44 @@ template <class T, size_t ndims> class nDGridMap {
             d_[1] = dimsize_[0]*dimsize_[1]; etc. */
         std::array<unsigned int, ndims> d_;
 
-        /** \brief  Auxiliar array to speed up neighbor and indexing generalization:
-            for getMinValueInDim() function. */
-        std::array<unsigned int, 2> n_;
+        /** \brief Index offset of neighbor cells in each dimension: stride_[0] = 1,
+            stride_[1] = d_[0], stride_[2] = d_[1], etc. In bricked grids, offset of
+            neighbor cells within a brick: 1, brickSize, brickSize^2... */
+        std::array<unsigned int, ndims> stride_;
+
+        /** \brief Index offset of neighbor cells in different bricks in each dimension. In
+            row-major order, it is the same as stride_. */
+        std::array<unsigned int, ndims> crossStride_;
+
+        /** \brief Index offset between consecutive bricks in each dimension. */
+        std::array<unsigned int, ndims> brickStride_;
+
+        /** \brief Each side of a brick has 2^brickBits_ cells, 0 means row-major order. */
+        unsigned int brickBits_;
+
+        /** \brief Precomputed neighbors of each cell: bit 2*i is set if neighbor idx-stride_[i] is within the grid
+            and bit 2*i+1 if neighbor idx+stride_[i] is. Shared with the solution layers. */
+        std::shared_ptr<const std::vector<neighmask_t> > neighMasks_;
 
-        /** \brief Internal variable that counts the number of neighbors found in
-            every iteration. Modified by getNeighbours(), getNeighborsInDim() and getMinValueInDim() functions. */
-        unsigned int n_neighs;
+        /** \brief Limits of the bricks of sparse grids, 2 per dimension (see computeNeighborMasks()). */
+        std::vector<uint16_t> brickLimits_;
 
-        /** \brief Caches the occupied cells (obstacles). */
-        std::vector<unsigned int> occupied_;
+        /** \brief Mask of a cell with all its neighbors within the grid. */
+        neighmask_t fullMask_;
+
+        /** \brief Caches the occupied cells (obstacles), one bit per cell. Shared with the solution layers. */
+        std::shared_ptr<const OccupancyBitmap> occupied_;
+
+        /** \brief Dirty blocks have at least 2^minDirtyBits cells. */
+        static constexpr unsigned int minDirtyBits = 6;
+
+        /** \brief Each dirty block has 2^dirtyBits_ consecutive cells. */
+        unsigned int dirtyBits_;
+
+        /** \brief Bitmap of the blocks accessed since the grid was last cleaned. */
+        std::vector<uint64_t> dirty_;
 };
 
+template <class T, size_t ndims> constexpr unsigned int nDGridMap<T, ndims>::minDirtyBits;
+
 #endif /* NDGRIDCELL_HPP_*/
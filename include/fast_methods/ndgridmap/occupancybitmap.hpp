@@ -0,0 +1,193 @@
+/*! \class OccupancyBitmap
+    \brief Set of cells of a grid (the obstacles, see nDGridMap::setOccupiedCells()) stored as
+    one bit per cell, in words of 64 bits.
+
+    It takes size()/8 bytes whatever the number of cells set, instead of 4 bytes per cell of
+    a vector of indices. Cells set are visited a word at a time: forEach() skips the empty
+    words and finds the bits set of the rest with count trailing zeros, and forEachRun() gives
+    the runs of consecutive cells set, so that dense obstacles are extracted as ranges.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCCUPANCYBITMAP_HPP_
+#define OCCUPANCYBITMAP_HPP_
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class OccupancyBitmap {
+
+    public:
+        /** \brief Creates a bitmap of n cells, none of them set. */
+        OccupancyBitmap(size_t n = 0) : size_(n), words_((n + 63) >> 6, 0) {}
+
+        /** \brief Creates a bitmap of n cells with the cells idxs set. Indices not lower than n are ignored. */
+        OccupancyBitmap(size_t n, const std::vector<unsigned int> & idxs) : OccupancyBitmap(n) {
+            for (unsigned int i : idxs)
+                if (i < n)
+                    set(i);
+        }
+
+        /** \brief Resizes the bitmap to n cells and clears it. */
+        void resize
+        (size_t n) {
+            size_ = n;
+            words_.assign((n + 63) >> 6, 0);
+        }
+
+        /** \brief Returns the number of cells of the bitmap. */
+        inline size_t size
+        () const {
+            return size_;
+        }
+
+        inline void set
+        (size_t i) {
+            words_[i >> 6] |= uint64_t(1) << (i & 63);
+        }
+
+        inline void reset
+        (size_t i) {
+            words_[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        }
+
+        /** \brief Sets the cells of the bits of word w (cells 64*w to 64*w+63). Safe with concurrent calls
+            of orWord() on the same bitmap, so that threads can set the cells of a word. */
+        inline void orWord
+        (size_t w, uint64_t bits) {
+            __atomic_fetch_or(&words_[w], bits, __ATOMIC_RELAXED);
+        }
+
+        /** \brief Returns true if cell i is set. */
+        inline bool test
+        (size_t i) const {
+            return (words_[i >> 6] >> (i & 63)) & 1;
+        }
+
+        /** \brief Returns the number of cells set. */
+        size_t count
+        () const {
+            size_t n = 0;
+            for (uint64_t w : words_)
+                n += __builtin_popcountll(w);
+            return n;
+        }
+
+        /** \brief Returns the number of cells set in [first, last). */
+        size_t count
+        (size_t first, size_t last) const {
+            if (first >= last)
+                return 0;
+            const size_t fw = first >> 6, lw = (last - 1) >> 6;
+            const uint64_t fmask = ~uint64_t(0) << (first & 63);
+            const uint64_t lmask = ~uint64_t(0) >> (63 - ((last - 1) & 63));
+            if (fw == lw)
+                return __builtin_popcountll(words_[fw] & fmask & lmask);
+            size_t n = __builtin_popcountll(words_[fw] & fmask) + __builtin_popcountll(words_[lw] & lmask);
+            for (size_t w = fw + 1; w < lw; ++w)
+                n += __builtin_popcountll(words_[w]);
+            return n;
+        }
+
+        /** \brief Returns true if no cell is set. */
+        bool none
+        () const {
+            for (uint64_t w : words_)
+                if (w)
+                    return false;
+            return true;
+        }
+
+        /** \brief Calls f(i) for every cell i set, in increasing order. */
+        template <class F>
+        void forEach
+        (F f) const {
+            for (size_t w = 0; w < words_.size(); ++w)
+                for (uint64_t bits = words_[w]; bits; bits &= bits - 1)
+                    f((unsigned int)((w << 6) + __builtin_ctzll(bits)));
+        }
+
+        /** \brief Calls f(first, last) for every run of consecutive cells set, [first, last), in increasing order. */
+        template <class F>
+        void forEachRun
+        (F f) const {
+            size_t i = 0;
+            while ((i = next(i, true)) < size_) {
+                const size_t last = next(i, false);
+                f((unsigned int)i, (unsigned int)last);
+                i = last;
+            }
+        }
+
+        /** \brief Stores the indices of the cells set, in increasing order. */
+        void toIndices
+        (std::vector<unsigned int> & idxs) const {
+            idxs.clear();
+            idxs.reserve(count());
+            forEachRun([&idxs] (unsigned int first, unsigned int last) {
+                for (unsigned int i = first; i < last; ++i)
+                    idxs.push_back(i);
+            });
+        }
+
+        /** \brief Returns the memory used by the bits, in bytes. */
+        size_t memory
+        () const {
+            return words_.size() * sizeof(uint64_t);
+        }
+
+        /** \brief Words of 64 cells, cell i is bit i%64 of word i/64. Bits past size() are 0. */
+        const std::vector<uint64_t> & getWords
+        () const {
+            return words_;
+        }
+
+        bool operator==
+        (const OccupancyBitmap & other) const {
+            return size_ == other.size_ && words_ == other.words_;
+        }
+
+        bool operator!=
+        (const OccupancyBitmap & other) const {
+            return !(*this == other);
+        }
+
+    private:
+        /** \brief Returns the first cell from i (included) which is set (if value) or not set, size() if none. */
+        size_t next
+        (size_t i, bool value) const {
+            size_t w = i >> 6;
+            if (w >= words_.size())
+                return size_;
+            uint64_t bits = (value ? words_[w] : ~words_[w]) & (~uint64_t(0) << (i & 63));
+            while (!bits) {
+                if (++w == words_.size())
+                    return size_;
+                bits = value ? words_[w] : ~words_[w];
+            }
+            const size_t j = (w << 6) + __builtin_ctzll(bits);
+            return (j < size_) ? j : size_;
+        }
+
+        /** \brief Number of cells. */
+        size_t size_;
+
+        /** \brief Bits of the cells. */
+        std::vector<uint64_t> words_;
+};
+
+#endif /* OCCUPANCYBITMAP_HPP_ */
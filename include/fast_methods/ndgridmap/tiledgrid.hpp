@@ -0,0 +1,635 @@
+/*! \class TiledGrid
+    \brief Grid stored on disk as tiles, for grids which do not fit in memory as an nDGridMap.
+    Solved by TiledFIM.
+
+    The grid is split into tiles of tileSize cells per side (tiles in the last positions of
+    each dimension are padded with obstacles). The file has a little-endian header followed by
+    the tiles, each of them its velocities and then its arrival times (tileSize^ndims doubles
+    each, in the byte order of the machine, since it is a working file):
+
+        magic "FMTILES\0"                    (8 bytes)
+        version                              (uint32, currently 1)
+        ndims                                (uint32)
+        tileSize                             (uint32)
+        reserved                             (uint32)
+        leafsize                             (float64)
+        dimsize[0] ... dimsize[ndims-1]      (uint32 each)
+        padding up to 4096 bytes
+        tiles in row-major order of tiles
+
+    Tiles are accessed through a cache of setCacheSize() tiles: acquire() returns a tile,
+    reading it from the file if it is not cached and writing back the least recently used one
+    not acquired if the cache is full, and release() lets it be written back again. Memory is
+    then bounded by the cache, not by the size of the grid. The arrival times of the tiles not
+    written yet are not read from the file but set to infinity, so create() does not write
+    them and resetTimes() does not touch the file.
+
+    Files are created from a .fmgrid file of velocities (see GridBinary), memory-mapped, or
+    from a function of the coordinates of the cells. saveGridValuesBinary() exports the
+    arrival times as a .fmgrid file, a tile at a time.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TILEDGRID_HPP_
+#define TILEDGRID_HPP_
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fast_methods/console/console.h>
+#include <fast_methods/io/gridbinary.hpp>
+
+template <size_t ndims> class TiledGrid {
+
+    public:
+        typedef std::array<unsigned int, ndims> coord_t;
+
+        /** \brief A tile in the cache. Local index of cell (c0, c1...) is c0 + c1*tileSize + ... */
+        struct Tile {
+            std::vector<double> velocities;
+            std::vector<double> times;
+
+            /** \brief Index of the tile, getNumberOfTiles() if the slot is empty. */
+            unsigned int        tile;
+
+            /** \brief Number of times acquired and not released. */
+            unsigned int        pins;
+
+            /** \brief True if the times have to be written back. To be set by writers. */
+            bool                dirty;
+
+            /** \brief Last access, for the LRU replacement. */
+            uint64_t            lastUse;
+        };
+
+        /** \brief Version written, the only one read. */
+        static constexpr uint32_t VERSION = 1;
+
+        /** \brief Offset of the first tile in the file. */
+        static constexpr size_t DATA_OFFSET = 4096;
+
+        /** \brief Minimum number of tiles cached: a tile and its neighbors, as TiledFIM needs. */
+        static constexpr unsigned int MIN_CACHE = 2*ndims + 1;
+
+        TiledGrid() : fd_(-1), tileSize_(0), cellsPerTile_(0), ntiles_(0), leafsize_(1), capacity_(MIN_CACHE),
+            clock_(0), loads_(0), writes_(0) {}
+
+        ~TiledGrid() { close(); }
+
+        TiledGrid(const TiledGrid &) = delete;
+        TiledGrid & operator=(const TiledGrid &) = delete;
+
+        /** \brief Creates the file of a grid of dimsize cells, the velocity of each cell given by
+            velocity(coords). Returns false if the file cannot be written. */
+        template <class F>
+        bool create
+        (const char * filename, const coord_t & dimsize, double leafsize, unsigned int tileSize, F velocity) {
+            close();
+            fd_ = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd_ < 0) {
+                console::error("The tiled grid file could not be created.");
+                return false;
+            }
+            setDimensions(dimsize, leafsize, std::max(tileSize, 1u));
+
+            unsigned char header[DATA_OFFSET] = {};
+            std::memcpy(header, magic(), 8);
+            GridBinary::writeU32(header + 8, VERSION);
+            GridBinary::writeU32(header + 12, ndims);
+            GridBinary::writeU32(header + 16, tileSize_);
+            GridBinary::writeF64(header + 24, leafsize_);
+            for (size_t i = 0; i < ndims; ++i)
+                GridBinary::writeU32(header + 32 + 4*i, dimsize_[i]);
+            if (!writeAt(header, DATA_OFFSET, 0) || ftruncate(fd_, off_t(tileOffset(ntiles_))) != 0) {
+                console::error("The tiled grid file could not be written.");
+                close();
+                return false;
+            }
+
+            // Velocities only, times are not written until tiles are.
+            std::vector<double> vels(cellsPerTile_);
+            coord_t origin, coords;
+            for (unsigned int t = 0; t < ntiles_; ++t) {
+                getTileOrigin(t, origin);
+                for (unsigned int l = 0; l < cellsPerTile_; ++l) {
+                    bool inside = true;
+                    unsigned int rem = l;
+                    for (size_t i = 0; i < ndims; ++i) {
+                        coords[i] = origin[i] + rem % tileSize_;
+                        rem /= tileSize_;
+                        inside = inside && coords[i] < dimsize_[i];
+                    }
+                    vels[l] = inside ? double(velocity(coords)) : 0;
+                }
+                if (!writeAt(vels.data(), cellsPerTile_*sizeof(double), tileOffset(t))) {
+                    console::error("The tiled grid file could not be written.");
+                    close();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /** \brief Creates the file of the grid of velocities of a .fmgrid file (see
+            MapLoader::loadMapFromBinary()), which is memory-mapped. Compressed files are not
+            supported, since they would be decompressed in memory. */
+        bool createFromBinary
+        (const char * filename, const char * fmgrid, unsigned int tileSize) {
+            const int fd = ::open(fmgrid, O_RDONLY);
+            if (fd < 0) {
+                console::error("File not found.");
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || size_t(st.st_size) < GridBinary::dataOffset(ndims)) {
+                console::error("Not a binary grid file.");
+                ::close(fd);
+                return false;
+            }
+            const size_t length = st.st_size;
+            void * map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED) {
+                console::error("Binary grid file could not be mapped.");
+                return false;
+            }
+
+            const unsigned char * data = static_cast<const unsigned char *>(map);
+            const uint32_t dtype = GridBinary::readU32(data + 16);
+            const size_t bytes = GridBinary::dtypeSize(dtype);
+            coord_t dimsize;
+            uint64_t ncells = 1;
+            for (size_t i = 0; i < ndims; ++i) {
+                dimsize[i] = GridBinary::readU32(data + GridBinary::FIXED_HEADER + 4*i);
+                ncells *= dimsize[i];
+            }
+            bool created = false;
+            if (std::memcmp(data, GridBinary::magic(), 8) != 0 || GridBinary::readU32(data + 8) != GridBinary::VERSION)
+                console::error("Not a binary grid file (or a compressed one).");
+            else if (GridBinary::readU32(data + 12) != ndims)
+                console::error("Number of dimensions specified does not match the loaded grid.");
+            else if (bytes == 0 || GridBinary::readU32(data + 20) != GridBinary::PAYLOAD_VELOCITIES)
+                console::error("The binary grid file does not store velocities of a known type.");
+            else if (length < GridBinary::dataOffset(ndims) + ncells*bytes)
+                console::error("The binary grid file is truncated.");
+            else {
+                const unsigned char * values = data + GridBinary::dataOffset(ndims);
+                created = create(filename, dimsize, GridBinary::readF64(data + 24), tileSize,
+                    [values, bytes, dtype, &dimsize] (const coord_t & c) {
+                        uint64_t i = 0;
+                        for (size_t j = ndims; j-- > 0;)
+                            i = i*dimsize[j] + c[j];
+                        const unsigned char * v = values + i*bytes;
+                        return (dtype == GridBinary::DTYPE_FLOAT64) ? GridBinary::readF64(v) : GridBinary::readF32(v);
+                    });
+            }
+            munmap(map, length);
+            return created;
+        }
+
+        /** \brief Opens a file created by create(). Arrival times are not kept: all of them are infinity. */
+        bool open
+        (const char * filename) {
+            close();
+            fd_ = ::open(filename, O_RDWR);
+            unsigned char header[DATA_OFFSET];
+            if (fd_ < 0 || !readAt(header, DATA_OFFSET, 0)) {
+                console::error("The tiled grid file could not be opened.");
+                close();
+                return false;
+            }
+            if (std::memcmp(header, magic(), 8) != 0 || GridBinary::readU32(header + 8) != VERSION) {
+                console::error("Not a tiled grid file.");
+                close();
+                return false;
+            }
+            if (GridBinary::readU32(header + 12) != ndims) {
+                console::error("Number of dimensions specified does not match the loaded grid.");
+                close();
+                return false;
+            }
+            coord_t dimsize;
+            for (size_t i = 0; i < ndims; ++i)
+                dimsize[i] = GridBinary::readU32(header + 32 + 4*i);
+            setDimensions(dimsize, GridBinary::readF64(header + 24), GridBinary::readU32(header + 16));
+            return true;
+        }
+
+        /** \brief Writes back the cached tiles and closes the file. */
+        void close
+        () {
+            if (fd_ < 0)
+                return;
+            flush();
+            ::close(fd_);
+            fd_ = -1;
+            slots_.clear();
+        }
+
+        /** \brief Sets the number of tiles cached, at least MIN_CACHE. The cache is flushed and emptied. */
+        void setCacheSize
+        (unsigned int tiles) {
+            flush();
+            for (const Tile & s : slots_)
+                if (s.tile < ntiles_)
+                    slotOf_[s.tile] = ntiles_;
+            slots_.clear();
+            capacity_ = std::max(tiles, MIN_CACHE);
+            // Slots are never reallocated, acquired tiles stay valid.
+            slots_.reserve(capacity_);
+        }
+
+        /** \brief Returns the number of tiles cached. */
+        unsigned int getCacheSize
+        () const {
+            return capacity_;
+        }
+
+        /** \brief Returns the memory of the tiles of a full cache, in bytes. */
+        size_t getCacheMemory
+        () const {
+            return size_t(capacity_) * cellsPerTile_ * 2 * sizeof(double);
+        }
+
+        /** \brief Returns tile t, read into the cache if needed, which is not written back (its
+            data stays valid) until released. */
+        Tile & acquire
+        (unsigned int t) {
+            unsigned int s = slotOf_[t];
+            if (s == ntiles_) {
+                s = freeSlot();
+                load(t, slots_[s]);
+                slotOf_[t] = s;
+            }
+            Tile & tile = slots_[s];
+            ++tile.pins;
+            tile.lastUse = ++clock_;
+            return tile;
+        }
+
+        /** \brief Releases a tile returned by acquire(). */
+        inline void release
+        (Tile & tile) {
+            --tile.pins;
+        }
+
+        /** \brief Writes the dirty tiles of the cache to the file. */
+        void flush
+        () {
+            for (Tile & s : slots_)
+                if (s.tile < ntiles_ && s.dirty)
+                    writeBack(s);
+        }
+
+        /** \brief Sets all the arrival times to infinity. */
+        void resetTimes
+        () {
+            std::fill(written_.begin(), written_.end(), 0);
+            for (Tile & s : slots_) {
+                std::fill(s.times.begin(), s.times.end(), std::numeric_limits<double>::infinity());
+                s.dirty = false;
+            }
+        }
+
+        /** \brief Returns the arrival time of the cell of coordinates c. */
+        double getArrivalTime
+        (const coord_t & c) {
+            unsigned int l;
+            Tile & tile = acquire(getTile(c, l));
+            const double t = tile.times[l];
+            release(tile);
+            return t;
+        }
+
+        /** \brief Returns the velocity of the cell of coordinates c. */
+        double getVelocity
+        (const coord_t & c) {
+            unsigned int l;
+            Tile & tile = acquire(getTile(c, l));
+            const double v = tile.velocities[l];
+            release(tile);
+            return v;
+        }
+
+        /** \brief Saves the arrival times in the binary .fmgrid format (see GridBinary), in double
+            precision, writing the rows of a tile at a time. */
+        bool saveGridValuesBinary
+        (const char * filename) {
+            const int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                console::error("The binary grid file could not be created.");
+                return false;
+            }
+            uint64_t ncells = 1;
+            for (size_t i = 0; i < ndims; ++i)
+                ncells *= dimsize_[i];
+            std::vector<unsigned char> buf(GridBinary::dataOffset(ndims), 0);
+            std::memcpy(buf.data(), GridBinary::magic(), 8);
+            GridBinary::writeU32(&buf[8], GridBinary::VERSION);
+            GridBinary::writeU32(&buf[12], ndims);
+            GridBinary::writeU32(&buf[16], GridBinary::DTYPE_FLOAT64);
+            GridBinary::writeU32(&buf[20], GridBinary::PAYLOAD_VALUES);
+            GridBinary::writeF64(&buf[24], leafsize_);
+            for (size_t i = 0; i < ndims; ++i)
+                GridBinary::writeU32(&buf[GridBinary::FIXED_HEADER + 4*i], dimsize_[i]);
+            bool ok = writeAll(fd, buf.data(), buf.size(), 0) &&
+                      ftruncate(fd, off_t(GridBinary::dataOffset(ndims) + ncells*8)) == 0;
+
+            coord_t origin;
+            buf.resize(8*tileSize_);
+            const unsigned int rows = cellsPerTile_ / tileSize_;
+            for (unsigned int t = 0; ok && t < ntiles_; ++t) {
+                getTileOrigin(t, origin);
+                const unsigned int n = std::min(tileSize_, dimsize_[0] - origin[0]);
+                Tile & tile = acquire(t);
+                for (unsigned int r = 0; ok && r < rows; ++r) {
+                    // Row-major index of the first cell of row r of the tile.
+                    uint64_t i = 0;
+                    bool inside = true;
+                    for (size_t j = ndims; j-- > 1;) {
+                        const unsigned int c = origin[j] + (r / strideInTile(j-1) % tileSize_);
+                        inside = inside && c < dimsize_[j];
+                        i = i*dimsize_[j] + c;
+                    }
+                    if (!inside)
+                        continue;
+                    i = i*dimsize_[0] + origin[0];
+                    for (unsigned int k = 0; k < n; ++k)
+                        GridBinary::writeF64(&buf[8*k], tile.times[r*tileSize_ + k]);
+                    ok = writeAll(fd, buf.data(), 8*n, GridBinary::dataOffset(ndims) + i*8);
+                }
+                release(tile);
+            }
+            ::close(fd);
+            if (!ok)
+                console::error("The binary grid file could not be written.");
+            return ok;
+        }
+
+        /** \brief Returns the tile of the cell of coordinates c and its local index l. */
+        inline unsigned int getTile
+        (const coord_t & c, unsigned int & l) const {
+            unsigned int t = 0;
+            l = 0;
+            for (size_t i = ndims; i-- > 0;) {
+                t = t*ntilesDim_[i] + c[i] / tileSize_;
+                l = l*tileSize_ + c[i] % tileSize_;
+            }
+            return t;
+        }
+
+        /** \brief Coordinates of the first cell of tile t. */
+        inline void getTileOrigin
+        (unsigned int t, coord_t & origin) const {
+            for (size_t i = 0; i < ndims; ++i) {
+                origin[i] = (t % ntilesDim_[i]) * tileSize_;
+                t /= ntilesDim_[i];
+            }
+        }
+
+        /** \brief Returns the neighbor tile of t in dimension dim, below it if !up and above it
+            otherwise, or getNumberOfTiles() if it is out of the grid. */
+        inline unsigned int getNeighborTile
+        (unsigned int t, size_t dim, bool up) const {
+            const unsigned int c = (t / tileStride_[dim]) % ntilesDim_[dim];
+            if (up)
+                return (c + 1 < ntilesDim_[dim]) ? t + tileStride_[dim] : ntiles_;
+            return (c > 0) ? t - tileStride_[dim] : ntiles_;
+        }
+
+        /** \brief Local index offset of the next cell in dimension dim within a tile. */
+        inline unsigned int strideInTile
+        (size_t dim) const {
+            unsigned int s = 1;
+            for (size_t i = 0; i < dim; ++i)
+                s *= tileSize_;
+            return s;
+        }
+
+        const coord_t & getDimSizes
+        () const {
+            return dimsize_;
+        }
+
+        double getLeafSize
+        () const {
+            return leafsize_;
+        }
+
+        unsigned int getTileSize
+        () const {
+            return tileSize_;
+        }
+
+        unsigned int getCellsPerTile
+        () const {
+            return cellsPerTile_;
+        }
+
+        unsigned int getNumberOfTiles
+        () const {
+            return ntiles_;
+        }
+
+        /** \brief Returns the number of tiles read from the file. */
+        uint64_t getTileLoads
+        () const {
+            return loads_;
+        }
+
+        /** \brief Returns the number of tiles written to the file. */
+        uint64_t getTileWrites
+        () const {
+            return writes_;
+        }
+
+        /** \brief Returns true if a file is open. */
+        bool isOpen
+        () const {
+            return fd_ >= 0;
+        }
+
+        /** \brief Makes the number of dimensions of the grid available at compilation time. */
+        static constexpr size_t getNDims() {return ndims;}
+
+    private:
+        static const char * magic
+        () {
+            return "FMTILES\0";
+        }
+
+        void setDimensions
+        (const coord_t & dimsize, double leafsize, unsigned int tileSize) {
+            dimsize_ = dimsize;
+            leafsize_ = leafsize;
+            tileSize_ = tileSize;
+            cellsPerTile_ = 1;
+            ntiles_ = 1;
+            for (size_t i = 0; i < ndims; ++i) {
+                cellsPerTile_ *= tileSize_;
+                ntilesDim_[i] = (dimsize_[i] + tileSize_ - 1) / tileSize_;
+                tileStride_[i] = ntiles_;
+                ntiles_ *= ntilesDim_[i];
+            }
+            slots_.clear();
+            slots_.reserve(capacity_);
+            slotOf_.assign(ntiles_, ntiles_);
+            written_.assign(ntiles_, 0);
+            loads_ = writes_ = 0;
+        }
+
+        inline uint64_t tileOffset
+        (unsigned int t) const {
+            return DATA_OFFSET + uint64_t(t) * cellsPerTile_ * 2 * sizeof(double);
+        }
+
+        /** \brief Returns an empty slot, or empties the least recently used one not acquired. */
+        unsigned int freeSlot
+        () {
+            if (slots_.size() < capacity_) {
+                slots_.push_back(Tile());
+                slots_.back().tile = ntiles_;
+                slots_.back().pins = 0;
+                slots_.back().dirty = false;
+                slots_.back().lastUse = 0;
+                return slots_.size() - 1;
+            }
+            unsigned int lru = slots_.size();
+            for (unsigned int s = 0; s < slots_.size(); ++s)
+                if (slots_[s].pins == 0 && (lru == slots_.size() || slots_[s].lastUse < slots_[lru].lastUse))
+                    lru = s;
+            if (lru == slots_.size()) {
+                console::error("TiledGrid: all the cached tiles are acquired, the cache is too small.");
+                exit(1);
+            }
+            Tile & tile = slots_[lru];
+            if (tile.tile < ntiles_) {
+                if (tile.dirty)
+                    writeBack(tile);
+                slotOf_[tile.tile] = ntiles_;
+                tile.tile = ntiles_;
+            }
+            return lru;
+        }
+
+        void load
+        (unsigned int t, Tile & tile) {
+            tile.velocities.resize(cellsPerTile_);
+            tile.times.resize(cellsPerTile_);
+            bool ok = readAt(tile.velocities.data(), cellsPerTile_*sizeof(double), tileOffset(t));
+            if (written_[t])
+                ok = ok && readAt(tile.times.data(), cellsPerTile_*sizeof(double), tileOffset(t) + cellsPerTile_*sizeof(double));
+            else
+                std::fill(tile.times.begin(), tile.times.end(), std::numeric_limits<double>::infinity());
+            if (!ok) {
+                console::error("TiledGrid: a tile could not be read.");
+                exit(1);
+            }
+            tile.tile = t;
+            tile.dirty = false;
+            ++loads_;
+        }
+
+        void writeBack
+        (Tile & tile) {
+            if (!writeAt(tile.times.data(), cellsPerTile_*sizeof(double), tileOffset(tile.tile) + cellsPerTile_*sizeof(double))) {
+                console::error("TiledGrid: a tile could not be written.");
+                exit(1);
+            }
+            written_[tile.tile] = 1;
+            tile.dirty = false;
+            ++writes_;
+        }
+
+        inline bool readAt
+        (void * buf, size_t n, uint64_t offset) const {
+            unsigned char * p = static_cast<unsigned char *>(buf);
+            while (n > 0) {
+                const ssize_t r = pread(fd_, p, n, off_t(offset));
+                if (r <= 0)
+                    return false;
+                p += r;
+                n -= r;
+                offset += r;
+            }
+            return true;
+        }
+
+        inline bool writeAt
+        (const void * buf, size_t n, uint64_t offset) const {
+            return writeAll(fd_, buf, n, offset);
+        }
+
+        static inline bool writeAll
+        (int fd, const void * buf, size_t n, uint64_t offset) {
+            const unsigned char * p = static_cast<const unsigned char *>(buf);
+            while (n > 0) {
+                const ssize_t w = pwrite(fd, p, n, off_t(offset));
+                if (w <= 0)
+                    return false;
+                p += w;
+                n -= w;
+                offset += w;
+            }
+            return true;
+        }
+
+        /** \brief Descriptor of the file, -1 if none is open. */
+        int fd_;
+
+        coord_t dimsize_;
+        unsigned int tileSize_;
+        unsigned int cellsPerTile_;
+        unsigned int ntiles_;
+        double leafsize_;
+
+        /** \brief Number of tiles in each dimension and offset of the next tile in each dimension. */
+        coord_t ntilesDim_;
+        coord_t tileStride_;
+
+        /** \brief Maximum number of tiles cached. */
+        unsigned int capacity_;
+
+        /** \brief Cached tiles. */
+        std::vector<Tile> slots_;
+
+        /** \brief Slot of each tile, getNumberOfTiles() if it is not cached. */
+        std::vector<unsigned int> slotOf_;
+
+        /** \brief 1 for the tiles whose times were written to the file. */
+        std::vector<unsigned char> written_;
+
+        /** \brief Counter of accesses, for the LRU replacement. */
+        uint64_t clock_;
+
+        uint64_t loads_;
+        uint64_t writes_;
+};
+
+template <size_t ndims> constexpr uint32_t TiledGrid<ndims>::VERSION;
+template <size_t ndims> constexpr size_t TiledGrid<ndims>::DATA_OFFSET;
+template <size_t ndims> constexpr unsigned int TiledGrid<ndims>::MIN_CACHE;
+
+#endif /* TILEDGRID_HPP_ */
@@ -0,0 +1,99 @@
+/*! \class AllocationCounter
+    \brief Counts the heap allocations of the program (calls to operator new), for instance to
+    check that solvers do not allocate memory once they have solved a query on a map.
+
+    Allocations are only counted in programs which expand FAST_METHODS_COUNT_ALLOCATIONS() once,
+    at global scope of one of their source files: it replaces the global operator new and
+    delete by versions which count the calls and use malloc() and free(). Otherwise, enabled()
+    is false and the count is always 0. fm_benchmark counts them and logs the allocations of
+    every run (see Benchmark).
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALLOCATIONCOUNTER_HPP_
+#define ALLOCATIONCOUNTER_HPP_
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+class AllocationCounter {
+
+    public:
+        /** \brief Returns the number of allocations since the program started. */
+        static unsigned long long count
+        () {
+            return counter().load(std::memory_order_relaxed);
+        }
+
+        /** \brief Returns true if allocations are counted (FAST_METHODS_COUNT_ALLOCATIONS() was expanded). */
+        static bool enabled
+        () {
+            return flag();
+        }
+
+        /** \brief Counts an allocation. Called by the operator new of FAST_METHODS_COUNT_ALLOCATIONS(). */
+        static void add
+        () {
+            counter().fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /** \brief Marks allocations as counted. Called by FAST_METHODS_COUNT_ALLOCATIONS(). */
+        static bool enable
+        () {
+            return flag() = true;
+        }
+
+        /** \brief Allocates n bytes with malloc(), counting the allocation. */
+        static void * allocate
+        (std::size_t n) {
+            add();
+            return std::malloc(n ? n : 1);
+        }
+
+    private:
+        static std::atomic<unsigned long long> & counter
+        () {
+            static std::atomic<unsigned long long> n(0);
+            return n;
+        }
+
+        static bool & flag
+        () {
+            static bool f = false;
+            return f;
+        }
+};
+
+/** \brief Replaces the global operator new and delete by versions counting the allocations (see AllocationCounter). */
+#define FAST_METHODS_COUNT_ALLOCATIONS() \
+    void * operator new(std::size_t n) { \
+        if (void * p = AllocationCounter::allocate(n)) return p; \
+        throw std::bad_alloc(); \
+    } \
+    void * operator new[](std::size_t n) { \
+        if (void * p = AllocationCounter::allocate(n)) return p; \
+        throw std::bad_alloc(); \
+    } \
+    void * operator new(std::size_t n, const std::nothrow_t &) noexcept { return AllocationCounter::allocate(n); } \
+    void * operator new[](std::size_t n, const std::nothrow_t &) noexcept { return AllocationCounter::allocate(n); } \
+    void operator delete(void * p) noexcept { std::free(p); } \
+    void operator delete[](void * p) noexcept { std::free(p); } \
+    void operator delete(void * p, const std::nothrow_t &) noexcept { std::free(p); } \
+    void operator delete[](void * p, const std::nothrow_t &) noexcept { std::free(p); } \
+    static const bool fast_methods_allocations_counted_ = AllocationCounter::enable();
+
+#endif /* ALLOCATIONCOUNTER_HPP_ */
@@ -0,0 +1,59 @@
+/*! \class CancelToken
+    \brief Flag shared by its copies to ask the solvers using it to stop (see Solver::setCancelToken()).
+
+    Any thread can cancel a token while a solver checks it: solvers check their token every
+    some iterations of their main loops and, if it is cancelled, stop leaving the cells
+    computed so far. Tokens stay cancelled until reset(), so a token shared by several
+    solvers stops all of them.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CANCELTOKEN_HPP_
+#define CANCELTOKEN_HPP_
+
+#include <atomic>
+#include <memory>
+
+class CancelToken {
+
+    public:
+        /** \brief Creates a new token, not cancelled. */
+        CancelToken() : flag_(std::make_shared<std::atomic<bool> >(false)) {}
+
+        /** \brief Asks the solvers using this token (or a copy of it) to stop. */
+        void cancel
+        () {
+            flag_->store(true, std::memory_order_relaxed);
+        }
+
+        /** \brief Returns true if the token has been cancelled. */
+        inline bool isCancelled
+        () const {
+            return flag_->load(std::memory_order_relaxed);
+        }
+
+        /** \brief Sets the token as not cancelled, for the next queries. */
+        void reset
+        () {
+            flag_->store(false, std::memory_order_relaxed);
+        }
+
+    private:
+        /** \brief The flag, shared by the copies. */
+        std::shared_ptr<std::atomic<bool> > flag_;
+};
+
+#endif /* CANCELTOKEN_HPP_ */
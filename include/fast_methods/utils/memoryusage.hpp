@@ -0,0 +1,151 @@
+/*! \class MemoryUsage
+    \brief Utilities to account the memory of grids and solvers (see nDGridMap::memory() and
+    Solver::memory()) and to measure the resident memory of the process.
+
+    of() returns the bytes allocated by a container: the capacity of vectors (of vectors too)
+    or memory() for the classes which have it. The heap memory of the elements of other
+    containers is not included.
+
+    The peak resident set size (peakRSS()) is read from /proc/self/status in Linux, where
+    resetPeakRSS() makes it start again from the current resident memory, so that the peak of a
+    run can be measured (see Benchmark). Elsewhere, it is the peak of the process since it
+    started, as given by getrusage(), and it cannot be reset.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYUSAGE_HPP_
+#define MEMORYUSAGE_HPP_
+
+#include <cstddef>
+#include <vector>
+#include <array>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+class MemoryUsage {
+
+    public:
+        /** \brief Returns the bytes allocated by a class with a memory() member function. */
+        template <class C>
+        static size_t of
+        (const C & c) {
+            return c.memory();
+        }
+
+        /** \brief Returns the bytes allocated by the vector. */
+        template <class T, class A>
+        static size_t of
+        (const std::vector<T, A> & v) {
+            return v.capacity()*sizeof(T);
+        }
+
+        /** \brief Returns the bytes allocated by the vector of bits. */
+        static size_t of
+        (const std::vector<bool> & v) {
+            return v.capacity()/8;
+        }
+
+        /** \brief Returns the bytes allocated by the vector of vectors and by its vectors. */
+        template <class T, class A, class B>
+        static size_t of
+        (const std::vector<std::vector<T, A>, B> & v) {
+            size_t bytes = v.capacity()*sizeof(v[0]);
+            for (const std::vector<T, A> & w : v)
+                bytes += of(w);
+            return bytes;
+        }
+
+        /** \brief Returns the bytes allocated by the vectors of the array. */
+        template <class T, class A, size_t N>
+        static size_t of
+        (const std::array<std::vector<T, A>, N> & a) {
+            size_t bytes = 0;
+            for (const std::vector<T, A> & v : a)
+                bytes += of(v);
+            return bytes;
+        }
+
+        /** \brief Returns the peak resident memory of the process, in bytes (0 if unknown). */
+        static size_t peakRSS
+        () {
+            const size_t hwm = readStatus("VmHWM:");
+            if (hwm)
+                return hwm;
+#if defined(__unix__) || defined(__APPLE__)
+            struct rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef __APPLE__
+                return size_t(usage.ru_maxrss);
+#else
+                return size_t(usage.ru_maxrss)*1024;
+#endif
+#endif
+            return 0;
+        }
+
+        /** \brief Returns the resident memory of the process, in bytes (0 if unknown). */
+        static size_t currentRSS
+        () {
+            return readStatus("VmRSS:");
+        }
+
+        /** \brief Sets the peak resident memory to the current one (Linux 4.0 or later). Returns false
+            if it cannot be reset. */
+        static bool resetPeakRSS
+        () {
+            std::ofstream ofs("/proc/self/clear_refs");
+            ofs << "5";
+            ofs.close();
+            return bool(ofs);
+        }
+
+        /** \brief Formats bytes in B, KB, MB or GB (powers of 1024). */
+        static std::string toString
+        (size_t bytes) {
+            static const char * units[] = {"B", "KB", "MB", "GB"};
+            double v = bytes;
+            unsigned int u = 0;
+            while (v >= 1024 && u < 3) {
+                v /= 1024;
+                ++u;
+            }
+            std::ostringstream oss;
+            oss << std::fixed << std::setprecision(u ? 2 : 0) << v << ' ' << units[u];
+            return oss.str();
+        }
+
+    private:
+        /** \brief Returns the value of a field of /proc/self/status given in kB, in bytes (0 if it is
+            not found). */
+        static size_t readStatus
+        (const std::string & field) {
+            std::ifstream ifs("/proc/self/status");
+            std::string line;
+            while (std::getline(ifs, line))
+                if (line.compare(0, field.size(), field) == 0) {
+                    std::istringstream iss(line.substr(field.size()));
+                    size_t kb = 0;
+                    iss >> kb;
+                    return kb*1024;
+                }
+            return 0;
+        }
+};
+
+#endif /* MEMORYUSAGE_HPP_ */
@@ -0,0 +1,147 @@
+/*! \class OpCounters
+    \brief Counters of the operations of the hot paths of the solvers (Eikonal solves, neighbor
+    queries, heap operations, passes, sweeps...), to see why a solver is faster than another on a
+    given map (see Solver::getCounters()).
+
+    Counters are only compiled in if FAST_METHODS_COUNTERS is defined (building with
+    -DUSE_COUNTERS=true): otherwise FAST_METHODS_COUNT() and the rest of the macros expand to
+    nothing, OpCounters is empty and solvers run the same code as without instrumentation.
+    Counters are atomic, so threads of parallel solvers can count in them, and solvers clear
+    them at the start of every compute(). A neighbor query is a call to getNeighbors() (all the
+    neighbors of a cell).
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPCOUNTERS_HPP_
+#define OPCOUNTERS_HPP_
+
+#include <iostream>
+#include <array>
+#include <atomic>
+
+class OpCounters {
+
+    public:
+        /** \brief Operations counted. */
+        enum Counter {
+            EIKONAL_SOLVES,         /*!< Solutions of the Eikonal equation for a cell. */
+            NEIGHBOR_QUERIES,       /*!< getNeighbors() calls. */
+            HEAP_PUSHES,            /*!< Cells pushed to a heap or a queue. */
+            HEAP_INCREASES,         /*!< Cells of a heap updated. */
+            HEAP_POPS,              /*!< Cells popped from a heap or a queue. */
+            PEAK_NARROW_BAND,       /*!< Largest narrow band (or active list) during the run. */
+            PASSES,                 /*!< Passes over the active list (FIM, BFIM). */
+            GROUPS,                 /*!< Groups of cells marched together (GMM). */
+            SWEEPS,                 /*!< Sweeps (FSM, VFSM, LSM). */
+            LOCKED_SKIPS,           /*!< Cells skipped by a sweep because they were locked (LSM). */
+            BLOCK_SKIPS,            /*!< Rows and words of 64 cells skipped at once because they were locked (LSM). */
+            THRESHOLD_ADJUSTMENTS,  /*!< Changes of the threshold between the queues (DDQM). */
+            NCOUNTERS
+        };
+
+        /** \brief Returns true if the counters are compiled in (FAST_METHODS_COUNTERS defined). */
+        static constexpr bool enabled
+        () {
+#ifdef FAST_METHODS_COUNTERS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /** \brief Returns the name of counter c, as logged. */
+        static const char * name
+        (Counter c) {
+            static const char * names[NCOUNTERS] = {"eikonal_solves", "neighbor_queries", "heap_pushes",
+                "heap_increases", "heap_pops", "peak_narrow_band", "passes", "groups", "sweeps",
+                "locked_skips", "block_skips", "threshold_adjustments"};
+            return names[c];
+        }
+
+#ifdef FAST_METHODS_COUNTERS
+        OpCounters() {
+            clear();
+        }
+
+        OpCounters(const OpCounters & other) {
+            for (unsigned int c = 0; c < NCOUNTERS; ++c)
+                counts_[c].store(other.get(Counter(c)), std::memory_order_relaxed);
+        }
+
+        /** \brief Adds n to counter c. It is const so that const methods called by threads can count. */
+        inline void add
+        (Counter c, unsigned long long n = 1) const {
+            counts_[c].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /** \brief Sets counter c to v if v is larger. */
+        inline void max
+        (Counter c, unsigned long long v) const {
+            unsigned long long old = counts_[c].load(std::memory_order_relaxed);
+            while (v > old && !counts_[c].compare_exchange_weak(old, v, std::memory_order_relaxed));
+        }
+
+        /** \brief Returns the value of counter c. */
+        unsigned long long get
+        (Counter c) const {
+            return counts_[c].load(std::memory_order_relaxed);
+        }
+
+        /** \brief Sets all the counters to 0. */
+        void clear
+        () {
+            for (std::atomic<unsigned long long> & n : counts_)
+                n.store(0, std::memory_order_relaxed);
+        }
+#else
+        unsigned long long get
+        (Counter) const {
+            return 0;
+        }
+
+        void clear
+        () {}
+#endif
+
+        /** \brief Prints the counters which are not 0, a line per counter as in the printRunInfo() of
+            the solvers. Nothing if they are not compiled in. */
+        void print
+        () const {
+            for (unsigned int c = 0; c < NCOUNTERS; ++c)
+                if (get(Counter(c)))
+                    std::cout << '\t' << name(Counter(c)) << ": " << get(Counter(c)) << '\n';
+        }
+
+    private:
+#ifdef FAST_METHODS_COUNTERS
+        mutable std::array<std::atomic<unsigned long long>, NCOUNTERS> counts_;
+#endif
+};
+
+#ifdef FAST_METHODS_COUNTERS
+/** \brief Adds 1 to counter c (an OpCounters::Counter without scope) of the solver. */
+#define FAST_METHODS_COUNT(c) this->counters_.add(OpCounters::c)
+/** \brief Adds n to counter c of the solver. */
+#define FAST_METHODS_COUNT_N(c, n) this->counters_.add(OpCounters::c, (n))
+/** \brief Sets counter c of the solver to v if it is larger. */
+#define FAST_METHODS_COUNT_MAX(c, v) this->counters_.max(OpCounters::c, (v))
+#else
+#define FAST_METHODS_COUNT(c) ((void)0)
+#define FAST_METHODS_COUNT_N(c, n) ((void)0)
+#define FAST_METHODS_COUNT_MAX(c, v) ((void)0)
+#endif
+
+#endif /* OPCOUNTERS_HPP_ */
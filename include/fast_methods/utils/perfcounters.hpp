@@ -0,0 +1,247 @@
+/*! \class PerfCounters
+    \brief Counts hardware and software events (cycles, instructions, cache and TLB misses, page
+    faults...) of a piece of code with the perf_event_open() system call of Linux, for instance
+    around Solver::compute() in the benchmarks (see Benchmark::setPerfEvents()).
+
+    Events are named as in perf: generic ones (cycles, instructions, cache-references,
+    cache-misses, branches, branch-misses, ref-cycles, stalled-cycles-frontend/backend), software
+    ones (task-clock, page-faults, minor-faults, major-faults, context-switches, cpu-migrations),
+    cache ones as <cache>-<op>s or <cache>-<op>-misses, with cache L1-dcache, L1-icache, LLC, dTLB,
+    iTLB, branch or node and op load, store or prefetch (LLC-misses for LLC-load-misses), and raw
+    ones as r<hex code>. Only user space is counted, so that perf_event_paranoid up to 2 allows it.
+
+    Events which are unknown or cannot be counted (not Linux, no hardware counters in virtual
+    machines, forbidden by perf_event_paranoid) are warned about when opened and count NaN; the
+    rest are still counted. Events are counted independently: if there are more than hardware
+    counters, the kernel multiplexes them and counts are scaled by the time each one ran.
+
+    Counters follow the thread which opens them and the threads it starts after opening them,
+    whose counts are added when they finish. Threads started before, such as those of WorkerPool,
+    are not counted.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFCOUNTERS_HPP_
+#define PERFCOUNTERS_HPP_
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include <fast_methods/console/console.h>
+
+class PerfCounters {
+
+    public:
+        PerfCounters() {}
+
+        ~PerfCounters() { close(); }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters & operator=(const PerfCounters &) = delete;
+
+        /** \brief Returns true if events can be counted in this platform (Linux). */
+        static constexpr bool supported
+        () {
+#ifdef __linux__
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /** \brief Opens the counters of the events given, replacing the previous ones. Returns the
+            number of events which can be counted. */
+        unsigned int open
+        (const std::vector<std::string> & events) {
+            close();
+            events_ = events;
+            counts_.assign(events.size(), std::numeric_limits<double>::quiet_NaN());
+            unsigned int opened = 0;
+#ifdef __linux__
+            for (const std::string & e : events) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                int fd = -1;
+                if (!parse(e, attr))
+                    console::warning("Unknown event " + e + ", not counted.");
+                else {
+                    attr.size = sizeof(attr);
+                    attr.disabled = 1;
+                    attr.inherit = 1;
+                    attr.exclude_kernel = 1;
+                    attr.exclude_hv = 1;
+                    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                    fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+                    if (fd < 0)
+                        console::warning("Event " + e + " cannot be counted (" + std::strerror(errno) +
+                                         "), see /proc/sys/kernel/perf_event_paranoid.");
+                    else
+                        ++opened;
+                }
+                fds_.push_back(fd);
+            }
+#else
+            if (!events.empty())
+                console::warning("Events can only be counted in Linux, not counted.");
+#endif
+            return opened;
+        }
+
+        /** \brief Resets the counters and starts counting. */
+        void start
+        () {
+#ifdef __linux__
+            for (int fd : fds_)
+                if (fd >= 0) {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+#endif
+        }
+
+        /** \brief Stops counting and reads the counts since start(). */
+        void stop
+        () {
+#ifdef __linux__
+            for (int fd : fds_)
+                if (fd >= 0)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            for (unsigned int i = 0; i < fds_.size(); ++i) {
+                // Value, time enabled and time running.
+                uint64_t v[3];
+                if (fds_[i] < 0 || read(fds_[i], v, sizeof(v)) != sizeof(v) || v[2] == 0)
+                    counts_[i] = std::numeric_limits<double>::quiet_NaN();
+                else
+                    counts_[i] = double(v[0])*double(v[1])/double(v[2]);
+            }
+#endif
+        }
+
+        /** \brief Closes the counters. */
+        void close
+        () {
+#ifdef __linux__
+            for (int fd : fds_)
+                if (fd >= 0)
+                    ::close(fd);
+#endif
+            fds_.clear();
+        }
+
+        /** \brief Returns the events opened. */
+        const std::vector<std::string> & getEvents
+        () const {
+            return events_;
+        }
+
+        /** \brief Returns the counts of the events between the last start() and stop(), NaN for
+            those which are not counted. */
+        const std::vector<double> & getCounts
+        () const {
+            return counts_;
+        }
+
+    private:
+#ifdef __linux__
+        /** \brief Sets the type and config of attr to those of event e. Returns false if unknown. */
+        static bool parse
+        (const std::string & e, perf_event_attr & attr) {
+            struct Event { const char * name; uint32_t type; uint64_t config; };
+            static const Event events[] = {
+                {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {"cpu-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {"cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES},
+                {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                {"branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+                {"branch-instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+                {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {"bus-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES},
+                {"ref-cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES},
+                {"stalled-cycles-frontend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND},
+                {"stalled-cycles-backend", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+                {"task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+                {"cpu-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK},
+                {"page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+                {"faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+                {"minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN},
+                {"major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ},
+                {"context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+                {"cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS}};
+            for (const Event & ev : events)
+                if (e == ev.name) {
+                    attr.type = ev.type;
+                    attr.config = ev.config;
+                    return true;
+                }
+
+            // Raw events: r<hex code>.
+            if (e.size() > 1 && e[0] == 'r' && e.find_first_not_of("0123456789abcdefABCDEF", 1) == std::string::npos) {
+                attr.type = PERF_TYPE_RAW;
+                attr.config = std::strtoull(e.c_str() + 1, nullptr, 16);
+                return true;
+            }
+
+            // Cache events: <cache>-<op>s, <cache>-<op>-misses or <cache>-misses.
+            struct Cache { const char * name; uint64_t id; };
+            static const Cache caches[] = {
+                {"L1-dcache-", PERF_COUNT_HW_CACHE_L1D}, {"L1-icache-", PERF_COUNT_HW_CACHE_L1I},
+                {"LLC-", PERF_COUNT_HW_CACHE_LL}, {"dTLB-", PERF_COUNT_HW_CACHE_DTLB},
+                {"iTLB-", PERF_COUNT_HW_CACHE_ITLB}, {"branch-", PERF_COUNT_HW_CACHE_BPU},
+                {"node-", PERF_COUNT_HW_CACHE_NODE}};
+            static const Cache ops[] = {
+                {"loads", PERF_COUNT_HW_CACHE_OP_READ}, {"stores", PERF_COUNT_HW_CACHE_OP_WRITE},
+                {"prefetches", PERF_COUNT_HW_CACHE_OP_PREFETCH}, {"load-misses", PERF_COUNT_HW_CACHE_OP_READ},
+                {"store-misses", PERF_COUNT_HW_CACHE_OP_WRITE}, {"prefetch-misses", PERF_COUNT_HW_CACHE_OP_PREFETCH},
+                {"misses", PERF_COUNT_HW_CACHE_OP_READ}};
+            for (const Cache & c : caches) {
+                const std::string prefix(c.name);
+                if (e.compare(0, prefix.size(), prefix) != 0)
+                    continue;
+                const std::string op = e.substr(prefix.size());
+                for (const Cache & o : ops)
+                    if (op == o.name) {
+                        const bool miss = op.size() >= 6 && op.compare(op.size() - 6, 6, "misses") == 0;
+                        attr.type = PERF_TYPE_HW_CACHE;
+                        attr.config = c.id | (o.id << 8) |
+                            (uint64_t(miss ? PERF_COUNT_HW_CACHE_RESULT_MISS : PERF_COUNT_HW_CACHE_RESULT_ACCESS) << 16);
+                        return true;
+                    }
+            }
+            return false;
+        }
+#endif
+
+        /** \brief Names of the events. */
+        std::vector<std::string>    events_;
+
+        /** \brief Last counts of the events. */
+        std::vector<double>         counts_;
+
+        /** \brief File descriptors of the counters, -1 for events not counted. */
+        std::vector<int>            fds_;
+};
+
+#endif /* PERFCOUNTERS_HPP_ */
@@ -0,0 +1,170 @@
+/*! \class WorkerPool
+    \brief Pool of threads which run the same job in parallel, for the parallel solvers.
+
+    run() calls the job once per thread of the pool, with the number of the thread as
+    parameter, and returns when all of them are done. The calling thread runs job 0, so
+    a pool of size 1 does not start any thread. Threads are started once and wait for
+    the next job, so run() can be called many times per solve (once per round of a
+    solver) without creating threads each time. Jobs are passed by reference to the threads,
+    not stored in a std::function, so running a job does not allocate memory whatever it
+    captures.
+
+    Copyright (C) 2015 Javier V. Gomez
+    www.javiervgomez.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORKERPOOL_HPP_
+#define WORKERPOOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+class WorkerPool {
+
+    public:
+        /** @param nthreads number of threads, including the calling one. 0 for as many as
+                   hardware threads. */
+        WorkerPool(unsigned int nthreads = 1) : job_(nullptr), invoke_(nullptr), stop_(false), generation_(0), pending_(0) {
+            resize(nthreads);
+        }
+
+        ~WorkerPool() { stopThreads(); }
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool & operator=(const WorkerPool &) = delete;
+
+        /** \brief Sets the number of threads, including the calling one. 0 for as many as
+            hardware threads. */
+        void resize
+        (unsigned int nthreads) {
+            if (nthreads == 0)
+                nthreads = std::max(1u, std::thread::hardware_concurrency());
+            if (nthreads == size())
+                return;
+
+            stopThreads();
+            stop_ = false;
+            for (unsigned int t = 1; t < nthreads; ++t)
+                threads_.emplace_back(&WorkerPool::work, this, t, generation_);
+        }
+
+        /** \brief Returns the number of threads, including the calling one. */
+        inline unsigned int size
+        () const {
+            return threads_.size() + 1;
+        }
+
+        /** \brief Runs job(t) for t = 0, ..., size()-1 in parallel, job(0) in the calling thread.
+            Returns when all of them have finished. */
+        template <class F>
+        void run
+        (const F & job) {
+            if (threads_.empty()) {
+                job(0);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job_ = &job;
+                invoke_ = &WorkerPool::invoke<F>;
+                pending_ = threads_.size();
+                ++generation_;
+            }
+            start_.notify_all();
+            job(0);
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] () { return pending_ == 0; });
+            job_ = nullptr;
+            invoke_ = nullptr;
+        }
+
+    private:
+        /** \brief Calls job, of type F, for thread t. */
+        template <class F>
+        static void invoke
+        (const void * job, unsigned int t) {
+            (*static_cast<const F *>(job))(t);
+        }
+
+        /** \brief Loop of the threads of the pool: waits for a job newer than generation, runs it
+            and notifies. */
+        void work
+        (unsigned int t, unsigned long generation) {
+            while (true) {
+                const void * job;
+                void (*invoke)(const void *, unsigned int);
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    start_.wait(lock, [this, generation] () { return stop_ || generation_ != generation; });
+                    if (stop_)
+                        return;
+                    generation = generation_;
+                    job = job_;
+                    invoke = invoke_;
+                }
+
+                invoke(job, t);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--pending_ == 0)
+                    done_.notify_one();
+            }
+        }
+
+        /** \brief Stops and joins all the threads. */
+        void stopThreads
+        () {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            start_.notify_all();
+            for (std::thread & th : threads_)
+                th.join();
+            threads_.clear();
+        }
+
+        /** \brief Threads of the pool, besides the calling one. */
+        std::vector<std::thread>                    threads_;
+
+        /** \brief Job being run. */
+        const void *                                job_;
+
+        /** \brief Calls job_ with its actual type. */
+        void (*invoke_)(const void *, unsigned int);
+
+        std::mutex                                  mutex_;
+
+        /** \brief Notifies the threads a new job (or stop) is available. */
+        std::condition_variable                     start_;
+
+        /** \brief Notifies the calling thread all the threads are done. */
+        std::condition_variable                     done_;
+
+        /** \brief The threads have to finish. */
+        bool                                        stop_;
+
+        /** \brief Incremented for every job, so that threads do not run a job twice. */
+        unsigned long                               generation_;
+
+        /** \brief Number of threads which have not finished the current job. */
+        unsigned int                                pending_;
+};
+
+#endif /* WORKERPOOL_HPP_ */
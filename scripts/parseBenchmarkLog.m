@@ -1,7 +1,15 @@
 function bm = parseBenchmarkLog (path_to_file)
     %% Opening file.
     txt = fileread(path_to_file);
-    txt = regexprep(fileread(path_to_file), '\s+', '\t'); % Spaces (if any) to tabs.
+    events = regexp(txt, '\n# Hardware events:\t([^\n]*)', 'tokens', 'once');
+    if isempty(events)
+        bm.events = {};
+    else
+        bm.events = strsplit(events{1}, ','); % A column per event after the memory.
+    end
+    ncols = 10 + numel(bm.events);
+    txt = regexprep(txt, '\n#.*', ''); % Summary lines at the end.
+    txt = regexprep(txt, '\s+', '\t'); % Spaces (if any) to tabs.
     txt = regexp(txt, '[\t\n]', 'split');
 
     %% Parsing header.
@@ -24,22 +32,48 @@ function bm = parseBenchmarkLog (path_to_file)
     hs = 5+bm.ndims+nstartpoints; % Header's length
 
     %% Parsing experiments. Might be a bit redundant.
-    bm.nexp = (length(txt)-hs)/3;
+    bm.nexp = (length(txt)-hs)/ncols;
     id = zeros(bm.nexp,1);
     idstr = cell(bm.nexp,1);
     solvers = cell(bm.nexp/bm.nruns,1);
     times = zeros(bm.nexp,1);
+    resettimes = zeros(bm.nexp,1);
+    allocations = zeros(bm.nexp,1);
+    setuptimes = zeros(bm.nexp,1);
+    velstimes = zeros(bm.nexp,1);
+    solvermem = zeros(bm.nexp,1);
+    gridmem = zeros(bm.nexp,1);
+    peakrss = zeros(bm.nexp,1);
+    counts = zeros(bm.nexp,numel(bm.events));
     for i = 1:bm.nexp
-        idx = hs+(i-1)*3 + 1;
+        idx = hs+(i-1)*ncols + 1;
         idstr{i} = txt{idx};
         id(i) = str2double(idstr(i));
         solvers{i} = txt{idx+1};
         times(i) = str2double(txt{idx+2});
+        resettimes(i) = str2double(txt{idx+3});
+        allocations(i) = str2double(txt{idx+4});
+        setuptimes(i) = str2double(txt{idx+5});
+        velstimes(i) = str2double(txt{idx+6});
+        solvermem(i) = str2double(txt{idx+7});
+        gridmem(i) = str2double(txt{idx+8});
+        peakrss(i) = str2double(txt{idx+9});
+        for j = 1:numel(bm.events)
+            counts(i,j) = str2double(txt{idx+9+j});
+        end
     end
 
-    bm.exp = cell(bm.nexp/bm.nruns,2);
+    bm.exp = cell(bm.nexp/bm.nruns,10);
     for i = 1:bm.nexp/bm.nruns
         bm.exp{i,1} = solvers{(i-1)*bm.nruns+1};
         bm.exp{i,2} = times((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,3} = resettimes((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,4} = allocations((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,5} = setuptimes((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,6} = velstimes((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,7} = solvermem((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,8} = gridmem((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,9} = peakrss((i-1)*bm.nruns+1:i*bm.nruns);
+        bm.exp{i,10} = counts((i-1)*bm.nruns+1:i*bm.nruns,:);
     end
 
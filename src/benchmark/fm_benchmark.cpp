@@ -1,4 +1,6 @@
-/*! \brief Automatically configures and runs a Benchmark from a CFG file.
+/*! \brief Automatically configures and runs a Benchmark from a CFG file, or a BenchmarkSuite of
+    synthetic problems with --suite. With --compare, the times of the run (or of a JSON log) are
+    compared with those of a baseline JSON log, returning 2 if any solver regressed.
 
     This program is free software: you can redistribute it and/or modify
     it under the terms of the GNU General Public License as published by
@@ -16,10 +18,15 @@
 #include <cmath>
 #include <array>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
 
 #include <boost/variant.hpp>
 
 #include <fast_methods/ndgridmap/fmcell.h>
+#include <fast_methods/ndgridmap/fmcellsoa.h>
+#include <fast_methods/ndgridmap/fmcellsparse.h>
 #include <fast_methods/ndgridmap/ndgridmap.hpp>
 
 #include <fast_methods/fm/fmm.hpp>
@@ -28,72 +35,199 @@
 #include <fast_methods/fm/ufmm.hpp>
 
 #include <fast_methods/datastructures/fmfibheap.hpp>
+#include <fast_methods/datastructures/fmradixheap.hpp>
+#include <fast_methods/datastructures/fmhashheap.hpp>
+#include <fast_methods/datastructures/fmkeyheap.hpp>
 #include <fast_methods/datastructures/fmdaryheap.hpp>
 #include <fast_methods/datastructures/fmpriorityqueue.hpp>
 
 #include <fast_methods/benchmark/benchmark.hpp>
 #include <fast_methods/benchmark/benchmarkcfg.hpp>
+#include <fast_methods/benchmark/benchmarksuite.hpp>
+#include <fast_methods/benchmark/benchmarkcomparison.hpp>
+#include <fast_methods/utils/allocationcounter.hpp>
 
 using namespace std;
 
+// Logging the heap allocations of every run.
+FAST_METHODS_COUNT_ALLOCATIONS()
+
+/** \brief Configures and runs the benchmark for nDGridMap<cell_t, ndims> grids. */
+template <class cell_t>
+void runBenchmark
+(BenchmarkCFG & bcfg) {
+    // ... and for dimensions...
+    switch (bcfg.getValue<unsigned int>("grid.ndims"))
+    {
+        case 2:
+        {
+            Benchmark<nDGridMap<cell_t,2> > b;
+            bcfg.configure<nDGridMap<cell_t,2>, cell_t>(b);
+            b.run();
+            break;
+        }
+        case 3:
+        {
+            Benchmark<nDGridMap<cell_t,3> > b;
+            bcfg.configure<nDGridMap<cell_t,3>, cell_t>(b);
+            b.run();
+            break;
+        }
+        // Include here new dimensions copying, pasting and changing x.
+        /*case x:
+        {
+            Benchmark<nDGridMap<cell_t,x> > b;
+            bcfg.configure<nDGridMap<cell_t,x>, cell_t>(b);
+            b.run();
+            break;
+        }*/
+    }
+}
+
+/** \brief Configures and runs the benchmark for sparse grids, which have at least 3 dimensions. */
+template <class cell_t>
+void runSparseBenchmark
+(BenchmarkCFG & bcfg) {
+    switch (bcfg.getValue<unsigned int>("grid.ndims"))
+    {
+        case 3:
+        {
+            Benchmark<nDGridMap<cell_t,3> > b;
+            bcfg.configure<nDGridMap<cell_t,3>, cell_t>(b);
+            b.run();
+            break;
+        }
+        default:
+            console::error("Sparse grids require 3 dimensions.");
+    }
+}
+
+/** \brief Runs the suite of synthetic problems of a CFG file. */
+int runSuite
+(const char * filename) {
+    BenchmarkSuite suite;
+    if (!suite.readOptions(filename))
+        return 1;
+    const std::string cell = suite.getValue<std::string>("suite.cell");
+    const std::string precision = suite.getValue<std::string>("suite.precision");
+    if (precision != "double" && precision != "float")
+    {
+        console::error("Unknown suite.precision: " + precision + ". Use double or float.");
+        return 1;
+    }
+    const bool single = (precision == "float");
+    if (cell == "FMCell")
+    {
+        if (single)
+            suite.run<FMCellF>();
+        else
+            suite.run<FMCell>();
+    }
+    else if (cell == "FMCellSoA")
+    {
+        if (single)
+            suite.run<FMCellSoAF>();
+        else
+            suite.run<FMCellSoA>();
+    }
+    else
+    {
+        console::error("Unknown suite.cell: " + cell + ". Use FMCell or FMCellSoA.");
+        return 1;
+    }
+    return 0;
+}
+
+/** \brief Compares the JSON logs given, printing the comparison. Returns 2 if any solver regressed. */
+int compareLogs
+(const std::string & baseline, const std::string & current, double threshold) {
+    BenchmarkComparison comparison(threshold);
+    if (!comparison.compare(baseline, current))
+        return 1;
+    comparison.print();
+    return comparison.hasRegressions() ? 2 : 0;
+}
+
 int main(int argc, const char ** argv)
 {
     // Parse input.
-    if (argc < 2)
+    std::vector<std::string> args(argv + 1, argv + argc);
+    std::string baseline;
+    double threshold = 0.05;
+    for (std::size_t i = 0; i + 1 < args.size(); )
     {
-        std::cerr << "Usage:\n\t " << argv[0] << " problem.cfg" << std::endl;
+        if (args[i] == "--compare")
+            baseline = args[i + 1];
+        else if (args[i] == "--threshold")
+            threshold = std::atof(args[i + 1].c_str())/100;
+        else
+        {
+            ++i;
+            continue;
+        }
+        args.erase(args.begin() + i, args.begin() + i + 2);
+    }
+    if (args.empty() || (args[0] == "--suite" && args.size() < 2) || std::find(args.begin(), args.end(), "--compare") != args.end() ||
+        std::find(args.begin(), args.end(), "--threshold") != args.end())
+    {
+        std::cerr << "Usage:\n\t " << argv[0] << " problem.cfg [--compare baseline.json [--threshold percent]]\n\t "
+                  << argv[0] << " --compare baseline.json current.json [--threshold percent]\n\t "
+                  << argv[0] << " --suite suite.cfg" << std::endl;
         return 1;
     }
+    if (args[0] == "--suite")
+        return runSuite(args[1].c_str());
+
+    // Comparison of two logs, without running anything.
+    if (!baseline.empty() && args[0].size() > 5 && args[0].compare(args[0].size() - 5, 5, ".json") == 0)
+        return compareLogs(baseline, args[0], threshold);
 
     // Parse the CFG file.
     BenchmarkCFG bcfg;
-    if (bcfg.readOptions(argv[1]))
+    if (!bcfg.readOptions(args[0].c_str()))
+        return 1;
+    // The comparison requires the JSON log.
+    if (!baseline.empty())
+        bcfg.setValue("benchmark.format", bcfg.getValue<std::string>("benchmark.format") + ",json");
+    const std::string cell = bcfg.getValue<std::string>("grid.cell");
+    const std::string precision = bcfg.getValue<std::string>("grid.precision");
+    if (precision != "double" && precision != "float")
     {
-        // If FMCell is used...
-        if(bcfg.getValue<std::string>("grid.cell") == "FMCell")
-        {
-            // ... and for dimensions...
-            switch (bcfg.getValue<unsigned int>("grid.ndims"))
-            {
-                case 2:
-                {
-                    Benchmark<nDGridMap<FMCell,2> > b;
-                    bcfg.configure<nDGridMap<FMCell,2>, FMCell>(b);
-                    b.run();
-                    break;
-                }
-                case 3:
-                {
-                    Benchmark<nDGridMap<FMCell,3> > b;
-                    bcfg.configure<nDGridMap<FMCell,3>, FMCell>(b);
-                    b.run();
-                    break;
-                }
-                // Include here new dimensions copying, pasting and changing x.
-                /*case x:
-                {
-                    Benchmark<nDGridMap<FMCell,x> > b;
-                    bcfg.configure<nDGridMap<FMCell,x>, FMCell>(b);
-                    b.run();
-                    break;
-                }*/
-            }
-        }
-        else // else if (bcfg.getValue<std::string>("grid.cell") == "MyCell") 
-        {
-            // Include here new celltypes and include the corresponding switch dimensions as for FMCell.
-            // ... and for dimensions...
-            /*switch (bcfg.getValue<unsigned int>("grid.ndims"))
-            {
-                case 2:
-                {
-                    Benchmark<nDGridMap<MyCell,2> > b;
-                    bcfg.configure<nDGridMap<MyCell,2>, MyCell>(b);
-                    b.run();
-                    break;
-                }
-                //...
-            }*/
-        }
+        console::error("Unknown grid.precision: " + precision + ". Use double or float.");
+        return 1;
+    }
+    const bool single = (precision == "float");
+
+    // If FMCell is used...
+    if (cell == "FMCell")
+    {
+        if (single)
+            runBenchmark<FMCellF>(bcfg);
+        else
+            runBenchmark<FMCell>(bcfg);
+    }
+    // If FMCellSoA (structure of arrays) is used...
+    else if (cell == "FMCellSoA")
+    {
+        if (single)
+            runBenchmark<FMCellSoAF>(bcfg);
+        else
+            runBenchmark<FMCellSoA>(bcfg);
+    }
+    // If FMCellSparse (allocated in chunks when written) is used...
+    else if (cell == "FMCellSparse")
+    {
+        if (single)
+            runSparseBenchmark<FMCellSparseF>(bcfg);
+        else
+            runSparseBenchmark<FMCellSparse>(bcfg);
+    }
+    else // else if (cell == "MyCell")
+    {
+        // Include here new celltypes as for FMCell:
+        // runBenchmark<MyCell>(bcfg);
     }
+    if (!baseline.empty())
+        return compareLogs(baseline, "results/" + bcfg.getValue<std::string>("benchmark.name") + ".json", threshold);
+    return 0;
 }
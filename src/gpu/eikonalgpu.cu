@@ -0,0 +1,333 @@
+/* CUDA backend of GPUFIM and GPUFSM, see eikonalgpu.h. Built only with -DUSE_CUDA=true. */
+
+#include <fast_methods/gpu/eikonalgpu.h>
+
+#include <cmath>
+#include <mutex>
+#include <algorithm>
+
+#include <cuda_runtime.h>
+
+namespace {
+
+    /** \brief Size of the grid and leaf size, given to the kernels by value. */
+    struct GridDesc {
+        int nx, ny, nz;
+        double h;
+    };
+
+    /** \brief Tiles of the grid: cells per side and number of tiles in each dimension. */
+    struct TileDesc {
+        int sx, sy, sz;
+        int nx, ny, nz;
+        unsigned int ntiles;
+    };
+
+    /** \brief Same margin as utils::COMP_MARGIN. */
+    __device__ __forceinline__ double compMargin
+    () {
+        return 2.220446049250313e-16 * 1e5;
+    }
+
+    __device__ __forceinline__ void compareExchange
+    (double & a, double & b) {
+        const double lo = fmin(a, b);
+        b = fmax(a, b);
+        a = lo;
+    }
+
+    /** \brief Minimum time of the neighbors of cell idx in a dimension, c being the coordinate
+        of the cell in that dimension, n its size and stride the index increment. */
+    __device__ __forceinline__ double minInDim
+    (const double * times, int idx, int c, int n, int stride) {
+        double t = INFINITY;
+        if (c > 0)
+            t = times[idx - stride];
+        if (c < n - 1)
+            t = fmin(t, times[idx + stride]);
+        return t;
+    }
+
+    /** \brief New arrival time of cell (x, y, z), as EikonalSolver::solveEikonal() and EikonalKernel. */
+    __device__ double updateCell
+    (const GridDesc & g, const double * speeds, const double * times, int x, int y, int z) {
+        const int idx = x + g.nx*(y + g.ny*z);
+        const double v = speeds[idx];
+        if (v <= 0)
+            return INFINITY;
+
+        double T[3];
+        T[0] = minInDim(times, idx, x, g.nx, 1);
+        T[1] = minInDim(times, idx, y, g.ny, g.nx);
+        T[2] = minInDim(times, idx, z, g.nz, g.nx*g.ny);
+        compareExchange(T[0], T[1]);
+        compareExchange(T[1], T[2]);
+        compareExchange(T[0], T[1]);
+        const int a = isinf(T[0]) ? 0 : (isinf(T[1]) ? 1 : (isinf(T[2]) ? 2 : 3));
+        if (a == 0)
+            return INFINITY;
+
+        const double hv = g.h / v;
+        const double h2v2 = hv*hv;
+        double updatedT = T[0] + hv;
+        if (a == 1 || (updatedT - T[1]) < compMargin())
+            return updatedT;
+
+        const double T0 = T[0];
+        double sumT = 0;
+        double sumTT = 0;
+        for (int i = 2; i <= a; ++i) {
+            const double dT = T[i-1] - T0;
+            sumT += dT;
+            sumTT += dT*dT;
+            const double qa = i;
+            const double qb = -2*sumT;
+            const double qc = sumTT - h2v2;
+            const double quad_term = qb*qb - 4*qa*qc;
+            if (quad_term < 0)
+                updatedT = INFINITY;
+            else
+                updatedT = T0 + (-qb + sqrt(quad_term))/(2*qa);
+            if (i == a || (updatedT - T[i]) < compMargin())
+                break;
+        }
+        return updatedT;
+    }
+
+    /** \brief Updates the cells of the tiles in the list, a block per tile and a thread per cell,
+        iterations times. Tiles in which a time improves by more than error are flagged in changed. */
+    __global__ void updateTiles
+    (GridDesc g, TileDesc td, const unsigned int * tiles, const double * speeds, double * times,
+     unsigned char * changed, double error, int iterations) {
+        const unsigned int t = tiles[blockIdx.x];
+        const int x = int(t % td.nx)*td.sx + threadIdx.x;
+        const int y = int((t / td.nx) % td.ny)*td.sy + threadIdx.y;
+        const int z = int(t / (td.nx*td.ny))*td.sz + threadIdx.z;
+        const bool inside = x < g.nx && y < g.ny && z < g.nz;
+        const int idx = x + g.nx*(y + g.ny*z);
+        const double threshold = fmax(error, compMargin());
+
+        // All the threads of the block reach every __syncthreads().
+        for (int it = 0; it < iterations; ++it) {
+            if (inside) {
+                const double p = times[idx];
+                const double q = updateCell(g, speeds, times, x, y, z);
+                if (q < p) {
+                    times[idx] = q;
+                    if (p - q > threshold)
+                        changed[t] = 1;
+                }
+            }
+            __syncthreads();
+        }
+    }
+
+    /** \brief Lists the tiles to update in the next round: those which changed and their neighbors. */
+    __global__ void activateTiles
+    (TileDesc td, const unsigned char * changed, unsigned int * tiles, unsigned int * count) {
+        const unsigned int t = blockIdx.x*blockDim.x + threadIdx.x;
+        if (t >= td.ntiles)
+            return;
+        const int x = t % td.nx;
+        const int y = (t / td.nx) % td.ny;
+        const int z = t / (td.nx*td.ny);
+        const int sy = td.nx;
+        const int sz = td.nx*td.ny;
+        const bool active = changed[t] ||
+            (x > 0 && changed[t - 1]) || (x < td.nx - 1 && changed[t + 1]) ||
+            (y > 0 && changed[t - sy]) || (y < td.ny - 1 && changed[t + sy]) ||
+            (z > 0 && changed[t - sz]) || (z < td.nz - 1 && changed[t + sz]);
+        if (active)
+            tiles[atomicAdd(count, 1u)] = t;
+    }
+
+    /** \brief Updates the cells of level (sum of coordinates in the direction of the sweep) of a
+        sweep, a thread per (y, z) pair. Bit i of dir set is increasing coordinate i. */
+    __global__ void sweepLevel
+    (GridDesc g, int dir, int level, const double * speeds, double * times, int * changed) {
+        const int j = blockIdx.x*blockDim.x + threadIdx.x;
+        const int k = blockIdx.y*blockDim.y + threadIdx.y;
+        const int i = level - j - k;
+        if (j >= g.ny || k >= g.nz || i < 0 || i >= g.nx)
+            return;
+        const int x = (dir & 1) ? i : g.nx - 1 - i;
+        const int y = (dir & 2) ? j : g.ny - 1 - j;
+        const int z = (dir & 4) ? k : g.nz - 1 - k;
+        const int idx = x + g.nx*(y + g.ny*z);
+        const double q = updateCell(g, speeds, times, x, y, z);
+        if (q + compMargin() < times[idx]) {
+            times[idx] = q;
+            *changed = 1;
+        }
+    }
+
+    /** \brief Device arrays, kept between solves. */
+    struct DeviceBuffers {
+        double * speeds = nullptr;
+        double * times = nullptr;
+        size_t cells = 0;
+
+        unsigned char * changed = nullptr;
+        unsigned int * tiles = nullptr;
+        size_t ntiles = 0;
+
+        unsigned int * count = nullptr;
+        int * flag = nullptr;
+    };
+
+    DeviceBuffers buffers;
+    std::mutex buffersMutex;
+
+    inline bool ok
+    (cudaError_t e) {
+        return e == cudaSuccess;
+    }
+
+    /** \brief Makes room for a grid of cells and ntiles tiles. */
+    bool reserve
+    (size_t cells, size_t ntiles) {
+        if (!buffers.count && (!ok(cudaMalloc(&buffers.count, sizeof(unsigned int))) ||
+                               !ok(cudaMalloc(&buffers.flag, sizeof(int)))))
+            return false;
+        if (cells > buffers.cells) {
+            cudaFree(buffers.speeds);
+            cudaFree(buffers.times);
+            buffers.cells = 0;
+            if (!ok(cudaMalloc(&buffers.speeds, cells*sizeof(double))) ||
+                !ok(cudaMalloc(&buffers.times, cells*sizeof(double))))
+                return false;
+            buffers.cells = cells;
+        }
+        if (ntiles > buffers.ntiles) {
+            cudaFree(buffers.changed);
+            cudaFree(buffers.tiles);
+            buffers.ntiles = 0;
+            if (!ok(cudaMalloc(&buffers.changed, ntiles)) ||
+                !ok(cudaMalloc(&buffers.tiles, ntiles*sizeof(unsigned int))))
+                return false;
+            buffers.ntiles = ntiles;
+        }
+        return true;
+    }
+
+    /** \brief Uploads the speeds and times of a grid. */
+    bool upload
+    (const std::vector<double> & speeds, const std::vector<double> & times) {
+        return ok(cudaMemcpy(buffers.speeds, speeds.data(), speeds.size()*sizeof(double), cudaMemcpyHostToDevice)) &&
+               ok(cudaMemcpy(buffers.times, times.data(), times.size()*sizeof(double), cudaMemcpyHostToDevice));
+    }
+
+    /** \brief Downloads the times. */
+    bool download
+    (std::vector<double> & times) {
+        return ok(cudaMemcpy(times.data(), buffers.times, times.size()*sizeof(double), cudaMemcpyDeviceToHost));
+    }
+
+    GridDesc makeGrid
+    (const unsigned int * dims, double leafsize) {
+        GridDesc g;
+        g.nx = dims[0];
+        g.ny = dims[1];
+        g.nz = dims[2];
+        g.h = leafsize;
+        return g;
+    }
+}
+
+namespace gpu {
+
+    bool available
+    () {
+        static const bool device = [] () {
+            int n = 0;
+            return ok(cudaGetDeviceCount(&n)) && n > 0;
+        }();
+        return device;
+    }
+
+    std::string deviceName
+    () {
+        cudaDeviceProp prop;
+        if (!available() || !ok(cudaGetDeviceProperties(&prop, 0)))
+            return std::string();
+        return prop.name;
+    }
+
+    bool solveFIM
+    (const unsigned int * dims, double leafsize, const std::vector<double> & speeds,
+     std::vector<double> & times, double error, unsigned int tileSize, unsigned int & rounds) {
+        const GridDesc g = makeGrid(dims, leafsize);
+        TileDesc td;
+        td.sx = std::min<int>(tileSize, g.nx);
+        td.sy = std::min<int>(tileSize, g.ny);
+        td.sz = std::min<int>(tileSize, g.nz);
+        if (td.sx*td.sy*td.sz > 1024) // Threads per block.
+            return false;
+        td.nx = (g.nx + td.sx - 1)/td.sx;
+        td.ny = (g.ny + td.sy - 1)/td.sy;
+        td.nz = (g.nz + td.sz - 1)/td.sz;
+        td.ntiles = td.nx*td.ny*td.nz;
+
+        // Tiles of the initial points are the first changed.
+        std::vector<unsigned char> changed(td.ntiles, 0);
+        for (size_t i = 0; i < times.size(); ++i)
+            if (times[i] == 0) {
+                const int x = i % g.nx, y = (i / g.nx) % g.ny, z = i / (g.nx*g.ny);
+                changed[x/td.sx + td.nx*(y/td.sy + td.ny*(z/td.sz))] = 1;
+            }
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        if (!reserve(times.size(), td.ntiles) || !upload(speeds, times) ||
+            !ok(cudaMemcpy(buffers.changed, changed.data(), td.ntiles, cudaMemcpyHostToDevice)))
+            return false;
+
+        const dim3 block(td.sx, td.sy, td.sz);
+        const unsigned int threads = 256;
+        for (;;) {
+            unsigned int count = 0;
+            cudaMemset(buffers.count, 0, sizeof(unsigned int));
+            activateTiles<<<(td.ntiles + threads - 1)/threads, threads>>>(td, buffers.changed, buffers.tiles, buffers.count);
+            if (!ok(cudaMemcpy(&count, buffers.count, sizeof(unsigned int), cudaMemcpyDeviceToHost)))
+                return false;
+            if (count == 0)
+                break;
+
+            ++rounds;
+            cudaMemset(buffers.changed, 0, td.ntiles);
+            updateTiles<<<count, block>>>(g, td, buffers.tiles, buffers.speeds, buffers.times,
+                                          buffers.changed, error, std::max(td.sx, std::max(td.sy, td.sz)));
+        }
+        return ok(cudaGetLastError()) && download(times);
+    }
+
+    bool solveSweeping
+    (const unsigned int * dims, double leafsize, const std::vector<double> & speeds,
+     std::vector<double> & times, unsigned int maxSweeps, unsigned int & sweeps) {
+        const GridDesc g = makeGrid(dims, leafsize);
+
+        // Directions differing only in dimensions of size 1 are the same sweep.
+        std::vector<int> dirs;
+        const int mask = (g.nx > 1) | ((g.ny > 1) << 1) | ((g.nz > 1) << 2);
+        for (int d = 0; d < 8; ++d)
+            if ((d & mask) == d)
+                dirs.push_back(d);
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        if (!reserve(times.size(), 0) || !upload(speeds, times))
+            return false;
+
+        const dim3 block(32, 8);
+        const dim3 grid((g.ny + block.x - 1)/block.x, (g.nz + block.y - 1)/block.y);
+        const int levels = g.nx + g.ny + g.nz - 2;
+        int changed = 1;
+        while (changed && sweeps < maxSweeps) {
+            cudaMemset(buffers.flag, 0, sizeof(int));
+            for (size_t d = 0; d < dirs.size() && sweeps < maxSweeps; ++d, ++sweeps)
+                for (int level = 0; level < levels; ++level)
+                    sweepLevel<<<grid, block>>>(g, dirs[d], level, buffers.speeds, buffers.times, buffers.flag);
+            if (!ok(cudaMemcpy(&changed, buffers.flag, sizeof(int), cudaMemcpyDeviceToHost)))
+                return false;
+        }
+        return ok(cudaGetLastError()) && download(times);
+    }
+}
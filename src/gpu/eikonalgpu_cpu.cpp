@@ -0,0 +1,27 @@
+/* Backend of GPUFIM and GPUFSM when the library is built without CUDA (see eikonalgpu.h):
+   there is no device, so the solvers run their CPU versions. */
+
+#include <fast_methods/gpu/eikonalgpu.h>
+
+namespace gpu {
+
+    bool available
+    () {
+        return false;
+    }
+
+    std::string deviceName
+    () {
+        return std::string();
+    }
+
+    bool solveFIM
+    (const unsigned int *, double, const std::vector<double> &, std::vector<double> &, double, unsigned int, unsigned int &) {
+        return false;
+    }
+
+    bool solveSweeping
+    (const unsigned int *, double, const std::vector<double> &, std::vector<double> &, unsigned int, unsigned int &) {
+        return false;
+    }
+}
@@ -0,0 +1,27 @@
+/* Compression of the binary grid files when the library is built without zstd (see
+   compression.h): grids are saved uncompressed. */
+
+#include <fast_methods/io/compression.h>
+
+namespace compression {
+
+    bool available
+    () {
+        return false;
+    }
+
+    bool isCompressed
+    (const unsigned char * data, size_t size) {
+        return size >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd;
+    }
+
+    bool compress
+    (const unsigned char *, size_t, std::vector<unsigned char> &, int) {
+        return false;
+    }
+
+    bool decompress
+    (const unsigned char *, size_t, std::vector<unsigned char> &) {
+        return false;
+    }
+}
@@ -0,0 +1,37 @@
+/* zstd compression of the binary grid files, see compression.h. Built only with -DUSE_ZSTD=true. */
+
+#include <fast_methods/io/compression.h>
+
+#include <zstd.h>
+
+namespace compression {
+
+    bool available
+    () {
+        return true;
+    }
+
+    bool isCompressed
+    (const unsigned char * data, size_t size) {
+        return size >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd;
+    }
+
+    bool compress
+    (const unsigned char * data, size_t size, std::vector<unsigned char> & out, int level) {
+        out.resize(ZSTD_compressBound(size));
+        const size_t n = ZSTD_compress(out.data(), out.size(), data, size, level);
+        if (ZSTD_isError(n))
+            return false;
+        out.resize(n);
+        return true;
+    }
+
+    bool decompress
+    (const unsigned char * data, size_t size, std::vector<unsigned char> & out) {
+        const unsigned long long n = ZSTD_getFrameContentSize(data, size);
+        if (n == ZSTD_CONTENTSIZE_ERROR || n == ZSTD_CONTENTSIZE_UNKNOWN)
+            return false;
+        out.resize(n);
+        return !ZSTD_isError(ZSTD_decompress(out.data(), out.size(), data, size));
+    }
+}
@@ -4,8 +4,9 @@
 
 using namespace std;
 
+template <class U>
 ostream& operator <<
-(ostream & os, Cell & c) {
+(ostream & os, CellT<U> & c) {
     os << console::str_info("Basic cell information:");
     os << "\t" << "Index: " << c.index_ << '\n'
        << "\t" << "Value: " << c.value_ << '\n'
@@ -13,7 +14,20 @@ ostream& operator <<
     return os;
 }
 
-void Cell::setDefault
-() {
-    value_ = -1;
+template <>
+std::string CellT<double>::type
+() const {
+    return std::string("Cell - Basic cell");
 }
+
+template <>
+std::string CellT<float>::type
+() const {
+    return std::string("CellF - Basic cell (float)");
+}
+
+template class CellT<double>;
+template class CellT<float>;
+
+template ostream& operator << (ostream & os, CellT<double> & c);
+template ostream& operator << (ostream & os, CellT<float> & c);
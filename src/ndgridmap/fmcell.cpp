@@ -4,8 +4,9 @@
 
 using namespace std;
 
+template <class U>
 ostream& operator << 
-(ostream & os, const FMCell & c) {
+(ostream & os, const FMCellT<U> & c) {
     os << console::str_info("Fast Marching cell information:");
     os << "\t" << "Index: " << c.index_ << '\n'
        << "\t" << "Value: " << c.value_ << '\n'
@@ -27,11 +28,20 @@ ostream& operator <<
     return os;
 }
 
-void FMCell::setDefault
-() {
-    Cell::setDefault();
-    value_ = std::numeric_limits<double>::infinity();
-    bucket_ = 0;
-    hValue_ = 0;
-    state_ = FMState::OPEN;
+template <>
+std::string FMCellT<double>::type
+() const {
+    return std::string("FMCell - Fast Marching cell");
 }
+
+template <>
+std::string FMCellT<float>::type
+() const {
+    return std::string("FMCellF - Fast Marching cell (float)");
+}
+
+template class FMCellT<double>;
+template class FMCellT<float>;
+
+template ostream& operator << (ostream & os, const FMCellT<double> & c);
+template ostream& operator << (ostream & os, const FMCellT<float> & c);
@@ -0,0 +1,53 @@
+#include "fast_methods/ndgridmap/fmcellexternal.h"
+
+#include <fast_methods/console/console.h>
+
+using namespace std;
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellExternalT<U> & c) {
+    os << console::str_info("Fast Marching cell (external) information:");
+    os << "\t" << "Index: " << c.idx_ << '\n'
+       << "\t" << "Value: " << c.getValue() << '\n'
+       << "\t" << "Velocity: " << c.getVelocity() << '\n'
+       << "\t" << "State: " ;
+
+    switch (c.getState()) {
+        case FMState::OPEN:
+            os << "OPEN";
+            break;
+        case FMState::NARROW:
+            os << "NARROW";
+            break;
+        case FMState::FROZEN:
+            os << "FROZEN";
+            break;
+        }
+    os << '\n';
+    return os;
+}
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellExternalPtrT<U> & p) {
+    os << p->getIndex();
+    return os;
+}
+
+template <>
+std::string FMCellExternalT<double>::type
+() const {
+    return std::string("FMCellExternal - Fast Marching cell (external buffers)");
+}
+
+template <>
+std::string FMCellExternalT<float>::type
+() const {
+    return std::string("FMCellExternalF - Fast Marching cell (external buffers, float)");
+}
+
+template ostream& operator << (ostream & os, const FMCellExternalT<double> & c);
+template ostream& operator << (ostream & os, const FMCellExternalT<float> & c);
+template ostream& operator << (ostream & os, const FMCellExternalPtrT<double> & p);
+template ostream& operator << (ostream & os, const FMCellExternalPtrT<float> & p);
@@ -0,0 +1,53 @@
+#include "fast_methods/ndgridmap/fmcellsoa.h"
+
+#include <fast_methods/console/console.h>
+
+using namespace std;
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellSoAT<U> & c) {
+    os << console::str_info("Fast Marching cell (SoA) information:");
+    os << "\t" << "Index: " << c.idx_ << '\n'
+       << "\t" << "Value: " << c.getValue() << '\n'
+       << "\t" << "Velocity: " << c.getVelocity() << '\n'
+       << "\t" << "State: " ;
+
+    switch (c.getState()) {
+        case FMState::OPEN:
+            os << "OPEN";
+            break;
+        case FMState::NARROW:
+            os << "NARROW";
+            break;
+        case FMState::FROZEN:
+            os << "FROZEN";
+            break;
+        }
+    os << '\n';
+    return os;
+}
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellSoAPtrT<U> & p) {
+    os << p->getIndex();
+    return os;
+}
+
+template <>
+std::string FMCellSoAT<double>::type
+() const {
+    return std::string("FMCellSoA - Fast Marching cell (structure of arrays)");
+}
+
+template <>
+std::string FMCellSoAT<float>::type
+() const {
+    return std::string("FMCellSoAF - Fast Marching cell (structure of arrays, float)");
+}
+
+template ostream& operator << (ostream & os, const FMCellSoAT<double> & c);
+template ostream& operator << (ostream & os, const FMCellSoAT<float> & c);
+template ostream& operator << (ostream & os, const FMCellSoAPtrT<double> & p);
+template ostream& operator << (ostream & os, const FMCellSoAPtrT<float> & p);
@@ -0,0 +1,53 @@
+#include "fast_methods/ndgridmap/fmcellsparse.h"
+
+#include <fast_methods/console/console.h>
+
+using namespace std;
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellSparseT<U> & c) {
+    os << console::str_info("Fast Marching cell (sparse) information:");
+    os << "\t" << "Index: " << c.idx_ << '\n'
+       << "\t" << "Value: " << c.getValue() << '\n'
+       << "\t" << "Velocity: " << c.getVelocity() << '\n'
+       << "\t" << "State: " ;
+
+    switch (c.getState()) {
+        case FMState::OPEN:
+            os << "OPEN";
+            break;
+        case FMState::NARROW:
+            os << "NARROW";
+            break;
+        case FMState::FROZEN:
+            os << "FROZEN";
+            break;
+        }
+    os << '\n';
+    return os;
+}
+
+template <class U>
+ostream& operator <<
+(ostream & os, const FMCellSparsePtrT<U> & p) {
+    os << p->getIndex();
+    return os;
+}
+
+template <>
+std::string FMCellSparseT<double>::type
+() const {
+    return std::string("FMCellSparse - Fast Marching cell (sparse, allocated in chunks)");
+}
+
+template <>
+std::string FMCellSparseT<float>::type
+() const {
+    return std::string("FMCellSparseF - Fast Marching cell (sparse, allocated in chunks, float)");
+}
+
+template ostream& operator << (ostream & os, const FMCellSparseT<double> & c);
+template ostream& operator << (ostream & os, const FMCellSparseT<float> & c);
+template ostream& operator << (ostream & os, const FMCellSparsePtrT<double> & p);
+template ostream& operator << (ostream & os, const FMCellSparsePtrT<float> & p);